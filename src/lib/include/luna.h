@@ -30,6 +30,8 @@
 #include <SDL2/SDL.h>
 #include "luna_define.h"
 #include "luna_exception.h"
+#include "luna_file.h"
+#include "luna_math.h"
 
 using namespace LUNA;
 
@@ -37,9 +39,26 @@ using namespace LUNA;
 #define COMP component
 #endif // COMP
 
+#include "luna_arena.h"
+#include "luna_atlas.h"
+#include "luna_bvh.h"
+#include "luna_cull.h"
 #include "luna_display.h"
+#include "luna_entity.h"
+#include "luna_grid.h"
 #include "luna_input.h"
+#include "luna_job.h"
+#include "luna_loader.h"
+#include "luna_mesh.h"
+#include "luna_navigation.h"
+#include "luna_pack.h"
+#include "luna_particle.h"
+#include "luna_physics.h"
 #include "luna_shader.h"
+#include "luna_sprite.h"
+#include "luna_texture.h"
+#include "luna_transform.h"
+#include "luna_uniform.h"
 #include "luna_vertex.h"
 
 using namespace LUNA::COMP;
@@ -227,14 +246,48 @@ namespace LUNA {
 
 			static _luna *acquire(void);
 
+			luna_arena_ptr acquire_arena(void);
+
+			luna_atlas_ptr acquire_atlas(void);
+
+			luna_bvh_ptr acquire_bvh(void);
+
+			luna_cull_ptr acquire_cull(void);
+
 			luna_display_ptr acquire_display(void);
 
+			luna_entity_ptr acquire_entity(void);
+
+			luna_grid_ptr acquire_grid(void);
+
 			luna_input_ptr acquire_input(void);
 
+			luna_job_ptr acquire_job(void);
+
+			luna_loader_ptr acquire_loader(void);
+
+			luna_mesh_ptr acquire_mesh(void);
+
+			luna_navigation_ptr acquire_navigation(void);
+
+			luna_pack_ptr acquire_pack(void);
+
+			luna_particle_ptr acquire_particle(void);
+
+			luna_physics_ptr acquire_physics(void);
+
 			luna_shader_ptr acquire_shader(void);
 
 			luna_shader_program_ptr acquire_shader_program(void);
 
+			luna_sprite_ptr acquire_sprite(void);
+
+			luna_texture_ptr acquire_texture(void);
+
+			luna_transform_ptr acquire_transform(void);
+
+			luna_uniform_ptr acquire_uniform(void);
+
 			luna_vertex_ptr acquire_vertex(void);
 
 			GLuint add_buffer(
@@ -251,13 +304,18 @@ namespace LUNA {
 			GLuint add_shader(
 				__in const std::string &input,
 				__in bool is_file,
-				__in GLenum type
+				__in GLenum type,
+				__in_opt const luna_shader_define &define = luna_shader_define()
 				);			
 
 			GLuint add_shader_program(
 				__in const std::vector<GLuint> &ids
 				);
 
+			GLuint add_texture(
+				__in const std::string &path
+				);
+
 			GLuint add_vertex(
 				__in size_t count
 				);
@@ -267,6 +325,11 @@ namespace LUNA {
 				__in_opt GLuint id = 0
 				);
 
+			void bind_texture(
+				__in_opt GLuint id = 0,
+				__in_opt GLuint unit = 0
+				);
+
 			void bind_vertex(
 				__in_opt GLuint id = 0
 				);
@@ -283,6 +346,8 @@ namespace LUNA {
 
 			void clear_shader_programs(void);
 
+			void clear_textures(void);
+
 			void clear_tick(void);
 
 			void clear_vertex_buffer(void);
@@ -303,6 +368,10 @@ namespace LUNA {
 				__in GLuint id
 				);
 
+			bool contains_texture(
+				__in GLuint id
+				);
+
 			bool contains_vertex(
 				__in GLuint id
 				);
@@ -321,6 +390,10 @@ namespace LUNA {
 
 			bool is_running(void);
 
+			uint32_t mount_pack(
+				__in const std::string &path
+				);
+
 			void remove_buffer(
 				__in GLuint id
 				);
@@ -337,6 +410,10 @@ namespace LUNA {
 				__in GLuint id
 				);
 
+			void remove_texture(
+				__in GLuint id
+				);
+
 			void remove_vertex(
 				__in GLuint id
 				);
@@ -348,6 +425,13 @@ namespace LUNA {
 				__in GLenum usage
 				);
 
+			void set_buffer_sub_data(
+				__in GLenum target,
+				__in size_t offset,
+				__in const void *data,
+				__in size_t length
+				);
+
 			void set_draw(
 				__in const luna_draw_config &config
 				);
@@ -388,12 +472,18 @@ namespace LUNA {
 
 			void stop(void);
 
+			size_t texture_count(void);
+
 			std::string to_string(
 				__in_opt bool verbose = false
 				);
 
 			void uninitialize(void);
 
+			void unmount_pack(
+				__in uint32_t id
+				);
+
 			void use_shader_program(
 				__in_opt GLuint id = 0
 				);
@@ -442,14 +532,48 @@ namespace LUNA {
 
 			luna_event_config m_event_config;
 
+			luna_arena_ptr m_instance_arena;
+
+			luna_atlas_ptr m_instance_atlas;
+
+			luna_bvh_ptr m_instance_bvh;
+
+			luna_cull_ptr m_instance_cull;
+
 			luna_display_ptr m_instance_display;
 
+			luna_entity_ptr m_instance_entity;
+
+			luna_grid_ptr m_instance_grid;
+
 			luna_input_ptr m_instance_input;
 
+			luna_job_ptr m_instance_job;
+
+			luna_loader_ptr m_instance_loader;
+
+			luna_mesh_ptr m_instance_mesh;
+
+			luna_navigation_ptr m_instance_navigation;
+
+			luna_pack_ptr m_instance_pack;
+
+			luna_particle_ptr m_instance_particle;
+
+			luna_physics_ptr m_instance_physics;
+
 			luna_shader_ptr m_instance_shader;
 
 			luna_shader_program_ptr m_instance_shader_program;
 
+			luna_sprite_ptr m_instance_sprite;
+
+			luna_texture_ptr m_instance_texture;
+
+			luna_transform_ptr m_instance_transform;
+
+			luna_uniform_ptr m_instance_uniform;
+
 			luna_vertex_ptr m_instance_vertex;
 
 			bool m_running;
@@ -0,0 +1,181 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_ARENA_H_
+#define LUNA_ARENA_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define ARENA_BUFFER_COUNT 2
+		#define ARENA_DEF_ALIGNMENT 16
+		#define ARENA_DEF_CAPACITY (1024 * 1024)
+
+		typedef class _luna_arena {
+
+			public:
+
+				~_luna_arena(void);
+
+				static _luna_arena *acquire(void);
+
+				void *allocate(
+					__in size_t length,
+					__in_opt size_t alignment = ARENA_DEF_ALIGNMENT
+					);
+
+				size_t capacity(void);
+
+				void clear(void);
+
+				size_t high_water(void);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_initialized(void);
+
+				size_t overflow_count(void);
+
+				void reserve(
+					__in size_t capacity
+					);
+
+				void swap(void);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+				size_t used(void);
+
+			protected:
+
+				_luna_arena(void);
+
+				_luna_arena(
+					__in const _luna_arena &other
+					);
+
+				_luna_arena &operator=(
+					__in const _luna_arena &other
+					);
+
+				static void _delete(void);
+
+				void *allocate_overflow(
+					__in size_t length,
+					__in size_t alignment
+					);
+
+				void release(
+					__in size_t index
+					);
+
+				uint8_t *m_buffer[ARENA_BUFFER_COUNT];
+
+				size_t m_capacity[ARENA_BUFFER_COUNT];
+
+				size_t m_frame;
+
+				size_t m_high_water;
+
+				bool m_initialized;
+
+				static _luna_arena *m_instance;
+
+				std::atomic<size_t> m_offset;
+
+				std::vector<uint8_t *> m_overflow[ARENA_BUFFER_COUNT];
+
+				size_t m_overflow_count;
+
+				size_t m_overflow_length[ARENA_BUFFER_COUNT];
+
+				std::mutex m_overflow_lock;
+
+				size_t m_reserve;
+
+		} luna_arena, *luna_arena_ptr;
+
+		template <class T> class _luna_arena_allocator {
+
+			public:
+
+				typedef T value_type;
+
+				template <class U> struct rebind {
+					typedef _luna_arena_allocator<U> other;
+				};
+
+				_luna_arena_allocator(void)
+				{
+					return;
+				}
+
+				template <class U> _luna_arena_allocator(
+					__in const _luna_arena_allocator<U> &other
+					)
+				{
+					UNREFERENCE_PARAM(other);
+				}
+
+				T *allocate(
+					__in size_t count
+					)
+				{
+					return (T *) luna_arena::acquire()->allocate(count * sizeof(T), 
+						alignof(T) > ARENA_DEF_ALIGNMENT ? alignof(T) : ARENA_DEF_ALIGNMENT);
+				}
+
+				void deallocate(
+					__in T *address,
+					__in size_t count
+					)
+				{
+					UNREFERENCE_PARAM(address);
+					UNREFERENCE_PARAM(count);
+				}
+		};
+
+		template <class T, class U> bool operator==(
+			__in const _luna_arena_allocator<T> &left,
+			__in const _luna_arena_allocator<U> &right
+			)
+		{
+			return true;
+		}
+
+		template <class T, class U> bool operator!=(
+			__in const _luna_arena_allocator<T> &left,
+			__in const _luna_arena_allocator<U> &right
+			)
+		{
+			return false;
+		}
+
+		template <class T> using luna_arena_vector = std::vector<T, _luna_arena_allocator<T>>;
+	}
+}
+
+#endif // LUNA_ARENA_H_
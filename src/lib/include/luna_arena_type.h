@@ -0,0 +1,66 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_ARENA_TYPE_H_
+#define LUNA_ARENA_TYPE_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define LUNA_ARENA_HEADER "(ARENA)"
+
+#ifndef NDEBUG
+		#define LUNA_ARENA_EXCEPTION_HEADER LUNA_ARENA_HEADER
+#else
+		#define LUNA_ARENA_EXCEPTION_HEADER EXCEPTION_HEADER
+#endif // NDEBUG
+
+		enum {
+			LUNA_ARENA_EXCEPTION_ALLOCATED = 0,
+			LUNA_ARENA_EXCEPTION_INITIALIZED,
+			LUNA_ARENA_EXCEPTION_INVALID,
+			LUNA_ARENA_EXCEPTION_UNINITIALIZED,
+		};
+
+		#define LUNA_ARENA_EXCEPTION_MAX LUNA_ARENA_EXCEPTION_UNINITIALIZED
+
+		static const std::string LUNA_ARENA_EXCEPTION_STR[] = {
+			LUNA_ARENA_EXCEPTION_HEADER " Failed to allocate arena component",
+			LUNA_ARENA_EXCEPTION_HEADER " Arena component is initialized",
+			LUNA_ARENA_EXCEPTION_HEADER " Invalid allocation alignment",
+			LUNA_ARENA_EXCEPTION_HEADER " Arena component is uninitialized",
+			};
+
+		#define LUNA_ARENA_EXCEPTION_STRING(_TYPE_) \
+			((_TYPE_) > LUNA_ARENA_EXCEPTION_MAX ? EXCEPTION_UNKNOWN : \
+			STRING_CHECK(LUNA_ARENA_EXCEPTION_STR[_TYPE_]))
+
+		#define THROW_LUNA_ARENA_EXCEPTION(_EXCEPT_) \
+			THROW_EXCEPTION(LUNA_ARENA_EXCEPTION_STRING(_EXCEPT_))
+		#define THROW_LUNA_ARENA_EXCEPTION_FORMAT(_EXCEPT_, _FORMAT_, ...) \
+			THROW_EXCEPTION_FORMAT(LUNA_ARENA_EXCEPTION_STRING(_EXCEPT_), \
+			_FORMAT_, __VA_ARGS__)
+
+		class _luna_arena;
+		typedef _luna_arena luna_arena, *luna_arena_ptr;
+	}
+}
+
+#endif // LUNA_ARENA_TYPE_H_
@@ -0,0 +1,165 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_ATLAS_H_
+#define LUNA_ATLAS_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define ATLAS_DEF_PADDING 1
+		#define ATLAS_DEF_PAGE_HEIGHT 2048
+		#define ATLAS_DEF_PAGE_WIDTH 2048
+
+		typedef struct {
+			GLsizei height;
+			GLuint texture;
+			GLfloat u0, u1, v0, v1;
+			GLsizei width;
+			GLsizei x, y;
+		} luna_atlas_rect;
+
+		typedef struct {
+			GLsizei width;
+			GLsizei x, y;
+		} luna_atlas_skyline;
+
+		typedef struct {
+			std::vector<luna_atlas_skyline> skyline;
+			GLuint texture;
+			size_t used;
+		} luna_atlas_page;
+
+		typedef struct {
+			GLsizei height;
+			GLsizei padding;
+			std::vector<luna_atlas_page> page;
+			GLsizei width;
+		} luna_atlas_entry;
+
+		typedef class _luna_atlas {
+
+			public:
+
+				~_luna_atlas(void);
+
+				static _luna_atlas *acquire(void);
+
+				uint32_t add(
+					__in_opt GLsizei width = ATLAS_DEF_PAGE_WIDTH,
+					__in_opt GLsizei height = ATLAS_DEF_PAGE_HEIGHT,
+					__in_opt GLsizei padding = ATLAS_DEF_PADDING
+					);
+
+				void clear(void);
+
+				bool contains(
+					__in uint32_t id
+					);
+
+				void initialize(void);
+
+				luna_atlas_rect insert(
+					__in uint32_t id,
+					__in GLsizei width,
+					__in GLsizei height,
+					__in const void *data
+					);
+
+				static bool is_allocated(void);
+
+				bool is_initialized(void);
+
+				GLuint page(
+					__in uint32_t id,
+					__in size_t index
+					);
+
+				size_t page_count(
+					__in uint32_t id
+					);
+
+				void remove(
+					__in uint32_t id
+					);
+
+				size_t size(void);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+			protected:
+
+				_luna_atlas(void);
+
+				_luna_atlas(
+					__in const _luna_atlas &other
+					);
+
+				_luna_atlas &operator=(
+					__in const _luna_atlas &other
+					);
+
+				static void _delete(void);
+
+				std::map<uint32_t, luna_atlas_entry>::iterator find(
+					__in uint32_t id
+					);
+
+				static bool fit(
+					__in luna_atlas_page &page,
+					__in GLsizei page_width,
+					__in GLsizei page_height,
+					__in GLsizei width,
+					__in GLsizei height,
+					__out size_t &index,
+					__out GLsizei &x,
+					__out GLsizei &y
+					);
+
+				static void place(
+					__in luna_atlas_page &page,
+					__in size_t index,
+					__in GLsizei x,
+					__in GLsizei y,
+					__in GLsizei width,
+					__in GLsizei height
+					);
+
+				void release(
+					__in luna_atlas_entry &entry
+					);
+
+				std::map<uint32_t, luna_atlas_entry> m_atlas_map;
+
+				bool m_initialized;
+
+				static _luna_atlas *m_instance;
+
+				uint32_t m_next;
+
+		} luna_atlas, *luna_atlas_ptr;
+	}
+}
+
+#endif // LUNA_ATLAS_H_
@@ -0,0 +1,219 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_BVH_H_
+#define LUNA_BVH_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define BVH_BIN_COUNT 16
+		#define BVH_DEF_QUERIES 1024
+		#define BVH_LEAF_MAX 8
+		#define BVH_LEAF_MIN 2
+
+		typedef struct {
+			GLfloat min[3];
+			GLfloat max[3];
+		} luna_bvh_bound;
+
+		// 32 bytes, interior nodes keep the left child adjacent and store the right
+		// child in offset, leaves store their first primitive in offset
+		typedef struct {
+			GLfloat min[3];
+			uint32_t offset;
+			GLfloat max[3];
+			uint32_t count;
+		} luna_bvh_node;
+
+		// build/refit in milliseconds, queries in queries per millisecond
+		typedef struct {
+			double build;
+			size_t node_count;
+			size_t primitive_count;
+			double query_frustum;
+			double query_ray;
+			double refit;
+		} luna_bvh_stat;
+
+		typedef struct {
+			std::vector<luna_bvh_bound> bound;
+			std::vector<luna_bvh_node> node;
+			std::vector<uint32_t> primitive;
+		} luna_bvh_tree;
+
+		typedef class _luna_bvh {
+
+			public:
+
+				~_luna_bvh(void);
+
+				static _luna_bvh *acquire(void);
+
+				uint32_t add(
+					__in const luna_vec3 &minimum,
+					__in const luna_vec3 &maximum
+					);
+
+				static luna_bvh_stat benchmark(
+					__in size_t count,
+					__in_opt size_t queries = BVH_DEF_QUERIES
+					);
+
+				void build(void);
+
+				void clear(void);
+
+				bool contains(
+					__in uint32_t id
+					);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_initialized(void);
+
+				size_t query_frustum(
+					__in const luna_frustum &frustum,
+					__out std::vector<uint32_t> &result
+					);
+
+				bool query_ray(
+					__in const luna_vec3 &origin,
+					__in const luna_vec3 &direction,
+					__in GLfloat distance_max,
+					__out uint32_t &id,
+					__out GLfloat &distance
+					);
+
+				bool query_segment(
+					__in const luna_vec3 &begin,
+					__in const luna_vec3 &end,
+					__out uint32_t &id,
+					__out GLfloat &distance
+					);
+
+				void refit(void);
+
+				void remove(
+					__in uint32_t id
+					);
+
+				void set(
+					__in uint32_t id,
+					__in const luna_vec3 &minimum,
+					__in const luna_vec3 &maximum
+					);
+
+				size_t size(void);
+
+				luna_bvh_stat stat(void);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+			protected:
+
+				_luna_bvh(void);
+
+				_luna_bvh(
+					__in const _luna_bvh &other
+					);
+
+				_luna_bvh &operator=(
+					__in const _luna_bvh &other
+					);
+
+				static void _delete(void);
+
+				static void build_node(
+					__inout luna_bvh_tree &tree,
+					__in const std::vector<luna_vec3> &centroid,
+					__in size_t begin,
+					__in size_t end
+					);
+
+				static void build_tree(
+					__inout luna_bvh_tree &tree
+					);
+
+				std::map<uint32_t, size_t>::iterator find(
+					__in uint32_t id
+					);
+
+				void prepare(void);
+
+				static void query_frustum_tree(
+					__in const luna_bvh_tree &tree,
+					__in const luna_frustum &frustum,
+					__in_opt const uint32_t *id,
+					__out std::vector<uint32_t> &result
+					);
+
+				static bool query_ray_tree(
+					__in const luna_bvh_tree &tree,
+					__in const luna_vec3 &origin,
+					__in const luna_vec3 &direction,
+					__in GLfloat distance_max,
+					__out size_t &primitive,
+					__out GLfloat &distance
+					);
+
+				static void refit_tree(
+					__inout luna_bvh_tree &tree
+					);
+
+				double m_build_time;
+
+				bool m_built;
+
+				size_t m_frustum_count;
+
+				double m_frustum_time;
+
+				std::vector<uint32_t> m_id;
+
+				std::map<uint32_t, size_t> m_index_map;
+
+				bool m_initialized;
+
+				static _luna_bvh *m_instance;
+
+				uint32_t m_next;
+
+				size_t m_ray_count;
+
+				double m_ray_time;
+
+				bool m_refit;
+
+				double m_refit_time;
+
+				luna_bvh_tree m_tree;
+
+		} luna_bvh, *luna_bvh_ptr;
+	}
+}
+
+#endif // LUNA_BVH_H_
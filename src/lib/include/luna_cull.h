@@ -0,0 +1,171 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_CULL_H_
+#define LUNA_CULL_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define CULL_BLOCK 4096
+
+		enum {
+			CULL_AABB = 0,
+			CULL_SPHERE,
+		};
+
+		typedef struct {
+			size_t index;
+			uint32_t type;
+		} luna_cull_entry;
+
+		typedef class _luna_cull {
+
+			public:
+
+				~_luna_cull(void);
+
+				static _luna_cull *acquire(void);
+
+				uint32_t add_aabb(
+					__in const luna_vec3 &minimum,
+					__in const luna_vec3 &maximum
+					);
+
+				uint32_t add_sphere(
+					__in const luna_vec3 &center,
+					__in GLfloat radius
+					);
+
+				void clear(void);
+
+				bool contains(
+					__in uint32_t id
+					);
+
+				size_t cull(
+					__in const luna_mat4 &view_projection
+					);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_initialized(void);
+
+				double ratio(void);
+
+				void remove(
+					__in uint32_t id
+					);
+
+				void set_aabb(
+					__in uint32_t id,
+					__in const luna_vec3 &minimum,
+					__in const luna_vec3 &maximum
+					);
+
+				void set_sphere(
+					__in uint32_t id,
+					__in const luna_vec3 &center,
+					__in GLfloat radius
+					);
+
+				size_t size(void);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+				const std::vector<uint32_t> &visible(void);
+
+			protected:
+
+				_luna_cull(void);
+
+				_luna_cull(
+					__in const _luna_cull &other
+					);
+
+				_luna_cull &operator=(
+					__in const _luna_cull &other
+					);
+
+				static void _delete(void);
+
+				static void cull_range(
+					__in size_t begin,
+					__in size_t end,
+					__in void *context
+					);
+
+				std::map<uint32_t, luna_cull_entry>::iterator find(
+					__in uint32_t id
+					);
+
+				std::vector<GLfloat> m_aabb_extent_x;
+
+				std::vector<GLfloat> m_aabb_extent_y;
+
+				std::vector<GLfloat> m_aabb_extent_z;
+
+				std::vector<uint32_t> m_aabb_id;
+
+				std::vector<GLfloat> m_aabb_x;
+
+				std::vector<GLfloat> m_aabb_y;
+
+				std::vector<GLfloat> m_aabb_z;
+
+				std::vector<size_t> m_block_count;
+
+				luna_frustum m_frustum;
+
+				std::map<uint32_t, luna_cull_entry> m_index_map;
+
+				bool m_initialized;
+
+				static _luna_cull *m_instance;
+
+				uint32_t m_next;
+
+				std::vector<uint32_t> m_scratch;
+
+				std::vector<uint32_t> m_sphere_id;
+
+				std::vector<GLfloat> m_sphere_radius;
+
+				std::vector<GLfloat> m_sphere_x;
+
+				std::vector<GLfloat> m_sphere_y;
+
+				std::vector<GLfloat> m_sphere_z;
+
+				size_t m_tested;
+
+				std::vector<uint32_t> m_visible;
+
+		} luna_cull, *luna_cull_ptr;
+	}
+}
+
+#endif // LUNA_CULL_H_
@@ -0,0 +1,68 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_CULL_TYPE_H_
+#define LUNA_CULL_TYPE_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define LUNA_CULL_HEADER "(CULL)"
+
+#ifndef NDEBUG
+		#define LUNA_CULL_EXCEPTION_HEADER LUNA_CULL_HEADER
+#else
+		#define LUNA_CULL_EXCEPTION_HEADER EXCEPTION_HEADER
+#endif // NDEBUG
+
+		enum {
+			LUNA_CULL_EXCEPTION_ALLOCATED = 0,
+			LUNA_CULL_EXCEPTION_INITIALIZED,
+			LUNA_CULL_EXCEPTION_INVALID,
+			LUNA_CULL_EXCEPTION_NOT_FOUND,
+			LUNA_CULL_EXCEPTION_UNINITIALIZED,
+		};
+
+		#define LUNA_CULL_EXCEPTION_MAX LUNA_CULL_EXCEPTION_UNINITIALIZED
+
+		static const std::string LUNA_CULL_EXCEPTION_STR[] = {
+			LUNA_CULL_EXCEPTION_HEADER " Failed to allocate cull component",
+			LUNA_CULL_EXCEPTION_HEADER " Cull component is initialized",
+			LUNA_CULL_EXCEPTION_HEADER " Invalid cull bounds",
+			LUNA_CULL_EXCEPTION_HEADER " Cull bounds do not exist",
+			LUNA_CULL_EXCEPTION_HEADER " Cull component is uninitialized",
+			};
+
+		#define LUNA_CULL_EXCEPTION_STRING(_TYPE_) \
+			((_TYPE_) > LUNA_CULL_EXCEPTION_MAX ? EXCEPTION_UNKNOWN : \
+			STRING_CHECK(LUNA_CULL_EXCEPTION_STR[_TYPE_]))
+
+		#define THROW_LUNA_CULL_EXCEPTION(_EXCEPT_) \
+			THROW_EXCEPTION(LUNA_CULL_EXCEPTION_STRING(_EXCEPT_))
+		#define THROW_LUNA_CULL_EXCEPTION_FORMAT(_EXCEPT_, _FORMAT_, ...) \
+			THROW_EXCEPTION_FORMAT(LUNA_CULL_EXCEPTION_STRING(_EXCEPT_), \
+			_FORMAT_, __VA_ARGS__)
+
+		class _luna_cull;
+		typedef _luna_cull luna_cull, *luna_cull_ptr;
+	}
+}
+
+#endif // LUNA_CULL_TYPE_H_
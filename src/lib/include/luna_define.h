@@ -20,14 +20,22 @@
 #ifndef LUNA_DEFINE_H_
 #define LUNA_DEFINE_H_
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdbool>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <exception>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace LUNA {
@@ -51,6 +59,12 @@ namespace LUNA {
 	#define __out_opt
 	#endif // __out_opt
 
+	#define HASH_FNV_BASIS 0xcbf29ce484222325ULL
+	#define HASH_FNV_PRIME 0x100000001b3ULL
+
+	#define HASH_FNV(_HASH_, _BYTE_) \
+		(((_HASH_) ^ (uint8_t) (_BYTE_)) * HASH_FNV_PRIME)
+
 	#define MS_PER_SEC 1000
 	#define REFERENCE_INIT 1
 
@@ -102,6 +102,8 @@ namespace LUNA {
 
 				bool is_running(void);
 
+				SDL_GLContext loader_context(void);
+
 				void set(
 					__in const luna_display_config &config
 					);
@@ -140,6 +142,8 @@ namespace LUNA {
 
 				static _luna_display *m_instance;
 
+				SDL_GLContext m_loader_context;
+
 				bool m_running;
 
 				SDL_Window *m_window;
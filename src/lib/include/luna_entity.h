@@ -0,0 +1,251 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_ENTITY_H_
+#define LUNA_ENTITY_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define ENTITY_CHUNK_SIZE 0x4000
+		#define ENTITY_COLUMN_ALIGNMENT 16
+		#define ENTITY_COMPONENT_MAX 64
+
+		#define ENTITY_MASK(_COMPONENT_) (((uint64_t) 1) << (_COMPONENT_))
+
+		typedef struct {
+			size_t count;
+			void *column[ENTITY_COMPONENT_MAX];
+			const uint32_t *entity;
+			uint32_t tick;
+		} luna_entity_view;
+
+		typedef void (*luna_entity_system_cb)(
+			__in luna_entity_view &,
+			__in void *
+			);
+
+		typedef struct {
+			size_t count;
+			std::vector<uint8_t> data;
+		} luna_entity_chunk;
+
+		typedef struct {
+			size_t capacity;
+			std::vector<luna_entity_chunk> chunk;
+			size_t count;
+			size_t offset[ENTITY_COMPONENT_MAX];
+			uint64_t signature;
+		} luna_entity_archetype;
+
+		typedef struct {
+			std::string name;
+			size_t size;
+		} luna_entity_component;
+
+		typedef struct {
+			bool alive;
+			size_t archetype;
+			size_t chunk;
+			uint32_t generation;
+			size_t row;
+		} luna_entity_record;
+
+		typedef struct {
+			luna_entity_system_cb callback;
+			void *context;
+			uint64_t read;
+			uint64_t write;
+		} luna_entity_system;
+
+		typedef class _luna_entity {
+
+			public:
+
+				~_luna_entity(void);
+
+				static _luna_entity *acquire(void);
+
+				uint32_t add(
+					__in_opt uint64_t signature = 0
+					);
+
+				uint32_t add_component(
+					__in const std::string &name,
+					__in size_t size
+					);
+
+				uint32_t add_system(
+					__in uint64_t read,
+					__in uint64_t write,
+					__in luna_entity_system_cb callback,
+					__in_opt void *context = NULL
+					);
+
+				size_t archetype_count(void);
+
+				void attach(
+					__in uint32_t id,
+					__in uint32_t component
+					);
+
+				void clear(void);
+
+				bool contains(
+					__in uint32_t id
+					);
+
+				void *data(
+					__in uint32_t id,
+					__in uint32_t component
+					);
+
+				void detach(
+					__in uint32_t id,
+					__in uint32_t component
+					);
+
+				bool has(
+					__in uint32_t id,
+					__in uint32_t component
+					);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_initialized(void);
+
+				void query(
+					__in uint64_t include,
+					__in luna_entity_system_cb callback,
+					__in_opt void *context = NULL,
+					__in_opt uint64_t exclude = 0
+					);
+
+				void remove(
+					__in uint32_t id
+					);
+
+				void remove_system(
+					__in uint32_t id
+					);
+
+				size_t size(void);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+				void update(
+					__in_opt uint32_t tick = 0
+					);
+
+			protected:
+
+				_luna_entity(void);
+
+				_luna_entity(
+					__in const _luna_entity &other
+					);
+
+				_luna_entity &operator=(
+					__in const _luna_entity &other
+					);
+
+				static void _delete(void);
+
+				void allocate_row(
+					__in size_t archetype,
+					__in uint32_t id
+					);
+
+				size_t find_archetype(
+					__in uint64_t signature
+					);
+
+				std::vector<luna_entity_record>::iterator find_entity(
+					__in uint32_t id
+					);
+
+				void free_row(
+					__in size_t archetype,
+					__in size_t chunk,
+					__in size_t row
+					);
+
+				void iterate(
+					__in uint64_t include,
+					__in uint64_t exclude,
+					__in luna_entity_system_cb callback,
+					__in void *context,
+					__in uint32_t tick
+					);
+
+				void move(
+					__in uint32_t id,
+					__in uint64_t signature
+					);
+
+				void schedule(void);
+
+				static void system_range(
+					__in size_t begin,
+					__in size_t end,
+					__in void *context
+					);
+
+				std::vector<luna_entity_archetype> m_archetype;
+
+				std::map<uint64_t, size_t> m_archetype_map;
+
+				size_t m_batch;
+
+				std::vector<luna_entity_component> m_component;
+
+				std::vector<uint32_t> m_free;
+
+				bool m_initialized;
+
+				static _luna_entity *m_instance;
+
+				std::vector<luna_entity_record> m_record;
+
+				bool m_running;
+
+				std::vector<std::vector<uint32_t>> m_schedule;
+
+				bool m_scheduled;
+
+				size_t m_size;
+
+				std::map<uint32_t, luna_entity_system> m_system_map;
+
+				uint32_t m_system_next;
+
+				uint32_t m_tick;
+
+		} luna_entity, *luna_entity_ptr;
+	}
+}
+
+#endif // LUNA_ENTITY_H_
@@ -0,0 +1,72 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_ENTITY_TYPE_H_
+#define LUNA_ENTITY_TYPE_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define LUNA_ENTITY_HEADER "(ENTITY)"
+
+#ifndef NDEBUG
+		#define LUNA_ENTITY_EXCEPTION_HEADER LUNA_ENTITY_HEADER
+#else
+		#define LUNA_ENTITY_EXCEPTION_HEADER EXCEPTION_HEADER
+#endif // NDEBUG
+
+		enum {
+			LUNA_ENTITY_EXCEPTION_ALLOCATED = 0,
+			LUNA_ENTITY_EXCEPTION_FULL,
+			LUNA_ENTITY_EXCEPTION_INITIALIZED,
+			LUNA_ENTITY_EXCEPTION_INVALID,
+			LUNA_ENTITY_EXCEPTION_NOT_FOUND,
+			LUNA_ENTITY_EXCEPTION_RUNNING,
+			LUNA_ENTITY_EXCEPTION_UNINITIALIZED,
+		};
+
+		#define LUNA_ENTITY_EXCEPTION_MAX LUNA_ENTITY_EXCEPTION_UNINITIALIZED
+
+		static const std::string LUNA_ENTITY_EXCEPTION_STR[] = {
+			LUNA_ENTITY_EXCEPTION_HEADER " Failed to allocate entity component",
+			LUNA_ENTITY_EXCEPTION_HEADER " Entity component limit reached",
+			LUNA_ENTITY_EXCEPTION_HEADER " Entity component is initialized",
+			LUNA_ENTITY_EXCEPTION_HEADER " Invalid entity component",
+			LUNA_ENTITY_EXCEPTION_HEADER " Entity does not exist",
+			LUNA_ENTITY_EXCEPTION_HEADER " Entity systems are running",
+			LUNA_ENTITY_EXCEPTION_HEADER " Entity component is uninitialized",
+			};
+
+		#define LUNA_ENTITY_EXCEPTION_STRING(_TYPE_) \
+			((_TYPE_) > LUNA_ENTITY_EXCEPTION_MAX ? EXCEPTION_UNKNOWN : \
+			STRING_CHECK(LUNA_ENTITY_EXCEPTION_STR[_TYPE_]))
+
+		#define THROW_LUNA_ENTITY_EXCEPTION(_EXCEPT_) \
+			THROW_EXCEPTION(LUNA_ENTITY_EXCEPTION_STRING(_EXCEPT_))
+		#define THROW_LUNA_ENTITY_EXCEPTION_FORMAT(_EXCEPT_, _FORMAT_, ...) \
+			THROW_EXCEPTION_FORMAT(LUNA_ENTITY_EXCEPTION_STRING(_EXCEPT_), \
+			_FORMAT_, __VA_ARGS__)
+
+		class _luna_entity;
+		typedef _luna_entity luna_entity, *luna_entity_ptr;
+	}
+}
+
+#endif // LUNA_ENTITY_TYPE_H_
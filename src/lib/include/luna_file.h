@@ -0,0 +1,86 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_FILE_H_
+#define LUNA_FILE_H_
+
+namespace LUNA {
+
+	typedef class _luna_file {
+
+		public:
+
+			_luna_file(void);
+
+			_luna_file(
+				__in const std::string &path
+				);
+
+			~_luna_file(void);
+
+			void close(void);
+
+			const char *data(void);
+
+			bool is_open(void);
+
+			void map(
+				__in const std::string &path
+				);
+
+			void open(
+				__in const std::string &path
+				);
+
+			std::string path(void);
+
+			size_t size(void);
+
+			std::string to_string(
+				__in_opt bool verbose = false
+				);
+
+		protected:
+
+			_luna_file(
+				__in const _luna_file &other
+				);
+
+			_luna_file &operator=(
+				__in const _luna_file &other
+				);
+
+			std::vector<char> m_buffer;
+
+			const char *m_data;
+
+			bool m_mapped;
+
+			bool m_open;
+
+			uint32_t m_pack;
+
+			std::string m_path;
+
+			size_t m_size;
+
+	} luna_file, *luna_file_ptr;
+}
+
+#endif // LUNA_FILE_H_
@@ -0,0 +1,59 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_FILE_TYPE_H_
+#define LUNA_FILE_TYPE_H_
+
+namespace LUNA {
+
+	#define LUNA_FILE_HEADER "(FILE)"
+
+#ifndef NDEBUG
+	#define LUNA_FILE_EXCEPTION_HEADER LUNA_FILE_HEADER
+#else
+	#define LUNA_FILE_EXCEPTION_HEADER EXCEPTION_HEADER
+#endif // NDEBUG
+
+	enum {
+		LUNA_FILE_EXCEPTION_EXTERNAL = 0,
+		LUNA_FILE_EXCEPTION_NOT_FOUND,
+	};
+
+	#define LUNA_FILE_EXCEPTION_MAX LUNA_FILE_EXCEPTION_NOT_FOUND
+
+	static const std::string LUNA_FILE_EXCEPTION_STR[] = {
+		LUNA_FILE_EXCEPTION_HEADER " External exception",
+		LUNA_FILE_EXCEPTION_HEADER " File does not exist",
+		};
+
+	#define LUNA_FILE_EXCEPTION_STRING(_TYPE_) \
+		((_TYPE_) > LUNA_FILE_EXCEPTION_MAX ? EXCEPTION_UNKNOWN : \
+		STRING_CHECK(LUNA_FILE_EXCEPTION_STR[_TYPE_]))
+
+	#define THROW_LUNA_FILE_EXCEPTION(_EXCEPT_) \
+		THROW_EXCEPTION(LUNA_FILE_EXCEPTION_STRING(_EXCEPT_))
+	#define THROW_LUNA_FILE_EXCEPTION_FORMAT(_EXCEPT_, _FORMAT_, ...) \
+		THROW_EXCEPTION_FORMAT(LUNA_FILE_EXCEPTION_STRING(_EXCEPT_), \
+		_FORMAT_, __VA_ARGS__)
+
+	class _luna_file;
+	typedef _luna_file luna_file, *luna_file_ptr;
+}
+
+#endif // LUNA_FILE_TYPE_H_
@@ -0,0 +1,230 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_GRID_H_
+#define LUNA_GRID_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define GRID_BLOCK 4096
+		#define GRID_CELL_DEF 4.f
+		#define GRID_DEF_QUERIES 1024
+		#define GRID_TABLE_MIN 64
+
+		// entities are spheres, hashed by the cell holding their center, so queries reach out
+		// by the largest radius, buckets hold their entities contiguously in the sorted arrays,
+		// cells a few times the largest radius keep neighbourhoods to a handful of buckets
+		typedef struct {
+			std::vector<uint32_t> bucket;
+			GLfloat cell;
+			std::vector<uint32_t> hash;
+			uint32_t mask;
+			std::vector<uint32_t> order;
+			std::vector<GLfloat> radius;
+			GLfloat radius_max;
+			std::vector<GLfloat> sorted_radius;
+			std::vector<GLfloat> sorted_x;
+			std::vector<GLfloat> sorted_y;
+			std::vector<GLfloat> sorted_z;
+			std::vector<GLfloat> x;
+			std::vector<GLfloat> y;
+			std::vector<GLfloat> z;
+		} luna_grid_table;
+
+		typedef struct {
+			const uint32_t *id;
+			std::vector<std::vector<std::pair<uint32_t, uint32_t>>> pair;
+			const luna_grid_table *table;
+		} luna_grid_pass;
+
+		// build/pairs in milliseconds, queries in queries per millisecond
+		typedef struct {
+			double build;
+			size_t count;
+			size_t pair_count;
+			double pairs;
+			double query_aabb;
+			double query_radius;
+			size_t workers;
+		} luna_grid_stat;
+
+		typedef class _luna_grid {
+
+			public:
+
+				~_luna_grid(void);
+
+				static _luna_grid *acquire(void);
+
+				uint32_t add(
+					__in const luna_vec3 &position,
+					__in GLfloat radius
+					);
+
+				static luna_grid_stat benchmark(
+					__in size_t count,
+					__in_opt size_t queries = GRID_DEF_QUERIES
+					);
+
+				void build(void);
+
+				GLfloat cell_size(void);
+
+				void clear(void);
+
+				bool contains(
+					__in uint32_t id
+					);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_initialized(void);
+
+				size_t query_aabb(
+					__in const luna_vec3 &minimum,
+					__in const luna_vec3 &maximum,
+					__out std::vector<uint32_t> &result
+					);
+
+				size_t query_pairs(
+					__out std::vector<std::pair<uint32_t, uint32_t>> &result
+					);
+
+				size_t query_radius(
+					__in const luna_vec3 &center,
+					__in GLfloat radius,
+					__out std::vector<uint32_t> &result
+					);
+
+				void remove(
+					__in uint32_t id
+					);
+
+				void set(
+					__in uint32_t id,
+					__in const luna_vec3 &position,
+					__in GLfloat radius
+					);
+
+				void set_cell_size(
+					__in GLfloat size
+					);
+
+				size_t size(void);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+			protected:
+
+				_luna_grid(void);
+
+				_luna_grid(
+					__in const _luna_grid &other
+					);
+
+				_luna_grid &operator=(
+					__in const _luna_grid &other
+					);
+
+				static void _delete(void);
+
+				static void build_gather_range(
+					__in size_t begin,
+					__in size_t end,
+					__in void *context
+					);
+
+				static void build_hash_range(
+					__in size_t begin,
+					__in size_t end,
+					__in void *context
+					);
+
+				static void build_table(
+					__inout luna_grid_table &table
+					);
+
+				std::map<uint32_t, size_t>::iterator find(
+					__in uint32_t id
+					);
+
+				static void pairs_range(
+					__in size_t begin,
+					__in size_t end,
+					__in void *context
+					);
+
+				void prepare(void);
+
+				static void query_aabb_table(
+					__in const luna_grid_table &table,
+					__in const luna_vec3 &minimum,
+					__in const luna_vec3 &maximum,
+					__in_opt const uint32_t *id,
+					__inout std::vector<uint32_t> &scratch,
+					__out std::vector<uint32_t> &result
+					);
+
+				static void query_pairs_table(
+					__in const luna_grid_table &table,
+					__in_opt const uint32_t *id,
+					__inout luna_grid_pass &pass,
+					__out std::vector<std::pair<uint32_t, uint32_t>> &result
+					);
+
+				static void query_radius_table(
+					__in const luna_grid_table &table,
+					__in const luna_vec3 &center,
+					__in GLfloat radius,
+					__in_opt const uint32_t *id,
+					__inout std::vector<uint32_t> &scratch,
+					__out std::vector<uint32_t> &result
+					);
+
+				bool m_built;
+
+				std::vector<uint32_t> m_id;
+
+				std::map<uint32_t, size_t> m_index_map;
+
+				bool m_initialized;
+
+				static _luna_grid *m_instance;
+
+				uint32_t m_next;
+
+				luna_grid_pass m_pass;
+
+				std::vector<uint32_t> m_scratch;
+
+				luna_grid_table m_table;
+
+		} luna_grid, *luna_grid_ptr;
+	}
+}
+
+#endif // LUNA_GRID_H_
@@ -117,6 +117,15 @@ namespace LUNA {
 
 				bool is_initialized(void);
 
+				bool is_recording(void);
+
+				bool is_replaying(void);
+
+				bool poll(
+					__in uint32_t tick,
+					__out SDL_Event &event
+					);
+
 				void remove(
 					__in const SDL_EventType &type
 					);
@@ -127,6 +136,18 @@ namespace LUNA {
 
 				size_t size(void);
 
+				void start_record(
+					__in const std::string &path
+					);
+
+				void start_replay(
+					__in const std::string &path
+					);
+
+				void stop_record(void);
+
+				void stop_replay(void);
+
 				std::string to_string(
 					__in_opt bool verbose = false
 					);
@@ -153,6 +174,22 @@ namespace LUNA {
 
 				static _luna_input *m_instance;
 
+				std::vector<std::pair<uint32_t, SDL_Event>> m_record;
+
+				std::string m_record_path;
+
+				uint32_t m_record_tick;
+
+				bool m_recording;
+
+				std::vector<std::pair<uint32_t, SDL_Event>> m_replay;
+
+				size_t m_replay_position;
+
+				uint32_t m_replay_tick;
+
+				bool m_replaying;
+
 		} luna_input, *luna_input_ptr;
 	}
 }
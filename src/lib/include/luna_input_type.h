@@ -34,9 +34,13 @@ namespace LUNA {
 
 		enum {
 			LUNA_INPUT_EXCEPTION_ALLOCATED = 0,
+			LUNA_INPUT_EXCEPTION_FILE_NOT_FOUND,
 			LUNA_INPUT_EXCEPTION_INITIALIZED,
 			LUNA_INPUT_EXCEPTION_INVALID,
+			LUNA_INPUT_EXCEPTION_MALFORMED,
 			LUNA_INPUT_EXCEPTION_NOT_FOUND,
+			LUNA_INPUT_EXCEPTION_RECORDING,
+			LUNA_INPUT_EXCEPTION_REPLAYING,
 			LUNA_INPUT_EXCEPTION_UNINITIALIZED,
 		};
 
@@ -44,9 +48,13 @@ namespace LUNA {
 
 		static const std::string LUNA_INPUT_EXCEPTION_STR[] = {
 			LUNA_INPUT_EXCEPTION_HEADER " Failed to allocate input component",
+			LUNA_INPUT_EXCEPTION_HEADER " File does not exist",
 			LUNA_INPUT_EXCEPTION_HEADER " Input component is initialized",
 			LUNA_INPUT_EXCEPTION_HEADER " Invalid input callback",
+			LUNA_INPUT_EXCEPTION_HEADER " Malformed input recording",
 			LUNA_INPUT_EXCEPTION_HEADER " Input does not exist",
+			LUNA_INPUT_EXCEPTION_HEADER " Input component is recording",
+			LUNA_INPUT_EXCEPTION_HEADER " Input component is replaying",
 			LUNA_INPUT_EXCEPTION_HEADER " Input component is uninitialized",
 			};
 
@@ -0,0 +1,122 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_JOB_H_
+#define LUNA_JOB_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define JOB_DEF_GRAIN 1
+		#define JOB_MIN_WORKERS 1
+
+		typedef void (*luna_job_cb)(
+			__in void *
+			);
+
+		typedef void (*luna_job_range_cb)(
+			__in size_t,
+			__in size_t,
+			__in void *
+			);
+
+		typedef class _luna_job {
+
+			public:
+
+				~_luna_job(void);
+
+				static _luna_job *acquire(void);
+
+				void add(
+					__in luna_job_cb callback,
+					__in_opt void *context = NULL
+					);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_initialized(void);
+
+				size_t pending(void);
+
+				void run(
+					__in size_t count,
+					__in luna_job_range_cb callback,
+					__in_opt void *context = NULL,
+					__in_opt size_t grain = JOB_DEF_GRAIN
+					);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+				void wait(void);
+
+				size_t worker_count(void);
+
+			protected:
+
+				_luna_job(void);
+
+				_luna_job(
+					__in const _luna_job &other
+					);
+
+				_luna_job &operator=(
+					__in const _luna_job &other
+					);
+
+				static void _delete(void);
+
+				static void run_range(
+					__in void *context
+					);
+
+				static void worker(
+					__in _luna_job *instance
+					);
+
+				size_t m_active;
+
+				std::condition_variable m_condition;
+
+				std::condition_variable m_condition_idle;
+
+				bool m_initialized;
+
+				static _luna_job *m_instance;
+
+				std::mutex m_lock;
+
+				std::deque<std::pair<luna_job_cb, void *>> m_queue;
+
+				bool m_running;
+
+				std::vector<std::thread> m_worker;
+
+		} luna_job, *luna_job_ptr;
+	}
+}
+
+#endif // LUNA_JOB_H_
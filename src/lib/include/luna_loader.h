@@ -0,0 +1,229 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LUNA_LOADER_H_
+#define LUNA_LOADER_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define LOADER_BUDGET_DEF 2.0
+		#define LOADER_CHUNK_SIZE 0x40000
+		#define LOADER_PAGE_SIZE 0x1000
+
+		typedef enum {
+			LUNA_LOADER_PRIORITY_LOW = 0,
+			LUNA_LOADER_PRIORITY_NORMAL,
+			LUNA_LOADER_PRIORITY_HIGH,
+		} luna_loader_priority;
+
+		#define LUNA_LOADER_PRIORITY_MAX LUNA_LOADER_PRIORITY_HIGH
+
+		typedef enum {
+			LUNA_LOADER_STATE_NONE = 0,
+			LUNA_LOADER_STATE_QUEUED,
+			LUNA_LOADER_STATE_LOADING,
+			LUNA_LOADER_STATE_LOADED,
+			LUNA_LOADER_STATE_UPLOADING,
+			LUNA_LOADER_STATE_FAILED,
+		} luna_loader_state;
+
+		typedef void (*luna_loader_load_cb)(
+			__inout struct _luna_loader_request &
+			);
+
+		typedef bool (*luna_loader_finalize_cb)(
+			__inout struct _luna_loader_request &
+			);
+
+		typedef struct _luna_loader_request {
+			bool cancelled;
+			void *context;
+			std::vector<uint8_t> data;
+			std::string error;
+			GLsync fence;
+			luna_file file;
+			luna_loader_finalize_cb finalize;
+			uint32_t id;
+			luna_loader_load_cb load;
+			GLuint object;
+			uint64_t order;
+			std::string path;
+			luna_loader_priority priority;
+			size_t progress;
+			bool shared;
+			luna_loader_state state;
+			GLenum usage;
+		} luna_loader_request;
+
+		typedef class _luna_loader {
+
+			public:
+
+				~_luna_loader(void);
+
+				static _luna_loader *acquire(void);
+
+				uint32_t add(
+					__in const std::string &path,
+					__in luna_loader_finalize_cb finalize,
+					__in_opt void *context = NULL,
+					__in_opt luna_loader_priority priority = LUNA_LOADER_PRIORITY_NORMAL,
+					__in_opt luna_loader_load_cb load = NULL,
+					__in_opt bool shared = false
+					);
+
+				uint32_t add_buffer(
+					__in const std::string &path,
+					__in GLuint buffer,
+					__in_opt GLenum usage = GL_STATIC_DRAW,
+					__in_opt luna_loader_priority priority = LUNA_LOADER_PRIORITY_NORMAL
+					);
+
+				bool cancel(
+					__in uint32_t id
+					);
+
+				void clear(void);
+
+				bool contains(
+					__in uint32_t id
+					);
+
+				std::string error(
+					__in uint32_t id
+					);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_failed(
+					__in uint32_t id
+					);
+
+				bool is_initialized(void);
+
+				bool is_running(void);
+
+				size_t pending(void);
+
+				void start(
+					__in SDL_Window *window,
+					__in SDL_GLContext context
+					);
+
+				luna_loader_state state(
+					__in uint32_t id
+					);
+
+				void stop(void);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+				size_t update(
+					__in_opt double budget = LOADER_BUDGET_DEF
+					);
+
+			protected:
+
+				_luna_loader(void);
+
+				_luna_loader(
+					__in const _luna_loader &other
+					);
+
+				_luna_loader &operator=(
+					__in const _luna_loader &other
+					);
+
+				static void _delete(void);
+
+				static bool finalize_buffer(
+					__inout luna_loader_request &request
+					);
+
+				static void load(
+					__inout luna_loader_request &request
+					);
+
+				static void pump(
+					__in void *context
+					);
+
+				static void release(
+					__in luna_loader_request *request
+					);
+
+				uint32_t submit(
+					__in const std::string &path,
+					__in luna_loader_finalize_cb finalize,
+					__in void *context,
+					__in luna_loader_priority priority,
+					__in luna_loader_load_cb load,
+					__in GLuint object,
+					__in GLenum usage,
+					__in bool shared
+					);
+
+				static void upload(
+					__in _luna_loader *instance
+					);
+
+				SDL_GLContext m_context;
+
+				size_t m_finalized;
+
+				bool m_initialized;
+
+				static _luna_loader *m_instance;
+
+				std::map<uint64_t, luna_loader_request *> m_loaded;
+
+				std::mutex m_lock;
+
+				uint32_t m_next;
+
+				uint64_t m_order;
+
+				std::atomic<size_t> m_pending;
+
+				std::map<uint64_t, luna_loader_request *> m_queue;
+
+				std::map<uint32_t, luna_loader_request *> m_request_map;
+
+				std::map<uint64_t, luna_loader_request *> m_upload;
+
+				std::condition_variable m_upload_condition;
+
+				bool m_upload_running;
+
+				std::thread m_upload_thread;
+
+				SDL_Window *m_window;
+
+		} luna_loader, *luna_loader_ptr;
+	}
+}
+
+#endif // LUNA_LOADER_H_
@@ -0,0 +1,68 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_LOADER_TYPE_H_
+#define LUNA_LOADER_TYPE_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define LUNA_LOADER_HEADER "(LOADER)"
+
+#ifndef NDEBUG
+		#define LUNA_LOADER_EXCEPTION_HEADER LUNA_LOADER_HEADER
+#else
+		#define LUNA_LOADER_EXCEPTION_HEADER EXCEPTION_HEADER
+#endif // NDEBUG
+
+		enum {
+			LUNA_LOADER_EXCEPTION_ALLOCATED = 0,
+			LUNA_LOADER_EXCEPTION_EXTERNAL,
+			LUNA_LOADER_EXCEPTION_INITIALIZED,
+			LUNA_LOADER_EXCEPTION_STARTED,
+			LUNA_LOADER_EXCEPTION_UNINITIALIZED,
+		};
+
+		#define LUNA_LOADER_EXCEPTION_MAX LUNA_LOADER_EXCEPTION_UNINITIALIZED
+
+		static const std::string LUNA_LOADER_EXCEPTION_STR[] = {
+			LUNA_LOADER_EXCEPTION_HEADER " Failed to allocate loader component",
+			LUNA_LOADER_EXCEPTION_HEADER " External exception",
+			LUNA_LOADER_EXCEPTION_HEADER " Loader component is initialized",
+			LUNA_LOADER_EXCEPTION_HEADER " Loader thread is running",
+			LUNA_LOADER_EXCEPTION_HEADER " Loader component is uninitialized",
+			};
+
+		#define LUNA_LOADER_EXCEPTION_STRING(_TYPE_) \
+			((_TYPE_) > LUNA_LOADER_EXCEPTION_MAX ? EXCEPTION_UNKNOWN : \
+			STRING_CHECK(LUNA_LOADER_EXCEPTION_STR[_TYPE_]))
+
+		#define THROW_LUNA_LOADER_EXCEPTION(_EXCEPT_) \
+			THROW_EXCEPTION(LUNA_LOADER_EXCEPTION_STRING(_EXCEPT_))
+		#define THROW_LUNA_LOADER_EXCEPTION_FORMAT(_EXCEPT_, _FORMAT_, ...) \
+			THROW_EXCEPTION_FORMAT(LUNA_LOADER_EXCEPTION_STRING(_EXCEPT_), \
+			_FORMAT_, __VA_ARGS__)
+
+		class _luna_loader;
+		typedef _luna_loader luna_loader, *luna_loader_ptr;
+	}
+}
+
+#endif // LUNA_LOADER_TYPE_H_
@@ -0,0 +1,244 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_MATH_H_
+#define LUNA_MATH_H_
+
+namespace LUNA {
+
+	#define MATH_ALIGNMENT 16
+	#define MATH_EPSILON 0.000001f
+	#define MATH_PI 3.14159265358979323846f
+
+	typedef struct alignas(MATH_ALIGNMENT) {
+		GLfloat x, y, z, pad;
+	} luna_vec3;
+
+	typedef struct alignas(MATH_ALIGNMENT) {
+		GLfloat x, y, z, w;
+	} luna_vec4;
+
+	typedef struct alignas(MATH_ALIGNMENT) {
+		GLfloat x, y, z, w;
+	} luna_quat;
+
+	// column-major, matching opengl
+	typedef struct alignas(MATH_ALIGNMENT) {
+		GLfloat m[16];
+	} luna_mat4;
+
+	// planes as (a, b, c, d), normals point inward and are normalized
+	typedef struct {
+		luna_vec4 plane[6];
+	} luna_frustum;
+
+	typedef struct {
+		GLfloat *x;
+		GLfloat *y;
+		GLfloat *z;
+	} luna_vec3_soa;
+
+	// nanoseconds per element, simd against the scalar reference
+	typedef struct {
+		double inverse;
+		double inverse_reference;
+		double multiply;
+		double multiply_reference;
+		double slerp;
+		double slerp_reference;
+		double transform;
+		double transform_reference;
+	} luna_math_stat;
+
+	luna_math_stat luna_math_benchmark(
+		__in_opt size_t count = 4096,
+		__in_opt size_t iterations = 16
+		);
+
+	std::string luna_math_stat_as_string(
+		__in const luna_math_stat &stat
+		);
+
+	void luna_frustum_from_matrix(
+		__in const luna_mat4 &matrix,
+		__out luna_frustum &out
+		);
+
+	void luna_lerp_batch(
+		__in const GLfloat *left,
+		__in const GLfloat *right,
+		__in GLfloat t,
+		__out GLfloat *out,
+		__in size_t count
+		);
+
+	void luna_mat4_from_trs(
+		__in const luna_vec3 &translation,
+		__in const luna_quat &rotation,
+		__in const luna_vec3 &scale,
+		__out luna_mat4 &out
+		);
+
+	void luna_mat4_identity(
+		__out luna_mat4 &out
+		);
+
+	bool luna_mat4_inverse(
+		__in const luna_mat4 &matrix,
+		__out luna_mat4 &out
+		);
+
+	bool luna_mat4_inverse_reference(
+		__in const luna_mat4 &matrix,
+		__out luna_mat4 &out
+		);
+
+	void luna_mat4_multiply(
+		__in const luna_mat4 &left,
+		__in const luna_mat4 &right,
+		__out luna_mat4 &out
+		);
+
+	void luna_mat4_multiply_batch(
+		__in const luna_mat4 *left,
+		__in const luna_mat4 *right,
+		__out luna_mat4 *out,
+		__in size_t count
+		);
+
+	void luna_mat4_multiply_reference(
+		__in const luna_mat4 &left,
+		__in const luna_mat4 &right,
+		__out luna_mat4 &out
+		);
+
+	void luna_mat4_orthographic(
+		__in GLfloat left,
+		__in GLfloat right,
+		__in GLfloat bottom,
+		__in GLfloat top,
+		__in GLfloat near,
+		__in GLfloat far,
+		__out luna_mat4 &out
+		);
+
+	void luna_mat4_perspective(
+		__in GLfloat fov,
+		__in GLfloat aspect,
+		__in GLfloat near,
+		__in GLfloat far,
+		__out luna_mat4 &out
+		);
+
+	void luna_mat4_transform(
+		__in const luna_mat4 &matrix,
+		__in const luna_vec4 &vector,
+		__out luna_vec4 &out
+		);
+
+	void luna_mat4_transform_batch(
+		__in const luna_mat4 &matrix,
+		__in const luna_vec3_soa &in,
+		__out const luna_vec3_soa &out,
+		__in size_t count
+		);
+
+	void luna_mat4_transform_batch_reference(
+		__in const luna_mat4 &matrix,
+		__in const luna_vec3_soa &in,
+		__out const luna_vec3_soa &out,
+		__in size_t count
+		);
+
+	void luna_mat4_transpose(
+		__in const luna_mat4 &matrix,
+		__out luna_mat4 &out
+		);
+
+	void luna_quat_from_axis_angle(
+		__in const luna_vec3 &axis,
+		__in GLfloat angle,
+		__out luna_quat &out
+		);
+
+	void luna_quat_identity(
+		__out luna_quat &out
+		);
+
+	void luna_quat_multiply(
+		__in const luna_quat &left,
+		__in const luna_quat &right,
+		__out luna_quat &out
+		);
+
+	void luna_quat_slerp(
+		__in const luna_quat &left,
+		__in const luna_quat &right,
+		__in GLfloat t,
+		__out luna_quat &out
+		);
+
+	void luna_quat_slerp_reference(
+		__in const luna_quat &left,
+		__in const luna_quat &right,
+		__in GLfloat t,
+		__out luna_quat &out
+		);
+
+	void luna_vec3_cross(
+		__in const luna_vec3 &left,
+		__in const luna_vec3 &right,
+		__out luna_vec3 &out
+		);
+
+	GLfloat luna_vec3_dot(
+		__in const luna_vec3 &left,
+		__in const luna_vec3 &right
+		);
+
+	GLfloat luna_vec3_length(
+		__in const luna_vec3 &vector
+		);
+
+	void luna_vec3_make(
+		__in GLfloat x,
+		__in GLfloat y,
+		__in GLfloat z,
+		__out luna_vec3 &out
+		);
+
+	void luna_vec3_normalize(
+		__in const luna_vec3 &vector,
+		__out luna_vec3 &out
+		);
+
+	GLfloat luna_vec4_dot(
+		__in const luna_vec4 &left,
+		__in const luna_vec4 &right
+		);
+
+	void luna_vec4_lerp(
+		__in const luna_vec4 &left,
+		__in const luna_vec4 &right,
+		__in GLfloat t,
+		__out luna_vec4 &out
+		);
+}
+
+#endif // LUNA_MATH_H_
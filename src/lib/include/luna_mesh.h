@@ -0,0 +1,301 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_MESH_H_
+#define LUNA_MESH_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define MESH_ALIGN 0x10
+		#define MESH_ATTRIBUTE_NORMAL 1
+		#define MESH_ATTRIBUTE_POSITION 0
+		#define MESH_ATTRIBUTE_UV 2
+		#define MESH_CACHE_SIZE 32
+		#define MESH_FIFO_SIZE 16
+		#define MESH_FLAG_UV 0x1
+		#define MESH_LOD_BLOCK 4096
+		#define MESH_LOD_HYSTERESIS 0.25f
+		#define MESH_LOD_MAX 4
+		#define MESH_LOD_NEAR 0.001f
+		#define MESH_LOD_RATIO 0.5f
+		#define MESH_LOD_THRESHOLD_DEF 1.f
+		#define MESH_MAGIC 0x48534d4c
+		#define MESH_VERSION 2
+
+		// positions are unorm over the mesh bounds, normals snorm and uvs half float
+		typedef struct {
+			uint16_t position[4];
+			int8_t normal[4];
+			uint16_t uv[2];
+		} luna_mesh_vertex;
+
+		typedef struct {
+			uint32_t magic;
+			uint32_t version;
+			uint32_t flags;
+			uint32_t index_size;
+			uint32_t vertex_count;
+			uint32_t index_count;
+			uint32_t lod_count;
+			uint32_t reserved;
+			uint64_t vertex;
+			uint64_t index;
+			uint64_t lod;
+			float minimum[3];
+			float maximum[3];
+		} luna_mesh_header;
+
+		// levels are index ranges over the shared vertices, with their object space error
+		typedef struct {
+			uint32_t offset;
+			uint32_t count;
+			float error;
+			uint32_t reserved;
+		} luna_mesh_lod;
+
+		typedef struct {
+			size_t index;
+			GLuint mesh;
+		} luna_mesh_lod_entry;
+
+		typedef struct {
+			GLuint index_buffer;
+			GLsizei index_count;
+			GLenum index_type;
+			std::vector<luna_mesh_lod> lod;
+			luna_vec3 maximum;
+			luna_vec3 minimum;
+			size_t reference;
+			GLuint vertex_buffer;
+			GLsizei vertex_count;
+		} luna_mesh_entry;
+
+		typedef struct {
+			double acmr;
+			double acmr_input;
+			double atvr;
+			double atvr_input;
+			size_t index_count;
+			std::vector<luna_mesh_lod> lod;
+			size_t size;
+			size_t size_input;
+			size_t vertex_count;
+		} luna_mesh_stat;
+
+		typedef class _luna_mesh {
+
+			public:
+
+				~_luna_mesh(void);
+
+				static _luna_mesh *acquire(void);
+
+				static double acmr(
+					__in const std::vector<uint32_t> &index,
+					__in_opt size_t cache = MESH_FIFO_SIZE
+					);
+
+				GLuint add(
+					__in const std::string &path
+					);
+
+				uint32_t add_lod(
+					__in GLuint id,
+					__in const luna_vec3 &center,
+					__in GLfloat radius
+					);
+
+				void bind(
+					__in_opt GLuint id = 0
+					);
+
+				void bounds(
+					__in GLuint id,
+					__out luna_vec3 &minimum,
+					__out luna_vec3 &maximum
+					);
+
+				static luna_mesh_stat build(
+					__in const std::string &path,
+					__in const std::string &input,
+					__in_opt size_t levels = MESH_LOD_MAX
+					);
+
+				void clear(void);
+
+				bool contains(
+					__in GLuint id
+					);
+
+				size_t decrement_reference(
+					__in GLuint id
+					);
+
+				void draw(
+					__in GLuint id,
+					__in_opt uint32_t level = 0
+					);
+
+				size_t increment_reference(
+					__in GLuint id
+					);
+
+				GLsizei index_count(
+					__in GLuint id,
+					__in_opt uint32_t level = 0
+					);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_initialized(void);
+
+				uint32_t level(
+					__in uint32_t id
+					);
+
+				uint32_t lod_count(
+					__in GLuint id
+					);
+
+				static void optimize(
+					__inout std::vector<uint32_t> &index,
+					__in size_t vertex_count
+					);
+
+				static void optimize_overdraw(
+					__inout std::vector<uint32_t> &index,
+					__in const std::vector<float> &position
+					);
+
+				size_t reference_count(
+					__in GLuint id
+					);
+
+				void remove(
+					__in GLuint id
+					);
+
+				void remove_lod(
+					__in uint32_t id
+					);
+
+				size_t select(
+					__in const luna_vec3 &eye,
+					__in GLfloat scale,
+					__in_opt GLfloat threshold = MESH_LOD_THRESHOLD_DEF
+					);
+
+				void set_lod(
+					__in uint32_t id,
+					__in const luna_vec3 &center,
+					__in GLfloat radius
+					);
+
+				static float simplify(
+					__in const std::vector<uint32_t> &index,
+					__in const std::vector<float> &position,
+					__in size_t target,
+					__out std::vector<uint32_t> &result
+					);
+
+				size_t size(void);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+			protected:
+
+				_luna_mesh(void);
+
+				_luna_mesh(
+					__in const _luna_mesh &other
+					);
+
+				_luna_mesh &operator=(
+					__in const _luna_mesh &other
+					);
+
+				static void _delete(void);
+
+				std::map<GLuint, luna_mesh_entry>::iterator find(
+					__in GLuint id
+					);
+
+				std::map<uint32_t, luna_mesh_lod_entry>::iterator find_lod(
+					__in uint32_t id
+					);
+
+				void release(
+					__in std::map<GLuint, luna_mesh_entry>::iterator iter
+					);
+
+				static void select_range(
+					__in size_t begin,
+					__in size_t end,
+					__in void *context
+					);
+
+				static void validate(
+					__in luna_file &file
+					);
+
+				bool m_initialized;
+
+				static _luna_mesh *m_instance;
+
+				std::vector<size_t> m_lod_changed;
+
+				std::vector<GLfloat> m_lod_error[MESH_LOD_MAX];
+
+				luna_vec3 m_lod_eye;
+
+				std::vector<uint32_t> m_lod_id;
+
+				std::vector<uint32_t> m_lod_level;
+
+				std::map<uint32_t, luna_mesh_lod_entry> m_lod_map;
+
+				std::vector<GLfloat> m_lod_radius;
+
+				GLfloat m_lod_scale;
+
+				GLfloat m_lod_threshold;
+
+				std::vector<GLfloat> m_lod_x;
+
+				std::vector<GLfloat> m_lod_y;
+
+				std::vector<GLfloat> m_lod_z;
+
+				std::map<GLuint, luna_mesh_entry> m_mesh_map;
+
+				uint32_t m_next;
+
+		} luna_mesh, *luna_mesh_ptr;
+	}
+}
+
+#endif // LUNA_MESH_H_
@@ -0,0 +1,70 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_MESH_TYPE_H_
+#define LUNA_MESH_TYPE_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define LUNA_MESH_HEADER "(MESH)"
+
+#ifndef NDEBUG
+		#define LUNA_MESH_EXCEPTION_HEADER LUNA_MESH_HEADER
+#else
+		#define LUNA_MESH_EXCEPTION_HEADER EXCEPTION_HEADER
+#endif // NDEBUG
+
+		enum {
+			LUNA_MESH_EXCEPTION_ALLOCATED = 0,
+			LUNA_MESH_EXCEPTION_EXTERNAL,
+			LUNA_MESH_EXCEPTION_INITIALIZED,
+			LUNA_MESH_EXCEPTION_INVALID,
+			LUNA_MESH_EXCEPTION_NOT_FOUND,
+			LUNA_MESH_EXCEPTION_UNINITIALIZED,
+		};
+
+		#define LUNA_MESH_EXCEPTION_MAX LUNA_MESH_EXCEPTION_UNINITIALIZED
+
+		static const std::string LUNA_MESH_EXCEPTION_STR[] = {
+			LUNA_MESH_EXCEPTION_HEADER " Failed to allocate mesh component",
+			LUNA_MESH_EXCEPTION_HEADER " External exception",
+			LUNA_MESH_EXCEPTION_HEADER " Mesh component is initialized",
+			LUNA_MESH_EXCEPTION_HEADER " Malformed mesh",
+			LUNA_MESH_EXCEPTION_HEADER " Mesh does not exist",
+			LUNA_MESH_EXCEPTION_HEADER " Mesh component is uninitialized",
+			};
+
+		#define LUNA_MESH_EXCEPTION_STRING(_TYPE_) \
+			((_TYPE_) > LUNA_MESH_EXCEPTION_MAX ? EXCEPTION_UNKNOWN : \
+			STRING_CHECK(LUNA_MESH_EXCEPTION_STR[_TYPE_]))
+
+		#define THROW_LUNA_MESH_EXCEPTION(_EXCEPT_) \
+			THROW_EXCEPTION(LUNA_MESH_EXCEPTION_STRING(_EXCEPT_))
+		#define THROW_LUNA_MESH_EXCEPTION_FORMAT(_EXCEPT_, _FORMAT_, ...) \
+			THROW_EXCEPTION_FORMAT(LUNA_MESH_EXCEPTION_STRING(_EXCEPT_), \
+			_FORMAT_, __VA_ARGS__)
+
+		class _luna_mesh;
+		typedef _luna_mesh luna_mesh, *luna_mesh_ptr;
+	}
+}
+
+#endif // LUNA_MESH_TYPE_H_
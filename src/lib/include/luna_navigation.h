@@ -0,0 +1,251 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_NAVIGATION_H_
+#define LUNA_NAVIGATION_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define NAVIGATION_CELL_MAX 0x100000
+		#define NAVIGATION_COST_BLOCKED UINT8_MAX
+		#define NAVIGATION_COST_DEF 1
+		#define NAVIGATION_DEF_CELL 1.f
+		#define NAVIGATION_DEF_HEIGHT 128
+		#define NAVIGATION_DEF_WIDTH 128
+		#define NAVIGATION_SECTOR 16
+
+		enum {
+			NAVIGATION_DIRECTION_EAST = 0,
+			NAVIGATION_DIRECTION_NORTH_EAST,
+			NAVIGATION_DIRECTION_NORTH,
+			NAVIGATION_DIRECTION_NORTH_WEST,
+			NAVIGATION_DIRECTION_WEST,
+			NAVIGATION_DIRECTION_SOUTH_WEST,
+			NAVIGATION_DIRECTION_SOUTH,
+			NAVIGATION_DIRECTION_SOUTH_EAST,
+			NAVIGATION_DIRECTION_GOAL,
+			NAVIGATION_DIRECTION_NONE,
+		};
+
+		#define NAVIGATION_DIRECTION_MAX NAVIGATION_DIRECTION_NONE
+
+		// the integration field holds the cost to the goal, the flow field the neighbour to step 
+		// toward, fields are immutable once built so workers and sampling can share them
+		typedef struct {
+			std::vector<uint8_t> direction;
+			std::vector<uint32_t> integration;
+		} luna_navigation_data;
+
+		typedef struct {
+			std::shared_ptr<const luna_navigation_data> data;
+			std::set<uint32_t> dirty;
+			uint32_t goal;
+			bool pending;
+			size_t reference;
+			bool rebuild;
+			size_t serial;
+		} luna_navigation_field;
+
+		typedef struct {
+			std::shared_ptr<const std::vector<uint8_t>> cost;
+			uint32_t goal;
+			size_t height;
+			uint32_t id;
+			std::shared_ptr<const luna_navigation_data> previous;
+			std::shared_ptr<luna_navigation_data> result;
+			std::vector<uint32_t> sector;
+			size_t serial;
+			size_t width;
+		} luna_navigation_request;
+
+		typedef class _luna_navigation {
+
+			public:
+
+				~_luna_navigation(void);
+
+				static _luna_navigation *acquire(void);
+
+				uint32_t add(
+					__in const luna_vec3 &target
+					);
+
+				GLfloat cell_size(void);
+
+				void clear(void);
+
+				bool contains(
+					__in uint32_t id
+					);
+
+				uint8_t cost(
+					__in const luna_vec3 &position
+					);
+
+				size_t height(void);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_initialized(void);
+
+				bool is_ready(
+					__in uint32_t id
+					);
+
+				size_t pending(void);
+
+				size_t reference_count(
+					__in uint32_t id
+					);
+
+				void remove(
+					__in uint32_t id
+					);
+
+				bool sample(
+					__in uint32_t id,
+					__in const luna_vec3 &position,
+					__out luna_vec3 &direction
+					);
+
+				size_t sample(
+					__in uint32_t id,
+					__in const std::vector<luna_vec3> &position,
+					__out std::vector<luna_vec3> &direction
+					);
+
+				void set_cost(
+					__in const luna_vec3 &position,
+					__in uint8_t cost
+					);
+
+				void set_cost(
+					__in const luna_vec3 &minimum,
+					__in const luna_vec3 &maximum,
+					__in uint8_t cost
+					);
+
+				void set_grid(
+					__in size_t width,
+					__in size_t height,
+					__in_opt GLfloat cell_size = NAVIGATION_DEF_CELL,
+					__in_opt const luna_vec3 &origin = luna_vec3()
+					);
+
+				size_t size(void);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+				size_t update(void);
+
+				size_t width(void);
+
+			protected:
+
+				_luna_navigation(void);
+
+				_luna_navigation(
+					__in const _luna_navigation &other
+					);
+
+				_luna_navigation &operator=(
+					__in const _luna_navigation &other
+					);
+
+				static void _delete(void);
+
+				bool cell(
+					__in const luna_vec3 &position,
+					__out size_t &x,
+					__out size_t &y
+					);
+
+				size_t collect(void);
+
+				void dispatch(
+					__in uint32_t id,
+					__inout luna_navigation_field &field
+					);
+
+				std::map<uint32_t, luna_navigation_field>::iterator find(
+					__in uint32_t id
+					);
+
+				static void generate(
+					__inout luna_navigation_request &request
+					);
+
+				void mark(
+					__in size_t minimum_x,
+					__in size_t minimum_y,
+					__in size_t maximum_x,
+					__in size_t maximum_y
+					);
+
+				static void run(
+					__in void *context
+					);
+
+				GLfloat m_cell;
+
+				std::vector<uint8_t> m_cost;
+
+				std::shared_ptr<const std::vector<uint8_t>> m_cost_snapshot;
+
+				std::deque<luna_navigation_request *> m_complete;
+
+				std::condition_variable m_complete_condition;
+
+				std::mutex m_complete_lock;
+
+				std::set<uint32_t> m_dirty;
+
+				std::map<uint32_t, luna_navigation_field> m_field_map;
+
+				size_t m_height;
+
+				bool m_initialized;
+
+				static _luna_navigation *m_instance;
+
+				uint32_t m_next;
+
+				luna_vec3 m_origin;
+
+				std::atomic<size_t> m_pending;
+
+				size_t m_serial;
+
+				std::map<uint32_t, uint32_t> m_target_map;
+
+				size_t m_width;
+
+		} luna_navigation, *luna_navigation_ptr;
+	}
+}
+
+#endif // LUNA_NAVIGATION_H_
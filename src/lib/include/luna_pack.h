@@ -0,0 +1,173 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LUNA_PACK_H_
+#define LUNA_PACK_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define PACK_ALIGN 0x10
+		#define PACK_FLAG_COMPRESSED 0x1
+		#define PACK_MAGIC 0x4b41504c
+		#define PACK_VERSION 1
+
+		typedef struct {
+			uint32_t magic;
+			uint32_t version;
+			uint64_t count;
+			uint64_t toc;
+			uint64_t reserved;
+		} luna_pack_header;
+
+		typedef struct {
+			uint64_t hash;
+			uint64_t offset;
+			uint32_t size;
+			uint32_t length;
+			uint16_t flags;
+			uint16_t name_length;
+			uint32_t name;
+		} luna_pack_toc;
+
+		typedef struct {
+			const char *data;
+			uint16_t flags;
+			uint32_t id;
+			size_t length;
+			size_t size;
+		} luna_pack_view;
+
+		typedef class _luna_pack {
+
+			public:
+
+				~_luna_pack(void);
+
+				static _luna_pack *acquire(void);
+
+				static size_t build(
+					__in const std::string &path,
+					__in const std::vector<std::string> &input,
+					__in_opt bool compress = true
+					);
+
+				void clear(void);
+
+				void close(
+					__in uint32_t id
+					);
+
+				static void compress(
+					__in const char *data,
+					__in size_t size,
+					__out std::vector<char> &result
+					);
+
+				bool contains(
+					__in const std::string &name
+					);
+
+				static void decompress(
+					__in const char *data,
+					__in size_t size,
+					__out char *result,
+					__in size_t length
+					);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_initialized(void);
+
+				bool lookup(
+					__in const std::string &name,
+					__out luna_pack_view &view
+					);
+
+				uint32_t mount(
+					__in const std::string &path
+					);
+
+				bool open(
+					__in const std::string &name,
+					__out luna_pack_view &view
+					);
+
+				size_t size(void);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+				void unmount(
+					__in uint32_t id
+					);
+
+			protected:
+
+				_luna_pack(void);
+
+				_luna_pack(
+					__in const _luna_pack &other
+					);
+
+				_luna_pack &operator=(
+					__in const _luna_pack &other
+					);
+
+				static void _delete(void);
+
+				static uint64_t key(
+					__in const std::string &name
+					);
+
+				static bool search(
+					__in luna_file &file,
+					__in const std::string &name,
+					__in uint64_t hash,
+					__out luna_pack_view &view
+					);
+
+				static void validate(
+					__in luna_file &file
+					);
+
+				bool m_initialized;
+
+				static _luna_pack *m_instance;
+
+				uint32_t m_next;
+
+				std::map<uint32_t, luna_file *> m_pack_map;
+
+				std::mutex m_pack_lock;
+
+				std::map<uint32_t, luna_file *> m_unmount_map;
+
+				std::map<uint32_t, size_t> m_view_map;
+
+		} luna_pack, *luna_pack_ptr;
+	}
+}
+
+#endif // LUNA_PACK_H_
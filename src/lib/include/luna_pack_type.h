@@ -0,0 +1,71 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LUNA_PACK_TYPE_H_
+#define LUNA_PACK_TYPE_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define LUNA_PACK_HEADER "(PACK)"
+
+#ifndef NDEBUG
+		#define LUNA_PACK_EXCEPTION_HEADER LUNA_PACK_HEADER
+#else
+		#define LUNA_PACK_EXCEPTION_HEADER EXCEPTION_HEADER
+#endif // NDEBUG
+
+		enum {
+			LUNA_PACK_EXCEPTION_ALLOCATED = 0,
+			LUNA_PACK_EXCEPTION_DUPLICATE,
+			LUNA_PACK_EXCEPTION_EXTERNAL,
+			LUNA_PACK_EXCEPTION_INITIALIZED,
+			LUNA_PACK_EXCEPTION_INVALID,
+			LUNA_PACK_EXCEPTION_NOT_FOUND,
+			LUNA_PACK_EXCEPTION_UNINITIALIZED,
+		};
+
+		#define LUNA_PACK_EXCEPTION_MAX LUNA_PACK_EXCEPTION_UNINITIALIZED
+
+		static const std::string LUNA_PACK_EXCEPTION_STR[] = {
+			LUNA_PACK_EXCEPTION_HEADER " Failed to allocate pack component",
+			LUNA_PACK_EXCEPTION_HEADER " Duplicate pack entry",
+			LUNA_PACK_EXCEPTION_HEADER " External exception",
+			LUNA_PACK_EXCEPTION_HEADER " Pack component is initialized",
+			LUNA_PACK_EXCEPTION_HEADER " Malformed pack",
+			LUNA_PACK_EXCEPTION_HEADER " Pack does not exist",
+			LUNA_PACK_EXCEPTION_HEADER " Pack component is uninitialized",
+			};
+
+		#define LUNA_PACK_EXCEPTION_STRING(_TYPE_) \
+			((_TYPE_) > LUNA_PACK_EXCEPTION_MAX ? EXCEPTION_UNKNOWN : \
+			STRING_CHECK(LUNA_PACK_EXCEPTION_STR[_TYPE_]))
+
+		#define THROW_LUNA_PACK_EXCEPTION(_EXCEPT_) \
+			THROW_EXCEPTION(LUNA_PACK_EXCEPTION_STRING(_EXCEPT_))
+		#define THROW_LUNA_PACK_EXCEPTION_FORMAT(_EXCEPT_, _FORMAT_, ...) \
+			THROW_EXCEPTION_FORMAT(LUNA_PACK_EXCEPTION_STRING(_EXCEPT_), \
+			_FORMAT_, __VA_ARGS__)
+
+		class _luna_pack;
+		typedef _luna_pack luna_pack, *luna_pack_ptr;
+	}
+}
+
+#endif // LUNA_PACK_TYPE_H_
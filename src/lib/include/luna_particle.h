@@ -0,0 +1,324 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_PARTICLE_H_
+#define LUNA_PARTICLE_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define PARTICLE_ATTRIBUTE_POSITION "particle_position"
+		#define PARTICLE_ATTRIBUTE_VELOCITY "particle_velocity"
+		#define PARTICLE_BLOCK 4096
+		#define PARTICLE_BUFFER_COUNT 2
+		#define PARTICLE_DEF_FRAMES 60
+		#define PARTICLE_UNIFORM_BUFFER "particle_buffer"
+		#define PARTICLE_UNIFORM_COLOR_BEGIN "particle_color_begin"
+		#define PARTICLE_UNIFORM_COLOR_END "particle_color_end"
+		#define PARTICLE_UNIFORM_OFFSET "particle_offset"
+		#define PARTICLE_UNIFORM_PROJECTION "particle_projection"
+		#define PARTICLE_UNIFORM_SIZE "particle_size"
+		#define PARTICLE_UNIFORM_STRIDE "particle_stride"
+		#define PARTICLE_UNIFORM_TEXTURE "particle_texture"
+		#define PARTICLE_UNIFORM_TEXTURED "particle_textured"
+		#define PARTICLE_UNIFORM_VIEW "particle_view"
+		#define PARTICLE_VARYING_POSITION "particle_feedback_position"
+		#define PARTICLE_VARYING_VELOCITY "particle_feedback_velocity"
+
+		// colors are packed as sprite colors, velocities are scaled by speed after spread
+		typedef struct {
+			luna_vec3 acceleration;
+			uint32_t color_begin;
+			uint32_t color_end;
+			luna_vec3 direction;
+			GLfloat drag;
+			GLfloat lifetime_max;
+			GLfloat lifetime_min;
+			luna_vec3 position;
+			GLuint program;
+			GLfloat rate;
+			GLfloat size_begin;
+			GLfloat size_end;
+			GLfloat speed_max;
+			GLfloat speed_min;
+			GLfloat spread;
+			GLuint texture;
+		} luna_particle_emitter;
+
+		// cpu particle state is soa, stream holds the interleaved position and fade uploaded
+		// each flush, gpu emitters instead ping-pong their state between two feedback buffers
+		typedef struct {
+			GLuint buffer[PARTICLE_BUFFER_COUNT];
+			size_t buffer_index;
+			size_t capacity;
+			size_t count;
+			GLfloat emit;
+			luna_particle_emitter emitter;
+			std::vector<GLfloat> inverse_lifetime;
+			std::vector<GLfloat> life;
+			uint32_t random;
+			size_t spawn;
+			std::vector<GLfloat> stream;
+			std::vector<GLfloat> velocity_x;
+			std::vector<GLfloat> velocity_y;
+			std::vector<GLfloat> velocity_z;
+			GLuint vertex[PARTICLE_BUFFER_COUNT];
+			std::vector<GLfloat> x;
+			std::vector<GLfloat> y;
+			std::vector<GLfloat> z;
+		} luna_particle_entry;
+
+		// gpu particles are two vec4s, position and fade, then velocity and lifetime
+		typedef struct {
+			GLfloat position[4];
+			GLfloat velocity[4];
+		} luna_particle_state;
+
+		typedef struct {
+			GLint acceleration;
+			GLint capacity;
+			GLint damping;
+			GLint delta;
+			GLint direction;
+			GLint lifetime;
+			GLint origin;
+			GLint position;
+			GLint seed;
+			GLint spawn_begin;
+			GLint spawn_count;
+			GLint speed;
+			GLint spread;
+			GLint velocity;
+		} luna_particle_feedback;
+
+		typedef struct {
+			size_t alive;
+			size_t count;
+			luna_particle_entry *entry;
+			size_t offset;
+		} luna_particle_block;
+
+		typedef struct {
+			std::vector<luna_particle_block> block;
+			GLfloat delta;
+		} luna_particle_pass;
+
+		typedef struct {
+			GLint buffer;
+			GLint color_begin;
+			GLint color_end;
+			GLint offset;
+			GLint projection;
+			size_t serial;
+			GLint size;
+			GLint stride;
+			GLint texture;
+			GLint textured;
+			GLint view;
+		} luna_particle_program;
+
+		// update in particles per millisecond
+		typedef struct {
+			size_t count;
+			size_t frames;
+			double update;
+			double update_serial;
+			size_t workers;
+		} luna_particle_stat;
+
+		typedef class _luna_particle {
+
+			public:
+
+				~_luna_particle(void);
+
+				static _luna_particle *acquire(void);
+
+				uint32_t add(
+					__in const luna_particle_emitter &emitter,
+					__in size_t capacity,
+					__in_opt bool gpu = false
+					);
+
+				static luna_particle_stat benchmark(
+					__in size_t count,
+					__in_opt size_t frames = PARTICLE_DEF_FRAMES
+					);
+
+				void clear(void);
+
+				bool contains(
+					__in uint32_t id
+					);
+
+				size_t draw_count(void);
+
+				size_t emit(
+					__in uint32_t id,
+					__in size_t count
+					);
+
+				luna_particle_emitter emitter(
+					__in uint32_t id
+					);
+
+				void flush(
+					__in const luna_mat4 &view,
+					__in const luna_mat4 &projection
+					);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_initialized(void);
+
+				size_t particle_count(void);
+
+				size_t particle_count(
+					__in uint32_t id
+					);
+
+				void remove(
+					__in uint32_t id
+					);
+
+				void set(
+					__in uint32_t id,
+					__in const luna_particle_emitter &emitter
+					);
+
+				size_t size(void);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+				size_t update(
+					__in GLfloat delta
+					);
+
+			protected:
+
+				_luna_particle(void);
+
+				_luna_particle(
+					__in const _luna_particle &other
+					);
+
+				_luna_particle &operator=(
+					__in const _luna_particle &other
+					);
+
+				static void _delete(void);
+
+				void add_feedback(
+					__inout luna_particle_entry &entry
+					);
+
+				void bind_feedback(
+					__inout luna_particle_entry &entry
+					);
+
+				std::map<uint32_t, luna_particle_entry>::iterator find(
+					__in uint32_t id
+					);
+
+				std::map<GLuint, luna_particle_program>::iterator find_program(
+					__in GLuint id
+					);
+
+				static void integrate_range(
+					__in size_t begin,
+					__in size_t end,
+					__in void *context
+					);
+
+				void load_feedback(void);
+
+				void release(void);
+
+				void remove_feedback(
+					__inout luna_particle_entry &entry
+					);
+
+				void simulate(
+					__inout luna_particle_entry &entry,
+					__in size_t count,
+					__in GLfloat delta
+					);
+
+				static size_t spawn(
+					__inout luna_particle_entry &entry,
+					__in size_t count
+					);
+
+				static void step(
+					__in const std::vector<luna_particle_entry *> &entries,
+					__in GLfloat delta,
+					__in bool parallel,
+					__inout luna_particle_pass &pass
+					);
+
+				GLuint m_buffer;
+
+				size_t m_buffer_length;
+
+				GLint m_buffer_max;
+
+				GLuint m_buffer_texture;
+
+				size_t m_draw_count;
+
+				std::vector<luna_particle_entry *> m_entry_active;
+
+				std::map<uint32_t, luna_particle_entry> m_entry_map;
+
+				luna_particle_feedback m_feedback;
+
+				GLuint m_feedback_program;
+
+				size_t m_feedback_serial;
+
+				GLuint m_feedback_shader;
+
+				bool m_initialized;
+
+				static _luna_particle *m_instance;
+
+				uint32_t m_next;
+
+				luna_particle_pass m_pass;
+
+				GLuint m_program;
+
+				std::map<GLuint, luna_particle_program> m_program_map;
+
+				std::vector<GLuint> m_program_shader;
+
+				GLuint m_vertex;
+
+		} luna_particle, *luna_particle_ptr;
+	}
+}
+
+#endif // LUNA_PARTICLE_H_
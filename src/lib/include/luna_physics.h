@@ -0,0 +1,346 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_PHYSICS_H_
+#define LUNA_PHYSICS_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define PHYSICS_BLOCK 4096
+		#define PHYSICS_DEF_ITERATIONS 8
+		#define PHYSICS_DEF_STEP (1.f / 60.f)
+		#define PHYSICS_POINT_MAX 2
+		#define PHYSICS_VERTEX_MAX 8
+
+		enum {
+			PHYSICS_SHAPE_CIRCLE = 0,
+			PHYSICS_SHAPE_POLYGON,
+		};
+
+		#define PHYSICS_SHAPE_MAX PHYSICS_SHAPE_POLYGON
+
+		// polygons are convex, counter-clockwise and relative to the center of mass
+		typedef struct {
+			size_t count;
+			GLfloat radius;
+			uint32_t type;
+			luna_vec3 vertex[PHYSICS_VERTEX_MAX];
+		} luna_physics_shape;
+
+		// bodies without mass are static, the z components are ignored
+		typedef struct {
+			GLfloat angle;
+			GLfloat angular_velocity;
+			GLfloat friction;
+			GLfloat mass;
+			luna_vec3 position;
+			GLfloat restitution;
+			luna_physics_shape shape;
+			luna_vec3 velocity;
+		} luna_physics_body;
+
+		typedef struct {
+			size_t count;
+			GLfloat normal_x[PHYSICS_VERTEX_MAX];
+			GLfloat normal_y[PHYSICS_VERTEX_MAX];
+			GLfloat x[PHYSICS_VERTEX_MAX];
+			GLfloat y[PHYSICS_VERTEX_MAX];
+		} luna_physics_polygon;
+
+		typedef struct {
+			GLfloat anchor_x[2];
+			GLfloat anchor_y[2];
+			GLfloat bias;
+			uint32_t feature;
+			GLfloat impulse_normal;
+			GLfloat impulse_tangent;
+			GLfloat mass_normal;
+			GLfloat mass_tangent;
+			GLfloat penetration;
+			GLfloat x;
+			GLfloat y;
+		} luna_physics_point;
+
+		// the normal points from the first body, which has the lower id, to the second
+		typedef struct {
+			uint32_t body[2];
+			size_t count;
+			GLfloat friction;
+			uint64_t key;
+			uint32_t local[2];
+			GLfloat normal_x;
+			GLfloat normal_y;
+			luna_physics_point point[PHYSICS_POINT_MAX];
+			GLfloat restitution;
+		} luna_physics_contact;
+
+		// islands solve against their own copy of the body velocities, so static bodies shared 
+		// between islands are never written concurrently
+		typedef struct {
+			std::vector<GLfloat> angular_velocity;
+			std::vector<uint32_t> body;
+			std::vector<uint32_t> contact;
+			std::vector<GLfloat> velocity_x;
+			std::vector<GLfloat> velocity_y;
+		} luna_physics_island;
+
+		typedef struct {
+			std::vector<GLfloat> angle;
+			std::vector<GLfloat> angular_velocity;
+			std::vector<GLfloat> force_x;
+			std::vector<GLfloat> force_y;
+			std::vector<GLfloat> friction;
+			std::vector<GLfloat> inertia_inverse;
+			std::vector<luna_physics_polygon> local;
+			std::vector<GLfloat> mass_inverse;
+			std::vector<GLfloat> maximum_x;
+			std::vector<GLfloat> maximum_y;
+			std::vector<GLfloat> minimum_x;
+			std::vector<GLfloat> minimum_y;
+			std::vector<GLfloat> radius;
+			std::vector<GLfloat> restitution;
+			std::vector<GLfloat> torque;
+			std::vector<uint32_t> type;
+			std::vector<GLfloat> velocity_x;
+			std::vector<GLfloat> velocity_y;
+			std::vector<luna_physics_polygon> world;
+			std::vector<GLfloat> x;
+			std::vector<GLfloat> y;
+		} luna_physics_table;
+
+		typedef class _luna_physics {
+
+			public:
+
+				~_luna_physics(void);
+
+				static _luna_physics *acquire(void);
+
+				uint32_t add(
+					__in const luna_physics_body &body
+					);
+
+				GLfloat angle(
+					__in uint32_t id
+					);
+
+				GLfloat angular_velocity(
+					__in uint32_t id
+					);
+
+				void apply_force(
+					__in uint32_t id,
+					__in const luna_vec3 &force,
+					__in_opt GLfloat torque = 0.f
+					);
+
+				void apply_impulse(
+					__in uint32_t id,
+					__in const luna_vec3 &impulse,
+					__in_opt GLfloat angular_impulse = 0.f
+					);
+
+				void clear(void);
+
+				bool contains(
+					__in uint32_t id
+					);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_initialized(void);
+
+				size_t island_count(void);
+
+				luna_vec3 position(
+					__in uint32_t id
+					);
+
+				size_t query_contacts(
+					__out std::vector<std::pair<uint32_t, uint32_t>> &result
+					);
+
+				void remove(
+					__in uint32_t id
+					);
+
+				void set_angle(
+					__in uint32_t id,
+					__in GLfloat angle
+					);
+
+				void set_angular_velocity(
+					__in uint32_t id,
+					__in GLfloat angular_velocity
+					);
+
+				void set_fixed_step(
+					__in GLfloat step
+					);
+
+				void set_gravity(
+					__in const luna_vec3 &gravity
+					);
+
+				void set_iterations(
+					__in size_t iterations
+					);
+
+				void set_position(
+					__in uint32_t id,
+					__in const luna_vec3 &position
+					);
+
+				void set_velocity(
+					__in uint32_t id,
+					__in const luna_vec3 &velocity
+					);
+
+				size_t size(void);
+
+				size_t step(
+					__in GLfloat delta
+					);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+				luna_vec3 velocity(
+					__in uint32_t id
+					);
+
+			protected:
+
+				_luna_physics(void);
+
+				_luna_physics(
+					__in const _luna_physics &other
+					);
+
+				_luna_physics &operator=(
+					__in const _luna_physics &other
+					);
+
+				static void _delete(void);
+
+				static void bound_range(
+					__in size_t begin,
+					__in size_t end,
+					__in void *context
+					);
+
+				void broadphase(void);
+
+				static void collide(
+					__in const luna_physics_table &table,
+					__inout luna_physics_contact &contact
+					);
+
+				std::map<uint32_t, size_t>::iterator find(
+					__in uint32_t id
+					);
+
+				static void integrate_position_range(
+					__in size_t begin,
+					__in size_t end,
+					__in void *context
+					);
+
+				static void integrate_velocity_range(
+					__in size_t begin,
+					__in size_t end,
+					__in void *context
+					);
+
+				void island(void);
+
+				void match(void);
+
+				static void narrow_range(
+					__in size_t begin,
+					__in size_t end,
+					__in void *context
+					);
+
+				void simulate(
+					__in GLfloat delta
+					);
+
+				void solve(
+					__inout luna_physics_island &island
+					);
+
+				static void solve_range(
+					__in size_t begin,
+					__in size_t end,
+					__in void *context
+					);
+
+				GLfloat m_accumulator;
+
+				size_t m_axis;
+
+				std::vector<luna_physics_contact> m_contact;
+
+				std::vector<luna_physics_contact> m_contact_previous;
+
+				GLfloat m_delta;
+
+				GLfloat m_fixed_step;
+
+				luna_vec3 m_gravity;
+
+				std::vector<uint32_t> m_id;
+
+				std::map<uint32_t, size_t> m_index_map;
+
+				bool m_initialized;
+
+				static _luna_physics *m_instance;
+
+				std::vector<luna_physics_island> m_island;
+
+				size_t m_island_count;
+
+				size_t m_iterations;
+
+				std::vector<uint32_t> m_label;
+
+				std::vector<uint32_t> m_local;
+
+				uint32_t m_next;
+
+				std::vector<uint32_t> m_parent;
+
+				std::vector<uint32_t> m_sweep;
+
+				luna_physics_table m_table;
+
+		} luna_physics, *luna_physics_ptr;
+	}
+}
+
+#endif // LUNA_PHYSICS_H_
@@ -24,6 +24,47 @@ namespace LUNA {
 
 	namespace COMP {
 
+		#define SHADER_WATCH_BUFFER 0x1000
+
+		typedef std::map<std::string, std::string> luna_shader_define;
+
+		typedef struct {
+			luna_shader_define define;
+			std::vector<std::string> file;
+			std::string input;
+			bool is_file;
+			size_t reference;
+			size_t serial;
+			uint64_t source;
+			std::string text;
+			GLenum type;
+		} luna_shader_entry;
+
+		typedef struct {
+			std::deque<luna_file> file;
+			std::vector<GLint> length;
+			std::vector<std::string> name;
+			std::vector<const GLchar *> span;
+			std::deque<std::string> text;
+		} luna_shader_source;
+
+		typedef struct {
+			luna_shader_define define;
+			std::string error;
+			GLuint id;
+			std::string input;
+			size_t serial;
+			luna_shader_source source;
+		} luna_shader_request;
+
+		typedef struct {
+			luna_shader_define define;
+			GLuint id;
+			std::string input;
+			bool is_file;
+			GLenum type;
+		} luna_shader_variant;
+
 		typedef class _luna_shader {
 
 			public:
@@ -35,7 +76,8 @@ namespace LUNA {
 				GLuint add(
 					__in const std::string &input,
 					__in bool is_file,
-					__in GLenum type
+					__in GLenum type,
+					__in_opt const luna_shader_define &define = luna_shader_define()
 					);
 
 				void clear(void);
@@ -58,10 +100,18 @@ namespace LUNA {
 
 				bool is_initialized(void);
 
+				std::string preprocess(
+					__in const std::string &input,
+					__in bool is_file,
+					__in_opt const luna_shader_define &define = luna_shader_define()
+					);
+
 				size_t reference_count(
 					__in GLuint id
 					);
 
+				std::string reload_error(void);
+
 				void remove(
 					__in GLuint id
 					);
@@ -78,6 +128,8 @@ namespace LUNA {
 
 				void uninitialize(void);
 
+				size_t update(void);
+
 			protected:
 
 				_luna_shader(void);
@@ -92,15 +144,103 @@ namespace LUNA {
 
 				static void _delete(void);
 
-				std::map<GLuint, std::pair<GLenum, size_t>>::iterator find(
+				static GLuint compile(
+					__in const luna_shader_source &source,
+					__in GLenum type,
+					__in_opt GLuint id = 0
+					);
+
+				static void expand(
+					__in const char *data,
+					__in size_t size,
+					__in size_t index,
+					__in const luna_shader_define &define,
+					__in size_t offset,
+					__inout std::set<std::string> &included,
+					__inout luna_shader_source &result
+					);
+
+				std::map<GLuint, luna_shader_entry>::iterator find(
+					__in GLuint id
+					);
+
+				static uint64_t key(
+					__in const std::string &input,
+					__in bool is_file,
+					__in GLenum type,
+					__in const luna_shader_define &define
+					);
+
+				static uint64_t key(
+					__in const luna_shader_source &source,
+					__in const std::string &input,
+					__in bool is_file,
+					__in GLenum type
+					);
+
+				void poll(void);
+
+				static void preprocess(
+					__in const std::string &input,
+					__in bool is_file,
+					__in const luna_shader_define &define,
+					__out luna_shader_source &result
+					);
+
+				static luna_file &read(
+					__in const std::string &path,
+					__inout luna_shader_source &source
+					);
+
+				void release(
+					__in std::map<GLuint, luna_shader_entry>::iterator iter
+					);
+
+				static void reload(
+					__in void *context
+					);
+
+				bool swap(
+					__in luna_shader_request &request
+					);
+
+				void unwatch(
+					__in GLuint id
+					);
+
+				void watch(
 					__in GLuint id
 					);
 
+				std::map<std::string, int> m_directory_map;
+
+				std::map<std::string, std::set<GLuint>> m_file_map;
+
 				bool m_initialized;
 
 				static _luna_shader *m_instance;
 
-				std::map<GLuint, std::pair<GLenum, size_t>> m_shader_map;
+				std::atomic<size_t> m_pending;
+
+				std::string m_reload_error;
+
+				std::deque<luna_shader_request *> m_reloaded;
+
+				std::condition_variable m_reloaded_condition;
+
+				std::mutex m_reloaded_lock;
+
+				size_t m_serial;
+
+				std::map<GLuint, luna_shader_entry> m_shader_map;
+
+				std::map<uint64_t, GLuint> m_source_map;
+
+				std::map<uint64_t, luna_shader_variant> m_variant_map;
+
+				int m_watch;
+
+				std::map<int, std::pair<std::string, size_t>> m_watch_map;
 
 		} luna_shader, *luna_shader_ptr;
 
@@ -113,7 +253,8 @@ namespace LUNA {
 				static _luna_shader_program *acquire(void);
 
 				GLuint add(
-					__in const std::vector<GLuint> &shaders
+					__in const std::vector<GLuint> &shaders,
+					__in_opt const std::vector<std::string> &varyings = std::vector<std::string>()
 					);
 
 				GLint attribute(
@@ -145,10 +286,18 @@ namespace LUNA {
 					__in GLuint id
 					);
 
+				size_t relink(
+					__in GLuint shader
+					);
+
 				void remove(
 					__in GLuint id
 					);
 
+				size_t serial(
+					__in GLuint id
+					);
+
 				size_t size(void);
 
 				std::string to_string(
@@ -180,6 +329,10 @@ namespace LUNA {
 
 				static void _delete(void);
 
+				void bind_uniform_blocks(
+					__in GLuint id
+					);
+
 				size_t decrement_shader_reference(
 					__in GLuint id
 					);
@@ -192,12 +345,35 @@ namespace LUNA {
 					__in GLuint id
 					);
 
+				static uint64_t key(
+					__in const std::vector<GLuint> &shaders,
+					__in const std::vector<std::string> &varyings
+					);
+
+				static void link(
+					__in GLuint id,
+					__in const std::vector<GLuint> &shaders,
+					__in const std::vector<std::string> &varyings
+					);
+
+				void release(
+					__in std::map<GLuint, std::pair<std::vector<GLuint>, size_t>>::iterator iter
+					);
+
 				bool m_initialized;
 
 				static _luna_shader_program *m_instance;
 
+				std::map<uint64_t, GLuint> m_key_map;
+
+				size_t m_serial;
+
+				std::map<GLuint, size_t> m_serial_map;
+
 				std::map<GLuint, std::pair<std::vector<GLuint>, size_t>> m_shader_program_map;
 
+				std::map<GLuint, std::vector<std::string>> m_varying_map;
+
 		} luna_shader_program, *luna_shader_program_ptr;
 	}
 }
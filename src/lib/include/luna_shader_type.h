@@ -38,6 +38,7 @@ namespace LUNA {
 			LUNA_SHADER_EXCEPTION_EXTERNAL,
 			LUNA_SHADER_EXCEPTION_FILE_NOT_FOUND,
 			LUNA_SHADER_EXCEPTION_INITIALIZED,
+			LUNA_SHADER_EXCEPTION_INVALID,
 			LUNA_SHADER_EXCEPTION_NOT_FOUND,
 			LUNA_SHADER_EXCEPTION_UNINITIALIZED,
 		};
@@ -49,6 +50,7 @@ namespace LUNA {
 			LUNA_SHADER_EXCEPTION_HEADER " External exception",
 			LUNA_SHADER_EXCEPTION_HEADER " Files does not exist",
 			LUNA_SHADER_EXCEPTION_HEADER " Shader component is initialized",
+			LUNA_SHADER_EXCEPTION_HEADER " Invalid shader directive",
 			LUNA_SHADER_EXCEPTION_HEADER " Shader does not exist",
 			LUNA_SHADER_EXCEPTION_HEADER " Shader component is uninitialized",
 			};
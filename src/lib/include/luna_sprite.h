@@ -0,0 +1,190 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_SPRITE_H_
+#define LUNA_SPRITE_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define SPRITE_ATTRIBUTE_COLOR "sprite_color"
+		#define SPRITE_ATTRIBUTE_POSITION "sprite_position"
+		#define SPRITE_ATTRIBUTE_UV "sprite_uv"
+		#define SPRITE_UNIFORM_PROJECTION "sprite_projection"
+		#define SPRITE_UNIFORM_TEXTURE "sprite_texture"
+
+		#define SPRITE_COLOR(_RED_, _GREEN_, _BLUE_, _ALPHA_) \
+			((uint32_t) (_RED_) | ((uint32_t) (_GREEN_) << 8) \
+			| ((uint32_t) (_BLUE_) << 16) | ((uint32_t) (_ALPHA_) << 24))
+		#define SPRITE_COLOR_WHITE SPRITE_COLOR(0xff, 0xff, 0xff, 0xff)
+
+		typedef struct {
+			uint32_t color;
+			GLfloat height;
+			uint16_t layer;
+			GLuint program;
+			GLfloat rotation;
+			GLuint texture;
+			GLfloat u0, u1, v0, v1;
+			GLfloat width;
+			GLfloat x, y;
+		} luna_sprite_quad;
+
+		typedef struct {
+			GLint projection;
+			size_t serial;
+			GLint texture;
+			GLuint vao;
+		} luna_sprite_program;
+
+		typedef struct {
+			GLfloat x, y;
+			GLfloat u, v;
+			uint32_t color;
+		} luna_sprite_vertex;
+
+		typedef class _luna_sprite {
+
+			public:
+
+				~_luna_sprite(void);
+
+				static _luna_sprite *acquire(void);
+
+				void add(
+					__in const luna_sprite_quad &quad
+					);
+
+				void add(
+					__in const luna_atlas_rect &rect,
+					__in GLfloat x,
+					__in GLfloat y,
+					__in_opt GLfloat rotation = 0.f,
+					__in_opt uint32_t color = SPRITE_COLOR_WHITE,
+					__in_opt uint16_t layer = 0,
+					__in_opt GLuint program = 0
+					);
+
+				void clear(void);
+
+				size_t draw_count(void);
+
+				void flush(
+					__in GLsizei width,
+					__in GLsizei height
+					);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_initialized(void);
+
+				size_t size(void);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+			protected:
+
+				_luna_sprite(void);
+
+				_luna_sprite(
+					__in const _luna_sprite &other
+					);
+
+				_luna_sprite &operator=(
+					__in const _luna_sprite &other
+					);
+
+				static void _delete(void);
+
+				void build(void);
+
+				std::map<GLuint, luna_sprite_program>::iterator find_program(
+					__in GLuint id
+					);
+
+				void release(void);
+
+				void reserve_index(
+					__in size_t count
+					);
+
+				void reset(void);
+
+				GLuint m_buffer;
+
+				GLuint m_buffer_index;
+
+				size_t m_buffer_index_count;
+
+				size_t m_buffer_length;
+
+				std::vector<GLfloat> m_corner_x[4];
+
+				std::vector<GLfloat> m_corner_y[4];
+
+				std::vector<GLfloat> m_cosine;
+
+				std::vector<uint32_t> m_color;
+
+				size_t m_draw_count;
+
+				std::vector<GLfloat> m_half_height;
+
+				std::vector<GLfloat> m_half_width;
+
+				bool m_initialized;
+
+				static _luna_sprite *m_instance;
+
+				std::vector<uint64_t> m_key;
+
+				std::vector<size_t> m_order;
+
+				GLuint m_program;
+
+				std::map<GLuint, luna_sprite_program> m_program_map;
+
+				std::vector<GLuint> m_program_shader;
+
+				std::vector<GLuint> m_quad_program;
+
+				std::vector<GLuint> m_quad_texture;
+
+				std::vector<GLfloat> m_sine;
+
+				std::vector<GLfloat> m_uv[4];
+
+				std::vector<luna_sprite_vertex> m_vertex;
+
+				std::vector<GLfloat> m_x;
+
+				std::vector<GLfloat> m_y;
+
+		} luna_sprite, *luna_sprite_ptr;
+	}
+}
+
+#endif // LUNA_SPRITE_H_
@@ -0,0 +1,185 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_TEXTURE_H_
+#define LUNA_TEXTURE_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define TEXTURE_PBO_COUNT 2
+		#define TEXTURE_UPLOAD_PER_FRAME 2
+
+		typedef struct {
+			std::string error;
+			bool failed;
+			GLsizei height;
+			bool loaded;
+			size_t reference;
+			size_t serial;
+			GLsizei width;
+		} luna_texture_entry;
+
+		typedef struct {
+			std::string error;
+			GLsizei height;
+			GLuint id;
+			std::string path;
+			std::vector<uint8_t> pixels;
+			size_t serial;
+			GLsizei width;
+		} luna_texture_request;
+
+		typedef class _luna_texture {
+
+			public:
+
+				~_luna_texture(void);
+
+				static _luna_texture *acquire(void);
+
+				GLuint add(
+					__in const std::string &path
+					);
+
+				GLuint add(
+					__in GLsizei width,
+					__in GLsizei height,
+					__in_opt const void *data = NULL
+					);
+
+				void bind(
+					__in_opt GLuint id = 0,
+					__in_opt GLuint unit = 0
+					);
+
+				void clear(void);
+
+				bool contains(
+					__in GLuint id
+					);
+
+				size_t decrement_reference(
+					__in GLuint id
+					);
+
+				std::string error(
+					__in GLuint id
+					);
+
+				GLsizei height(
+					__in GLuint id
+					);
+
+				size_t increment_reference(
+					__in GLuint id
+					);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_failed(
+					__in GLuint id
+					);
+
+				bool is_initialized(void);
+
+				bool is_loaded(
+					__in GLuint id
+					);
+
+				size_t pending(void);
+
+				size_t reference_count(
+					__in GLuint id
+					);
+
+				void remove(
+					__in GLuint id
+					);
+
+				size_t size(void);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+				void update(
+					__in_opt size_t limit = TEXTURE_UPLOAD_PER_FRAME
+					);
+
+				GLsizei width(
+					__in GLuint id
+					);
+
+			protected:
+
+				_luna_texture(void);
+
+				_luna_texture(
+					__in const _luna_texture &other
+					);
+
+				_luna_texture &operator=(
+					__in const _luna_texture &other
+					);
+
+				static void _delete(void);
+
+				static void decode(
+					__in void *context
+					);
+
+				std::map<GLuint, luna_texture_entry>::iterator find(
+					__in GLuint id
+					);
+
+				void upload(
+					__in luna_texture_request &request
+					);
+
+				std::deque<luna_texture_request *> m_decoded;
+
+				std::condition_variable m_decoded_condition;
+
+				std::mutex m_decoded_lock;
+
+				bool m_initialized;
+
+				static _luna_texture *m_instance;
+
+				GLuint m_pbo[TEXTURE_PBO_COUNT];
+
+				size_t m_pbo_index;
+
+				std::atomic<size_t> m_pending;
+
+				size_t m_serial;
+
+				std::map<GLuint, luna_texture_entry> m_texture_map;
+
+		} luna_texture, *luna_texture_ptr;
+	}
+}
+
+#endif // LUNA_TEXTURE_H_
@@ -0,0 +1,184 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_TRANSFORM_H_
+#define LUNA_TRANSFORM_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define TRANSFORM_GRAIN 256
+		#define TRANSFORM_PARALLEL_MIN 1024
+
+		typedef class _luna_transform {
+
+			public:
+
+				~_luna_transform(void);
+
+				static _luna_transform *acquire(void);
+
+				uint32_t add(
+					__in_opt uint32_t parent = 0
+					);
+
+				void clear(void);
+
+				bool contains(
+					__in uint32_t id
+					);
+
+				size_t index(
+					__in uint32_t id
+					);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_initialized(void);
+
+				uint32_t parent(
+					__in uint32_t id
+					);
+
+				luna_vec3 position(
+					__in uint32_t id
+					);
+
+				void remove(
+					__in uint32_t id
+					);
+
+				luna_quat rotation(
+					__in uint32_t id
+					);
+
+				luna_vec3 scale(
+					__in uint32_t id
+					);
+
+				void set_parent(
+					__in uint32_t id,
+					__in_opt uint32_t parent = 0
+					);
+
+				void set_position(
+					__in uint32_t id,
+					__in const luna_vec3 &position
+					);
+
+				void set_rotation(
+					__in uint32_t id,
+					__in const luna_quat &rotation
+					);
+
+				void set_scale(
+					__in uint32_t id,
+					__in const luna_vec3 &scale
+					);
+
+				size_t size(void);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+				size_t update(void);
+
+				const luna_mat4 &world(
+					__in uint32_t id
+					);
+
+				const luna_mat4 *world_data(void);
+
+			protected:
+
+				_luna_transform(void);
+
+				_luna_transform(
+					__in const _luna_transform &other
+					);
+
+				_luna_transform &operator=(
+					__in const _luna_transform &other
+					);
+
+				static void _delete(void);
+
+				std::map<uint32_t, size_t>::iterator find(
+					__in uint32_t id
+					);
+
+				void reorder(
+					__in const std::vector<size_t> &order
+					);
+
+				void sort(void);
+
+				static void update_range(
+					__in size_t begin,
+					__in size_t end,
+					__in void *context
+					);
+
+				std::vector<uint32_t> m_changed;
+
+				std::vector<uint32_t> m_depth;
+
+				std::vector<uint8_t> m_dirty;
+
+				std::vector<uint32_t> m_id;
+
+				std::map<uint32_t, size_t> m_index_map;
+
+				bool m_initialized;
+
+				static _luna_transform *m_instance;
+
+				std::vector<size_t> m_level;
+
+				size_t m_level_begin;
+
+				uint32_t m_next;
+
+				std::vector<size_t> m_parent;
+
+				std::vector<luna_vec3> m_position;
+
+				std::vector<luna_quat> m_rotation;
+
+				std::vector<luna_vec3> m_scale;
+
+				uint32_t m_serial;
+
+				bool m_sorted;
+
+				std::atomic<size_t> m_update_count;
+
+				std::vector<luna_mat4> m_world;
+
+		} luna_transform, *luna_transform_ptr;
+	}
+}
+
+#endif // LUNA_TRANSFORM_H_
@@ -0,0 +1,68 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_TRANSFORM_TYPE_H_
+#define LUNA_TRANSFORM_TYPE_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define LUNA_TRANSFORM_HEADER "(TRANSFORM)"
+
+#ifndef NDEBUG
+		#define LUNA_TRANSFORM_EXCEPTION_HEADER LUNA_TRANSFORM_HEADER
+#else
+		#define LUNA_TRANSFORM_EXCEPTION_HEADER EXCEPTION_HEADER
+#endif // NDEBUG
+
+		enum {
+			LUNA_TRANSFORM_EXCEPTION_ALLOCATED = 0,
+			LUNA_TRANSFORM_EXCEPTION_INITIALIZED,
+			LUNA_TRANSFORM_EXCEPTION_INVALID,
+			LUNA_TRANSFORM_EXCEPTION_NOT_FOUND,
+			LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED,
+		};
+
+		#define LUNA_TRANSFORM_EXCEPTION_MAX LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED
+
+		static const std::string LUNA_TRANSFORM_EXCEPTION_STR[] = {
+			LUNA_TRANSFORM_EXCEPTION_HEADER " Failed to allocate transform component",
+			LUNA_TRANSFORM_EXCEPTION_HEADER " Transform component is initialized",
+			LUNA_TRANSFORM_EXCEPTION_HEADER " Transform parent is invalid",
+			LUNA_TRANSFORM_EXCEPTION_HEADER " Transform does not exist",
+			LUNA_TRANSFORM_EXCEPTION_HEADER " Transform component is uninitialized",
+			};
+
+		#define LUNA_TRANSFORM_EXCEPTION_STRING(_TYPE_) \
+			((_TYPE_) > LUNA_TRANSFORM_EXCEPTION_MAX ? EXCEPTION_UNKNOWN : \
+			STRING_CHECK(LUNA_TRANSFORM_EXCEPTION_STR[_TYPE_]))
+
+		#define THROW_LUNA_TRANSFORM_EXCEPTION(_EXCEPT_) \
+			THROW_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_STRING(_EXCEPT_))
+		#define THROW_LUNA_TRANSFORM_EXCEPTION_FORMAT(_EXCEPT_, _FORMAT_, ...) \
+			THROW_EXCEPTION_FORMAT(LUNA_TRANSFORM_EXCEPTION_STRING(_EXCEPT_), \
+			_FORMAT_, __VA_ARGS__)
+
+		class _luna_transform;
+		typedef _luna_transform luna_transform, *luna_transform_ptr;
+	}
+}
+
+#endif // LUNA_TRANSFORM_TYPE_H_
@@ -0,0 +1,146 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_UNIFORM_H_
+#define LUNA_UNIFORM_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define UNIFORM_BINDING_MAX 24
+		#define UNIFORM_FENCE_TIMEOUT 1000000000
+		#define UNIFORM_FRAME_COUNT 3
+		#define UNIFORM_FRAME_SIZE 0x100000
+
+		typedef struct {
+			GLvoid *data;
+			GLintptr offset;
+			GLsizeiptr size;
+		} luna_uniform_range;
+
+		typedef class _luna_uniform {
+
+			public:
+
+				~_luna_uniform(void);
+
+				static _luna_uniform *acquire(void);
+
+				GLuint add(
+					__in const std::string &name
+					);
+
+				luna_uniform_range allocate(
+					__in GLsizeiptr size
+					);
+
+				void bind(
+					__in GLuint binding,
+					__in const luna_uniform_range &range
+					);
+
+				GLuint binding(
+					__in const std::string &name
+					);
+
+				void clear(void);
+
+				bool contains(
+					__in const std::string &name
+					);
+
+				void initialize(void);
+
+				static bool is_allocated(void);
+
+				bool is_initialized(void);
+
+				luna_uniform_range push(
+					__in GLuint binding,
+					__in const GLvoid *data,
+					__in GLsizeiptr size
+					);
+
+				size_t size(void);
+
+				std::string to_string(
+					__in_opt bool verbose = false
+					);
+
+				void uninitialize(void);
+
+				void update(void);
+
+				void upload(void);
+
+				size_t used(void);
+
+			protected:
+
+				_luna_uniform(void);
+
+				_luna_uniform(
+					__in const _luna_uniform &other
+					);
+
+				_luna_uniform &operator=(
+					__in const _luna_uniform &other
+					);
+
+				static void _delete(void);
+
+				void prepare(void);
+
+				void release(void);
+
+				void write(
+					__in GLintptr offset,
+					__in GLsizeiptr size
+					);
+
+				GLint m_alignment;
+
+				std::map<std::string, GLuint> m_binding_map;
+
+				GLuint m_buffer;
+
+				GLsync m_fence[UNIFORM_FRAME_COUNT];
+
+				size_t m_frame;
+
+				bool m_initialized;
+
+				static _luna_uniform *m_instance;
+
+				GLint m_maximum;
+
+				GLintptr m_offset;
+
+				size_t m_peak;
+
+				std::vector<uint8_t> m_staging;
+
+				GLintptr m_uploaded;
+
+		} luna_uniform, *luna_uniform_ptr;
+	}
+}
+
+#endif // LUNA_UNIFORM_H_
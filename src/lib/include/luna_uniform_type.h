@@ -0,0 +1,72 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUNA_UNIFORM_TYPE_H_
+#define LUNA_UNIFORM_TYPE_H_
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define LUNA_UNIFORM_HEADER "(UNIFORM)"
+
+#ifndef NDEBUG
+		#define LUNA_UNIFORM_EXCEPTION_HEADER LUNA_UNIFORM_HEADER
+#else
+		#define LUNA_UNIFORM_EXCEPTION_HEADER EXCEPTION_HEADER
+#endif // NDEBUG
+
+		enum {
+			LUNA_UNIFORM_EXCEPTION_ALLOCATED = 0,
+			LUNA_UNIFORM_EXCEPTION_EXTERNAL,
+			LUNA_UNIFORM_EXCEPTION_FULL,
+			LUNA_UNIFORM_EXCEPTION_INITIALIZED,
+			LUNA_UNIFORM_EXCEPTION_INVALID,
+			LUNA_UNIFORM_EXCEPTION_NOT_FOUND,
+			LUNA_UNIFORM_EXCEPTION_UNINITIALIZED,
+		};
+
+		#define LUNA_UNIFORM_EXCEPTION_MAX LUNA_UNIFORM_EXCEPTION_UNINITIALIZED
+
+		static const std::string LUNA_UNIFORM_EXCEPTION_STR[] = {
+			LUNA_UNIFORM_EXCEPTION_HEADER " Failed to allocate uniform component",
+			LUNA_UNIFORM_EXCEPTION_HEADER " External exception",
+			LUNA_UNIFORM_EXCEPTION_HEADER " Uniform buffer is full",
+			LUNA_UNIFORM_EXCEPTION_HEADER " Uniform component is initialized",
+			LUNA_UNIFORM_EXCEPTION_HEADER " Invalid uniform range",
+			LUNA_UNIFORM_EXCEPTION_HEADER " Uniform block does not exist",
+			LUNA_UNIFORM_EXCEPTION_HEADER " Uniform component is uninitialized",
+			};
+
+		#define LUNA_UNIFORM_EXCEPTION_STRING(_TYPE_) \
+			((_TYPE_) > LUNA_UNIFORM_EXCEPTION_MAX ? EXCEPTION_UNKNOWN : \
+			STRING_CHECK(LUNA_UNIFORM_EXCEPTION_STR[_TYPE_]))
+
+		#define THROW_LUNA_UNIFORM_EXCEPTION(_EXCEPT_) \
+			THROW_EXCEPTION(LUNA_UNIFORM_EXCEPTION_STRING(_EXCEPT_))
+		#define THROW_LUNA_UNIFORM_EXCEPTION_FORMAT(_EXCEPT_, _FORMAT_, ...) \
+			THROW_EXCEPTION_FORMAT(LUNA_UNIFORM_EXCEPTION_STRING(_EXCEPT_), \
+			_FORMAT_, __VA_ARGS__)
+
+		class _luna_uniform;
+		typedef _luna_uniform luna_uniform, *luna_uniform_ptr;
+	}
+}
+
+#endif // LUNA_UNIFORM_TYPE_H_
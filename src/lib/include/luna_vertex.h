@@ -109,6 +109,13 @@ namespace LUNA {
 					__in GLenum usage
 					);
 
+				void set_buffer_sub_data(
+					__in GLenum target,
+					__in size_t offset,
+					__in const void *data,
+					__in size_t length
+					);
+
 				size_t size(void);
 
 				std::string to_string(
@@ -363,10 +363,27 @@ namespace LUNA {
 
 	_luna::_luna(void) :
 		m_initialized(false),
+		m_instance_arena(luna_arena::acquire()),
+		m_instance_atlas(luna_atlas::acquire()),
+		m_instance_bvh(luna_bvh::acquire()),
+		m_instance_cull(luna_cull::acquire()),
 		m_instance_display(luna_display::acquire()),
+		m_instance_entity(luna_entity::acquire()),
+		m_instance_grid(luna_grid::acquire()),
 		m_instance_input(luna_input::acquire()),
+		m_instance_job(luna_job::acquire()),
+		m_instance_loader(luna_loader::acquire()),
+		m_instance_mesh(luna_mesh::acquire()),
+		m_instance_navigation(luna_navigation::acquire()),
+		m_instance_pack(luna_pack::acquire()),
+		m_instance_particle(luna_particle::acquire()),
+		m_instance_physics(luna_physics::acquire()),
 		m_instance_shader(luna_shader::acquire()),
 		m_instance_shader_program(luna_shader_program::acquire()),
+		m_instance_sprite(luna_sprite::acquire()),
+		m_instance_texture(luna_texture::acquire()),
+		m_instance_transform(luna_transform::acquire()),
+		m_instance_uniform(luna_uniform::acquire()),
 		m_instance_vertex(luna_vertex::acquire()),
 		m_running(false),
 		m_tick(0)
@@ -408,6 +425,50 @@ namespace LUNA {
 		return luna::m_instance;
 	}
 
+	luna_arena_ptr 
+	_luna::acquire_arena(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_arena;
+	}
+
+	luna_atlas_ptr 
+	_luna::acquire_atlas(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_atlas;
+	}
+
+	luna_bvh_ptr 
+	_luna::acquire_bvh(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_bvh;
+	}
+
+	luna_cull_ptr 
+	_luna::acquire_cull(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_cull;
+	}
+
 	luna_display_ptr 
 	_luna::acquire_display(void)
 	{
@@ -419,6 +480,28 @@ namespace LUNA {
 		return m_instance_display;
 	}
 
+	luna_entity_ptr 
+	_luna::acquire_entity(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_entity;
+	}
+
+	luna_grid_ptr 
+	_luna::acquire_grid(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_grid;
+	}
+
 	luna_input_ptr 
 	_luna::acquire_input(void)
 	{
@@ -430,6 +513,83 @@ namespace LUNA {
 		return m_instance_input;
 	}
 
+	luna_job_ptr 
+	_luna::acquire_job(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_job;
+	}
+
+	luna_loader_ptr 
+	_luna::acquire_loader(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_loader;
+	}
+
+	luna_mesh_ptr 
+	_luna::acquire_mesh(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_mesh;
+	}
+
+	luna_navigation_ptr 
+	_luna::acquire_navigation(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_navigation;
+	}
+
+	luna_pack_ptr 
+	_luna::acquire_pack(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_pack;
+	}
+
+	luna_particle_ptr 
+	_luna::acquire_particle(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_particle;
+	}
+
+	luna_physics_ptr 
+	_luna::acquire_physics(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_physics;
+	}
+
 	luna_shader_ptr 
 	_luna::acquire_shader(void)
 	{
@@ -452,6 +612,50 @@ namespace LUNA {
 		return m_instance_shader_program;
 	}
 
+	luna_sprite_ptr 
+	_luna::acquire_sprite(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_sprite;
+	}
+
+	luna_texture_ptr 
+	_luna::acquire_texture(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_texture;
+	}
+
+	luna_transform_ptr 
+	_luna::acquire_transform(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_transform;
+	}
+
+	luna_uniform_ptr 
+	_luna::acquire_uniform(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_uniform;
+	}
+
 	luna_vertex_ptr 
 	_luna::acquire_vertex(void)
 	{
@@ -496,7 +700,8 @@ namespace LUNA {
 	_luna::add_shader(
 		__in const std::string &input,
 		__in bool is_file,
-		__in GLenum type
+		__in GLenum type,
+		__in_opt const luna_shader_define &define
 		)
 	{
 
@@ -504,7 +709,7 @@ namespace LUNA {
 			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
 		}
 
-		return m_instance_shader->add(input, is_file, type);
+		return m_instance_shader->add(input, is_file, type, define);
 	}
 
 	GLuint 
@@ -520,6 +725,19 @@ namespace LUNA {
 		return m_instance_shader_program->add(ids);
 	}
 
+	GLuint 
+	_luna::add_texture(
+		__in const std::string &path
+		)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_texture->add(path);
+	}
+
 	GLuint 
 	_luna::add_vertex(
 		__in size_t count
@@ -547,6 +765,20 @@ namespace LUNA {
 		m_instance_vertex->bind_buffer(target, id);
 	}
 
+	void 
+	_luna::bind_texture(
+		__in_opt GLuint id,
+		__in_opt GLuint unit
+		)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		m_instance_texture->bind(id, unit);
+	}
+
 	void 
 	_luna::bind_vertex(
 		__in_opt GLuint id
@@ -617,6 +849,17 @@ namespace LUNA {
 		m_instance_shader_program->clear();
 	}
 
+	void 
+	_luna::clear_textures(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		m_instance_texture->clear();
+	}
+
 	void 
 	_luna::clear_tick(void)
 	{
@@ -691,6 +934,19 @@ namespace LUNA {
 		return m_instance_shader_program->contains(id);
 	}
 
+	bool 
+	_luna::contains_texture(
+		__in GLuint id
+		)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_texture->contains(id);
+	}
+
 	bool 
 	_luna::contains_vertex(
 		__in GLuint id
@@ -745,9 +1001,26 @@ namespace LUNA {
 			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_INITIALIZED);
 		}
 
+		m_instance_arena->initialize();
+		m_instance_job->initialize();
+		m_instance_pack->initialize();
+		m_instance_loader->initialize();
 		m_instance_shader->initialize();
 		m_instance_shader_program->initialize();
+		m_instance_texture->initialize();
+		m_instance_atlas->initialize();
 		m_instance_vertex->initialize();
+		m_instance_mesh->initialize();
+		m_instance_sprite->initialize();
+		m_instance_particle->initialize();
+		m_instance_transform->initialize();
+		m_instance_entity->initialize();
+		m_instance_cull->initialize();
+		m_instance_bvh->initialize();
+		m_instance_grid->initialize();
+		m_instance_physics->initialize();
+		m_instance_navigation->initialize();
+		m_instance_uniform->initialize();
 		m_instance_input->initialize();
 		m_instance_display->initialize();
 
@@ -787,6 +1060,19 @@ namespace LUNA {
 		return m_running;
 	}
 
+	uint32_t 
+	_luna::mount_pack(
+		__in const std::string &path
+		)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_pack->mount(path);
+	}
+
 	void 
 	_luna::remove_buffer(
 		__in GLuint id
@@ -839,6 +1125,19 @@ namespace LUNA {
 		m_instance_shader_program->remove(id);
 	}
 
+	void 
+	_luna::remove_texture(
+		__in GLuint id
+		)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		m_instance_texture->remove(id);
+	}
+
 	void 
 	_luna::remove_vertex(
 		__in GLuint id
@@ -868,6 +1167,22 @@ namespace LUNA {
 		m_instance_vertex->set_buffer_data(target, data, length, usage);
 	}
 
+	void 
+	_luna::set_buffer_sub_data(
+		__in GLenum target,
+		__in size_t offset,
+		__in const void *data,
+		__in size_t length
+		)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		m_instance_vertex->set_buffer_sub_data(target, offset, data, length);
+	}
+
 	void 
 	_luna::set_draw(
 		__in const luna_draw_config &config
@@ -922,11 +1237,29 @@ namespace LUNA {
 		}
 
 		luna::external_initialize();
+		m_instance_arena->clear();
+		m_instance_loader->clear();
+		m_instance_pack->clear();
+		m_instance_uniform->clear();
+		m_instance_navigation->clear();
+		m_instance_physics->clear();
+		m_instance_grid->clear();
+		m_instance_bvh->clear();
+		m_instance_cull->clear();
+		m_instance_entity->clear();
+		m_instance_transform->clear();
+		m_instance_particle->clear();
+		m_instance_sprite->clear();
+		m_instance_mesh->clear();
 		m_instance_shader->clear();
 		m_instance_shader_program->clear();
+		m_instance_atlas->clear();
+		m_instance_texture->clear();
 		m_instance_vertex->clear();
 		m_instance_input->set(input_config);
 		m_instance_display->start(display_config);
+		m_instance_loader->start(m_instance_display->window(), 
+			m_instance_display->loader_context());
 
 		// TODO: setup components
 
@@ -1030,8 +1363,9 @@ namespace LUNA {
 
 		while(m_running) {
 			tick = SDL_GetTicks();
+			m_instance_arena->swap();
 
-			while(SDL_PollEvent(&event)) {
+			while(m_instance_input->poll(m_tick, event)) {
 
 				switch(event.type) {
 					case SDL_QUIT:
@@ -1051,12 +1385,20 @@ namespace LUNA {
 			}
 
 			m_tick_config.invoke(window, context, m_tick);
-
-			if((SDL_GetTicks() - tick) < MIN_TICK) {
+			m_instance_entity->update(m_tick);
+			m_instance_transform->update();
+			m_instance_shader->update();
+			m_instance_texture->update();
+			m_instance_loader->update();
+			m_instance_navigation->update();
+
+			// replayed sessions run unthrottled, so they can be used as benchmark workloads
+			if(!m_instance_input->is_replaying() && ((SDL_GetTicks() - tick) < MIN_TICK)) {
 				SDL_Delay(MIN_TICK - (SDL_GetTicks() - tick));
 			}
 
 			m_draw_config.invoke(window, context);
+			m_instance_uniform->update();
 			++m_tick;
 		}
 
@@ -1099,14 +1441,51 @@ namespace LUNA {
 
 		// TODO: teardown components
 
+		m_instance_particle->clear();
+		m_instance_sprite->clear();
+		m_instance_mesh->clear();
+		m_instance_atlas->clear();
+		m_instance_texture->clear();
+		m_instance_loader->stop();
+		m_instance_uniform->clear();
+		m_instance_loader->clear();
 		m_instance_display->stop();
+
+		// a failed recording write is reported, but must not cut the teardown short
+		try {
+			m_instance_input->stop_record();
+		} catch(std::exception &exc) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Input record failed: %s", exc.what());
+		}
+
+		m_instance_input->stop_replay();
 		m_instance_input->clear();
 		m_instance_vertex->clear();
 		m_instance_shader_program->clear();
 		m_instance_shader->clear();
+		m_instance_entity->clear();
+		m_instance_transform->clear();
+		m_instance_cull->clear();
+		m_instance_bvh->clear();
+		m_instance_grid->clear();
+		m_instance_physics->clear();
+		m_instance_navigation->clear();
+		m_instance_pack->clear();
+		m_instance_arena->clear();
 		luna::external_uninitialize();
 	}
 
+	size_t 
+	_luna::texture_count(void)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		return m_instance_texture->size();
+	}
+
 	std::string 
 	_luna::to_string(
 		__in_opt bool verbose
@@ -1133,11 +1512,28 @@ namespace LUNA {
 				
 			result << std::endl << m_draw_config.to_string(verbose)
 				<< std::endl << m_tick_config.to_string(verbose)
+				<< std::endl << m_instance_arena->to_string(verbose)
 				<< std::endl << m_instance_display->to_string(verbose)
 				<< std::endl << m_instance_input->to_string(verbose)
 				<< std::endl << m_instance_shader->to_string(verbose)
 				<< std::endl << m_instance_shader_program->to_string(verbose)
-				<< std::endl << m_instance_vertex->to_string(verbose);
+				<< std::endl << m_instance_texture->to_string(verbose)
+				<< std::endl << m_instance_atlas->to_string(verbose)
+				<< std::endl << m_instance_vertex->to_string(verbose)
+				<< std::endl << m_instance_sprite->to_string(verbose)
+				<< std::endl << m_instance_transform->to_string(verbose)
+				<< std::endl << m_instance_entity->to_string(verbose)
+				<< std::endl << m_instance_cull->to_string(verbose)
+				<< std::endl << m_instance_bvh->to_string(verbose)
+				<< std::endl << m_instance_uniform->to_string(verbose)
+				<< std::endl << m_instance_pack->to_string(verbose)
+				<< std::endl << m_instance_loader->to_string(verbose)
+				<< std::endl << m_instance_mesh->to_string(verbose)
+				<< std::endl << m_instance_particle->to_string(verbose)
+				<< std::endl << m_instance_grid->to_string(verbose)
+				<< std::endl << m_instance_physics->to_string(verbose)
+				<< std::endl << m_instance_navigation->to_string(verbose)
+				<< std::endl << m_instance_job->to_string(verbose);
 
 			// TODO: print components
 
@@ -1164,9 +1560,39 @@ namespace LUNA {
 
 		m_instance_display->uninitialize();
 		m_instance_input->uninitialize();
+		m_instance_uniform->uninitialize();
+		m_instance_navigation->uninitialize();
+		m_instance_physics->uninitialize();
+		m_instance_grid->uninitialize();
+		m_instance_bvh->uninitialize();
+		m_instance_cull->uninitialize();
+		m_instance_entity->uninitialize();
+		m_instance_transform->uninitialize();
+		m_instance_particle->uninitialize();
+		m_instance_sprite->uninitialize();
+		m_instance_mesh->uninitialize();
 		m_instance_vertex->uninitialize();
+		m_instance_atlas->uninitialize();
+		m_instance_texture->uninitialize();
 		m_instance_shader_program->uninitialize();
 		m_instance_shader->uninitialize();
+		m_instance_loader->uninitialize();
+		m_instance_pack->uninitialize();
+		m_instance_job->uninitialize();
+		m_instance_arena->uninitialize();
+	}
+
+	void 
+	_luna::unmount_pack(
+		__in uint32_t id
+		)
+	{
+
+		if(!m_initialized) {
+			THROW_LUNA_EXCEPTION(LUNA_EXCEPTION_UNINITIALIZED);
+		}
+
+		m_instance_pack->unmount(id);
 	}
 
 	void 
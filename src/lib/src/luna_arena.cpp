@@ -0,0 +1,349 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../include/luna.h"
+#include "../include/luna_arena_type.h"
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define ARENA_ALIGN(_VAL_, _ALIGN_) \
+			(((_VAL_) + ((_ALIGN_) - 1)) & ~((uintptr_t) (_ALIGN_) - 1))
+
+		_luna_arena *_luna_arena::m_instance = NULL;
+
+		_luna_arena::_luna_arena(void) :
+			m_frame(0),
+			m_high_water(0),
+			m_initialized(false),
+			m_offset(0),
+			m_overflow_count(0),
+			m_reserve(ARENA_DEF_CAPACITY)
+		{
+			size_t iter = 0;
+
+			for(; iter < ARENA_BUFFER_COUNT; ++iter) {
+				m_buffer[iter] = NULL;
+				m_capacity[iter] = 0;
+				m_overflow_length[iter] = 0;
+			}
+
+			std::atexit(luna_arena::_delete);
+		}
+
+		_luna_arena::~_luna_arena(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_arena::_delete(void)
+		{
+
+			if(luna_arena::m_instance) {
+				delete luna_arena::m_instance;
+				luna_arena::m_instance = NULL;
+			}
+		}
+
+		_luna_arena *
+		_luna_arena::acquire(void)
+		{
+
+			if(!luna_arena::m_instance) {
+
+				luna_arena::m_instance = new luna_arena;
+				if(!luna_arena::m_instance) {
+					THROW_LUNA_ARENA_EXCEPTION(LUNA_ARENA_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_arena::m_instance;
+		}
+
+		void *
+		_luna_arena::allocate(
+			__in size_t length,
+			__in_opt size_t alignment
+			)
+		{
+			uintptr_t base;
+			void *result = NULL;
+			size_t aligned, next, offset;
+
+			if(!m_initialized) {
+				THROW_LUNA_ARENA_EXCEPTION(LUNA_ARENA_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!alignment || (alignment & (alignment - 1))) {
+				THROW_LUNA_ARENA_EXCEPTION_FORMAT(LUNA_ARENA_EXCEPTION_INVALID,
+					"%lu", (unsigned long) alignment);
+			}
+
+			base = (uintptr_t) m_buffer[m_frame];
+			offset = m_offset.load(std::memory_order_relaxed);
+
+			do {
+				aligned = ARENA_ALIGN(base + offset, alignment) - base;
+				next = aligned + length;
+
+				if(next > m_capacity[m_frame]) {
+					result = allocate_overflow(length, alignment);
+					break;
+				}
+			} while(!m_offset.compare_exchange_weak(offset, next, std::memory_order_relaxed));
+
+			if(!result) {
+				result = (void *) (base + aligned);
+			}
+
+			return result;
+		}
+
+		void *
+		_luna_arena::allocate_overflow(
+			__in size_t length,
+			__in size_t alignment
+			)
+		{
+			uint8_t *buffer = NULL;
+
+			std::lock_guard<std::mutex> lock(m_overflow_lock);
+
+			buffer = new uint8_t[length + alignment];
+			if(!buffer) {
+				THROW_LUNA_ARENA_EXCEPTION(LUNA_ARENA_EXCEPTION_ALLOCATED);
+			}
+
+			m_overflow[m_frame].push_back(buffer);
+			m_overflow_length[m_frame] += (length + alignment);
+			++m_overflow_count;
+
+			return (void *) ARENA_ALIGN((uintptr_t) buffer, alignment);
+		}
+
+		size_t 
+		_luna_arena::capacity(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ARENA_EXCEPTION(LUNA_ARENA_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_capacity[m_frame];
+		}
+
+		void 
+		_luna_arena::clear(void)
+		{
+			size_t iter = 0;
+
+			if(!m_initialized) {
+				THROW_LUNA_ARENA_EXCEPTION(LUNA_ARENA_EXCEPTION_UNINITIALIZED);
+			}
+
+			for(; iter < ARENA_BUFFER_COUNT; ++iter) {
+				release(iter);
+
+				if(m_capacity[iter] != m_reserve) {
+					delete [] m_buffer[iter];
+					m_buffer[iter] = new uint8_t[m_reserve];
+					if(!m_buffer[iter]) {
+						THROW_LUNA_ARENA_EXCEPTION(LUNA_ARENA_EXCEPTION_ALLOCATED);
+					}
+
+					m_capacity[iter] = m_reserve;
+				}
+			}
+
+			m_frame = 0;
+			m_high_water = 0;
+			m_offset = 0;
+			m_overflow_count = 0;
+		}
+
+		size_t 
+		_luna_arena::high_water(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ARENA_EXCEPTION(LUNA_ARENA_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_high_water;
+		}
+
+		void 
+		_luna_arena::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_ARENA_EXCEPTION(LUNA_ARENA_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			clear();
+		}
+
+		bool 
+		_luna_arena::is_allocated(void)
+		{
+			return (luna_arena::m_instance != NULL);
+		}
+
+		bool 
+		_luna_arena::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		size_t 
+		_luna_arena::overflow_count(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ARENA_EXCEPTION(LUNA_ARENA_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_overflow_count;
+		}
+
+		void 
+		_luna_arena::release(
+			__in size_t index
+			)
+		{
+			std::vector<uint8_t *>::iterator iter;
+
+			for(iter = m_overflow[index].begin(); iter != m_overflow[index].end(); ++iter) {
+				delete [] *iter;
+			}
+
+			m_overflow[index].clear();
+			m_overflow_length[index] = 0;
+		}
+
+		void 
+		_luna_arena::reserve(
+			__in size_t capacity
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ARENA_EXCEPTION(LUNA_ARENA_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_reserve = capacity;
+			clear();
+		}
+
+		void 
+		_luna_arena::swap(void)
+		{
+			size_t length;
+
+			if(!m_initialized) {
+				THROW_LUNA_ARENA_EXCEPTION(LUNA_ARENA_EXCEPTION_UNINITIALIZED);
+			}
+
+			length = used();
+			if(length > m_high_water) {
+				m_high_water = length;
+			}
+
+			// the previous frame remains valid, while the frame before it is recycled
+			m_frame = ((m_frame + 1) % ARENA_BUFFER_COUNT);
+
+			if(m_overflow_length[m_frame]) {
+				release(m_frame);
+			}
+
+			if(m_high_water > m_capacity[m_frame]) {
+				delete [] m_buffer[m_frame];
+				m_buffer[m_frame] = new uint8_t[m_high_water];
+				if(!m_buffer[m_frame]) {
+					THROW_LUNA_ARENA_EXCEPTION(LUNA_ARENA_EXCEPTION_ALLOCATED);
+				}
+
+				m_capacity[m_frame] = m_high_water;
+			}
+
+			m_offset = 0;
+		}
+
+		std::string 
+		_luna_arena::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+
+			result << LUNA_ARENA_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_arena_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+				result << std::endl << "--- FRAME: " << m_frame << ", USED. " << used()
+					<< ", CAP. " << m_capacity[m_frame] << ", HIGH. " << m_high_water
+					<< ", OVERFLOW. " << m_overflow_count;
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_arena::uninitialize(void)
+		{
+			size_t iter = 0;
+
+			if(!m_initialized) {
+				THROW_LUNA_ARENA_EXCEPTION(LUNA_ARENA_EXCEPTION_UNINITIALIZED);
+			}
+
+			for(; iter < ARENA_BUFFER_COUNT; ++iter) {
+				release(iter);
+				delete [] m_buffer[iter];
+				m_buffer[iter] = NULL;
+				m_capacity[iter] = 0;
+			}
+
+			m_offset = 0;
+			m_initialized = false;
+		}
+
+		size_t 
+		_luna_arena::used(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ARENA_EXCEPTION(LUNA_ARENA_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (m_offset.load() + m_overflow_length[m_frame]);
+		}
+	}
+}
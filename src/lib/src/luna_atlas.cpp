@@ -0,0 +1,510 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <climits>
+#include "../include/luna.h"
+#include "../include/luna_atlas_type.h"
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define ATLAS_CHANNELS 4
+		#define ATLAS_CLAMP(_VAL_, _MIN_, _MAX_) \
+			((_VAL_) < (_MIN_) ? (_MIN_) : ((_VAL_) > (_MAX_) ? (_MAX_) : (_VAL_)))
+
+		_luna_atlas *_luna_atlas::m_instance = NULL;
+
+		_luna_atlas::_luna_atlas(void) :
+			m_initialized(false),
+			m_next(0)
+		{
+			std::atexit(luna_atlas::_delete);
+		}
+
+		_luna_atlas::~_luna_atlas(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_atlas::_delete(void)
+		{
+
+			if(luna_atlas::m_instance) {
+				delete luna_atlas::m_instance;
+				luna_atlas::m_instance = NULL;
+			}
+		}
+
+		_luna_atlas *
+		_luna_atlas::acquire(void)
+		{
+
+			if(!luna_atlas::m_instance) {
+
+				luna_atlas::m_instance = new luna_atlas;
+				if(!luna_atlas::m_instance) {
+					THROW_LUNA_ATLAS_EXCEPTION(LUNA_ATLAS_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_atlas::m_instance;
+		}
+
+		uint32_t 
+		_luna_atlas::add(
+			__in_opt GLsizei width,
+			__in_opt GLsizei height,
+			__in_opt GLsizei padding
+			)
+		{
+			luna_atlas_entry entry;
+
+			if(!m_initialized) {
+				THROW_LUNA_ATLAS_EXCEPTION(LUNA_ATLAS_EXCEPTION_UNINITIALIZED);
+			}
+
+			if((width <= 0) || (height <= 0) || (padding < 0)) {
+				THROW_LUNA_ATLAS_EXCEPTION_FORMAT(LUNA_ATLAS_EXCEPTION_INVALID,
+					"%ix%i (pad. %i)", width, height, padding);
+			}
+
+			entry.height = height;
+			entry.padding = padding;
+			entry.width = width;
+			m_atlas_map.insert(std::pair<uint32_t, luna_atlas_entry>(++m_next, entry));
+
+			return m_next;
+		}
+
+		void 
+		_luna_atlas::clear(void)
+		{
+			std::map<uint32_t, luna_atlas_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_ATLAS_EXCEPTION(LUNA_ATLAS_EXCEPTION_UNINITIALIZED);
+			}
+
+			for(iter = m_atlas_map.begin(); iter != m_atlas_map.end(); ++iter) {
+				release(iter->second);
+			}
+
+			m_atlas_map.clear();
+		}
+
+		bool 
+		_luna_atlas::contains(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ATLAS_EXCEPTION(LUNA_ATLAS_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (m_atlas_map.find(id) != m_atlas_map.end());
+		}
+
+		std::map<uint32_t, luna_atlas_entry>::iterator 
+		_luna_atlas::find(
+			__in uint32_t id
+			)
+		{
+			std::map<uint32_t, luna_atlas_entry>::iterator result;
+
+			if(!m_initialized) {
+				THROW_LUNA_ATLAS_EXCEPTION(LUNA_ATLAS_EXCEPTION_UNINITIALIZED);
+			}
+
+			result = m_atlas_map.find(id);
+			if(result == m_atlas_map.end()) {
+				THROW_LUNA_ATLAS_EXCEPTION_FORMAT(LUNA_ATLAS_EXCEPTION_NOT_FOUND,
+					"0x%x", id);
+			}
+
+			return result;
+		}
+
+		bool 
+		_luna_atlas::fit(
+			__in luna_atlas_page &page,
+			__in GLsizei page_width,
+			__in GLsizei page_height,
+			__in GLsizei width,
+			__in GLsizei height,
+			__out size_t &index,
+			__out GLsizei &x,
+			__out GLsizei &y
+			)
+		{
+			bool result = false;
+			size_t iter = 0, span;
+			GLsizei best_width = INT_MAX, best_y = INT_MAX, remaining, top;
+
+			// bottom-left skyline: pick the lowest resting position, breaking ties
+			// on the narrowest segment to limit wasted space
+			for(; iter < page.skyline.size(); ++iter) {
+
+				if((page.skyline.at(iter).x + width) > page_width) {
+					break;
+				}
+
+				remaining = width;
+				top = 0;
+
+				for(span = iter; (remaining > 0) && (span < page.skyline.size()); ++span) {
+
+					if(page.skyline.at(span).y > top) {
+						top = page.skyline.at(span).y;
+					}
+
+					remaining -= page.skyline.at(span).width;
+				}
+
+				if((remaining > 0) || ((top + height) > page_height)) {
+					continue;
+				}
+
+				if((top < best_y) || ((top == best_y) 
+						&& (page.skyline.at(iter).width < best_width))) {
+					best_width = page.skyline.at(iter).width;
+					best_y = top;
+					index = iter;
+					x = page.skyline.at(iter).x;
+					y = top;
+					result = true;
+				}
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_atlas::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_ATLAS_EXCEPTION(LUNA_ATLAS_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			clear();
+		}
+
+		luna_atlas_rect 
+		_luna_atlas::insert(
+			__in uint32_t id,
+			__in GLsizei width,
+			__in GLsizei height,
+			__in const void *data
+			)
+		{
+			luna_atlas_rect result;
+			luna_atlas_page page;
+			luna_atlas_skyline level;
+			luna_atlas_page *target = NULL;
+			size_t index = 0, iter = 0;
+			std::vector<uint8_t> buffer;
+			const uint8_t *source = NULL;
+			GLsizei column, padded_height, padded_width, row, source_column, source_row, 
+				x = 0, y = 0;
+
+			if(!m_initialized) {
+				THROW_LUNA_ATLAS_EXCEPTION(LUNA_ATLAS_EXCEPTION_UNINITIALIZED);
+			}
+
+			luna_atlas_entry &entry = find(id)->second;
+			padded_height = (height + (entry.padding * 2));
+			padded_width = (width + (entry.padding * 2));
+
+			if((width <= 0) || (height <= 0) || (padded_width > entry.width) 
+					|| (padded_height > entry.height)) {
+				THROW_LUNA_ATLAS_EXCEPTION_FORMAT(LUNA_ATLAS_EXCEPTION_INVALID,
+					"%ix%i (page. %ix%i)", width, height, entry.width, entry.height);
+			}
+
+			for(; iter < entry.page.size(); ++iter) {
+
+				if(fit(entry.page.at(iter), entry.width, entry.height, padded_width, 
+						padded_height, index, x, y)) {
+					target = &entry.page.at(iter);
+					break;
+				}
+			}
+
+			if(!target) {
+				level.width = entry.width;
+				level.x = 0;
+				level.y = 0;
+				page.skyline.push_back(level);
+				page.texture = luna_texture::acquire()->add(entry.width, entry.height);
+				page.used = 0;
+				entry.page.push_back(page);
+				target = &entry.page.back();
+				fit(*target, entry.width, entry.height, padded_width, padded_height, 
+					index, x, y);
+			}
+
+			place(*target, index, x, y, padded_width, padded_height);
+			target->used += (padded_width * padded_height);
+
+			if(data) {
+				buffer.resize(padded_width * padded_height * ATLAS_CHANNELS);
+
+				// border texels are extruded from the image edge, so filtering never
+				// samples a neighbouring image, rows are flipped as luna_texture does, so
+				// v0 is the bottom edge of the image
+				for(row = 0; row < padded_height; ++row) {
+					source_row = ATLAS_CLAMP((padded_height - row - 1) - entry.padding, 0, 
+						height - 1);
+
+					for(column = 0; column < padded_width; ++column) {
+						source_column = ATLAS_CLAMP(column - entry.padding, 0, width - 1);
+						source = ((const uint8_t *) data + (((source_row * width) 
+							+ source_column) * ATLAS_CHANNELS));
+						std::copy(source, source + ATLAS_CHANNELS, 
+							&buffer[((row * padded_width) + column) * ATLAS_CHANNELS]);
+					}
+				}
+
+				glBindTexture(GL_TEXTURE_2D, target->texture);
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+				glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, padded_width, padded_height, GL_RGBA,
+					GL_UNSIGNED_BYTE, &buffer[0]);
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+				glBindTexture(GL_TEXTURE_2D, 0);
+			}
+
+			result.height = height;
+			result.texture = target->texture;
+			result.width = width;
+			result.x = (x + entry.padding);
+			result.y = (y + entry.padding);
+			result.u0 = (result.x / (GLfloat) entry.width);
+			result.u1 = ((result.x + width) / (GLfloat) entry.width);
+			result.v0 = (result.y / (GLfloat) entry.height);
+			result.v1 = ((result.y + height) / (GLfloat) entry.height);
+
+			return result;
+		}
+
+		bool 
+		_luna_atlas::is_allocated(void)
+		{
+			return (luna_atlas::m_instance != NULL);
+		}
+
+		bool 
+		_luna_atlas::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		GLuint 
+		_luna_atlas::page(
+			__in uint32_t id,
+			__in size_t index
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ATLAS_EXCEPTION(LUNA_ATLAS_EXCEPTION_UNINITIALIZED);
+			}
+
+			luna_atlas_entry &entry = find(id)->second;
+			if(index >= entry.page.size()) {
+				THROW_LUNA_ATLAS_EXCEPTION_FORMAT(LUNA_ATLAS_EXCEPTION_NOT_FOUND,
+					"0x%x, page. %lu", id, (unsigned long) index);
+			}
+
+			return entry.page.at(index).texture;
+		}
+
+		size_t 
+		_luna_atlas::page_count(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ATLAS_EXCEPTION(LUNA_ATLAS_EXCEPTION_UNINITIALIZED);
+			}
+
+			return find(id)->second.page.size();
+		}
+
+		void 
+		_luna_atlas::place(
+			__in luna_atlas_page &page,
+			__in size_t index,
+			__in GLsizei x,
+			__in GLsizei y,
+			__in GLsizei width,
+			__in GLsizei height
+			)
+		{
+			GLsizei shrink;
+			size_t iter = 0;
+			luna_atlas_skyline level;
+
+			level.width = width;
+			level.x = x;
+			level.y = (y + height);
+			page.skyline.insert(page.skyline.begin() + index, level);
+
+			// trim the segments now covered by the new level
+			for(iter = index + 1; iter < page.skyline.size();) {
+				luna_atlas_skyline &previous = page.skyline.at(iter - 1);
+				luna_atlas_skyline &current = page.skyline.at(iter);
+
+				if(current.x >= (previous.x + previous.width)) {
+					break;
+				}
+
+				shrink = ((previous.x + previous.width) - current.x);
+				current.x += shrink;
+				current.width -= shrink;
+
+				if(current.width > 0) {
+					break;
+				}
+
+				page.skyline.erase(page.skyline.begin() + iter);
+			}
+
+			for(iter = 0; (iter + 1) < page.skyline.size();) {
+
+				if(page.skyline.at(iter).y == page.skyline.at(iter + 1).y) {
+					page.skyline.at(iter).width += page.skyline.at(iter + 1).width;
+					page.skyline.erase(page.skyline.begin() + iter + 1);
+				} else {
+					++iter;
+				}
+			}
+		}
+
+		void 
+		_luna_atlas::release(
+			__in luna_atlas_entry &entry
+			)
+		{
+			luna_texture_ptr inst = NULL;
+			std::vector<luna_atlas_page>::iterator iter;
+
+			if(luna_texture::is_allocated()) {
+
+				inst = luna_texture::acquire();
+				if(inst && inst->is_initialized()) {
+
+					for(iter = entry.page.begin(); iter != entry.page.end(); ++iter) {
+
+						if(inst->contains(iter->texture)) {
+							inst->decrement_reference(iter->texture);
+						}
+					}
+				}
+			}
+
+			entry.page.clear();
+		}
+
+		void 
+		_luna_atlas::remove(
+			__in uint32_t id
+			)
+		{
+			std::map<uint32_t, luna_atlas_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_ATLAS_EXCEPTION(LUNA_ATLAS_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+			release(iter->second);
+			m_atlas_map.erase(iter);
+		}
+
+		size_t 
+		_luna_atlas::size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ATLAS_EXCEPTION(LUNA_ATLAS_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_atlas_map.size();
+		}
+
+		std::string 
+		_luna_atlas::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+			std::vector<luna_atlas_page>::iterator page_iter;
+			std::map<uint32_t, luna_atlas_entry>::iterator iter;
+
+			result << LUNA_ATLAS_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_atlas_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+
+				for(iter = m_atlas_map.begin(); iter != m_atlas_map.end(); ++iter) {
+					result << std::endl << "--- 0x" << SCALAR_AS_HEX(uint32_t, iter->first)
+						<< ", " << iter->second.width << "x" << iter->second.height
+						<< ", PAD. " << iter->second.padding;
+
+					for(page_iter = iter->second.page.begin(); 
+							page_iter != iter->second.page.end(); 
+							++page_iter) {
+						result << std::endl << "------ 0x" 
+							<< SCALAR_AS_HEX(GLuint, page_iter->texture) << ", USED. "
+							<< ((page_iter->used * 100) / (iter->second.width 
+								* iter->second.height)) << "%";
+					}
+				}
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_atlas::uninitialize(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ATLAS_EXCEPTION(LUNA_ATLAS_EXCEPTION_UNINITIALIZED);
+			}
+
+			clear();
+			m_initialized = false;
+		}
+	}
+}
@@ -0,0 +1,939 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include "../include/luna.h"
+#include "../include/luna_bvh_type.h"
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define BVH_AXIS_COUNT 3
+		#define BVH_NODE_SIZE 32
+		#define BVH_PLANE_COUNT 6
+		#define BVH_STACK_SIZE 128
+
+		#define BVH_ELAPSED(_BEGIN_) \
+			std::chrono::duration<double, std::milli>( \
+				std::chrono::high_resolution_clock::now() - (_BEGIN_)).count()
+
+		static_assert(sizeof(luna_bvh_node) == BVH_NODE_SIZE, "bvh node must be 32 bytes");
+
+		enum {
+			BVH_OUTSIDE = 0,
+			BVH_INTERSECT,
+			BVH_INSIDE,
+		};
+
+		static GLfloat 
+		bvh_area(
+			__in const GLfloat *minimum,
+			__in const GLfloat *maximum
+			)
+		{
+			GLfloat x, y, z;
+
+			x = maximum[0] - minimum[0];
+			y = maximum[1] - minimum[1];
+			z = maximum[2] - minimum[2];
+
+			return ((x * y) + (y * z) + (z * x));
+		}
+
+		static uint32_t 
+		bvh_classify(
+			__in const luna_frustum &frustum,
+			__in const GLfloat *minimum,
+			__in const GLfloat *maximum
+			)
+		{
+			size_t plane;
+			uint32_t result = BVH_INSIDE;
+			GLfloat center[3], distance, extent[3], radius;
+
+			for(plane = 0; plane < BVH_AXIS_COUNT; ++plane) {
+				center[plane] = (maximum[plane] + minimum[plane]) * 0.5f;
+				extent[plane] = (maximum[plane] - minimum[plane]) * 0.5f;
+			}
+
+			for(plane = 0; plane < BVH_PLANE_COUNT; ++plane) {
+				const luna_vec4 &entry = frustum.plane[plane];
+
+				distance = (entry.x * center[0]) + (entry.y * center[1]) 
+					+ (entry.z * center[2]) + entry.w;
+				radius = (std::fabs(entry.x) * extent[0]) + (std::fabs(entry.y) * extent[1]) 
+					+ (std::fabs(entry.z) * extent[2]);
+
+				if((distance + radius) < 0.f) {
+					result = BVH_OUTSIDE;
+					break;
+				} else if((distance - radius) < 0.f) {
+					result = BVH_INTERSECT;
+				}
+			}
+
+			return result;
+		}
+
+		static void 
+		bvh_grow(
+			__inout GLfloat *minimum,
+			__inout GLfloat *maximum,
+			__in const GLfloat *other_minimum,
+			__in const GLfloat *other_maximum
+			)
+		{
+			size_t axis;
+
+			for(axis = 0; axis < BVH_AXIS_COUNT; ++axis) {
+				minimum[axis] = std::min(minimum[axis], other_minimum[axis]);
+				maximum[axis] = std::max(maximum[axis], other_maximum[axis]);
+			}
+		}
+
+		static void 
+		bvh_reset(
+			__out GLfloat *minimum,
+			__out GLfloat *maximum
+			)
+		{
+			size_t axis;
+
+			for(axis = 0; axis < BVH_AXIS_COUNT; ++axis) {
+				minimum[axis] = HUGE_VALF;
+				maximum[axis] = -HUGE_VALF;
+			}
+		}
+
+		// slab test, the entry distance is clamped to the ray origin
+		static bool 
+		bvh_slab(
+			__in const GLfloat *minimum,
+			__in const GLfloat *maximum,
+			__in const GLfloat *origin,
+			__in const GLfloat *inverse,
+			__in GLfloat distance_max,
+			__out GLfloat &distance
+			)
+		{
+			size_t axis;
+			GLfloat far = distance_max, near = 0.f, first, second;
+
+			for(axis = 0; axis < BVH_AXIS_COUNT; ++axis) {
+				first = (minimum[axis] - origin[axis]) * inverse[axis];
+				second = (maximum[axis] - origin[axis]) * inverse[axis];
+				near = std::max(near, std::min(first, second));
+				far = std::min(far, std::max(first, second));
+			}
+
+			distance = near;
+
+			return (near <= far);
+		}
+
+		_luna_bvh *_luna_bvh::m_instance = NULL;
+
+		_luna_bvh::_luna_bvh(void) :
+			m_build_time(0.0),
+			m_built(true),
+			m_frustum_count(0),
+			m_frustum_time(0.0),
+			m_initialized(false),
+			m_next(0),
+			m_ray_count(0),
+			m_ray_time(0.0),
+			m_refit(false),
+			m_refit_time(0.0)
+		{
+			std::atexit(luna_bvh::_delete);
+		}
+
+		_luna_bvh::~_luna_bvh(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_bvh::_delete(void)
+		{
+
+			if(luna_bvh::m_instance) {
+				delete luna_bvh::m_instance;
+				luna_bvh::m_instance = NULL;
+			}
+		}
+
+		_luna_bvh *
+		_luna_bvh::acquire(void)
+		{
+
+			if(!luna_bvh::m_instance) {
+
+				luna_bvh::m_instance = new luna_bvh;
+				if(!luna_bvh::m_instance) {
+					THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_bvh::m_instance;
+		}
+
+		uint32_t 
+		_luna_bvh::add(
+			__in const luna_vec3 &minimum,
+			__in const luna_vec3 &maximum
+			)
+		{
+			luna_bvh_bound bound = luna_bvh_bound();
+
+			if(!m_initialized) {
+				THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_tree.bound.push_back(bound);
+			m_id.push_back(++m_next);
+			m_index_map.insert(std::pair<uint32_t, size_t>(m_next, m_id.size() - 1));
+			set(m_next, minimum, maximum);
+			m_built = false;
+
+			return m_next;
+		}
+
+		luna_bvh_stat 
+		_luna_bvh::benchmark(
+			__in size_t count,
+			__in_opt size_t queries
+			)
+		{
+			size_t iter, primitive;
+			luna_bvh_tree tree;
+			luna_bvh_stat result;
+			luna_frustum frustum;
+			GLfloat distance, extent;
+			std::vector<uint32_t> visible;
+			std::mt19937 generator(count);
+			luna_mat4 projection, view, view_projection;
+			luna_vec3 axis, direction, origin, position, scale;
+			std::chrono::high_resolution_clock::time_point begin;
+
+			// objects are spread so density stays constant across scene sizes
+			extent = std::cbrt((GLfloat) count) * 10.f;
+			std::uniform_real_distribution<GLfloat> coordinate(-extent, extent), 
+				size(0.5f, 4.f), unit(-1.f, 1.f);
+			tree.bound.resize(count);
+
+			for(iter = 0; iter < count; ++iter) {
+				luna_bvh_bound &bound = tree.bound[iter];
+
+				for(primitive = 0; primitive < BVH_AXIS_COUNT; ++primitive) {
+					bound.min[primitive] = coordinate(generator);
+					bound.max[primitive] = bound.min[primitive] + size(generator);
+				}
+			}
+
+			begin = std::chrono::high_resolution_clock::now();
+			build_tree(tree);
+			result.build = BVH_ELAPSED(begin);
+
+			for(iter = 0; iter < count; ++iter) {
+
+				for(primitive = 0; primitive < BVH_AXIS_COUNT; ++primitive) {
+					distance = unit(generator) * 0.5f;
+					tree.bound[iter].min[primitive] += distance;
+					tree.bound[iter].max[primitive] += distance;
+				}
+			}
+
+			begin = std::chrono::high_resolution_clock::now();
+			refit_tree(tree);
+			result.refit = BVH_ELAPSED(begin);
+			luna_mat4_perspective(MATH_PI / 3.f, 16.f / 9.f, 0.1f, extent, projection);
+			luna_vec3_make(1.f, 1.f, 1.f, scale);
+			result.query_frustum = 0.0;
+			result.query_ray = 0.0;
+
+			for(iter = 0; iter < queries; ++iter) {
+				luna_quat rotation;
+
+				luna_vec3_make(unit(generator), unit(generator), unit(generator), axis);
+				luna_vec3_normalize(axis, axis);
+				luna_vec3_make(coordinate(generator), coordinate(generator), 
+					coordinate(generator), position);
+				luna_quat_from_axis_angle(axis, unit(generator) * MATH_PI, rotation);
+				luna_mat4_from_trs(position, rotation, scale, view);
+				luna_mat4_inverse(view, view);
+				luna_mat4_multiply(projection, view, view_projection);
+				luna_frustum_from_matrix(view_projection, frustum);
+				visible.clear();
+				begin = std::chrono::high_resolution_clock::now();
+				query_frustum_tree(tree, frustum, NULL, visible);
+				result.query_frustum += BVH_ELAPSED(begin);
+				luna_vec3_make(coordinate(generator), coordinate(generator), 
+					coordinate(generator), origin);
+				luna_vec3_make(unit(generator), unit(generator), unit(generator), direction);
+				luna_vec3_normalize(direction, direction);
+				begin = std::chrono::high_resolution_clock::now();
+				query_ray_tree(tree, origin, direction, extent * 2.f, primitive, distance);
+				result.query_ray += BVH_ELAPSED(begin);
+			}
+
+			result.node_count = tree.node.size();
+			result.primitive_count = count;
+			result.query_frustum = ((result.query_frustum > 0.0) 
+				? (queries / result.query_frustum) : 0.0);
+			result.query_ray = ((result.query_ray > 0.0) ? (queries / result.query_ray) : 0.0);
+
+			return result;
+		}
+
+		void 
+		_luna_bvh::build(void)
+		{
+			std::chrono::high_resolution_clock::time_point begin;
+
+			if(!m_initialized) {
+				THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_UNINITIALIZED);
+			}
+
+			begin = std::chrono::high_resolution_clock::now();
+			build_tree(m_tree);
+			m_build_time = BVH_ELAPSED(begin);
+			m_built = true;
+			m_refit = false;
+		}
+
+		void 
+		_luna_bvh::build_node(
+			__inout luna_bvh_tree &tree,
+			__in const std::vector<luna_vec3> &centroid,
+			__in size_t begin,
+			__in size_t end
+			)
+		{
+			luna_bvh_node node;
+			GLfloat bin_maximum[BVH_BIN_COUNT][BVH_AXIS_COUNT], 
+				bin_minimum[BVH_BIN_COUNT][BVH_AXIS_COUNT], cost, cost_best = HUGE_VALF, 
+				left_area[BVH_BIN_COUNT], maximum[BVH_AXIS_COUNT], minimum[BVH_AXIS_COUNT], 
+				centroid_maximum[BVH_AXIS_COUNT], centroid_minimum[BVH_AXIS_COUNT], scale;
+			size_t axis, axis_best = BVH_AXIS_COUNT, bin, bin_best = 0, 
+				bin_count[BVH_BIN_COUNT], count, index, iter, left_count[BVH_BIN_COUNT], 
+				middle = begin, right_count;
+
+			index = tree.node.size();
+			count = end - begin;
+			bvh_reset(node.min, node.max);
+			bvh_reset(centroid_minimum, centroid_maximum);
+
+			for(iter = begin; iter < end; ++iter) {
+				const luna_bvh_bound &bound = tree.bound[tree.primitive[iter]];
+
+				bvh_grow(node.min, node.max, bound.min, bound.max);
+				bvh_grow(centroid_minimum, centroid_maximum, &centroid[tree.primitive[iter]].x, 
+					&centroid[tree.primitive[iter]].x);
+			}
+
+			node.count = count;
+			node.offset = begin;
+			tree.node.push_back(node);
+
+			if(count > BVH_LEAF_MIN) {
+
+				// binned sah over every axis with a non-degenerate centroid spread
+				for(axis = 0; axis < BVH_AXIS_COUNT; ++axis) {
+
+					if((centroid_maximum[axis] - centroid_minimum[axis]) <= MATH_EPSILON) {
+						continue;
+					}
+
+					scale = BVH_BIN_COUNT / (centroid_maximum[axis] - centroid_minimum[axis]);
+
+					for(bin = 0; bin < BVH_BIN_COUNT; ++bin) {
+						bin_count[bin] = 0;
+						bvh_reset(bin_minimum[bin], bin_maximum[bin]);
+					}
+
+					for(iter = begin; iter < end; ++iter) {
+						const luna_bvh_bound &bound = tree.bound[tree.primitive[iter]];
+
+						bin = std::min((size_t) BVH_BIN_COUNT - 1, (size_t) (((&centroid[
+							tree.primitive[iter]].x)[axis] - centroid_minimum[axis]) * scale));
+						++bin_count[bin];
+						bvh_grow(bin_minimum[bin], bin_maximum[bin], bound.min, bound.max);
+					}
+
+					bvh_reset(minimum, maximum);
+
+					for(iter = 0, right_count = 0; iter < (BVH_BIN_COUNT - 1); ++iter) {
+						right_count += bin_count[iter];
+						left_count[iter] = right_count;
+						bvh_grow(minimum, maximum, bin_minimum[iter], bin_maximum[iter]);
+						left_area[iter] = (right_count ? bvh_area(minimum, maximum) : 0.f);
+					}
+
+					bvh_reset(minimum, maximum);
+
+					for(iter = (BVH_BIN_COUNT - 1), right_count = 0; iter > 0; --iter) {
+						right_count += bin_count[iter];
+						bvh_grow(minimum, maximum, bin_minimum[iter], bin_maximum[iter]);
+						cost = (left_area[iter - 1] * left_count[iter - 1]) 
+							+ ((right_count ? bvh_area(minimum, maximum) : 0.f) * right_count);
+
+						if(left_count[iter - 1] && right_count && (cost < cost_best)) {
+							axis_best = axis;
+							bin_best = iter - 1;
+							cost_best = cost;
+						}
+					}
+				}
+
+				if(axis_best < BVH_AXIS_COUNT) {
+
+					// splitting must beat intersecting every primitive in a leaf
+					if((count > BVH_LEAF_MAX) 
+							|| (cost_best < (bvh_area(node.min, node.max) * count))) {
+						scale = BVH_BIN_COUNT / (centroid_maximum[axis_best] 
+							- centroid_minimum[axis_best]);
+						middle = std::partition(tree.primitive.begin() + begin, 
+							tree.primitive.begin() + end, [&](uint32_t primitive) {
+								return (std::min((size_t) BVH_BIN_COUNT - 1, 
+									(size_t) (((&centroid[primitive].x)[axis_best] 
+									- centroid_minimum[axis_best]) * scale)) <= bin_best);
+							}) - tree.primitive.begin();
+					}
+				} else if(count > BVH_LEAF_MAX) {
+					middle = begin + (count / 2);
+				}
+
+				if((middle > begin) && (middle < end)) {
+					tree.node[index].count = 0;
+					build_node(tree, centroid, begin, middle);
+					tree.node[index].offset = tree.node.size();
+					build_node(tree, centroid, middle, end);
+				}
+			}
+		}
+
+		void 
+		_luna_bvh::build_tree(
+			__inout luna_bvh_tree &tree
+			)
+		{
+			size_t iter;
+			std::vector<luna_vec3> centroid;
+
+			centroid.resize(tree.bound.size());
+			tree.node.clear();
+			tree.node.reserve(tree.bound.size() * 2);
+			tree.primitive.resize(tree.bound.size());
+
+			for(iter = 0; iter < tree.bound.size(); ++iter) {
+				const luna_bvh_bound &bound = tree.bound[iter];
+
+				luna_vec3_make((bound.min[0] + bound.max[0]) * 0.5f, 
+					(bound.min[1] + bound.max[1]) * 0.5f, 
+					(bound.min[2] + bound.max[2]) * 0.5f, centroid[iter]);
+				tree.primitive[iter] = iter;
+			}
+
+			if(!tree.bound.empty()) {
+				build_node(tree, centroid, 0, tree.bound.size());
+			}
+		}
+
+		void 
+		_luna_bvh::clear(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_build_time = 0.0;
+			m_built = true;
+			m_frustum_count = 0;
+			m_frustum_time = 0.0;
+			m_id.clear();
+			m_index_map.clear();
+			m_ray_count = 0;
+			m_ray_time = 0.0;
+			m_refit = false;
+			m_refit_time = 0.0;
+			m_tree.bound.clear();
+			m_tree.node.clear();
+			m_tree.primitive.clear();
+		}
+
+		bool 
+		_luna_bvh::contains(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (m_index_map.find(id) != m_index_map.end());
+		}
+
+		std::map<uint32_t, size_t>::iterator 
+		_luna_bvh::find(
+			__in uint32_t id
+			)
+		{
+			std::map<uint32_t, size_t>::iterator result;
+
+			if(!m_initialized) {
+				THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_UNINITIALIZED);
+			}
+
+			result = m_index_map.find(id);
+			if(result == m_index_map.end()) {
+				THROW_LUNA_BVH_EXCEPTION_FORMAT(LUNA_BVH_EXCEPTION_NOT_FOUND,
+					"0x%x", id);
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_bvh::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			m_next = 0;
+			clear();
+		}
+
+		bool 
+		_luna_bvh::is_allocated(void)
+		{
+			return (luna_bvh::m_instance != NULL);
+		}
+
+		bool 
+		_luna_bvh::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		void 
+		_luna_bvh::prepare(void)
+		{
+
+			// topology changes rebuild, bound changes only refit
+			if(!m_built) {
+				build();
+			} else if(m_refit) {
+				refit();
+			}
+		}
+
+		size_t 
+		_luna_bvh::query_frustum(
+			__in const luna_frustum &frustum,
+			__out std::vector<uint32_t> &result
+			)
+		{
+			std::chrono::high_resolution_clock::time_point begin;
+
+			if(!m_initialized) {
+				THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_UNINITIALIZED);
+			}
+
+			prepare();
+			result.clear();
+			begin = std::chrono::high_resolution_clock::now();
+			query_frustum_tree(m_tree, frustum, m_id.data(), result);
+			m_frustum_time += BVH_ELAPSED(begin);
+			++m_frustum_count;
+
+			return result.size();
+		}
+
+		void 
+		_luna_bvh::query_frustum_tree(
+			__in const luna_bvh_tree &tree,
+			__in const luna_frustum &frustum,
+			__in_opt const uint32_t *id,
+			__out std::vector<uint32_t> &result
+			)
+		{
+			size_t iter;
+			uint32_t primitive;
+			std::pair<uint32_t, bool> entry;
+			std::vector<std::pair<uint32_t, bool>> stack;
+
+			// degenerate inputs can build trees of any depth, so the stack grows as needed
+			stack.reserve(BVH_STACK_SIZE);
+
+			if(!tree.node.empty()) {
+				stack.push_back(std::pair<uint32_t, bool>(0, false));
+			}
+
+			// nodes fully inside the frustum emit their subtree without further tests
+			while(!stack.empty()) {
+				entry = stack.back();
+				stack.pop_back();
+				const luna_bvh_node &node = tree.node[entry.first];
+
+				if(!entry.second) {
+
+					switch(bvh_classify(frustum, node.min, node.max)) {
+						case BVH_OUTSIDE:
+							continue;
+						case BVH_INSIDE:
+							entry.second = true;
+							break;
+						default:
+							break;
+					}
+				}
+
+				if(node.count) {
+
+					for(iter = node.offset; iter < (node.offset + node.count); ++iter) {
+						primitive = tree.primitive[iter];
+
+						if(entry.second || (bvh_classify(frustum, tree.bound[primitive].min, 
+								tree.bound[primitive].max) != BVH_OUTSIDE)) {
+							result.push_back(id ? id[primitive] : primitive);
+						}
+					}
+				} else {
+					stack.push_back(std::pair<uint32_t, bool>(node.offset, entry.second));
+					stack.push_back(std::pair<uint32_t, bool>(entry.first + 1, entry.second));
+				}
+			}
+		}
+
+		bool 
+		_luna_bvh::query_ray(
+			__in const luna_vec3 &origin,
+			__in const luna_vec3 &direction,
+			__in GLfloat distance_max,
+			__out uint32_t &id,
+			__out GLfloat &distance
+			)
+		{
+			bool result;
+			size_t primitive;
+			std::chrono::high_resolution_clock::time_point begin;
+
+			if(!m_initialized) {
+				THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_UNINITIALIZED);
+			}
+
+			prepare();
+			begin = std::chrono::high_resolution_clock::now();
+			result = query_ray_tree(m_tree, origin, direction, distance_max, primitive, 
+				distance);
+			m_ray_time += BVH_ELAPSED(begin);
+			++m_ray_count;
+
+			if(result) {
+				id = m_id[primitive];
+			}
+
+			return result;
+		}
+
+		bool 
+		_luna_bvh::query_ray_tree(
+			__in const luna_bvh_tree &tree,
+			__in const luna_vec3 &origin,
+			__in const luna_vec3 &direction,
+			__in GLfloat distance_max,
+			__out size_t &primitive,
+			__out GLfloat &distance
+			)
+		{
+			bool result = false;
+			GLfloat hit, hit_left, hit_right, inverse[BVH_AXIS_COUNT];
+			size_t iter, left, right;
+			std::vector<uint32_t> stack;
+
+			// deep trees only cost a reallocation here, never an overrun
+			stack.reserve(BVH_STACK_SIZE);
+			inverse[0] = 1.f / direction.x;
+			inverse[1] = 1.f / direction.y;
+			inverse[2] = 1.f / direction.z;
+
+			if(!tree.node.empty() && bvh_slab(tree.node[0].min, tree.node[0].max, &origin.x, 
+					inverse, distance_max, hit)) {
+				stack.push_back(0);
+			}
+
+			// closest hit wins, the search distance shrinks as hits are found
+			while(!stack.empty()) {
+				const luna_bvh_node &node = tree.node[stack.back()];
+				stack.pop_back();
+
+				if(!bvh_slab(node.min, node.max, &origin.x, inverse, distance_max, hit)) {
+					continue;
+				}
+
+				if(node.count) {
+
+					for(iter = node.offset; iter < (node.offset + node.count); ++iter) {
+						const luna_bvh_bound &bound = tree.bound[tree.primitive[iter]];
+
+						if(bvh_slab(bound.min, bound.max, &origin.x, inverse, distance_max, hit)) {
+							distance_max = hit;
+							distance = hit;
+							primitive = tree.primitive[iter];
+							result = true;
+						}
+					}
+				} else {
+					left = (&node - &tree.node[0]) + 1;
+					right = node.offset;
+
+					if(bvh_slab(tree.node[left].min, tree.node[left].max, &origin.x, inverse, 
+							distance_max, hit_left)) {
+
+						if(bvh_slab(tree.node[right].min, tree.node[right].max, &origin.x, 
+								inverse, distance_max, hit_right)) {
+
+							// push the farther child first so the nearer one is popped next
+							stack.push_back((hit_left < hit_right) ? right : left);
+							stack.push_back((hit_left < hit_right) ? left : right);
+						} else {
+							stack.push_back(left);
+						}
+					} else if(bvh_slab(tree.node[right].min, tree.node[right].max, &origin.x, 
+							inverse, distance_max, hit_right)) {
+						stack.push_back(right);
+					}
+				}
+			}
+
+			return result;
+		}
+
+		bool 
+		_luna_bvh::query_segment(
+			__in const luna_vec3 &begin,
+			__in const luna_vec3 &end,
+			__out uint32_t &id,
+			__out GLfloat &distance
+			)
+		{
+			GLfloat length;
+			luna_vec3 direction;
+
+			if(!m_initialized) {
+				THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_UNINITIALIZED);
+			}
+
+			luna_vec3_make(end.x - begin.x, end.y - begin.y, end.z - begin.z, direction);
+			length = luna_vec3_length(direction);
+			luna_vec3_normalize(direction, direction);
+
+			return query_ray(begin, direction, length, id, distance);
+		}
+
+		void 
+		_luna_bvh::refit(void)
+		{
+			std::chrono::high_resolution_clock::time_point begin;
+
+			if(!m_initialized) {
+				THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!m_built) {
+				build();
+			} else {
+				begin = std::chrono::high_resolution_clock::now();
+				refit_tree(m_tree);
+				m_refit_time = BVH_ELAPSED(begin);
+				m_refit = false;
+			}
+		}
+
+		void 
+		_luna_bvh::refit_tree(
+			__inout luna_bvh_tree &tree
+			)
+		{
+			size_t iter, primitive;
+
+			// children always follow their parent, so a reverse sweep is bottom-up
+			for(iter = tree.node.size(); iter-- > 0;) {
+				luna_bvh_node &node = tree.node[iter];
+
+				bvh_reset(node.min, node.max);
+
+				if(node.count) {
+
+					for(primitive = node.offset; primitive < (node.offset + node.count); 
+							++primitive) {
+						const luna_bvh_bound &bound = tree.bound[tree.primitive[primitive]];
+
+						bvh_grow(node.min, node.max, bound.min, bound.max);
+					}
+				} else {
+					bvh_grow(node.min, node.max, tree.node[iter + 1].min, 
+						tree.node[iter + 1].max);
+					bvh_grow(node.min, node.max, tree.node[node.offset].min, 
+						tree.node[node.offset].max);
+				}
+			}
+		}
+
+		void 
+		_luna_bvh::remove(
+			__in uint32_t id
+			)
+		{
+			size_t index, last;
+			std::map<uint32_t, size_t>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+			index = iter->second;
+			last = m_id.size() - 1;
+			m_tree.bound[index] = m_tree.bound[last];
+			m_id[index] = m_id[last];
+			m_tree.bound.pop_back();
+			m_id.pop_back();
+			m_index_map.erase(iter);
+
+			if(index != last) {
+				find(m_id[index])->second = index;
+			}
+
+			m_built = false;
+		}
+
+		void 
+		_luna_bvh::set(
+			__in uint32_t id,
+			__in const luna_vec3 &minimum,
+			__in const luna_vec3 &maximum
+			)
+		{
+			size_t index;
+
+			if(!m_initialized) {
+				THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_UNINITIALIZED);
+			}
+
+			if((minimum.x > maximum.x) || (minimum.y > maximum.y) || (minimum.z > maximum.z)) {
+				THROW_LUNA_BVH_EXCEPTION_FORMAT(LUNA_BVH_EXCEPTION_INVALID,
+					"0x%x", id);
+			}
+
+			index = find(id)->second;
+			luna_bvh_bound &bound = m_tree.bound[index];
+			bound.min[0] = minimum.x;
+			bound.min[1] = minimum.y;
+			bound.min[2] = minimum.z;
+			bound.max[0] = maximum.x;
+			bound.max[1] = maximum.y;
+			bound.max[2] = maximum.z;
+			m_refit = true;
+		}
+
+		size_t 
+		_luna_bvh::size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_id.size();
+		}
+
+		luna_bvh_stat 
+		_luna_bvh::stat(void)
+		{
+			luna_bvh_stat result;
+
+			if(!m_initialized) {
+				THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_UNINITIALIZED);
+			}
+
+			result.build = m_build_time;
+			result.node_count = m_tree.node.size();
+			result.primitive_count = m_id.size();
+			result.query_frustum = ((m_frustum_time > 0.0) 
+				? (m_frustum_count / m_frustum_time) : 0.0);
+			result.query_ray = ((m_ray_time > 0.0) ? (m_ray_count / m_ray_time) : 0.0);
+			result.refit = m_refit_time;
+
+			return result;
+		}
+
+		std::string 
+		_luna_bvh::to_string(
+			__in_opt bool verbose
+			)
+		{
+			luna_bvh_stat entry;
+			std::stringstream result;
+
+			result << LUNA_BVH_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_bvh_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+				entry = stat();
+				result << " CNT. " << entry.primitive_count << ", NODE. " << entry.node_count
+					<< std::fixed << std::setprecision(3) << ", BUILD. " << entry.build 
+					<< " ms, REFIT. " << entry.refit << " ms, FRUSTUM. " 
+					<< entry.query_frustum << "/ms, RAY. " << entry.query_ray << "/ms";
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_bvh::uninitialize(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_BVH_EXCEPTION(LUNA_BVH_EXCEPTION_UNINITIALIZED);
+			}
+
+			clear();
+			m_initialized = false;
+		}
+	}
+}
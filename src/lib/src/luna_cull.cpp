@@ -0,0 +1,679 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "../include/luna.h"
+#include "../include/luna_cull_type.h"
+
+#ifdef __AVX__
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif // __AVX__
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define CULL_BLOCK_COUNT(_COUNT_) (((_COUNT_) + CULL_BLOCK - 1) / CULL_BLOCK)
+		#define CULL_PLANE_COUNT 6
+
+		// an aabb is outside a plane if its center is further than its projected extent
+		static size_t 
+		cull_aabb(
+			__in const luna_frustum &frustum,
+			__in const GLfloat *x,
+			__in const GLfloat *y,
+			__in const GLfloat *z,
+			__in const GLfloat *extent_x,
+			__in const GLfloat *extent_y,
+			__in const GLfloat *extent_z,
+			__in const uint32_t *id,
+			__in size_t count,
+			__out uint32_t *out
+			)
+		{
+			bool inside;
+			size_t iter = 0, plane, result = 0;
+
+#ifdef __AVX__
+			for(; (iter + 8) <= count; iter += 8) {
+				__m256 center_x, center_y, center_z, distance, extent_x_256, extent_y_256, 
+					extent_z_256, radius, visible;
+				uint32_t lane, mask;
+
+				center_x = _mm256_loadu_ps(&x[iter]);
+				center_y = _mm256_loadu_ps(&y[iter]);
+				center_z = _mm256_loadu_ps(&z[iter]);
+				extent_x_256 = _mm256_loadu_ps(&extent_x[iter]);
+				extent_y_256 = _mm256_loadu_ps(&extent_y[iter]);
+				extent_z_256 = _mm256_loadu_ps(&extent_z[iter]);
+				visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+				for(plane = 0; plane < CULL_PLANE_COUNT; ++plane) {
+					const luna_vec4 &entry = frustum.plane[plane];
+
+					distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(center_x, 
+						_mm256_set1_ps(entry.x)), _mm256_mul_ps(center_y, 
+						_mm256_set1_ps(entry.y))), _mm256_add_ps(_mm256_mul_ps(center_z, 
+						_mm256_set1_ps(entry.z)), _mm256_set1_ps(entry.w)));
+					radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(extent_x_256, 
+						_mm256_set1_ps(std::fabs(entry.x))), _mm256_mul_ps(extent_y_256, 
+						_mm256_set1_ps(std::fabs(entry.y)))), _mm256_mul_ps(extent_z_256, 
+						_mm256_set1_ps(std::fabs(entry.z))));
+					visible = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_add_ps(distance, 
+						radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+				}
+
+				// branchless compaction, every lane is written but only visible ones advance
+				mask = _mm256_movemask_ps(visible);
+				for(lane = 0; lane < 8; ++lane) {
+					out[result] = id[iter + lane];
+					result += ((mask >> lane) & 1);
+				}
+			}
+#endif // __AVX__
+#ifdef __SSE__
+			for(; (iter + 4) <= count; iter += 4) {
+				__m128 center_x, center_y, center_z, distance, extent_x_128, extent_y_128, 
+					extent_z_128, radius, visible;
+				uint32_t lane, mask;
+
+				center_x = _mm_loadu_ps(&x[iter]);
+				center_y = _mm_loadu_ps(&y[iter]);
+				center_z = _mm_loadu_ps(&z[iter]);
+				extent_x_128 = _mm_loadu_ps(&extent_x[iter]);
+				extent_y_128 = _mm_loadu_ps(&extent_y[iter]);
+				extent_z_128 = _mm_loadu_ps(&extent_z[iter]);
+				visible = _mm_cmpeq_ps(center_x, center_x);
+
+				for(plane = 0; plane < CULL_PLANE_COUNT; ++plane) {
+					const luna_vec4 &entry = frustum.plane[plane];
+
+					distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(center_x, _mm_set1_ps(entry.x)), 
+						_mm_mul_ps(center_y, _mm_set1_ps(entry.y))), _mm_add_ps(_mm_mul_ps(
+						center_z, _mm_set1_ps(entry.z)), _mm_set1_ps(entry.w)));
+					radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(extent_x_128, 
+						_mm_set1_ps(std::fabs(entry.x))), _mm_mul_ps(extent_y_128, 
+						_mm_set1_ps(std::fabs(entry.y)))), _mm_mul_ps(extent_z_128, 
+						_mm_set1_ps(std::fabs(entry.z))));
+					visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(distance, radius), 
+						_mm_setzero_ps()));
+				}
+
+				mask = _mm_movemask_ps(visible);
+				for(lane = 0; lane < 4; ++lane) {
+					out[result] = id[iter + lane];
+					result += ((mask >> lane) & 1);
+				}
+			}
+#endif // __SSE__
+
+			for(; iter < count; ++iter) {
+				inside = true;
+
+				for(plane = 0; plane < CULL_PLANE_COUNT; ++plane) {
+					const luna_vec4 &entry = frustum.plane[plane];
+
+					inside &= ((((entry.x * x[iter]) + (entry.y * y[iter]) + (entry.z * z[iter]) 
+						+ entry.w) + ((std::fabs(entry.x) * extent_x[iter]) 
+						+ (std::fabs(entry.y) * extent_y[iter]) 
+						+ (std::fabs(entry.z) * extent_z[iter]))) >= 0.f);
+				}
+
+				out[result] = id[iter];
+				result += inside;
+			}
+
+			return result;
+		}
+
+		static size_t 
+		cull_sphere(
+			__in const luna_frustum &frustum,
+			__in const GLfloat *x,
+			__in const GLfloat *y,
+			__in const GLfloat *z,
+			__in const GLfloat *radius,
+			__in const uint32_t *id,
+			__in size_t count,
+			__out uint32_t *out
+			)
+		{
+			bool inside;
+			size_t iter = 0, plane, result = 0;
+
+#ifdef __AVX__
+			for(; (iter + 8) <= count; iter += 8) {
+				__m256 center_x, center_y, center_z, distance, radius_256, visible;
+				uint32_t lane, mask;
+
+				center_x = _mm256_loadu_ps(&x[iter]);
+				center_y = _mm256_loadu_ps(&y[iter]);
+				center_z = _mm256_loadu_ps(&z[iter]);
+				radius_256 = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&radius[iter]));
+				visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+				for(plane = 0; plane < CULL_PLANE_COUNT; ++plane) {
+					const luna_vec4 &entry = frustum.plane[plane];
+
+					distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(center_x, 
+						_mm256_set1_ps(entry.x)), _mm256_mul_ps(center_y, 
+						_mm256_set1_ps(entry.y))), _mm256_add_ps(_mm256_mul_ps(center_z, 
+						_mm256_set1_ps(entry.z)), _mm256_set1_ps(entry.w)));
+					visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, radius_256, 
+						_CMP_GE_OQ));
+				}
+
+				mask = _mm256_movemask_ps(visible);
+				for(lane = 0; lane < 8; ++lane) {
+					out[result] = id[iter + lane];
+					result += ((mask >> lane) & 1);
+				}
+			}
+#endif // __AVX__
+#ifdef __SSE__
+			for(; (iter + 4) <= count; iter += 4) {
+				__m128 center_x, center_y, center_z, distance, radius_128, visible;
+				uint32_t lane, mask;
+
+				center_x = _mm_loadu_ps(&x[iter]);
+				center_y = _mm_loadu_ps(&y[iter]);
+				center_z = _mm_loadu_ps(&z[iter]);
+				radius_128 = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&radius[iter]));
+				visible = _mm_cmpeq_ps(center_x, center_x);
+
+				for(plane = 0; plane < CULL_PLANE_COUNT; ++plane) {
+					const luna_vec4 &entry = frustum.plane[plane];
+
+					distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(center_x, _mm_set1_ps(entry.x)), 
+						_mm_mul_ps(center_y, _mm_set1_ps(entry.y))), _mm_add_ps(_mm_mul_ps(
+						center_z, _mm_set1_ps(entry.z)), _mm_set1_ps(entry.w)));
+					visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, radius_128));
+				}
+
+				mask = _mm_movemask_ps(visible);
+				for(lane = 0; lane < 4; ++lane) {
+					out[result] = id[iter + lane];
+					result += ((mask >> lane) & 1);
+				}
+			}
+#endif // __SSE__
+
+			for(; iter < count; ++iter) {
+				inside = true;
+
+				for(plane = 0; plane < CULL_PLANE_COUNT; ++plane) {
+					const luna_vec4 &entry = frustum.plane[plane];
+
+					inside &= (((entry.x * x[iter]) + (entry.y * y[iter]) + (entry.z * z[iter]) 
+						+ entry.w) >= -radius[iter]);
+				}
+
+				out[result] = id[iter];
+				result += inside;
+			}
+
+			return result;
+		}
+
+		_luna_cull *_luna_cull::m_instance = NULL;
+
+		_luna_cull::_luna_cull(void) :
+			m_initialized(false),
+			m_next(0),
+			m_tested(0)
+		{
+			std::atexit(luna_cull::_delete);
+		}
+
+		_luna_cull::~_luna_cull(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_cull::_delete(void)
+		{
+
+			if(luna_cull::m_instance) {
+				delete luna_cull::m_instance;
+				luna_cull::m_instance = NULL;
+			}
+		}
+
+		_luna_cull *
+		_luna_cull::acquire(void)
+		{
+
+			if(!luna_cull::m_instance) {
+
+				luna_cull::m_instance = new luna_cull;
+				if(!luna_cull::m_instance) {
+					THROW_LUNA_CULL_EXCEPTION(LUNA_CULL_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_cull::m_instance;
+		}
+
+		uint32_t 
+		_luna_cull::add_aabb(
+			__in const luna_vec3 &minimum,
+			__in const luna_vec3 &maximum
+			)
+		{
+			luna_cull_entry entry;
+
+			if(!m_initialized) {
+				THROW_LUNA_CULL_EXCEPTION(LUNA_CULL_EXCEPTION_UNINITIALIZED);
+			}
+
+			// bounds are checked before anything is stored, so a bad add leaves no entry
+			if((minimum.x > maximum.x) || (minimum.y > maximum.y) || (minimum.z > maximum.z)) {
+				THROW_LUNA_CULL_EXCEPTION_FORMAT(LUNA_CULL_EXCEPTION_INVALID,
+					"(%f, %f, %f) > (%f, %f, %f)", minimum.x, minimum.y, minimum.z, 
+					maximum.x, maximum.y, maximum.z);
+			}
+
+			entry.index = m_aabb_id.size();
+			entry.type = CULL_AABB;
+			m_aabb_extent_x.push_back(0.f);
+			m_aabb_extent_y.push_back(0.f);
+			m_aabb_extent_z.push_back(0.f);
+			m_aabb_id.push_back(++m_next);
+			m_aabb_x.push_back(0.f);
+			m_aabb_y.push_back(0.f);
+			m_aabb_z.push_back(0.f);
+			m_index_map.insert(std::pair<uint32_t, luna_cull_entry>(m_next, entry));
+			set_aabb(m_next, minimum, maximum);
+
+			return m_next;
+		}
+
+		uint32_t 
+		_luna_cull::add_sphere(
+			__in const luna_vec3 &center,
+			__in GLfloat radius
+			)
+		{
+			luna_cull_entry entry;
+
+			if(!m_initialized) {
+				THROW_LUNA_CULL_EXCEPTION(LUNA_CULL_EXCEPTION_UNINITIALIZED);
+			}
+
+			// the radius is checked before anything is stored, so a bad add leaves no entry
+			if(radius < 0.f) {
+				THROW_LUNA_CULL_EXCEPTION_FORMAT(LUNA_CULL_EXCEPTION_INVALID,
+					"%f", radius);
+			}
+
+			entry.index = m_sphere_id.size();
+			entry.type = CULL_SPHERE;
+			m_sphere_id.push_back(++m_next);
+			m_sphere_radius.push_back(0.f);
+			m_sphere_x.push_back(0.f);
+			m_sphere_y.push_back(0.f);
+			m_sphere_z.push_back(0.f);
+			m_index_map.insert(std::pair<uint32_t, luna_cull_entry>(m_next, entry));
+			set_sphere(m_next, center, radius);
+
+			return m_next;
+		}
+
+		void 
+		_luna_cull::clear(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_CULL_EXCEPTION(LUNA_CULL_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_aabb_extent_x.clear();
+			m_aabb_extent_y.clear();
+			m_aabb_extent_z.clear();
+			m_aabb_id.clear();
+			m_aabb_x.clear();
+			m_aabb_y.clear();
+			m_aabb_z.clear();
+			m_block_count.clear();
+			m_index_map.clear();
+			m_scratch.clear();
+			m_sphere_id.clear();
+			m_sphere_radius.clear();
+			m_sphere_x.clear();
+			m_sphere_y.clear();
+			m_sphere_z.clear();
+			m_tested = 0;
+			m_visible.clear();
+		}
+
+		bool 
+		_luna_cull::contains(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_CULL_EXCEPTION(LUNA_CULL_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (m_index_map.find(id) != m_index_map.end());
+		}
+
+		size_t 
+		_luna_cull::cull(
+			__in const luna_mat4 &view_projection
+			)
+		{
+			size_t blocks, iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_CULL_EXCEPTION(LUNA_CULL_EXCEPTION_UNINITIALIZED);
+			}
+
+			luna_frustum_from_matrix(view_projection, m_frustum);
+			blocks = CULL_BLOCK_COUNT(m_sphere_id.size()) + CULL_BLOCK_COUNT(m_aabb_id.size());
+			m_block_count.resize(blocks);
+			m_scratch.resize(blocks * CULL_BLOCK);
+			m_tested = m_sphere_id.size() + m_aabb_id.size();
+			m_visible.clear();
+
+			// each block writes its survivors into its own scratch slice
+			if((blocks > 1) && luna_job::is_allocated() && luna_job::acquire()->is_initialized()) {
+				luna_job::acquire()->run(blocks, luna_cull::cull_range, this);
+			} else {
+				cull_range(0, blocks, this);
+			}
+
+			for(iter = 0; iter < blocks; ++iter) {
+				m_visible.insert(m_visible.end(), m_scratch.begin() + (iter * CULL_BLOCK), 
+					m_scratch.begin() + (iter * CULL_BLOCK) + m_block_count[iter]);
+			}
+
+			return m_visible.size();
+		}
+
+		void 
+		_luna_cull::cull_range(
+			__in size_t begin,
+			__in size_t end,
+			__in void *context
+			)
+		{
+			size_t block, count, offset, spheres;
+			luna_cull_ptr instance = (luna_cull_ptr) context;
+
+			spheres = CULL_BLOCK_COUNT(instance->m_sphere_id.size());
+
+			for(block = begin; block < end; ++block) {
+
+				if(block < spheres) {
+					offset = block * CULL_BLOCK;
+					count = std::min((size_t) CULL_BLOCK, instance->m_sphere_id.size() - offset);
+					instance->m_block_count[block] = cull_sphere(instance->m_frustum, 
+						&instance->m_sphere_x[offset], &instance->m_sphere_y[offset], 
+						&instance->m_sphere_z[offset], &instance->m_sphere_radius[offset], 
+						&instance->m_sphere_id[offset], count, 
+						&instance->m_scratch[block * CULL_BLOCK]);
+				} else {
+					offset = (block - spheres) * CULL_BLOCK;
+					count = std::min((size_t) CULL_BLOCK, instance->m_aabb_id.size() - offset);
+					instance->m_block_count[block] = cull_aabb(instance->m_frustum, 
+						&instance->m_aabb_x[offset], &instance->m_aabb_y[offset], 
+						&instance->m_aabb_z[offset], &instance->m_aabb_extent_x[offset], 
+						&instance->m_aabb_extent_y[offset], &instance->m_aabb_extent_z[offset], 
+						&instance->m_aabb_id[offset], count, 
+						&instance->m_scratch[block * CULL_BLOCK]);
+				}
+			}
+		}
+
+		std::map<uint32_t, luna_cull_entry>::iterator 
+		_luna_cull::find(
+			__in uint32_t id
+			)
+		{
+			std::map<uint32_t, luna_cull_entry>::iterator result;
+
+			if(!m_initialized) {
+				THROW_LUNA_CULL_EXCEPTION(LUNA_CULL_EXCEPTION_UNINITIALIZED);
+			}
+
+			result = m_index_map.find(id);
+			if(result == m_index_map.end()) {
+				THROW_LUNA_CULL_EXCEPTION_FORMAT(LUNA_CULL_EXCEPTION_NOT_FOUND,
+					"0x%x", id);
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_cull::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_CULL_EXCEPTION(LUNA_CULL_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			m_next = 0;
+			clear();
+		}
+
+		bool 
+		_luna_cull::is_allocated(void)
+		{
+			return (luna_cull::m_instance != NULL);
+		}
+
+		bool 
+		_luna_cull::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		double 
+		_luna_cull::ratio(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_CULL_EXCEPTION(LUNA_CULL_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (m_tested ? ((m_tested - m_visible.size()) / (double) m_tested) : 0.0);
+		}
+
+		void 
+		_luna_cull::remove(
+			__in uint32_t id
+			)
+		{
+			size_t index, last;
+			std::map<uint32_t, luna_cull_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_CULL_EXCEPTION(LUNA_CULL_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+			index = iter->second.index;
+
+			// swap the final entry into the hole so the arrays stay dense
+			if(iter->second.type == CULL_SPHERE) {
+				last = m_sphere_id.size() - 1;
+				m_sphere_id[index] = m_sphere_id[last];
+				m_sphere_radius[index] = m_sphere_radius[last];
+				m_sphere_x[index] = m_sphere_x[last];
+				m_sphere_y[index] = m_sphere_y[last];
+				m_sphere_z[index] = m_sphere_z[last];
+				m_sphere_id.pop_back();
+				m_sphere_radius.pop_back();
+				m_sphere_x.pop_back();
+				m_sphere_y.pop_back();
+				m_sphere_z.pop_back();
+
+				if(index != last) {
+					find(m_sphere_id[index])->second.index = index;
+				}
+			} else {
+				last = m_aabb_id.size() - 1;
+				m_aabb_extent_x[index] = m_aabb_extent_x[last];
+				m_aabb_extent_y[index] = m_aabb_extent_y[last];
+				m_aabb_extent_z[index] = m_aabb_extent_z[last];
+				m_aabb_id[index] = m_aabb_id[last];
+				m_aabb_x[index] = m_aabb_x[last];
+				m_aabb_y[index] = m_aabb_y[last];
+				m_aabb_z[index] = m_aabb_z[last];
+				m_aabb_extent_x.pop_back();
+				m_aabb_extent_y.pop_back();
+				m_aabb_extent_z.pop_back();
+				m_aabb_id.pop_back();
+				m_aabb_x.pop_back();
+				m_aabb_y.pop_back();
+				m_aabb_z.pop_back();
+
+				if(index != last) {
+					find(m_aabb_id[index])->second.index = index;
+				}
+			}
+
+			m_index_map.erase(iter);
+		}
+
+		void 
+		_luna_cull::set_aabb(
+			__in uint32_t id,
+			__in const luna_vec3 &minimum,
+			__in const luna_vec3 &maximum
+			)
+		{
+			std::map<uint32_t, luna_cull_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_CULL_EXCEPTION(LUNA_CULL_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+			if((iter->second.type != CULL_AABB) || (minimum.x > maximum.x) 
+					|| (minimum.y > maximum.y) || (minimum.z > maximum.z)) {
+				THROW_LUNA_CULL_EXCEPTION_FORMAT(LUNA_CULL_EXCEPTION_INVALID,
+					"0x%x", id);
+			}
+
+			// stored as center/half-extent, which is what the plane test wants
+			m_aabb_extent_x[iter->second.index] = (maximum.x - minimum.x) * 0.5f;
+			m_aabb_extent_y[iter->second.index] = (maximum.y - minimum.y) * 0.5f;
+			m_aabb_extent_z[iter->second.index] = (maximum.z - minimum.z) * 0.5f;
+			m_aabb_x[iter->second.index] = (maximum.x + minimum.x) * 0.5f;
+			m_aabb_y[iter->second.index] = (maximum.y + minimum.y) * 0.5f;
+			m_aabb_z[iter->second.index] = (maximum.z + minimum.z) * 0.5f;
+		}
+
+		void 
+		_luna_cull::set_sphere(
+			__in uint32_t id,
+			__in const luna_vec3 &center,
+			__in GLfloat radius
+			)
+		{
+			std::map<uint32_t, luna_cull_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_CULL_EXCEPTION(LUNA_CULL_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+			if((iter->second.type != CULL_SPHERE) || (radius < 0.f)) {
+				THROW_LUNA_CULL_EXCEPTION_FORMAT(LUNA_CULL_EXCEPTION_INVALID,
+					"0x%x", id);
+			}
+
+			m_sphere_radius[iter->second.index] = radius;
+			m_sphere_x[iter->second.index] = center.x;
+			m_sphere_y[iter->second.index] = center.y;
+			m_sphere_z[iter->second.index] = center.z;
+		}
+
+		size_t 
+		_luna_cull::size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_CULL_EXCEPTION(LUNA_CULL_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_index_map.size();
+		}
+
+		std::string 
+		_luna_cull::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+
+			result << LUNA_CULL_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_cull_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+				result << " SPHERE. " << m_sphere_id.size() << ", AABB. " << m_aabb_id.size()
+					<< ", VIS. " << m_visible.size() << "/" << m_tested << " (" 
+					<< std::fixed << std::setprecision(1) << (ratio() * 100.0) 
+					<< "% culled)";
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_cull::uninitialize(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_CULL_EXCEPTION(LUNA_CULL_EXCEPTION_UNINITIALIZED);
+			}
+
+			clear();
+			m_initialized = false;
+		}
+
+		const std::vector<uint32_t> &
+		_luna_cull::visible(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_CULL_EXCEPTION(LUNA_CULL_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_visible;
+		}
+	}
+}
@@ -152,6 +152,7 @@ namespace LUNA {
 
 		_luna_display::_luna_display(void) :
 			m_initialized(false),
+			m_loader_context(NULL),
 			m_running(false),
 			m_window(NULL),
 			m_window_context(NULL)
@@ -247,6 +248,21 @@ namespace LUNA {
 			return m_running;
 		}
 
+		SDL_GLContext 
+		_luna_display::loader_context(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_DISPLAY_EXCEPTION(LUNA_DISPLAY_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!m_running) {
+				THROW_LUNA_DISPLAY_EXCEPTION(LUNA_DISPLAY_EXCEPTION_STOPPED);
+			}
+
+			return m_loader_context;
+		}
+
 		void 
 		_luna_display::set(
 			__in const luna_display_config &config
@@ -309,6 +325,14 @@ namespace LUNA {
 					"OpenGL version unsupported: %s", glGetString(GL_VERSION));
 			}
 
+			// a second context sharing objects with the first lets a loader thread upload
+			// in the background, drivers that refuse simply leave uploads on this thread
+			SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+			m_loader_context = SDL_GL_CreateContext(m_window);
+			SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+
+			// creating a context makes it current, so the window context is restored
+			SDL_GL_MakeCurrent(m_window, m_window_context);
 			SDL_GL_SetSwapInterval(DISPLAY_SWAP_INTERVAL);
 			m_running = true;
 		}
@@ -327,6 +351,11 @@ namespace LUNA {
 
 			m_running = false;
 
+			if(m_loader_context) {
+				SDL_GL_DeleteContext(m_loader_context);
+				m_loader_context = NULL;
+			}
+
 			if(m_window_context) {
 				SDL_GL_DeleteContext(m_window_context);
 				m_window_context = NULL;
@@ -0,0 +1,829 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include "../include/luna.h"
+#include "../include/luna_entity_type.h"
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define ENTITY_ALIGN(_VAL_) \
+			(((_VAL_) + (ENTITY_COLUMN_ALIGNMENT - 1)) & ~((size_t) ENTITY_COLUMN_ALIGNMENT - 1))
+		#define ENTITY_COLUMN_INVALID SCALAR_INVALID(size_t)
+
+		// ids carry a generation above the record index, so a handle to a removed entity
+		// does not resolve to whatever entity reuses its record
+		#define ENTITY_INDEX_BITS 22
+		#define ENTITY_INDEX_MAX ((((uint32_t) 1) << ENTITY_INDEX_BITS) - 1)
+		#define ENTITY_GENERATION(_ID_) ((_ID_) >> ENTITY_INDEX_BITS)
+		#define ENTITY_GENERATION_MAX (UINT32_MAX >> ENTITY_INDEX_BITS)
+		#define ENTITY_ID(_INDEX_, _GENERATION_) \
+			((((uint32_t) (_GENERATION_)) << ENTITY_INDEX_BITS) | (_INDEX_))
+		#define ENTITY_INDEX(_ID_) ((_ID_) & ENTITY_INDEX_MAX)
+
+		_luna_entity *_luna_entity::m_instance = NULL;
+
+		_luna_entity::_luna_entity(void) :
+			m_batch(0),
+			m_initialized(false),
+			m_running(false),
+			m_scheduled(true),
+			m_size(0),
+			m_system_next(0),
+			m_tick(0)
+		{
+			std::atexit(luna_entity::_delete);
+		}
+
+		_luna_entity::~_luna_entity(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_entity::_delete(void)
+		{
+
+			if(luna_entity::m_instance) {
+				delete luna_entity::m_instance;
+				luna_entity::m_instance = NULL;
+			}
+		}
+
+		_luna_entity *
+		_luna_entity::acquire(void)
+		{
+
+			if(!luna_entity::m_instance) {
+
+				luna_entity::m_instance = new luna_entity;
+				if(!luna_entity::m_instance) {
+					THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_entity::m_instance;
+		}
+
+		uint32_t 
+		_luna_entity::add(
+			__in_opt uint64_t signature
+			)
+		{
+			uint32_t index;
+			size_t archetype;
+			luna_entity_record record = luna_entity_record();
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(m_running) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_RUNNING);
+			}
+
+			if(m_free.empty() && (m_record.size() >= ENTITY_INDEX_MAX)) {
+				THROW_LUNA_ENTITY_EXCEPTION_FORMAT(LUNA_ENTITY_EXCEPTION_FULL,
+					"%lu entities", (unsigned long) m_record.size());
+			}
+
+			archetype = find_archetype(signature);
+
+			if(!m_free.empty()) {
+				index = m_free.back();
+				m_free.pop_back();
+			} else {
+				m_record.push_back(record);
+				index = m_record.size();
+			}
+
+			m_record[index - 1].alive = true;
+			allocate_row(archetype, ENTITY_ID(index, m_record[index - 1].generation));
+			++m_size;
+
+			return ENTITY_ID(index, m_record[index - 1].generation);
+		}
+
+		uint32_t 
+		_luna_entity::add_component(
+			__in const std::string &name,
+			__in size_t size
+			)
+		{
+			luna_entity_component component;
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(m_running) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_RUNNING);
+			}
+
+			if(m_component.size() >= ENTITY_COMPONENT_MAX) {
+				THROW_LUNA_ENTITY_EXCEPTION_FORMAT(LUNA_ENTITY_EXCEPTION_FULL,
+					"%s", STRING_CHECK(name));
+			}
+
+			if((sizeof(uint32_t) + ENTITY_ALIGN(size)) > (ENTITY_CHUNK_SIZE 
+					- ENTITY_COLUMN_ALIGNMENT)) {
+				THROW_LUNA_ENTITY_EXCEPTION_FORMAT(LUNA_ENTITY_EXCEPTION_INVALID,
+					"%s (%u bytes)", STRING_CHECK(name), (uint32_t) size);
+			}
+
+			component.name = name;
+			component.size = size;
+			m_component.push_back(component);
+
+			return (m_component.size() - 1);
+		}
+
+		uint32_t 
+		_luna_entity::add_system(
+			__in uint64_t read,
+			__in uint64_t write,
+			__in luna_entity_system_cb callback,
+			__in_opt void *context
+			)
+		{
+			luna_entity_system system;
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(m_running) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_RUNNING);
+			}
+
+			if(!callback) {
+				THROW_LUNA_ENTITY_EXCEPTION_FORMAT(LUNA_ENTITY_EXCEPTION_INVALID,
+					"callback 0x%p", callback);
+			}
+
+			system.callback = callback;
+			system.context = context;
+			system.read = read;
+			system.write = write;
+			m_system_map.insert(std::pair<uint32_t, luna_entity_system>(++m_system_next, 
+				system));
+			m_scheduled = false;
+
+			return m_system_next;
+		}
+
+		void 
+		_luna_entity::allocate_row(
+			__in size_t archetype,
+			__in uint32_t id
+			)
+		{
+			size_t iter;
+			luna_entity_chunk chunk;
+			luna_entity_archetype &entry = m_archetype[archetype];
+			luna_entity_record &record = m_record[ENTITY_INDEX(id) - 1];
+
+			// every chunk but the last is kept full
+			if(entry.chunk.empty() || (entry.chunk.back().count == entry.capacity)) {
+				chunk.count = 0;
+				chunk.data.resize(ENTITY_CHUNK_SIZE, 0);
+				entry.chunk.push_back(chunk);
+			}
+
+			luna_entity_chunk &target = entry.chunk.back();
+			record.archetype = archetype;
+			record.chunk = entry.chunk.size() - 1;
+			record.row = target.count++;
+			((uint32_t *) &target.data[0])[record.row] = id;
+
+			for(iter = 0; iter < m_component.size(); ++iter) {
+
+				if(entry.offset[iter] != ENTITY_COLUMN_INVALID) {
+					std::memset(&target.data[entry.offset[iter] 
+						+ (record.row * m_component[iter].size)], 0, m_component[iter].size);
+				}
+			}
+
+			++entry.count;
+		}
+
+		size_t 
+		_luna_entity::archetype_count(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_archetype.size();
+		}
+
+		void 
+		_luna_entity::attach(
+			__in uint32_t id,
+			__in uint32_t component
+			)
+		{
+			uint64_t signature;
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(component >= m_component.size()) {
+				THROW_LUNA_ENTITY_EXCEPTION_FORMAT(LUNA_ENTITY_EXCEPTION_INVALID,
+					"component %u", component);
+			}
+
+			signature = m_archetype[find_entity(id)->archetype].signature;
+			if(!(signature & ENTITY_MASK(component))) {
+				move(id, signature | ENTITY_MASK(component));
+			}
+		}
+
+		void 
+		_luna_entity::clear(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(m_running) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_RUNNING);
+			}
+
+			m_archetype.clear();
+			m_archetype_map.clear();
+			m_component.clear();
+			m_free.clear();
+			m_record.clear();
+			m_schedule.clear();
+			m_scheduled = true;
+			m_size = 0;
+			m_system_map.clear();
+		}
+
+		bool 
+		_luna_entity::contains(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (ENTITY_INDEX(id) && (ENTITY_INDEX(id) <= m_record.size()) 
+				&& m_record[ENTITY_INDEX(id) - 1].alive 
+				&& (m_record[ENTITY_INDEX(id) - 1].generation == ENTITY_GENERATION(id)));
+		}
+
+		void *
+		_luna_entity::data(
+			__in uint32_t id,
+			__in uint32_t component
+			)
+		{
+			void *result = NULL;
+			std::vector<luna_entity_record>::iterator record;
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			record = find_entity(id);
+
+			luna_entity_archetype &entry = m_archetype[record->archetype];
+			if((component >= m_component.size()) 
+					|| !(entry.signature & ENTITY_MASK(component))) {
+				THROW_LUNA_ENTITY_EXCEPTION_FORMAT(LUNA_ENTITY_EXCEPTION_NOT_FOUND,
+					"0x%x (component %u)", id, component);
+			}
+
+			if(entry.offset[component] != ENTITY_COLUMN_INVALID) {
+				result = &entry.chunk[record->chunk].data[entry.offset[component] 
+					+ (record->row * m_component[component].size)];
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_entity::detach(
+			__in uint32_t id,
+			__in uint32_t component
+			)
+		{
+			uint64_t signature;
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(component >= m_component.size()) {
+				THROW_LUNA_ENTITY_EXCEPTION_FORMAT(LUNA_ENTITY_EXCEPTION_INVALID,
+					"component %u", component);
+			}
+
+			signature = m_archetype[find_entity(id)->archetype].signature;
+			if(signature & ENTITY_MASK(component)) {
+				move(id, signature & ~ENTITY_MASK(component));
+			}
+		}
+
+		size_t 
+		_luna_entity::find_archetype(
+			__in uint64_t signature
+			)
+		{
+			size_t iter, offset;
+			luna_entity_archetype entry;
+			size_t result = m_archetype.size(), stride = sizeof(uint32_t);
+			std::map<uint64_t, size_t>::iterator archetype;
+
+			archetype = m_archetype_map.find(signature);
+			if(archetype != m_archetype_map.end()) {
+				result = archetype->second;
+			} else {
+
+				if((m_component.size() < ENTITY_COMPONENT_MAX) 
+						&& (signature >> m_component.size())) {
+					THROW_LUNA_ENTITY_EXCEPTION_FORMAT(LUNA_ENTITY_EXCEPTION_INVALID,
+						"signature 0x%llx", (unsigned long long) signature);
+				}
+
+				for(iter = 0; iter < m_component.size(); ++iter) {
+
+					if(signature & ENTITY_MASK(iter)) {
+						stride += m_component[iter].size;
+					}
+				}
+
+				// shrink the row count until the aligned columns fit in one chunk
+				for(entry.capacity = (ENTITY_CHUNK_SIZE / stride); entry.capacity; 
+						--entry.capacity) {
+					offset = ENTITY_ALIGN(entry.capacity * sizeof(uint32_t));
+
+					for(iter = 0; iter < ENTITY_COMPONENT_MAX; ++iter) {
+						entry.offset[iter] = ENTITY_COLUMN_INVALID;
+
+						if((iter < m_component.size()) && (signature & ENTITY_MASK(iter))
+								&& m_component[iter].size) {
+							entry.offset[iter] = offset;
+							offset = ENTITY_ALIGN(offset + (entry.capacity 
+								* m_component[iter].size));
+						}
+					}
+
+					if(offset <= ENTITY_CHUNK_SIZE) {
+						break;
+					}
+				}
+
+				if(!entry.capacity) {
+					THROW_LUNA_ENTITY_EXCEPTION_FORMAT(LUNA_ENTITY_EXCEPTION_INVALID,
+						"signature 0x%llx (%u bytes)", (unsigned long long) signature, 
+						(uint32_t) stride);
+				}
+
+				entry.count = 0;
+				entry.signature = signature;
+				m_archetype.push_back(entry);
+				m_archetype_map.insert(std::pair<uint64_t, size_t>(signature, result));
+			}
+
+			return result;
+		}
+
+		std::vector<luna_entity_record>::iterator 
+		_luna_entity::find_entity(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			// stale handles fail the generation check once their record is reused
+			if(!contains(id)) {
+				THROW_LUNA_ENTITY_EXCEPTION_FORMAT(LUNA_ENTITY_EXCEPTION_NOT_FOUND,
+					"0x%x", id);
+			}
+
+			return (m_record.begin() + (ENTITY_INDEX(id) - 1));
+		}
+
+		void 
+		_luna_entity::free_row(
+			__in size_t archetype,
+			__in size_t chunk,
+			__in size_t row
+			)
+		{
+			uint32_t moved;
+			size_t iter, last;
+			luna_entity_archetype &entry = m_archetype[archetype];
+			luna_entity_chunk &source = entry.chunk.back(), &target = entry.chunk[chunk];
+
+			// fill the hole with the final row to keep chunks dense
+			last = source.count - 1;
+			if((&source != &target) || (row != last)) {
+				moved = ((uint32_t *) &source.data[0])[last];
+				((uint32_t *) &target.data[0])[row] = moved;
+
+				for(iter = 0; iter < m_component.size(); ++iter) {
+
+					if(entry.offset[iter] != ENTITY_COLUMN_INVALID) {
+						std::memcpy(&target.data[entry.offset[iter] 
+							+ (row * m_component[iter].size)], &source.data[entry.offset[iter] 
+							+ (last * m_component[iter].size)], m_component[iter].size);
+					}
+				}
+
+				m_record[ENTITY_INDEX(moved) - 1].chunk = chunk;
+				m_record[ENTITY_INDEX(moved) - 1].row = row;
+			}
+
+			--entry.count;
+			if(!--source.count) {
+				entry.chunk.pop_back();
+			}
+		}
+
+		bool 
+		_luna_entity::has(
+			__in uint32_t id,
+			__in uint32_t component
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			return ((component < m_component.size()) 
+				&& (m_archetype[find_entity(id)->archetype].signature 
+					& ENTITY_MASK(component)));
+		}
+
+		void 
+		_luna_entity::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			m_system_next = 0;
+			clear();
+		}
+
+		bool 
+		_luna_entity::is_allocated(void)
+		{
+			return (luna_entity::m_instance != NULL);
+		}
+
+		bool 
+		_luna_entity::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		void 
+		_luna_entity::iterate(
+			__in uint64_t include,
+			__in uint64_t exclude,
+			__in luna_entity_system_cb callback,
+			__in void *context,
+			__in uint32_t tick
+			)
+		{
+			size_t column;
+			luna_entity_view view;
+			std::vector<luna_entity_chunk>::iterator chunk;
+			std::vector<luna_entity_archetype>::iterator archetype;
+
+			view.tick = tick;
+
+			for(archetype = m_archetype.begin(); archetype != m_archetype.end(); ++archetype) {
+
+				if(((archetype->signature & include) != include) 
+						|| (archetype->signature & exclude)) {
+					continue;
+				}
+
+				for(chunk = archetype->chunk.begin(); chunk != archetype->chunk.end(); ++chunk) {
+					view.count = chunk->count;
+					view.entity = (const uint32_t *) &chunk->data[0];
+
+					for(column = 0; column < ENTITY_COMPONENT_MAX; ++column) {
+						view.column[column] = ((archetype->offset[column] != ENTITY_COLUMN_INVALID) 
+							? &chunk->data[archetype->offset[column]] : NULL);
+					}
+
+					callback(view, context);
+				}
+			}
+		}
+
+		void 
+		_luna_entity::move(
+			__in uint32_t id,
+			__in uint64_t signature
+			)
+		{
+			size_t archetype, chunk, iter, row, source;
+
+			if(m_running) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_RUNNING);
+			}
+
+			archetype = find_archetype(signature);
+			source = m_record[ENTITY_INDEX(id) - 1].archetype;
+			chunk = m_record[ENTITY_INDEX(id) - 1].chunk;
+			row = m_record[ENTITY_INDEX(id) - 1].row;
+			allocate_row(archetype, id);
+
+			luna_entity_archetype &entry = m_archetype[archetype], 
+				&entry_source = m_archetype[source];
+			luna_entity_record &record = m_record[ENTITY_INDEX(id) - 1];
+
+			for(iter = 0; iter < m_component.size(); ++iter) {
+
+				if((entry.offset[iter] != ENTITY_COLUMN_INVALID) 
+						&& (entry_source.offset[iter] != ENTITY_COLUMN_INVALID)) {
+					std::memcpy(&entry.chunk[record.chunk].data[entry.offset[iter] 
+						+ (record.row * m_component[iter].size)], 
+						&entry_source.chunk[chunk].data[entry_source.offset[iter] 
+						+ (row * m_component[iter].size)], m_component[iter].size);
+				}
+			}
+
+			free_row(source, chunk, row);
+		}
+
+		void 
+		_luna_entity::query(
+			__in uint64_t include,
+			__in luna_entity_system_cb callback,
+			__in_opt void *context,
+			__in_opt uint64_t exclude
+			)
+		{
+			bool running;
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!callback) {
+				THROW_LUNA_ENTITY_EXCEPTION_FORMAT(LUNA_ENTITY_EXCEPTION_INVALID,
+					"callback 0x%p", callback);
+			}
+
+			// structural changes would invalidate the chunks being walked
+			running = m_running;
+			m_running = true;
+
+			try {
+				iterate(include, exclude, callback, context, m_tick);
+			} catch(...) {
+				m_running = running;
+				throw;
+			}
+
+			m_running = running;
+		}
+
+		void 
+		_luna_entity::remove(
+			__in uint32_t id
+			)
+		{
+			std::vector<luna_entity_record>::iterator record;
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(m_running) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_RUNNING);
+			}
+
+			record = find_entity(id);
+			free_row(record->archetype, record->chunk, record->row);
+			record->alive = false;
+			record->generation = ((record->generation + 1) & ENTITY_GENERATION_MAX);
+			m_free.push_back(ENTITY_INDEX(id));
+			--m_size;
+		}
+
+		void 
+		_luna_entity::remove_system(
+			__in uint32_t id
+			)
+		{
+			std::map<uint32_t, luna_entity_system>::iterator system;
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(m_running) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_RUNNING);
+			}
+
+			system = m_system_map.find(id);
+			if(system == m_system_map.end()) {
+				THROW_LUNA_ENTITY_EXCEPTION_FORMAT(LUNA_ENTITY_EXCEPTION_NOT_FOUND,
+					"system 0x%x", id);
+			}
+
+			m_system_map.erase(system);
+			m_scheduled = false;
+		}
+
+		void 
+		_luna_entity::schedule(void)
+		{
+			bool conflict;
+			std::vector<uint32_t>::iterator batch;
+			std::map<uint32_t, luna_entity_system>::iterator iter;
+
+			if(!m_scheduled) {
+				m_schedule.clear();
+
+				// registration order is kept, a system joins the latest batch only if
+				// no system in it writes what it touches or touches what it writes
+				for(iter = m_system_map.begin(); iter != m_system_map.end(); ++iter) {
+					conflict = m_schedule.empty();
+
+					if(!conflict) {
+
+						for(batch = m_schedule.back().begin(); batch != m_schedule.back().end(); 
+								++batch) {
+							luna_entity_system &other = m_system_map.find(*batch)->second;
+
+							if((iter->second.write & (other.read | other.write)) 
+									|| (other.write & iter->second.read)) {
+								conflict = true;
+								break;
+							}
+						}
+					}
+
+					if(conflict) {
+						m_schedule.push_back(std::vector<uint32_t>());
+					}
+
+					m_schedule.back().push_back(iter->first);
+				}
+
+				m_scheduled = true;
+			}
+		}
+
+		size_t 
+		_luna_entity::size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_size;
+		}
+
+		void 
+		_luna_entity::system_range(
+			__in size_t begin,
+			__in size_t end,
+			__in void *context
+			)
+		{
+			size_t iter;
+			luna_entity_ptr instance = (luna_entity_ptr) context;
+
+			for(iter = begin; iter < end; ++iter) {
+				luna_entity_system &system = instance->m_system_map.find(
+					instance->m_schedule[instance->m_batch][iter])->second;
+
+				instance->iterate(system.read | system.write, 0, system.callback, 
+					system.context, instance->m_tick);
+			}
+		}
+
+		std::string 
+		_luna_entity::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+			std::vector<luna_entity_archetype>::iterator archetype;
+
+			result << LUNA_ENTITY_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_entity_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+				result << " CNT. " << m_size << ", COMP. " << m_component.size()
+					<< ", SYS. " << m_system_map.size() << " (" << m_schedule.size() 
+					<< " batches)";
+
+				for(archetype = m_archetype.begin(); archetype != m_archetype.end(); 
+						++archetype) {
+					result << std::endl << "--- 0x" << SCALAR_AS_HEX(uint64_t, 
+						archetype->signature) << ", CNT. " << archetype->count 
+						<< ", CHUNK. " << archetype->chunk.size() << " (" 
+						<< archetype->capacity << " rows)";
+				}
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_entity::uninitialize(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			clear();
+			m_initialized = false;
+		}
+
+		void 
+		_luna_entity::update(
+			__in_opt uint32_t tick
+			)
+		{
+			luna_job_ptr instance_job = NULL;
+
+			if(!m_initialized) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(m_running) {
+				THROW_LUNA_ENTITY_EXCEPTION(LUNA_ENTITY_EXCEPTION_RUNNING);
+			}
+
+			schedule();
+			m_running = true;
+			m_tick = tick;
+
+			if(luna_job::is_allocated() && luna_job::acquire()->is_initialized()) {
+				instance_job = luna_job::acquire();
+			}
+
+			try {
+
+				// batches run in order, systems inside a batch run concurrently
+				for(m_batch = 0; m_batch < m_schedule.size(); ++m_batch) {
+
+					if(instance_job && (m_schedule[m_batch].size() > 1)) {
+						instance_job->run(m_schedule[m_batch].size(), 
+							luna_entity::system_range, this);
+					} else {
+						system_range(0, m_schedule[m_batch].size(), this);
+					}
+				}
+			} catch(...) {
+				m_running = false;
+				throw;
+			}
+
+			m_running = false;
+		}
+	}
+}
@@ -0,0 +1,223 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/luna.h"
+#include "../include/luna_file_type.h"
+
+namespace LUNA {
+
+	_luna_file::_luna_file(void) :
+		m_data(NULL),
+		m_mapped(false),
+		m_open(false),
+		m_pack(0),
+		m_size(0)
+	{
+		return;
+	}
+
+	_luna_file::_luna_file(
+		__in const std::string &path
+		) :
+			m_data(NULL),
+			m_mapped(false),
+			m_open(false),
+			m_pack(0),
+			m_size(0)
+	{
+		open(path);
+	}
+
+	_luna_file::~_luna_file(void)
+	{
+		close();
+	}
+
+	void 
+	_luna_file::close(void)
+	{
+
+		if(m_mapped) {
+			munmap((void *) m_data, m_size);
+			m_mapped = false;
+		}
+
+		// in-place views pin their pack mapping until released here
+		if(m_pack) {
+
+			if(luna_pack::is_allocated() && luna_pack::acquire()->is_initialized()) {
+				luna_pack::acquire()->close(m_pack);
+			}
+
+			m_pack = 0;
+		}
+
+		m_buffer.clear();
+		m_buffer.shrink_to_fit();
+		m_data = NULL;
+		m_open = false;
+		m_path.clear();
+		m_size = 0;
+	}
+
+	const char *
+	_luna_file::data(void)
+	{
+		return m_data;
+	}
+
+	bool 
+	_luna_file::is_open(void)
+	{
+		return m_open;
+	}
+
+	void 
+	_luna_file::map(
+		__in const std::string &path
+		)
+	{
+		int descriptor;
+		void *data = NULL;
+		struct stat status;
+
+		close();
+
+		descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if(descriptor == SCALAR_INVALID(int)) {
+			THROW_LUNA_FILE_EXCEPTION_FORMAT(LUNA_FILE_EXCEPTION_NOT_FOUND,
+				"%s", STRING_CHECK(path));
+		}
+
+		if(fstat(descriptor, &status) == SCALAR_INVALID(int)) {
+			::close(descriptor);
+			THROW_LUNA_FILE_EXCEPTION_FORMAT(LUNA_FILE_EXCEPTION_EXTERNAL,
+				"fstat failed: %s", STRING_CHECK(path));
+		}
+
+		// empty files cannot be mapped, they open as a zero length view
+		if(status.st_size) {
+
+			data = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			if(data == MAP_FAILED) {
+				::close(descriptor);
+				THROW_LUNA_FILE_EXCEPTION_FORMAT(LUNA_FILE_EXCEPTION_EXTERNAL,
+					"mmap failed: %s", STRING_CHECK(path));
+			}
+
+			// assets are consumed front to back, so ask for aggressive readahead
+			madvise(data, status.st_size, MADV_SEQUENTIAL);
+			madvise(data, status.st_size, MADV_WILLNEED);
+			m_data = (const char *) data;
+			m_mapped = true;
+		}
+
+		::close(descriptor);
+		m_open = true;
+		m_path = path;
+		m_size = status.st_size;
+	}
+
+	void 
+	_luna_file::open(
+		__in const std::string &path
+		)
+	{
+		luna_pack_view view;
+		bool packed = false;
+		luna_pack_ptr inst = NULL;
+
+		close();
+
+		// mounted packs take precedence over loose files
+		if(luna_pack::is_allocated()) {
+
+			inst = luna_pack::acquire();
+			if(inst && inst->is_initialized()) {
+				packed = inst->open(path, view);
+			}
+		}
+
+		if(packed) {
+
+			// uncompressed entries are viewed in place, inside the pack mapping, which stays 
+			// mapped until this file closes, compressed entries release it once copied out
+			if(view.flags & PACK_FLAG_COMPRESSED) {
+
+				try {
+					m_buffer.resize(view.length);
+					luna_pack::decompress(view.data, view.size, m_buffer.data(), view.length);
+				} catch(...) {
+					inst->close(view.id);
+					throw;
+				}
+
+				inst->close(view.id);
+				m_data = m_buffer.data();
+			} else {
+				m_data = view.data;
+				m_pack = view.id;
+			}
+
+			m_open = true;
+			m_path = path;
+			m_size = view.length;
+		} else {
+			map(path);
+		}
+	}
+
+	std::string 
+	_luna_file::path(void)
+	{
+		return m_path;
+	}
+
+	size_t 
+	_luna_file::size(void)
+	{
+		return m_size;
+	}
+
+	std::string 
+	_luna_file::to_string(
+		__in_opt bool verbose
+		)
+	{
+		std::stringstream result;
+
+		result << LUNA_FILE_HEADER << " (" << (m_open ? "OPEN" : "CLOSED");
+
+		if(verbose) {
+			result << ", PTR. 0x" << SCALAR_AS_HEX(luna_file_ptr, this);
+		}
+
+		result << ")";
+
+		if(m_open) {
+			result << " " << m_path << ", SIZE. " << m_size;
+		}
+
+		return result.str();
+	}
+}
@@ -0,0 +1,1048 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include "../include/luna.h"
+#include "../include/luna_grid_type.h"
+
+#ifdef __AVX__
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif // __AVX__
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define GRID_COLLECT_LINEAR 64
+		#define GRID_HASH_X 73856093u
+		#define GRID_HASH_Y 19349663u
+		#define GRID_HASH_Z 83492791u
+
+		#define GRID_BLOCK_COUNT(_COUNT_) (((_COUNT_) + GRID_BLOCK - 1) / GRID_BLOCK)
+
+		#define GRID_ELAPSED(_BEGIN_) \
+			std::chrono::duration<double, std::milli>( \
+				std::chrono::high_resolution_clock::now() - (_BEGIN_)).count()
+
+		static inline int32_t 
+		grid_cell(
+			__in GLfloat value,
+			__in GLfloat inverse
+			)
+		{
+			return (int32_t) std::floor(value * inverse);
+		}
+
+		static inline uint32_t 
+		grid_hash(
+			__in int32_t x,
+			__in int32_t y,
+			__in int32_t z,
+			__in uint32_t mask
+			)
+		{
+			return ((((uint32_t) x * GRID_HASH_X) ^ ((uint32_t) y * GRID_HASH_Y) 
+				^ ((uint32_t) z * GRID_HASH_Z)) & mask);
+		}
+
+		// sphere against box, by the distance from the center to the closest point on the box
+		static void 
+		grid_box(
+			__in const luna_grid_table &table,
+			__in size_t begin,
+			__in size_t end,
+			__in const GLfloat *minimum,
+			__in const GLfloat *maximum,
+			__inout std::vector<uint32_t> &result
+			)
+		{
+			uint32_t *out;
+			GLfloat x, y, z;
+			size_t iter = begin, offset, written = 0;
+
+			offset = result.size();
+			result.resize(offset + (end - begin));
+			out = result.data() + offset;
+
+#ifdef __AVX__
+			for(; (iter + 8) <= end; iter += 8) {
+				__m256 distance, radius, x_256, y_256, z_256;
+				uint32_t lane, mask;
+
+				radius = _mm256_loadu_ps(&table.sorted_radius[iter]);
+				x_256 = _mm256_loadu_ps(&table.sorted_x[iter]);
+				y_256 = _mm256_loadu_ps(&table.sorted_y[iter]);
+				z_256 = _mm256_loadu_ps(&table.sorted_z[iter]);
+				x_256 = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_set1_ps(minimum[0]), x_256), 
+					_mm256_sub_ps(x_256, _mm256_set1_ps(maximum[0]))), _mm256_setzero_ps());
+				y_256 = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_set1_ps(minimum[1]), y_256), 
+					_mm256_sub_ps(y_256, _mm256_set1_ps(maximum[1]))), _mm256_setzero_ps());
+				z_256 = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_set1_ps(minimum[2]), z_256), 
+					_mm256_sub_ps(z_256, _mm256_set1_ps(maximum[2]))), _mm256_setzero_ps());
+				distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x_256, x_256), 
+					_mm256_mul_ps(y_256, y_256)), _mm256_mul_ps(z_256, z_256));
+				mask = _mm256_movemask_ps(_mm256_cmp_ps(distance, _mm256_mul_ps(radius, radius), 
+					_CMP_LE_OQ));
+
+				for(lane = 0; lane < 8; ++lane) {
+					out[written] = table.order[iter + lane];
+					written += ((mask >> lane) & 1);
+				}
+			}
+#endif // __AVX__
+#ifdef __SSE__
+			for(; (iter + 4) <= end; iter += 4) {
+				__m128 distance, radius, x_128, y_128, z_128;
+				uint32_t lane, mask;
+
+				radius = _mm_loadu_ps(&table.sorted_radius[iter]);
+				x_128 = _mm_loadu_ps(&table.sorted_x[iter]);
+				y_128 = _mm_loadu_ps(&table.sorted_y[iter]);
+				z_128 = _mm_loadu_ps(&table.sorted_z[iter]);
+				x_128 = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(minimum[0]), x_128), 
+					_mm_sub_ps(x_128, _mm_set1_ps(maximum[0]))), _mm_setzero_ps());
+				y_128 = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(minimum[1]), y_128), 
+					_mm_sub_ps(y_128, _mm_set1_ps(maximum[1]))), _mm_setzero_ps());
+				z_128 = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(minimum[2]), z_128), 
+					_mm_sub_ps(z_128, _mm_set1_ps(maximum[2]))), _mm_setzero_ps());
+				distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x_128, x_128), 
+					_mm_mul_ps(y_128, y_128)), _mm_mul_ps(z_128, z_128));
+				mask = _mm_movemask_ps(_mm_cmple_ps(distance, _mm_mul_ps(radius, radius)));
+
+				for(lane = 0; lane < 4; ++lane) {
+					out[written] = table.order[iter + lane];
+					written += ((mask >> lane) & 1);
+				}
+			}
+#endif // __SSE__
+
+			for(; iter < end; ++iter) {
+				x = std::max(std::max(minimum[0] - table.sorted_x[iter], 
+					table.sorted_x[iter] - maximum[0]), 0.f);
+				y = std::max(std::max(minimum[1] - table.sorted_y[iter], 
+					table.sorted_y[iter] - maximum[1]), 0.f);
+				z = std::max(std::max(minimum[2] - table.sorted_z[iter], 
+					table.sorted_z[iter] - maximum[2]), 0.f);
+				out[written] = table.order[iter];
+				written += (((x * x) + (y * y) + (z * z)) 
+					<= (table.sorted_radius[iter] * table.sorted_radius[iter]));
+			}
+
+			result.resize(offset + written);
+		}
+
+		// gathers the buckets under a box of cells as entity ranges, boxes spanning more cells 
+		// than there are buckets fall back to a single range over every entity
+		static void 
+		grid_collect(
+			__in const luna_grid_table &table,
+			__in const int32_t *low,
+			__in const int32_t *high,
+			__inout std::vector<uint32_t> &result
+			)
+		{
+			int32_t x, y, z;
+			uint32_t begin, hash;
+			size_t cells = 1, count, iter;
+
+			result.clear();
+
+			for(iter = 0; iter < 3; ++iter) {
+				cells = std::min(cells * (size_t) ((int64_t) high[iter] - low[iter] + 1), 
+					table.bucket.size());
+			}
+
+			if(cells >= (table.bucket.size() - 1)) {
+				result.push_back(0);
+				result.push_back(table.order.size());
+			} else if(cells <= GRID_COLLECT_LINEAR) {
+
+				for(z = low[2]; z <= high[2]; ++z) {
+
+					for(y = low[1]; y <= high[1]; ++y) {
+
+						for(x = low[0]; x <= high[0]; ++x) {
+							hash = grid_hash(x, y, z, table.mask);
+							begin = table.bucket[hash];
+							if(begin == table.bucket[hash + 1]) {
+								continue;
+							}
+
+							// small boxes rarely share a bucket, so a linear check is cheapest
+							for(iter = 0; iter < result.size(); iter += 2) {
+
+								if(result[iter] == begin) {
+									break;
+								}
+							}
+
+							if(iter == result.size()) {
+								result.push_back(begin);
+								result.push_back(table.bucket[hash + 1]);
+							}
+						}
+					}
+				}
+			} else {
+
+				for(z = low[2]; z <= high[2]; ++z) {
+
+					for(y = low[1]; y <= high[1]; ++y) {
+
+						for(x = low[0]; x <= high[0]; ++x) {
+							result.push_back(grid_hash(x, y, z, table.mask));
+						}
+					}
+				}
+
+				// neighbouring cells can share a bucket, so each is visited once
+				std::sort(result.begin(), result.end());
+				result.erase(std::unique(result.begin(), result.end()), result.end());
+				count = result.size();
+
+				// ranges are appended behind the buckets, adjacent buckets are merged
+				for(iter = 0; iter < count; ++iter) {
+					begin = table.bucket[result[iter]];
+					if(begin == table.bucket[result[iter] + 1]) {
+						continue;
+					}
+
+					if((result.size() > count) && (result.back() == begin)) {
+						result.back() = table.bucket[result[iter] + 1];
+					} else {
+						result.push_back(begin);
+						result.push_back(table.bucket[result[iter] + 1]);
+					}
+				}
+
+				result.erase(result.begin(), result.begin() + count);
+			}
+		}
+
+		static void 
+		grid_run(
+			__in size_t blocks,
+			__in luna_job_range_cb callback,
+			__in void *context
+			)
+		{
+
+			if((blocks > 1) && luna_job::is_allocated() && luna_job::acquire()->is_initialized()) {
+				luna_job::acquire()->run(blocks, callback, context);
+			} else {
+				callback(0, blocks, context);
+			}
+		}
+
+		// sphere against sphere, touching spheres overlap
+		static void 
+		grid_sphere(
+			__in const luna_grid_table &table,
+			__in size_t begin,
+			__in size_t end,
+			__in GLfloat x,
+			__in GLfloat y,
+			__in GLfloat z,
+			__in GLfloat radius,
+			__inout std::vector<uint32_t> &result
+			)
+		{
+			uint32_t *out;
+			GLfloat distance_x, distance_y, distance_z, reach;
+			size_t iter = begin, offset, written = 0;
+
+			offset = result.size();
+			result.resize(offset + (end - begin));
+			out = result.data() + offset;
+
+#ifdef __AVX__
+			for(; (iter + 8) <= end; iter += 8) {
+				__m256 distance, reach_256, x_256, y_256, z_256;
+				uint32_t lane, mask;
+
+				reach_256 = _mm256_add_ps(_mm256_loadu_ps(&table.sorted_radius[iter]), 
+					_mm256_set1_ps(radius));
+				x_256 = _mm256_sub_ps(_mm256_loadu_ps(&table.sorted_x[iter]), _mm256_set1_ps(x));
+				y_256 = _mm256_sub_ps(_mm256_loadu_ps(&table.sorted_y[iter]), _mm256_set1_ps(y));
+				z_256 = _mm256_sub_ps(_mm256_loadu_ps(&table.sorted_z[iter]), _mm256_set1_ps(z));
+				distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x_256, x_256), 
+					_mm256_mul_ps(y_256, y_256)), _mm256_mul_ps(z_256, z_256));
+				mask = _mm256_movemask_ps(_mm256_cmp_ps(distance, _mm256_mul_ps(reach_256, 
+					reach_256), _CMP_LE_OQ));
+
+				for(lane = 0; lane < 8; ++lane) {
+					out[written] = table.order[iter + lane];
+					written += ((mask >> lane) & 1);
+				}
+			}
+#endif // __AVX__
+#ifdef __SSE__
+			for(; (iter + 4) <= end; iter += 4) {
+				__m128 distance, reach_128, x_128, y_128, z_128;
+				uint32_t lane, mask;
+
+				reach_128 = _mm_add_ps(_mm_loadu_ps(&table.sorted_radius[iter]), 
+					_mm_set1_ps(radius));
+				x_128 = _mm_sub_ps(_mm_loadu_ps(&table.sorted_x[iter]), _mm_set1_ps(x));
+				y_128 = _mm_sub_ps(_mm_loadu_ps(&table.sorted_y[iter]), _mm_set1_ps(y));
+				z_128 = _mm_sub_ps(_mm_loadu_ps(&table.sorted_z[iter]), _mm_set1_ps(z));
+				distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x_128, x_128), 
+					_mm_mul_ps(y_128, y_128)), _mm_mul_ps(z_128, z_128));
+				mask = _mm_movemask_ps(_mm_cmple_ps(distance, _mm_mul_ps(reach_128, reach_128)));
+
+				for(lane = 0; lane < 4; ++lane) {
+					out[written] = table.order[iter + lane];
+					written += ((mask >> lane) & 1);
+				}
+			}
+#endif // __SSE__
+
+			for(; iter < end; ++iter) {
+				distance_x = table.sorted_x[iter] - x;
+				distance_y = table.sorted_y[iter] - y;
+				distance_z = table.sorted_z[iter] - z;
+				reach = table.sorted_radius[iter] + radius;
+				out[written] = table.order[iter];
+				written += (((distance_x * distance_x) + (distance_y * distance_y) 
+					+ (distance_z * distance_z)) <= (reach * reach));
+			}
+
+			result.resize(offset + written);
+		}
+
+		_luna_grid *_luna_grid::m_instance = NULL;
+
+		_luna_grid::_luna_grid(void) :
+			m_built(true),
+			m_initialized(false),
+			m_next(0)
+		{
+			std::atexit(luna_grid::_delete);
+			m_table.cell = GRID_CELL_DEF;
+			m_table.mask = 0;
+			m_table.radius_max = 0.f;
+		}
+
+		_luna_grid::~_luna_grid(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_grid::_delete(void)
+		{
+
+			if(luna_grid::m_instance) {
+				delete luna_grid::m_instance;
+				luna_grid::m_instance = NULL;
+			}
+		}
+
+		_luna_grid *
+		_luna_grid::acquire(void)
+		{
+
+			if(!luna_grid::m_instance) {
+
+				luna_grid::m_instance = new luna_grid;
+				if(!luna_grid::m_instance) {
+					THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_grid::m_instance;
+		}
+
+		uint32_t 
+		_luna_grid::add(
+			__in const luna_vec3 &position,
+			__in GLfloat radius
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_table.radius.push_back(0.f);
+			m_table.x.push_back(0.f);
+			m_table.y.push_back(0.f);
+			m_table.z.push_back(0.f);
+			m_id.push_back(++m_next);
+			m_index_map.insert(std::pair<uint32_t, size_t>(m_next, m_id.size() - 1));
+			set(m_next, position, radius);
+
+			return m_next;
+		}
+
+		luna_grid_stat 
+		_luna_grid::benchmark(
+			__in size_t count,
+			__in_opt size_t queries
+			)
+		{
+			size_t iter;
+			luna_grid_pass pass;
+			luna_grid_table table;
+			luna_grid_stat result;
+			GLfloat extent, size;
+			luna_vec3 center, maximum, minimum;
+			std::mt19937 generator(count);
+			std::vector<uint32_t> found, scratch;
+			std::vector<std::pair<uint32_t, uint32_t>> pairs;
+			std::chrono::high_resolution_clock::time_point begin;
+
+			// entities are spread so density stays constant across entity counts
+			extent = std::cbrt((GLfloat) count) * 1.5f;
+			std::uniform_real_distribution<GLfloat> coordinate(-extent, extent), 
+				radius(0.25f, 1.f), reach(1.f, 8.f), unit(-1.f, 1.f);
+			table.cell = GRID_CELL_DEF;
+			table.radius.resize(count);
+			table.x.resize(count);
+			table.y.resize(count);
+			table.z.resize(count);
+
+			for(iter = 0; iter < count; ++iter) {
+				table.radius[iter] = radius(generator);
+				table.x[iter] = coordinate(generator);
+				table.y[iter] = coordinate(generator);
+				table.z[iter] = coordinate(generator);
+			}
+
+			build_table(table);
+
+			// the timed build is a tick rebuild, after every entity has moved
+			for(iter = 0; iter < count; ++iter) {
+				table.x[iter] += unit(generator) * 0.5f;
+				table.y[iter] += unit(generator) * 0.5f;
+				table.z[iter] += unit(generator) * 0.5f;
+			}
+
+			begin = std::chrono::high_resolution_clock::now();
+			build_table(table);
+			result.build = GRID_ELAPSED(begin);
+			begin = std::chrono::high_resolution_clock::now();
+			query_pairs_table(table, NULL, pass, pairs);
+			result.pairs = GRID_ELAPSED(begin);
+			result.query_aabb = 0.0;
+			result.query_radius = 0.0;
+
+			for(iter = 0; iter < queries; ++iter) {
+				luna_vec3_make(coordinate(generator), coordinate(generator), 
+					coordinate(generator), center);
+				size = reach(generator);
+				found.clear();
+				begin = std::chrono::high_resolution_clock::now();
+				query_radius_table(table, center, size, NULL, scratch, found);
+				result.query_radius += GRID_ELAPSED(begin);
+				luna_vec3_make(center.x - size, center.y - size, center.z - size, minimum);
+				luna_vec3_make(center.x + size, center.y + size, center.z + size, maximum);
+				found.clear();
+				begin = std::chrono::high_resolution_clock::now();
+				query_aabb_table(table, minimum, maximum, NULL, scratch, found);
+				result.query_aabb += GRID_ELAPSED(begin);
+			}
+
+			result.count = count;
+			result.pair_count = pairs.size();
+			result.query_aabb = ((result.query_aabb > 0.0) ? (queries / result.query_aabb) : 0.0);
+			result.query_radius = ((result.query_radius > 0.0) 
+				? (queries / result.query_radius) : 0.0);
+			result.workers = ((luna_job::is_allocated() && luna_job::acquire()->is_initialized()) 
+				? luna_job::acquire()->worker_count() : 0);
+
+			return result;
+		}
+
+		void 
+		_luna_grid::build(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_UNINITIALIZED);
+			}
+
+			build_table(m_table);
+			m_built = true;
+		}
+
+		void 
+		_luna_grid::build_gather_range(
+			__in size_t begin,
+			__in size_t end,
+			__in void *context
+			)
+		{
+			size_t block, iter, last;
+			luna_grid_table *table = (luna_grid_table *) context;
+
+			for(block = begin; block < end; ++block) {
+				last = std::min((block + 1) * GRID_BLOCK, table->order.size());
+
+				for(iter = block * GRID_BLOCK; iter < last; ++iter) {
+					table->sorted_radius[iter] = table->radius[table->order[iter]];
+					table->sorted_x[iter] = table->x[table->order[iter]];
+					table->sorted_y[iter] = table->y[table->order[iter]];
+					table->sorted_z[iter] = table->z[table->order[iter]];
+				}
+			}
+		}
+
+		void 
+		_luna_grid::build_hash_range(
+			__in size_t begin,
+			__in size_t end,
+			__in void *context
+			)
+		{
+			GLfloat inverse;
+			size_t block, iter, last;
+			luna_grid_table *table = (luna_grid_table *) context;
+
+			inverse = 1.f / table->cell;
+
+			for(block = begin; block < end; ++block) {
+				last = std::min((block + 1) * GRID_BLOCK, table->hash.size());
+
+				for(iter = block * GRID_BLOCK; iter < last; ++iter) {
+					table->hash[iter] = grid_hash(grid_cell(table->x[iter], inverse), 
+						grid_cell(table->y[iter], inverse), grid_cell(table->z[iter], inverse), 
+						table->mask);
+				}
+			}
+		}
+
+		void 
+		_luna_grid::build_table(
+			__inout luna_grid_table &table
+			)
+		{
+			size_t blocks, count, iter, size = GRID_TABLE_MIN;
+
+			count = table.x.size();
+			while(size < count) {
+				size <<= 1;
+			}
+
+			blocks = GRID_BLOCK_COUNT(count);
+			table.bucket.assign(size + 1, 0);
+			table.hash.resize(count);
+			table.mask = size - 1;
+			table.order.resize(count);
+			table.radius_max = 0.f;
+			table.sorted_radius.resize(count);
+			table.sorted_x.resize(count);
+			table.sorted_y.resize(count);
+			table.sorted_z.resize(count);
+
+			for(iter = 0; iter < count; ++iter) {
+				table.radius_max = std::max(table.radius_max, table.radius[iter]);
+			}
+
+			grid_run(blocks, luna_grid::build_hash_range, &table);
+
+			// counting sort, buckets count up to their ends and the scatter walks them back 
+			// down to their begins, so entities keep their relative order within a bucket
+			for(iter = 0; iter < count; ++iter) {
+				++table.bucket[table.hash[iter]];
+			}
+
+			for(iter = 1; iter <= size; ++iter) {
+				table.bucket[iter] += table.bucket[iter - 1];
+			}
+
+			for(iter = count; iter > 0; --iter) {
+				table.order[--table.bucket[table.hash[iter - 1]]] = (iter - 1);
+			}
+
+			grid_run(blocks, luna_grid::build_gather_range, &table);
+		}
+
+		GLfloat 
+		_luna_grid::cell_size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_table.cell;
+		}
+
+		void 
+		_luna_grid::clear(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_built = true;
+			m_id.clear();
+			m_index_map.clear();
+			m_pass.pair.clear();
+			m_scratch.clear();
+			m_table.bucket.clear();
+			m_table.hash.clear();
+			m_table.mask = 0;
+			m_table.order.clear();
+			m_table.radius.clear();
+			m_table.radius_max = 0.f;
+			m_table.sorted_radius.clear();
+			m_table.sorted_x.clear();
+			m_table.sorted_y.clear();
+			m_table.sorted_z.clear();
+			m_table.x.clear();
+			m_table.y.clear();
+			m_table.z.clear();
+		}
+
+		bool 
+		_luna_grid::contains(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (m_index_map.find(id) != m_index_map.end());
+		}
+
+		std::map<uint32_t, size_t>::iterator 
+		_luna_grid::find(
+			__in uint32_t id
+			)
+		{
+			std::map<uint32_t, size_t>::iterator result;
+
+			if(!m_initialized) {
+				THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_UNINITIALIZED);
+			}
+
+			result = m_index_map.find(id);
+			if(result == m_index_map.end()) {
+				THROW_LUNA_GRID_EXCEPTION_FORMAT(LUNA_GRID_EXCEPTION_NOT_FOUND,
+					"0x%x", id);
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_grid::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			m_next = 0;
+			clear();
+		}
+
+		bool 
+		_luna_grid::is_allocated(void)
+		{
+			return (luna_grid::m_instance != NULL);
+		}
+
+		bool 
+		_luna_grid::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		void 
+		_luna_grid::pairs_range(
+			__in size_t begin,
+			__in size_t end,
+			__in void *context
+			)
+		{
+			GLfloat inverse, reach;
+			int32_t high[3], low[3];
+			std::vector<uint32_t> found, scratch;
+			size_t block, first, iter, last, offset, range;
+			luna_grid_pass *pass = (luna_grid_pass *) context;
+			const luna_grid_table *table = pass->table;
+
+			inverse = 1.f / table->cell;
+
+			for(block = begin; block < end; ++block) {
+				std::vector<std::pair<uint32_t, uint32_t>> &pair = pass->pair[block];
+
+				pair.clear();
+				last = std::min((block + 1) * GRID_BLOCK, table->order.size());
+
+				for(offset = block * GRID_BLOCK; offset < last; ++offset) {
+					reach = table->sorted_radius[offset] + table->radius_max;
+					low[0] = grid_cell(table->sorted_x[offset] - reach, inverse);
+					low[1] = grid_cell(table->sorted_y[offset] - reach, inverse);
+					low[2] = grid_cell(table->sorted_z[offset] - reach, inverse);
+					high[0] = grid_cell(table->sorted_x[offset] + reach, inverse);
+					high[1] = grid_cell(table->sorted_y[offset] + reach, inverse);
+					high[2] = grid_cell(table->sorted_z[offset] + reach, inverse);
+					grid_collect(*table, low, high, scratch);
+					found.clear();
+
+					// only later entities are tested, so every pair is reported once
+					for(range = 0; range < scratch.size(); range += 2) {
+						first = std::max((size_t) scratch[range], offset + 1);
+						if(first < scratch[range + 1]) {
+							grid_sphere(*table, first, scratch[range + 1], 
+								table->sorted_x[offset], table->sorted_y[offset], 
+								table->sorted_z[offset], table->sorted_radius[offset], found);
+						}
+					}
+
+					for(iter = 0; iter < found.size(); ++iter) {
+						pair.push_back(pass->id ? std::pair<uint32_t, uint32_t>(
+							pass->id[table->order[offset]], pass->id[found[iter]]) 
+							: std::pair<uint32_t, uint32_t>(table->order[offset], found[iter]));
+					}
+				}
+			}
+		}
+
+		void 
+		_luna_grid::prepare(void)
+		{
+
+			if(!m_built) {
+				build();
+			}
+		}
+
+		size_t 
+		_luna_grid::query_aabb(
+			__in const luna_vec3 &minimum,
+			__in const luna_vec3 &maximum,
+			__out std::vector<uint32_t> &result
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_UNINITIALIZED);
+			}
+
+			if((minimum.x > maximum.x) || (minimum.y > maximum.y) || (minimum.z > maximum.z)) {
+				THROW_LUNA_GRID_EXCEPTION_FORMAT(LUNA_GRID_EXCEPTION_INVALID,
+					"%f, %f, %f", (double) minimum.x, (double) minimum.y, (double) minimum.z);
+			}
+
+			prepare();
+			result.clear();
+			query_aabb_table(m_table, minimum, maximum, m_id.data(), m_scratch, result);
+
+			return result.size();
+		}
+
+		void 
+		_luna_grid::query_aabb_table(
+			__in const luna_grid_table &table,
+			__in const luna_vec3 &minimum,
+			__in const luna_vec3 &maximum,
+			__in_opt const uint32_t *id,
+			__inout std::vector<uint32_t> &scratch,
+			__out std::vector<uint32_t> &result
+			)
+		{
+			size_t iter, offset;
+			int32_t high[3], low[3];
+			GLfloat box_maximum[3], box_minimum[3], inverse;
+
+			if(table.order.empty()) {
+				return;
+			}
+
+			box_minimum[0] = minimum.x;
+			box_minimum[1] = minimum.y;
+			box_minimum[2] = minimum.z;
+			box_maximum[0] = maximum.x;
+			box_maximum[1] = maximum.y;
+			box_maximum[2] = maximum.z;
+			inverse = 1.f / table.cell;
+
+			for(iter = 0; iter < 3; ++iter) {
+				low[iter] = grid_cell(box_minimum[iter] - table.radius_max, inverse);
+				high[iter] = grid_cell(box_maximum[iter] + table.radius_max, inverse);
+			}
+
+			offset = result.size();
+			grid_collect(table, low, high, scratch);
+
+			for(iter = 0; iter < scratch.size(); iter += 2) {
+				grid_box(table, scratch[iter], scratch[iter + 1], box_minimum, box_maximum, result);
+			}
+
+			if(id) {
+
+				for(iter = offset; iter < result.size(); ++iter) {
+					result[iter] = id[result[iter]];
+				}
+			}
+		}
+
+		size_t 
+		_luna_grid::query_pairs(
+			__out std::vector<std::pair<uint32_t, uint32_t>> &result
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_UNINITIALIZED);
+			}
+
+			prepare();
+			result.clear();
+			query_pairs_table(m_table, m_id.data(), m_pass, result);
+
+			return result.size();
+		}
+
+		void 
+		_luna_grid::query_pairs_table(
+			__in const luna_grid_table &table,
+			__in_opt const uint32_t *id,
+			__inout luna_grid_pass &pass,
+			__out std::vector<std::pair<uint32_t, uint32_t>> &result
+			)
+		{
+			size_t blocks, iter;
+
+			blocks = GRID_BLOCK_COUNT(table.order.size());
+			pass.id = id;
+			pass.pair.resize(blocks);
+			pass.table = &table;
+
+			// blocks collect into their own lists, joined in block order so output is stable
+			grid_run(blocks, luna_grid::pairs_range, &pass);
+
+			for(iter = 0; iter < blocks; ++iter) {
+				result.insert(result.end(), pass.pair[iter].begin(), pass.pair[iter].end());
+			}
+		}
+
+		size_t 
+		_luna_grid::query_radius(
+			__in const luna_vec3 &center,
+			__in GLfloat radius,
+			__out std::vector<uint32_t> &result
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!(radius >= 0.f)) {
+				THROW_LUNA_GRID_EXCEPTION_FORMAT(LUNA_GRID_EXCEPTION_INVALID,
+					"%f", (double) radius);
+			}
+
+			prepare();
+			result.clear();
+			query_radius_table(m_table, center, radius, m_id.data(), m_scratch, result);
+
+			return result.size();
+		}
+
+		void 
+		_luna_grid::query_radius_table(
+			__in const luna_grid_table &table,
+			__in const luna_vec3 &center,
+			__in GLfloat radius,
+			__in_opt const uint32_t *id,
+			__inout std::vector<uint32_t> &scratch,
+			__out std::vector<uint32_t> &result
+			)
+		{
+			size_t iter, offset;
+			int32_t high[3], low[3];
+			GLfloat inverse, reach;
+
+			if(table.order.empty()) {
+				return;
+			}
+
+			inverse = 1.f / table.cell;
+			reach = radius + table.radius_max;
+			low[0] = grid_cell(center.x - reach, inverse);
+			low[1] = grid_cell(center.y - reach, inverse);
+			low[2] = grid_cell(center.z - reach, inverse);
+			high[0] = grid_cell(center.x + reach, inverse);
+			high[1] = grid_cell(center.y + reach, inverse);
+			high[2] = grid_cell(center.z + reach, inverse);
+			offset = result.size();
+			grid_collect(table, low, high, scratch);
+
+			for(iter = 0; iter < scratch.size(); iter += 2) {
+				grid_sphere(table, scratch[iter], scratch[iter + 1], center.x, center.y, 
+					center.z, radius, result);
+			}
+
+			if(id) {
+
+				for(iter = offset; iter < result.size(); ++iter) {
+					result[iter] = id[result[iter]];
+				}
+			}
+		}
+
+		void 
+		_luna_grid::remove(
+			__in uint32_t id
+			)
+		{
+			size_t index, last;
+			std::map<uint32_t, size_t>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+			index = iter->second;
+			last = m_id.size() - 1;
+			m_id[index] = m_id[last];
+			m_table.radius[index] = m_table.radius[last];
+			m_table.x[index] = m_table.x[last];
+			m_table.y[index] = m_table.y[last];
+			m_table.z[index] = m_table.z[last];
+			m_id.pop_back();
+			m_table.radius.pop_back();
+			m_table.x.pop_back();
+			m_table.y.pop_back();
+			m_table.z.pop_back();
+			m_index_map.erase(iter);
+
+			if(index != last) {
+				find(m_id[index])->second = index;
+			}
+
+			m_built = false;
+		}
+
+		void 
+		_luna_grid::set(
+			__in uint32_t id,
+			__in const luna_vec3 &position,
+			__in GLfloat radius
+			)
+		{
+			size_t index;
+
+			if(!m_initialized) {
+				THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!(radius >= 0.f)) {
+				THROW_LUNA_GRID_EXCEPTION_FORMAT(LUNA_GRID_EXCEPTION_INVALID,
+					"0x%x", id);
+			}
+
+			// moved entities are picked up by the next rebuild, which is cheap enough to run 
+			// every tick
+			index = find(id)->second;
+			m_table.radius[index] = radius;
+			m_table.x[index] = position.x;
+			m_table.y[index] = position.y;
+			m_table.z[index] = position.z;
+			m_built = false;
+		}
+
+		void 
+		_luna_grid::set_cell_size(
+			__in GLfloat size
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!(size > 0.f) || std::isinf(size)) {
+				THROW_LUNA_GRID_EXCEPTION_FORMAT(LUNA_GRID_EXCEPTION_INVALID,
+					"%f", (double) size);
+			}
+
+			m_table.cell = size;
+			m_built = false;
+		}
+
+		size_t 
+		_luna_grid::size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_id.size();
+		}
+
+		std::string 
+		_luna_grid::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+
+			result << LUNA_GRID_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_grid_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+				result << " CNT. " << m_id.size() << ", CELL. " << std::fixed 
+					<< std::setprecision(3) << m_table.cell << ", BUCKET. " 
+					<< (m_table.bucket.empty() ? 0 : (m_table.bucket.size() - 1)) 
+					<< ", BUILT. " << m_built;
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_grid::uninitialize(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_GRID_EXCEPTION(LUNA_GRID_EXCEPTION_UNINITIALIZED);
+			}
+
+			clear();
+			m_initialized = false;
+		}
+	}
+}
@@ -17,6 +17,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <fstream>
 #include "../include/luna.h"
 #include "../include/luna_input_type.h"
 
@@ -24,6 +25,234 @@ namespace LUNA {
 
 	namespace COMP {
 
+		#define INPUT_RECORD_MAGIC 0x504e494c // "LINP"
+		#define INPUT_RECORD_TEXT_WIDTH 32
+		#define INPUT_RECORD_VERSION 2
+
+		// recordings hold fixed-width little-endian fields rather than raw SDL_Event 
+		// structs, so they replay across builds, compilers and platforms
+		static bool 
+		input_read(
+			__in std::ifstream &file,
+			__in size_t width,
+			__out uint32_t &value
+			)
+		{
+			size_t iter;
+			uint8_t buffer[sizeof(uint32_t)] = { 0 };
+
+			file.read((char *) buffer, width);
+			for(value = 0, iter = 0; iter < width; ++iter) {
+				value |= (((uint32_t) buffer[iter]) << (iter * 8));
+			}
+
+			return !!file;
+		}
+
+		static void 
+		input_write(
+			__in std::ofstream &file,
+			__in size_t width,
+			__in uint32_t value
+			)
+		{
+			size_t iter;
+			uint8_t buffer[sizeof(uint32_t)] = { 0 };
+
+			for(iter = 0; iter < width; ++iter) {
+				buffer[iter] = ((value >> (iter * 8)) & UINT8_MAX);
+			}
+
+			file.write((char *) buffer, width);
+		}
+
+		static bool 
+		input_event_read(
+			__in std::ifstream &file,
+			__in uint32_t tick,
+			__out SDL_Event &event
+			)
+		{
+			uint32_t type, value[7] = { 0 };
+
+			event = SDL_Event();
+			if(!input_read(file, sizeof(uint32_t), type)) {
+				return false;
+			}
+
+			event.type = type;
+			event.common.timestamp = tick;
+
+			switch(type) {
+				case SDL_KEYDOWN:
+				case SDL_KEYUP:
+					input_read(file, sizeof(uint32_t), value[0]);
+					input_read(file, sizeof(uint8_t), value[1]);
+					input_read(file, sizeof(uint8_t), value[2]);
+					input_read(file, sizeof(uint32_t), value[3]);
+					input_read(file, sizeof(uint32_t), value[4]);
+					input_read(file, sizeof(uint16_t), value[5]);
+					event.key.windowID = value[0];
+					event.key.state = value[1];
+					event.key.repeat = value[2];
+					event.key.keysym.scancode = (SDL_Scancode) value[3];
+					event.key.keysym.sym = (SDL_Keycode) value[4];
+					event.key.keysym.mod = value[5];
+					break;
+				case SDL_MOUSEBUTTONDOWN:
+				case SDL_MOUSEBUTTONUP:
+					input_read(file, sizeof(uint32_t), value[0]);
+					input_read(file, sizeof(uint32_t), value[1]);
+					input_read(file, sizeof(uint8_t), value[2]);
+					input_read(file, sizeof(uint8_t), value[3]);
+					input_read(file, sizeof(uint8_t), value[4]);
+					input_read(file, sizeof(int32_t), value[5]);
+					input_read(file, sizeof(int32_t), value[6]);
+					event.button.windowID = value[0];
+					event.button.which = value[1];
+					event.button.button = value[2];
+					event.button.state = value[3];
+					event.button.clicks = value[4];
+					event.button.x = (int32_t) value[5];
+					event.button.y = (int32_t) value[6];
+					break;
+				case SDL_MOUSEMOTION:
+					input_read(file, sizeof(uint32_t), value[0]);
+					input_read(file, sizeof(uint32_t), value[1]);
+					input_read(file, sizeof(uint32_t), value[2]);
+					input_read(file, sizeof(int32_t), value[3]);
+					input_read(file, sizeof(int32_t), value[4]);
+					input_read(file, sizeof(int32_t), value[5]);
+					input_read(file, sizeof(int32_t), value[6]);
+					event.motion.windowID = value[0];
+					event.motion.which = value[1];
+					event.motion.state = value[2];
+					event.motion.x = (int32_t) value[3];
+					event.motion.y = (int32_t) value[4];
+					event.motion.xrel = (int32_t) value[5];
+					event.motion.yrel = (int32_t) value[6];
+					break;
+				case SDL_MOUSEWHEEL:
+					input_read(file, sizeof(uint32_t), value[0]);
+					input_read(file, sizeof(uint32_t), value[1]);
+					input_read(file, sizeof(int32_t), value[2]);
+					input_read(file, sizeof(int32_t), value[3]);
+					event.wheel.windowID = value[0];
+					event.wheel.which = value[1];
+					event.wheel.x = (int32_t) value[2];
+					event.wheel.y = (int32_t) value[3];
+					break;
+				case SDL_QUIT:
+					break;
+				case SDL_TEXTINPUT:
+					input_read(file, sizeof(uint32_t), value[0]);
+					file.read(event.text.text, INPUT_RECORD_TEXT_WIDTH);
+					event.text.windowID = value[0];
+					event.text.text[INPUT_RECORD_TEXT_WIDTH - 1] = '\0';
+					break;
+				case SDL_WINDOWEVENT:
+					input_read(file, sizeof(uint32_t), value[0]);
+					input_read(file, sizeof(uint8_t), value[1]);
+					input_read(file, sizeof(int32_t), value[2]);
+					input_read(file, sizeof(int32_t), value[3]);
+					event.window.windowID = value[0];
+					event.window.event = value[1];
+					event.window.data1 = (int32_t) value[2];
+					event.window.data2 = (int32_t) value[3];
+					break;
+				default:
+					file.setstate(std::ios::failbit);
+					break;
+			}
+
+			return !!file;
+		}
+
+		static bool 
+		input_event_supported(
+			__in const SDL_Event &event
+			)
+		{
+			bool result;
+
+			switch(event.type) {
+				case SDL_KEYDOWN:
+				case SDL_KEYUP:
+				case SDL_MOUSEBUTTONDOWN:
+				case SDL_MOUSEBUTTONUP:
+				case SDL_MOUSEMOTION:
+				case SDL_MOUSEWHEEL:
+				case SDL_QUIT:
+				case SDL_TEXTINPUT:
+				case SDL_WINDOWEVENT:
+					result = true;
+					break;
+				default:
+					result = false;
+					break;
+			}
+
+			return result;
+		}
+
+		static void 
+		input_event_write(
+			__in std::ofstream &file,
+			__in const SDL_Event &event
+			)
+		{
+			input_write(file, sizeof(uint32_t), event.type);
+
+			switch(event.type) {
+				case SDL_KEYDOWN:
+				case SDL_KEYUP:
+					input_write(file, sizeof(uint32_t), event.key.windowID);
+					input_write(file, sizeof(uint8_t), event.key.state);
+					input_write(file, sizeof(uint8_t), event.key.repeat);
+					input_write(file, sizeof(uint32_t), event.key.keysym.scancode);
+					input_write(file, sizeof(uint32_t), event.key.keysym.sym);
+					input_write(file, sizeof(uint16_t), event.key.keysym.mod);
+					break;
+				case SDL_MOUSEBUTTONDOWN:
+				case SDL_MOUSEBUTTONUP:
+					input_write(file, sizeof(uint32_t), event.button.windowID);
+					input_write(file, sizeof(uint32_t), event.button.which);
+					input_write(file, sizeof(uint8_t), event.button.button);
+					input_write(file, sizeof(uint8_t), event.button.state);
+					input_write(file, sizeof(uint8_t), event.button.clicks);
+					input_write(file, sizeof(int32_t), event.button.x);
+					input_write(file, sizeof(int32_t), event.button.y);
+					break;
+				case SDL_MOUSEMOTION:
+					input_write(file, sizeof(uint32_t), event.motion.windowID);
+					input_write(file, sizeof(uint32_t), event.motion.which);
+					input_write(file, sizeof(uint32_t), event.motion.state);
+					input_write(file, sizeof(int32_t), event.motion.x);
+					input_write(file, sizeof(int32_t), event.motion.y);
+					input_write(file, sizeof(int32_t), event.motion.xrel);
+					input_write(file, sizeof(int32_t), event.motion.yrel);
+					break;
+				case SDL_MOUSEWHEEL:
+					input_write(file, sizeof(uint32_t), event.wheel.windowID);
+					input_write(file, sizeof(uint32_t), event.wheel.which);
+					input_write(file, sizeof(int32_t), event.wheel.x);
+					input_write(file, sizeof(int32_t), event.wheel.y);
+					break;
+				case SDL_TEXTINPUT:
+					input_write(file, sizeof(uint32_t), event.text.windowID);
+					file.write(event.text.text, INPUT_RECORD_TEXT_WIDTH);
+					break;
+				case SDL_WINDOWEVENT:
+					input_write(file, sizeof(uint32_t), event.window.windowID);
+					input_write(file, sizeof(uint8_t), event.window.event);
+					input_write(file, sizeof(int32_t), event.window.data1);
+					input_write(file, sizeof(int32_t), event.window.data2);
+					break;
+				default:
+					break;
+			}
+		}
+
 		_luna_input_config::_luna_input_config(void)
 		{
 			return;
@@ -168,7 +397,12 @@ namespace LUNA {
 		_luna_input *_luna_input::m_instance = NULL;
 
 		_luna_input::_luna_input(void) :
-			m_initialized(false)
+			m_initialized(false),
+			m_record_tick(0),
+			m_recording(false),
+			m_replay_position(0),
+			m_replay_tick(0),
+			m_replaying(false)
 		{
 			std::atexit(luna_input::_delete);
 		}
@@ -281,6 +515,66 @@ namespace LUNA {
 			return m_initialized;
 		}
 
+		bool 
+		_luna_input::is_recording(void)
+		{
+			return m_recording;
+		}
+
+		bool 
+		_luna_input::is_replaying(void)
+		{
+			return m_replaying;
+		}
+
+		bool 
+		_luna_input::poll(
+			__in uint32_t tick,
+			__out SDL_Event &event
+			)
+		{
+			bool result = false;
+
+			if(!m_initialized) {
+				THROW_LUNA_INPUT_EXCEPTION(LUNA_INPUT_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(m_replaying) {
+
+				// drain live events, so the window stays responsive, but only honor quit requests
+				while(!result && SDL_PollEvent(&event)) {
+					result = (event.type == SDL_QUIT);
+				}
+
+				if(!result) {
+
+					if((m_replay_position < m_replay.size()) 
+							&& (m_replay.at(m_replay_position).first <= tick)) {
+						event = m_replay.at(m_replay_position++).second;
+						result = true;
+					} else if(tick > m_replay_tick) {
+						stop_replay();
+						event = SDL_Event();
+						event.type = SDL_QUIT;
+						result = true;
+					}
+				}
+			} else {
+				result = SDL_PollEvent(&event);
+
+				if(m_recording) {
+					m_record_tick = tick;
+
+					// only events with a serialized layout are recorded
+					if(result && input_event_supported(event)) {
+						m_record.push_back(std::pair<uint32_t, SDL_Event>(tick, event));
+					}
+				}
+			}
+
+			return result;
+		}
+
 		void 
 		_luna_input::remove(
 			__in const SDL_EventType &type
@@ -318,6 +612,154 @@ namespace LUNA {
 			return m_config.size();
 		}
 
+		void 
+		_luna_input::start_record(
+			__in const std::string &path
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_INPUT_EXCEPTION(LUNA_INPUT_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(m_recording) {
+				THROW_LUNA_INPUT_EXCEPTION(LUNA_INPUT_EXCEPTION_RECORDING);
+			}
+
+			if(m_replaying) {
+				THROW_LUNA_INPUT_EXCEPTION(LUNA_INPUT_EXCEPTION_REPLAYING);
+			}
+
+			m_record.clear();
+			m_record_path = path;
+			m_record_tick = 0;
+			m_recording = true;
+		}
+
+		void 
+		_luna_input::start_replay(
+			__in const std::string &path
+			)
+		{
+			SDL_Event event;
+			uint32_t count, magic, tick, version;
+
+			if(!m_initialized) {
+				THROW_LUNA_INPUT_EXCEPTION(LUNA_INPUT_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(m_recording) {
+				THROW_LUNA_INPUT_EXCEPTION(LUNA_INPUT_EXCEPTION_RECORDING);
+			}
+
+			if(m_replaying) {
+				THROW_LUNA_INPUT_EXCEPTION(LUNA_INPUT_EXCEPTION_REPLAYING);
+			}
+
+			std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+			if(!file) {
+				THROW_LUNA_INPUT_EXCEPTION_FORMAT(LUNA_INPUT_EXCEPTION_FILE_NOT_FOUND,
+					"%s", STRING_CHECK(path));
+			}
+
+			input_read(file, sizeof(uint32_t), magic);
+			input_read(file, sizeof(uint16_t), version);
+			input_read(file, sizeof(uint32_t), m_replay_tick);
+			if(!file || (magic != INPUT_RECORD_MAGIC) || (version != INPUT_RECORD_VERSION)) {
+				THROW_LUNA_INPUT_EXCEPTION_FORMAT(LUNA_INPUT_EXCEPTION_MALFORMED,
+					"%s", STRING_CHECK(path));
+			}
+
+			m_replay.clear();
+
+			while(input_read(file, sizeof(uint32_t), tick)) {
+
+				input_read(file, sizeof(uint32_t), count);
+				for(; file && count; --count) {
+
+					if(input_event_read(file, tick, event)) {
+						m_replay.push_back(std::pair<uint32_t, SDL_Event>(tick, event));
+					}
+				}
+
+				if(!file) {
+					m_replay.clear();
+					THROW_LUNA_INPUT_EXCEPTION_FORMAT(LUNA_INPUT_EXCEPTION_MALFORMED,
+						"%s", STRING_CHECK(path));
+				}
+			}
+
+			m_replay_position = 0;
+			m_replaying = true;
+		}
+
+		void 
+		_luna_input::stop_record(void)
+		{
+			bool result;
+			size_t begin, end;
+			std::string path;
+
+			if(!m_initialized) {
+				THROW_LUNA_INPUT_EXCEPTION(LUNA_INPUT_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(m_recording) {
+				m_recording = false;
+				path = m_record_path;
+
+				std::ofstream file(path.c_str(), std::ios::out | std::ios::binary 
+					| std::ios::trunc);
+				if(file) {
+					input_write(file, sizeof(uint32_t), INPUT_RECORD_MAGIC);
+					input_write(file, sizeof(uint16_t), INPUT_RECORD_VERSION);
+					input_write(file, sizeof(uint32_t), m_record_tick);
+
+					// events are grouped into blocks of (tick, count, events...)
+					for(begin = 0; begin < m_record.size(); begin = end) {
+
+						for(end = begin + 1; (end < m_record.size()) 
+								&& (m_record.at(end).first == m_record.at(begin).first); ++end);
+
+						input_write(file, sizeof(uint32_t), m_record.at(begin).first);
+						input_write(file, sizeof(uint32_t), end - begin);
+
+						for(; begin < end; ++begin) {
+							input_event_write(file, m_record.at(begin).second);
+						}
+					}
+
+					file.close();
+				}
+
+				// the recording is dropped even if the write failed, so the component
+				// is left idle
+				result = !file.fail();
+				m_record.clear();
+				m_record_path.clear();
+				m_record_tick = 0;
+
+				if(!result) {
+					THROW_LUNA_INPUT_EXCEPTION_FORMAT(LUNA_INPUT_EXCEPTION_FILE_NOT_FOUND,
+						"%s", STRING_CHECK(path));
+				}
+			}
+		}
+
+		void 
+		_luna_input::stop_replay(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_INPUT_EXCEPTION(LUNA_INPUT_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_replaying = false;
+			m_replay.clear();
+			m_replay_position = 0;
+			m_replay_tick = 0;
+		}
+
 		std::string 
 		_luna_input::to_string(
 			__in_opt bool verbose
@@ -327,6 +769,12 @@ namespace LUNA {
 
 			result << LUNA_INPUT_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
 
+			if(m_recording) {
+				result << ", RECORD. " << m_record.size();
+			} else if(m_replaying) {
+				result << ", REPLAY. " << m_replay_position << "/" << m_replay.size();
+			}
+
 			if(verbose) {
 				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_input_ptr, this);
 			}
@@ -348,6 +796,8 @@ namespace LUNA {
 				THROW_LUNA_INPUT_EXCEPTION(LUNA_INPUT_EXCEPTION_UNINITIALIZED);
 			}
 
+			stop_record();
+			stop_replay();
 			clear();
 			m_initialized = false;
 		}
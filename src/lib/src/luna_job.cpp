@@ -0,0 +1,350 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../include/luna.h"
+#include "../include/luna_job_type.h"
+
+namespace LUNA {
+
+	namespace COMP {
+
+		typedef struct {
+			std::atomic<size_t> complete;
+			size_t count;
+			luna_job_range_cb callback;
+			void *context;
+			std::exception_ptr error;
+			std::mutex error_lock;
+			size_t grain;
+			std::atomic<size_t> next;
+		} luna_job_range;
+
+		_luna_job *_luna_job::m_instance = NULL;
+
+		_luna_job::_luna_job(void) :
+			m_active(0),
+			m_initialized(false),
+			m_running(false)
+		{
+			std::atexit(luna_job::_delete);
+		}
+
+		_luna_job::~_luna_job(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_job::_delete(void)
+		{
+
+			if(luna_job::m_instance) {
+				delete luna_job::m_instance;
+				luna_job::m_instance = NULL;
+			}
+		}
+
+		_luna_job *
+		_luna_job::acquire(void)
+		{
+
+			if(!luna_job::m_instance) {
+
+				luna_job::m_instance = new luna_job;
+				if(!luna_job::m_instance) {
+					THROW_LUNA_JOB_EXCEPTION(LUNA_JOB_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_job::m_instance;
+		}
+
+		void 
+		_luna_job::add(
+			__in luna_job_cb callback,
+			__in_opt void *context
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_JOB_EXCEPTION(LUNA_JOB_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!callback) {
+				THROW_LUNA_JOB_EXCEPTION(LUNA_JOB_EXCEPTION_INVALID);
+			}
+
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_queue.push_back(std::pair<luna_job_cb, void *>(callback, context));
+			m_condition.notify_one();
+		}
+
+		void 
+		_luna_job::initialize(void)
+		{
+			size_t count, iter = 0;
+
+			if(m_initialized) {
+				THROW_LUNA_JOB_EXCEPTION(LUNA_JOB_EXCEPTION_INITIALIZED);
+			}
+
+			// the calling thread participates in ranged jobs, so leave it a core
+			count = std::thread::hardware_concurrency();
+			count = ((count > (JOB_MIN_WORKERS + 1)) ? (count - 1) : JOB_MIN_WORKERS);
+
+			m_running = true;
+
+			for(; iter < count; ++iter) {
+				m_worker.push_back(std::thread(luna_job::worker, this));
+			}
+
+			m_initialized = true;
+		}
+
+		bool 
+		_luna_job::is_allocated(void)
+		{
+			return (luna_job::m_instance != NULL);
+		}
+
+		bool 
+		_luna_job::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		size_t 
+		_luna_job::pending(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_JOB_EXCEPTION(LUNA_JOB_EXCEPTION_UNINITIALIZED);
+			}
+
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			return (m_queue.size() + m_active);
+		}
+
+		void 
+		_luna_job::run(
+			__in size_t count,
+			__in luna_job_range_cb callback,
+			__in_opt void *context,
+			__in_opt size_t grain
+			)
+		{
+			size_t chunks, iter = 0;
+			std::shared_ptr<luna_job_range> range;
+
+			if(!m_initialized) {
+				THROW_LUNA_JOB_EXCEPTION(LUNA_JOB_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!callback) {
+				THROW_LUNA_JOB_EXCEPTION(LUNA_JOB_EXCEPTION_INVALID);
+			}
+
+			if(count) {
+
+				if(!grain) {
+					grain = JOB_DEF_GRAIN;
+				}
+
+				range = std::make_shared<luna_job_range>();
+				range->complete = 0;
+				range->count = count;
+				range->callback = callback;
+				range->context = context;
+				range->grain = grain;
+				range->next = 0;
+
+				// helpers that start after the range is exhausted return immediately
+				chunks = ((count + grain - 1) / grain);
+				for(; (iter < m_worker.size()) && (iter < (chunks - 1)); ++iter) {
+					add(luna_job::run_range, new std::shared_ptr<luna_job_range>(range));
+				}
+
+				luna_job::run_range(new std::shared_ptr<luna_job_range>(range));
+
+				while(range->complete.load() < count) {
+					std::this_thread::yield();
+				}
+
+				if(range->error) {
+					std::rethrow_exception(range->error);
+				}
+			}
+		}
+
+		void 
+		_luna_job::run_range(
+			__in void *context
+			)
+		{
+			size_t begin, end;
+			std::shared_ptr<luna_job_range> range;
+			std::shared_ptr<luna_job_range> *handle = (std::shared_ptr<luna_job_range> *) context;
+
+			range = *handle;
+			delete handle;
+
+			for(;;) {
+
+				begin = range->next.fetch_add(range->grain);
+				if(begin >= range->count) {
+					break;
+				}
+
+				end = ((begin + range->grain) < range->count) ? (begin + range->grain) : range->count;
+
+				try {
+					range->callback(begin, end, range->context);
+				} catch(...) {
+					std::lock_guard<std::mutex> lock(range->error_lock);
+
+					if(!range->error) {
+						range->error = std::current_exception();
+					}
+				}
+
+				range->complete.fetch_add(end - begin);
+			}
+		}
+
+		std::string 
+		_luna_job::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+
+			result << LUNA_JOB_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_job_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+				result << std::endl << "--- WORKERS: " << m_worker.size() 
+					<< ", PENDING. " << pending();
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_job::uninitialize(void)
+		{
+			std::vector<std::thread>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_JOB_EXCEPTION(LUNA_JOB_EXCEPTION_UNINITIALIZED);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_lock);
+				m_running = false;
+				m_condition.notify_all();
+			}
+
+			// workers drain the queue before exiting
+			for(iter = m_worker.begin(); iter != m_worker.end(); ++iter) {
+				iter->join();
+			}
+
+			m_worker.clear();
+			m_initialized = false;
+		}
+
+		void 
+		_luna_job::wait(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_JOB_EXCEPTION(LUNA_JOB_EXCEPTION_UNINITIALIZED);
+			}
+
+			std::unique_lock<std::mutex> lock(m_lock);
+
+			while(!m_queue.empty() || m_active) {
+				m_condition_idle.wait(lock);
+			}
+		}
+
+		void 
+		_luna_job::worker(
+			__in _luna_job *instance
+			)
+		{
+			std::pair<luna_job_cb, void *> job;
+
+			for(;;) {
+
+				{
+					std::unique_lock<std::mutex> lock(instance->m_lock);
+
+					while(instance->m_running && instance->m_queue.empty()) {
+						instance->m_condition.wait(lock);
+					}
+
+					if(instance->m_queue.empty()) {
+						break;
+					}
+
+					job = instance->m_queue.front();
+					instance->m_queue.pop_front();
+					++instance->m_active;
+				}
+
+				try {
+					job.first(job.second);
+				} catch(...) {
+
+					// detached jobs are expected to report their own failures
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(instance->m_lock);
+					--instance->m_active;
+
+					if(instance->m_queue.empty() && !instance->m_active) {
+						instance->m_condition_idle.notify_all();
+					}
+				}
+			}
+		}
+
+		size_t 
+		_luna_job::worker_count(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_JOB_EXCEPTION(LUNA_JOB_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_worker.size();
+		}
+	}
+}
@@ -0,0 +1,718 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <chrono>
+#include "../include/luna.h"
+#include "../include/luna_loader_type.h"
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define LOADER_ELAPSED(_BEGIN_) \
+			std::chrono::duration<double, std::milli>( \
+				std::chrono::high_resolution_clock::now() - (_BEGIN_)).count()
+
+		#define LOADER_ORDER(_PRIORITY_, _ORDER_) \
+			((((uint64_t) (LUNA_LOADER_PRIORITY_MAX - (_PRIORITY_))) << 56) | (_ORDER_))
+
+		_luna_loader *_luna_loader::m_instance = NULL;
+
+		_luna_loader::_luna_loader(void) :
+			m_context(NULL),
+			m_finalized(0),
+			m_initialized(false),
+			m_next(0),
+			m_order(0),
+			m_pending(0),
+			m_upload_running(false),
+			m_window(NULL)
+		{
+			std::atexit(luna_loader::_delete);
+		}
+
+		_luna_loader::~_luna_loader(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_loader::_delete(void)
+		{
+
+			if(luna_loader::m_instance) {
+				delete luna_loader::m_instance;
+				luna_loader::m_instance = NULL;
+			}
+		}
+
+		_luna_loader *
+		_luna_loader::acquire(void)
+		{
+
+			if(!luna_loader::m_instance) {
+
+				luna_loader::m_instance = new luna_loader;
+				if(!luna_loader::m_instance) {
+					THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_loader::m_instance;
+		}
+
+		uint32_t 
+		_luna_loader::add(
+			__in const std::string &path,
+			__in luna_loader_finalize_cb finalize,
+			__in_opt void *context,
+			__in_opt luna_loader_priority priority,
+			__in_opt luna_loader_load_cb load,
+			__in_opt bool shared
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			return submit(path, finalize, context, priority, load, 0, GL_NONE, shared);
+		}
+
+		uint32_t 
+		_luna_loader::add_buffer(
+			__in const std::string &path,
+			__in GLuint buffer,
+			__in_opt GLenum usage,
+			__in_opt luna_loader_priority priority
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			return submit(path, luna_loader::finalize_buffer, NULL, priority, NULL, buffer, usage, 
+				true);
+		}
+
+		bool 
+		_luna_loader::cancel(
+			__in uint32_t id
+			)
+		{
+			bool result = false;
+			luna_loader_request *request = NULL;
+			std::map<uint32_t, luna_loader_request *>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			iter = m_request_map.find(id);
+			if(iter != m_request_map.end()) {
+				request = iter->second;
+
+				switch(request->state) {
+					case LUNA_LOADER_STATE_LOADING:
+					case LUNA_LOADER_STATE_UPLOADING:
+
+						// the owning thread drops it once its stage returns
+						request->cancelled = true;
+						break;
+					case LUNA_LOADER_STATE_QUEUED:
+						m_queue.erase(request->order);
+						release(request);
+						--m_pending;
+						break;
+					case LUNA_LOADER_STATE_FAILED:
+
+						// failed requests no longer count as pending
+						release(request);
+						break;
+					default:
+						m_loaded.erase(request->order);
+						m_upload.erase(request->order);
+						release(request);
+						--m_pending;
+						break;
+				}
+
+				m_request_map.erase(iter);
+				result = true;
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_loader::clear(void)
+		{
+			std::map<uint32_t, luna_loader_request *>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			for(iter = m_request_map.begin(); iter != m_request_map.end(); ++iter) {
+
+				if((iter->second->state == LUNA_LOADER_STATE_LOADING) 
+						|| (iter->second->state == LUNA_LOADER_STATE_UPLOADING)) {
+					iter->second->cancelled = true;
+				} else if(iter->second->state == LUNA_LOADER_STATE_FAILED) {
+					release(iter->second);
+				} else {
+					release(iter->second);
+					--m_pending;
+				}
+			}
+
+			m_finalized = 0;
+			m_loaded.clear();
+			m_queue.clear();
+			m_request_map.clear();
+			m_upload.clear();
+		}
+
+		bool 
+		_luna_loader::contains(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			return (m_request_map.find(id) != m_request_map.end());
+		}
+
+		std::string 
+		_luna_loader::error(
+			__in uint32_t id
+			)
+		{
+			std::string result;
+			std::map<uint32_t, luna_loader_request *>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			iter = m_request_map.find(id);
+			if(iter != m_request_map.end()) {
+				result = iter->second->error;
+			}
+
+			return result;
+		}
+
+		bool 
+		_luna_loader::finalize_buffer(
+			__inout luna_loader_request &request
+			)
+		{
+			size_t length, size;
+			const GLvoid *data = NULL;
+
+			if(request.data.empty()) {
+				data = request.file.data();
+				size = request.file.size();
+			} else {
+				data = request.data.data();
+				size = request.data.size();
+			}
+
+			// the copy-write binding point leaves vertex array state untouched
+			glBindBuffer(GL_COPY_WRITE_BUFFER, request.object);
+
+			if(!request.progress) {
+				glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, request.usage);
+			}
+
+			// large buffers upload a chunk per call, so the budget is checked in between
+			length = std::min(size - request.progress, (size_t) LOADER_CHUNK_SIZE);
+			if(length) {
+				glBufferSubData(GL_COPY_WRITE_BUFFER, request.progress, length, 
+					(const uint8_t *) data + request.progress);
+				request.progress += length;
+			}
+
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+			return (request.progress == size);
+		}
+
+		void 
+		_luna_loader::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			clear();
+		}
+
+		bool 
+		_luna_loader::is_allocated(void)
+		{
+			return (luna_loader::m_instance != NULL);
+		}
+
+		bool 
+		_luna_loader::is_failed(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (state(id) == LUNA_LOADER_STATE_FAILED);
+		}
+
+		bool 
+		_luna_loader::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		bool 
+		_luna_loader::is_running(void)
+		{
+			return m_upload_running;
+		}
+
+		void 
+		_luna_loader::load(
+			__inout luna_loader_request &request
+			)
+		{
+			size_t offset;
+			volatile char touch = 0;
+
+			request.file.open(request.path);
+
+			// pages are faulted in here, so the finalize stage never waits on the disk
+			for(offset = 0; offset < request.file.size(); offset += LOADER_PAGE_SIZE) {
+				touch = request.file.data()[offset];
+			}
+
+			(void) touch;
+		}
+
+		size_t 
+		_luna_loader::pending(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_pending;
+		}
+
+		void 
+		_luna_loader::pump(
+			__in void *context
+			)
+		{
+			luna_loader_ptr inst = luna_loader::acquire();
+			luna_loader_request *request = NULL;
+
+			{
+				std::lock_guard<std::mutex> lock(inst->m_lock);
+
+				// requests cancelled while queued leave their job with nothing to do
+				if(!inst->m_queue.empty()) {
+					request = inst->m_queue.begin()->second;
+					request->state = LUNA_LOADER_STATE_LOADING;
+					inst->m_queue.erase(inst->m_queue.begin());
+				}
+			}
+
+			if(request) {
+
+				try {
+
+					if(request->load) {
+						request->load(*request);
+					} else {
+						luna_loader::load(*request);
+					}
+				} catch(std::exception &exc) {
+					request->error = exc.what();
+				} catch(...) {
+					request->error = EXCEPTION_UNKNOWN;
+				}
+
+				std::lock_guard<std::mutex> lock(inst->m_lock);
+
+				if(request->cancelled) {
+					release(request);
+					--inst->m_pending;
+				} else {
+					request->state = LUNA_LOADER_STATE_LOADED;
+
+					if(request->shared && request->finalize && request->error.empty() 
+							&& inst->m_upload_running) {
+						inst->m_upload.insert(std::pair<uint64_t, luna_loader_request *>(
+							request->order, request));
+						inst->m_upload_condition.notify_one();
+					} else {
+						inst->m_loaded.insert(std::pair<uint64_t, luna_loader_request *>(
+							request->order, request));
+					}
+				}
+			}
+		}
+
+		void 
+		_luna_loader::release(
+			__in luna_loader_request *request
+			)
+		{
+
+			if(request->fence) {
+				glDeleteSync(request->fence);
+			}
+
+			delete request;
+		}
+
+		void 
+		_luna_loader::start(
+			__in SDL_Window *window,
+			__in SDL_GLContext context
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(m_upload_running) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_STARTED);
+			}
+
+			// without a shared context, shared requests finalize on the main thread
+			if(window && context) {
+				m_context = context;
+				m_upload_running = true;
+				m_window = window;
+				m_upload_thread = std::thread(luna_loader::upload, this);
+			}
+		}
+
+		luna_loader_state 
+		_luna_loader::state(
+			__in uint32_t id
+			)
+		{
+			luna_loader_state result = LUNA_LOADER_STATE_NONE;
+			std::map<uint32_t, luna_loader_request *>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			iter = m_request_map.find(id);
+			if(iter != m_request_map.end()) {
+				result = iter->second->state;
+			}
+
+			return result;
+		}
+
+		uint32_t 
+		_luna_loader::submit(
+			__in const std::string &path,
+			__in luna_loader_finalize_cb finalize,
+			__in void *context,
+			__in luna_loader_priority priority,
+			__in luna_loader_load_cb load,
+			__in GLuint object,
+			__in GLenum usage,
+			__in bool shared
+			)
+		{
+			uint32_t result;
+			luna_loader_request *request = NULL;
+
+			request = new luna_loader_request;
+			if(!request) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_ALLOCATED);
+			}
+
+			request->cancelled = false;
+			request->context = context;
+			request->fence = NULL;
+			request->finalize = finalize;
+			request->load = load;
+			request->object = object;
+			request->path = path;
+			request->priority = std::min(priority, LUNA_LOADER_PRIORITY_MAX);
+			request->progress = 0;
+			request->shared = shared;
+			request->state = LUNA_LOADER_STATE_QUEUED;
+			request->usage = usage;
+
+			{
+				std::lock_guard<std::mutex> lock(m_lock);
+
+				result = ++m_next;
+				request->id = result;
+				request->order = LOADER_ORDER(request->priority, ++m_order);
+				m_queue.insert(std::pair<uint64_t, luna_loader_request *>(request->order, request));
+				m_request_map.insert(std::pair<uint32_t, luna_loader_request *>(result, request));
+				++m_pending;
+			}
+
+			// each job takes whatever is most urgent when it runs, not the request it was
+			// queued for, so later high priority requests overtake earlier ones
+			try {
+				luna_job::acquire()->add(luna_loader::pump);
+			} catch(...) {
+				cancel(result);
+				throw;
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_loader::stop(void)
+		{
+			std::map<uint64_t, luna_loader_request *>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(m_upload_running) {
+
+				{
+					std::lock_guard<std::mutex> lock(m_lock);
+					m_upload_running = false;
+					m_upload_condition.notify_all();
+				}
+
+				m_upload_thread.join();
+
+				// anything still waiting for the loader thread falls back to the main thread
+				std::lock_guard<std::mutex> lock(m_lock);
+
+				m_loaded.insert(m_upload.begin(), m_upload.end());
+				m_upload.clear();
+				m_context = NULL;
+				m_window = NULL;
+			}
+		}
+
+		std::string 
+		_luna_loader::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+
+			result << LUNA_LOADER_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_loader_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+				std::lock_guard<std::mutex> lock(m_lock);
+
+				result << " QUEUE. " << m_queue.size() << ", UPLD. " << m_upload.size() 
+					<< ", LOAD. " << m_loaded.size() << ", PEND. " << m_pending << ", DONE. " 
+					<< m_finalized << ", THRD. " << (m_upload_running ? "STARTED" : "STOPPED");
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_loader::uninitialize(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			stop();
+			clear();
+			m_initialized = false;
+		}
+
+		size_t 
+		_luna_loader::update(
+			__in_opt double budget
+			)
+		{
+			bool complete;
+			size_t result = 0;
+			luna_loader_request *request = NULL;
+			std::chrono::high_resolution_clock::time_point begin;
+
+			if(!m_initialized) {
+				THROW_LUNA_LOADER_EXCEPTION(LUNA_LOADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			begin = std::chrono::high_resolution_clock::now();
+
+			// at least one step runs per frame, so a zero budget still makes progress
+			do {
+
+				{
+					std::lock_guard<std::mutex> lock(m_lock);
+					request = (m_loaded.empty() ? NULL : m_loaded.begin()->second);
+				}
+
+				if(request) {
+					complete = true;
+
+					if(!request->error.empty()) {
+						complete = false;
+					} else if(request->fence) {
+
+						// the wait is queued on the gpu, the main thread never blocks on it, and
+						// uploaded objects are current here once they are next bound
+						glWaitSync(request->fence, 0, GL_TIMEOUT_IGNORED);
+					} else if(request->finalize) {
+
+						try {
+							complete = request->finalize(*request);
+						} catch(std::exception &exc) {
+							request->error = exc.what();
+						} catch(...) {
+							request->error = EXCEPTION_UNKNOWN;
+						}
+					}
+
+					// a missing asset must not stop the frame loop, so the request stays 
+					// behind as failed, with its error, until cancelled or cleared
+					if(!request->error.empty()) {
+						SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Load failed: %s: %s", 
+							STRING_CHECK(request->path), request->error.c_str());
+
+						std::lock_guard<std::mutex> lock(m_lock);
+
+						m_loaded.erase(request->order);
+						request->data.clear();
+						request->file.close();
+						request->state = LUNA_LOADER_STATE_FAILED;
+						--m_pending;
+					} else if(complete) {
+						std::lock_guard<std::mutex> lock(m_lock);
+
+						m_loaded.erase(request->order);
+						m_request_map.erase(request->id);
+						release(request);
+						--m_pending;
+						++m_finalized;
+						++result;
+					}
+				}
+			} while(request && (LOADER_ELAPSED(begin) < budget));
+
+			return result;
+		}
+
+		void 
+		_luna_loader::upload(
+			__in _luna_loader *instance
+			)
+		{
+			bool complete;
+			luna_loader_request *request = NULL;
+
+			SDL_GL_MakeCurrent(instance->m_window, instance->m_context);
+
+			for(;;) {
+
+				{
+					std::unique_lock<std::mutex> lock(instance->m_lock);
+
+					while(instance->m_upload_running && instance->m_upload.empty()) {
+						instance->m_upload_condition.wait(lock);
+					}
+
+					if(!instance->m_upload_running) {
+						break;
+					}
+
+					request = instance->m_upload.begin()->second;
+					request->state = LUNA_LOADER_STATE_UPLOADING;
+					instance->m_upload.erase(instance->m_upload.begin());
+				}
+
+				// there is no frame to share with here, so each upload runs to completion
+				try {
+
+					do {
+						complete = request->finalize(*request);
+					} while(!complete);
+				} catch(std::exception &exc) {
+					request->error = exc.what();
+				} catch(...) {
+					request->error = EXCEPTION_UNKNOWN;
+				}
+
+				// flushing submits the fence, otherwise another context could wait forever
+				request->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				glFlush();
+
+				{
+					std::lock_guard<std::mutex> lock(instance->m_lock);
+
+					if(request->cancelled) {
+						release(request);
+						--instance->m_pending;
+					} else {
+						request->state = LUNA_LOADER_STATE_LOADED;
+						instance->m_loaded.insert(std::pair<uint64_t, luna_loader_request *>(
+							request->order, request));
+					}
+				}
+			}
+
+			SDL_GL_MakeCurrent(instance->m_window, NULL);
+		}
+	}
+}
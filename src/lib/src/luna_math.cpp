@@ -0,0 +1,960 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "../include/luna.h"
+
+#ifdef __AVX__
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif // __AVX__
+
+namespace LUNA {
+
+	#define MATH_SHUFFLE(_X_, _Y_, _Z_, _W_) \
+		((_X_) | ((_Y_) << 2) | ((_Z_) << 4) | ((_W_) << 6))
+	#define MATH_SWIZZLE(_VEC_, _X_, _Y_, _Z_, _W_) \
+		_mm_shuffle_ps(_VEC_, _VEC_, MATH_SHUFFLE(_X_, _Y_, _Z_, _W_))
+
+#ifdef __SSE__
+	// 2x2 block helpers, each block stored row-major in one register
+	static inline __m128 
+	math_mat2_multiply(
+		__in __m128 left,
+		__in __m128 right
+		)
+	{
+		return _mm_add_ps(_mm_mul_ps(left, MATH_SWIZZLE(right, 0, 3, 0, 3)),
+			_mm_mul_ps(MATH_SWIZZLE(left, 1, 0, 3, 2), MATH_SWIZZLE(right, 2, 1, 2, 1)));
+	}
+
+	static inline __m128 
+	math_mat2_adjugate_multiply(
+		__in __m128 left,
+		__in __m128 right
+		)
+	{
+		return _mm_sub_ps(_mm_mul_ps(MATH_SWIZZLE(left, 3, 3, 0, 0), right),
+			_mm_mul_ps(MATH_SWIZZLE(left, 1, 1, 2, 2), MATH_SWIZZLE(right, 2, 3, 0, 1)));
+	}
+
+	static inline __m128 
+	math_mat2_multiply_adjugate(
+		__in __m128 left,
+		__in __m128 right
+		)
+	{
+		return _mm_sub_ps(_mm_mul_ps(left, MATH_SWIZZLE(right, 3, 0, 3, 0)),
+			_mm_mul_ps(MATH_SWIZZLE(left, 1, 0, 3, 2), MATH_SWIZZLE(right, 2, 1, 2, 1)));
+	}
+
+	static inline __m128 
+	math_mat4_column(
+		__in const luna_mat4 &matrix,
+		__in const GLfloat *column
+		)
+	{
+		__m128 result;
+
+		result = _mm_mul_ps(_mm_load_ps(&matrix.m[0]), _mm_set1_ps(column[0]));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_load_ps(&matrix.m[4]), 
+			_mm_set1_ps(column[1])));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_load_ps(&matrix.m[8]), 
+			_mm_set1_ps(column[2])));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_load_ps(&matrix.m[12]), 
+			_mm_set1_ps(column[3])));
+
+		return result;
+	}
+#endif // __SSE__
+
+	template <class T> static double 
+	math_measure(
+		__in T function,
+		__in size_t count
+		)
+	{
+		std::chrono::high_resolution_clock::time_point begin;
+
+		begin = std::chrono::high_resolution_clock::now();
+		function();
+
+		return (std::chrono::duration<double, std::nano>(
+			std::chrono::high_resolution_clock::now() - begin).count() / count);
+	}
+
+	luna_math_stat 
+	luna_math_benchmark(
+		__in_opt size_t count,
+		__in_opt size_t iterations
+		)
+	{
+		size_t iter;
+		luna_math_stat result;
+		luna_vec3 axis, scale, translation;
+		volatile GLfloat checksum = 0.f;
+		std::vector<GLfloat> in_x, in_y, in_z, out_x, out_y, out_z;
+		std::vector<luna_mat4> left, out, right;
+		std::vector<luna_quat> quat_left, quat_out, quat_right;
+		luna_vec3_soa in, out_point;
+
+		count = std::max(count, (size_t) 1);
+		iterations = std::max(iterations, (size_t) 1);
+		in_x.resize(count);
+		in_y.resize(count);
+		in_z.resize(count);
+		out_x.resize(count);
+		out_y.resize(count);
+		out_z.resize(count);
+		left.resize(count);
+		out.resize(count);
+		right.resize(count);
+		quat_left.resize(count);
+		quat_out.resize(count);
+		quat_right.resize(count);
+		luna_vec3_make(1.f, 1.f, 1.f, scale);
+
+		for(iter = 0; iter < count; ++iter) {
+			in_x[iter] = iter;
+			in_y[iter] = iter * 0.5f;
+			in_z[iter] = iter * 0.25f;
+			luna_vec3_make(iter % 3, 1.f, iter % 5, axis);
+			luna_vec3_normalize(axis, axis);
+			luna_vec3_make(in_x[iter], in_y[iter], in_z[iter], translation);
+			luna_quat_from_axis_angle(axis, iter * 0.01f, quat_left[iter]);
+			luna_quat_from_axis_angle(axis, iter * 0.02f, quat_right[iter]);
+			luna_mat4_from_trs(translation, quat_left[iter], scale, left[iter]);
+			luna_mat4_from_trs(translation, quat_right[iter], scale, right[iter]);
+		}
+
+		in.x = &in_x[0];
+		in.y = &in_y[0];
+		in.z = &in_z[0];
+		out_point.x = &out_x[0];
+		out_point.y = &out_y[0];
+		out_point.z = &out_z[0];
+		count *= iterations;
+
+		result.inverse = math_measure([&]() {
+				for(size_t pass = 0; pass < iterations; ++pass) {
+					for(size_t index = 0; index < left.size(); ++index) {
+						luna_mat4_inverse(left[index], out[index]);
+					}
+				}
+			}, count);
+		checksum += out.back().m[0];
+
+		result.inverse_reference = math_measure([&]() {
+				for(size_t pass = 0; pass < iterations; ++pass) {
+					for(size_t index = 0; index < left.size(); ++index) {
+						luna_mat4_inverse_reference(left[index], out[index]);
+					}
+				}
+			}, count);
+		checksum += out.back().m[0];
+
+		result.multiply = math_measure([&]() {
+				for(size_t pass = 0; pass < iterations; ++pass) {
+					luna_mat4_multiply_batch(&left[0], &right[0], &out[0], left.size());
+				}
+			}, count);
+		checksum += out.back().m[0];
+
+		result.multiply_reference = math_measure([&]() {
+				for(size_t pass = 0; pass < iterations; ++pass) {
+					for(size_t index = 0; index < left.size(); ++index) {
+						luna_mat4_multiply_reference(left[index], right[index], out[index]);
+					}
+				}
+			}, count);
+		checksum += out.back().m[0];
+
+		result.slerp = math_measure([&]() {
+				for(size_t pass = 0; pass < iterations; ++pass) {
+					for(size_t index = 0; index < quat_left.size(); ++index) {
+						luna_quat_slerp(quat_left[index], quat_right[index], 0.5f, 
+							quat_out[index]);
+					}
+				}
+			}, count);
+		checksum += quat_out.back().w;
+
+		result.slerp_reference = math_measure([&]() {
+				for(size_t pass = 0; pass < iterations; ++pass) {
+					for(size_t index = 0; index < quat_left.size(); ++index) {
+						luna_quat_slerp_reference(quat_left[index], quat_right[index], 0.5f, 
+							quat_out[index]);
+					}
+				}
+			}, count);
+		checksum += quat_out.back().w;
+
+		result.transform = math_measure([&]() {
+				for(size_t pass = 0; pass < iterations; ++pass) {
+					luna_mat4_transform_batch(left.back(), in, out_point, in_x.size());
+				}
+			}, count);
+		checksum += out_x.back();
+
+		result.transform_reference = math_measure([&]() {
+				for(size_t pass = 0; pass < iterations; ++pass) {
+					luna_mat4_transform_batch_reference(left.back(), in, out_point, 
+						in_x.size());
+				}
+			}, count);
+		checksum += out_x.back();
+		UNREFERENCE_PARAM(checksum);
+
+		return result;
+	}
+
+	std::string 
+	luna_math_stat_as_string(
+		__in const luna_math_stat &stat
+		)
+	{
+		std::stringstream result;
+
+		result << std::fixed << std::setprecision(2)
+			<< "INV. " << stat.inverse << "/" << stat.inverse_reference << " ns"
+			<< ", MUL. " << stat.multiply << "/" << stat.multiply_reference << " ns"
+			<< ", SLERP. " << stat.slerp << "/" << stat.slerp_reference << " ns"
+			<< ", XFORM. " << stat.transform << "/" << stat.transform_reference << " ns";
+
+		return result.str();
+	}
+
+	void 
+	luna_frustum_from_matrix(
+		__in const luna_mat4 &matrix,
+		__out luna_frustum &out
+		)
+	{
+		GLfloat length;
+		size_t iter, plane;
+
+		// gribb/hartmann, planes are sums and differences of the clip rows
+		for(plane = 0; plane < 6; ++plane) {
+			GLfloat sign = ((plane % 2) ? -1.f : 1.f), *target = &out.plane[plane].x;
+
+			for(iter = 0; iter < 4; ++iter) {
+				target[iter] = matrix.m[(iter * 4) + 3] + (sign * matrix.m[(iter * 4) 
+					+ (plane / 2)]);
+			}
+
+			length = std::sqrt((target[0] * target[0]) + (target[1] * target[1]) 
+				+ (target[2] * target[2]));
+			if(length > MATH_EPSILON) {
+				length = 1.f / length;
+
+				for(iter = 0; iter < 4; ++iter) {
+					target[iter] *= length;
+				}
+			}
+		}
+	}
+
+	void 
+	luna_lerp_batch(
+		__in const GLfloat *left,
+		__in const GLfloat *right,
+		__in GLfloat t,
+		__out GLfloat *out,
+		__in size_t count
+		)
+	{
+		size_t iter = 0;
+
+#ifdef __AVX__
+		__m256 t_256 = _mm256_set1_ps(t);
+
+		for(; (iter + 8) <= count; iter += 8) {
+			__m256 left_256 = _mm256_loadu_ps(&left[iter]);
+
+			_mm256_storeu_ps(&out[iter], _mm256_add_ps(left_256, _mm256_mul_ps(t_256, 
+				_mm256_sub_ps(_mm256_loadu_ps(&right[iter]), left_256))));
+		}
+#endif // __AVX__
+#ifdef __SSE__
+		__m128 t_128 = _mm_set1_ps(t);
+
+		for(; (iter + 4) <= count; iter += 4) {
+			__m128 left_128 = _mm_loadu_ps(&left[iter]);
+
+			_mm_storeu_ps(&out[iter], _mm_add_ps(left_128, _mm_mul_ps(t_128, 
+				_mm_sub_ps(_mm_loadu_ps(&right[iter]), left_128))));
+		}
+#endif // __SSE__
+
+		for(; iter < count; ++iter) {
+			out[iter] = left[iter] + (t * (right[iter] - left[iter]));
+		}
+	}
+
+	void 
+	luna_mat4_from_trs(
+		__in const luna_vec3 &translation,
+		__in const luna_quat &rotation,
+		__in const luna_vec3 &scale,
+		__out luna_mat4 &out
+		)
+	{
+		GLfloat wx, wy, wz, xx, xy, xz, yy, yz, zz;
+
+		xx = rotation.x * rotation.x;
+		xy = rotation.x * rotation.y;
+		xz = rotation.x * rotation.z;
+		yy = rotation.y * rotation.y;
+		yz = rotation.y * rotation.z;
+		zz = rotation.z * rotation.z;
+		wx = rotation.w * rotation.x;
+		wy = rotation.w * rotation.y;
+		wz = rotation.w * rotation.z;
+		out.m[0] = (1.f - (2.f * (yy + zz))) * scale.x;
+		out.m[1] = (2.f * (xy + wz)) * scale.x;
+		out.m[2] = (2.f * (xz - wy)) * scale.x;
+		out.m[3] = 0.f;
+		out.m[4] = (2.f * (xy - wz)) * scale.y;
+		out.m[5] = (1.f - (2.f * (xx + zz))) * scale.y;
+		out.m[6] = (2.f * (yz + wx)) * scale.y;
+		out.m[7] = 0.f;
+		out.m[8] = (2.f * (xz + wy)) * scale.z;
+		out.m[9] = (2.f * (yz - wx)) * scale.z;
+		out.m[10] = (1.f - (2.f * (xx + yy))) * scale.z;
+		out.m[11] = 0.f;
+		out.m[12] = translation.x;
+		out.m[13] = translation.y;
+		out.m[14] = translation.z;
+		out.m[15] = 1.f;
+	}
+
+	void 
+	luna_mat4_identity(
+		__out luna_mat4 &out
+		)
+	{
+		size_t iter;
+
+		for(iter = 0; iter < 16; ++iter) {
+			out.m[iter] = ((iter % 5) ? 0.f : 1.f);
+		}
+	}
+
+	bool 
+	luna_mat4_inverse(
+		__in const luna_mat4 &matrix,
+		__out luna_mat4 &out
+		)
+	{
+		bool result = true;
+
+#ifdef __SSE__
+		__m128 a, a_b, b, c, column[4], d, d_c, determinant, determinant_a, 
+			determinant_b, determinant_c, determinant_d, determinant_sub, trace, 
+			w, x, y, z;
+
+		// block inverse, valid for column-major storage since inv(m^t) = inv(m)^t
+		column[0] = _mm_load_ps(&matrix.m[0]);
+		column[1] = _mm_load_ps(&matrix.m[4]);
+		column[2] = _mm_load_ps(&matrix.m[8]);
+		column[3] = _mm_load_ps(&matrix.m[12]);
+		a = _mm_movelh_ps(column[0], column[1]);
+		b = _mm_movehl_ps(column[1], column[0]);
+		c = _mm_movelh_ps(column[2], column[3]);
+		d = _mm_movehl_ps(column[3], column[2]);
+		determinant_sub = _mm_sub_ps(
+			_mm_mul_ps(_mm_shuffle_ps(column[0], column[2], MATH_SHUFFLE(0, 2, 0, 2)),
+				_mm_shuffle_ps(column[1], column[3], MATH_SHUFFLE(1, 3, 1, 3))),
+			_mm_mul_ps(_mm_shuffle_ps(column[0], column[2], MATH_SHUFFLE(1, 3, 1, 3)),
+				_mm_shuffle_ps(column[1], column[3], MATH_SHUFFLE(0, 2, 0, 2))));
+		determinant_a = MATH_SWIZZLE(determinant_sub, 0, 0, 0, 0);
+		determinant_b = MATH_SWIZZLE(determinant_sub, 1, 1, 1, 1);
+		determinant_c = MATH_SWIZZLE(determinant_sub, 2, 2, 2, 2);
+		determinant_d = MATH_SWIZZLE(determinant_sub, 3, 3, 3, 3);
+		d_c = math_mat2_adjugate_multiply(d, c);
+		a_b = math_mat2_adjugate_multiply(a, b);
+		x = _mm_sub_ps(_mm_mul_ps(determinant_d, a), math_mat2_multiply(b, d_c));
+		w = _mm_sub_ps(_mm_mul_ps(determinant_a, d), math_mat2_multiply(c, a_b));
+		y = _mm_sub_ps(_mm_mul_ps(determinant_b, c), math_mat2_multiply_adjugate(d, a_b));
+		z = _mm_sub_ps(_mm_mul_ps(determinant_c, b), math_mat2_multiply_adjugate(a, d_c));
+		determinant = _mm_add_ps(_mm_mul_ps(determinant_a, determinant_d), 
+			_mm_mul_ps(determinant_b, determinant_c));
+		trace = _mm_mul_ps(a_b, MATH_SWIZZLE(d_c, 0, 2, 1, 3));
+		trace = _mm_add_ps(trace, MATH_SWIZZLE(trace, 1, 0, 3, 2));
+		trace = _mm_add_ps(trace, MATH_SWIZZLE(trace, 2, 3, 0, 1));
+		determinant = _mm_sub_ps(determinant, trace);
+
+		if(std::fabs(_mm_cvtss_f32(determinant)) < MATH_EPSILON) {
+			result = false;
+		} else {
+			determinant = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), determinant);
+			x = _mm_mul_ps(x, determinant);
+			y = _mm_mul_ps(y, determinant);
+			z = _mm_mul_ps(z, determinant);
+			w = _mm_mul_ps(w, determinant);
+			_mm_store_ps(&out.m[0], _mm_shuffle_ps(x, y, MATH_SHUFFLE(3, 1, 3, 1)));
+			_mm_store_ps(&out.m[4], _mm_shuffle_ps(x, y, MATH_SHUFFLE(2, 0, 2, 0)));
+			_mm_store_ps(&out.m[8], _mm_shuffle_ps(z, w, MATH_SHUFFLE(3, 1, 3, 1)));
+			_mm_store_ps(&out.m[12], _mm_shuffle_ps(z, w, MATH_SHUFFLE(2, 0, 2, 0)));
+		}
+#else
+		result = luna_mat4_inverse_reference(matrix, out);
+#endif // __SSE__
+
+		return result;
+	}
+
+	bool 
+	luna_mat4_inverse_reference(
+		__in const luna_mat4 &matrix,
+		__out luna_mat4 &out
+		)
+	{
+		size_t iter;
+		bool result = true;
+		GLfloat determinant, inverse[16];
+		const GLfloat *m = matrix.m;
+
+		inverse[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] 
+			+ m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+		inverse[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] 
+			- m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+		inverse[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] 
+			+ m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+		inverse[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] 
+			- m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+		inverse[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] 
+			- m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+		inverse[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] 
+			+ m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+		inverse[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] 
+			- m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+		inverse[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] 
+			+ m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+		inverse[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] 
+			+ m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+		inverse[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] 
+			- m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+		inverse[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] 
+			+ m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+		inverse[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] 
+			- m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+		inverse[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] 
+			- m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+		inverse[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] 
+			+ m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+		inverse[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] 
+			- m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+		inverse[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] 
+			+ m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+		determinant = m[0] * inverse[0] + m[1] * inverse[4] + m[2] * inverse[8] 
+			+ m[3] * inverse[12];
+
+		if(std::fabs(determinant) < MATH_EPSILON) {
+			result = false;
+		} else {
+			determinant = 1.f / determinant;
+
+			for(iter = 0; iter < 16; ++iter) {
+				out.m[iter] = inverse[iter] * determinant;
+			}
+		}
+
+		return result;
+	}
+
+	void 
+	luna_mat4_multiply(
+		__in const luna_mat4 &left,
+		__in const luna_mat4 &right,
+		__out luna_mat4 &out
+		)
+	{
+#ifdef __SSE__
+		__m128 column[4];
+
+		// computed into registers first so out may alias either input
+		column[0] = math_mat4_column(left, &right.m[0]);
+		column[1] = math_mat4_column(left, &right.m[4]);
+		column[2] = math_mat4_column(left, &right.m[8]);
+		column[3] = math_mat4_column(left, &right.m[12]);
+		_mm_store_ps(&out.m[0], column[0]);
+		_mm_store_ps(&out.m[4], column[1]);
+		_mm_store_ps(&out.m[8], column[2]);
+		_mm_store_ps(&out.m[12], column[3]);
+#else
+		luna_mat4_multiply_reference(left, right, out);
+#endif // __SSE__
+	}
+
+	void 
+	luna_mat4_multiply_batch(
+		__in const luna_mat4 *left,
+		__in const luna_mat4 *right,
+		__out luna_mat4 *out,
+		__in size_t count
+		)
+	{
+		size_t iter;
+
+		for(iter = 0; iter < count; ++iter) {
+			luna_mat4_multiply(left[iter], right[iter], out[iter]);
+		}
+	}
+
+	void 
+	luna_mat4_multiply_reference(
+		__in const luna_mat4 &left,
+		__in const luna_mat4 &right,
+		__out luna_mat4 &out
+		)
+	{
+		luna_mat4 result;
+		size_t column, row;
+
+		for(column = 0; column < 4; ++column) {
+
+			for(row = 0; row < 4; ++row) {
+				result.m[(column * 4) + row] = (left.m[row] * right.m[column * 4])
+					+ (left.m[4 + row] * right.m[(column * 4) + 1])
+					+ (left.m[8 + row] * right.m[(column * 4) + 2])
+					+ (left.m[12 + row] * right.m[(column * 4) + 3]);
+			}
+		}
+
+		out = result;
+	}
+
+	void 
+	luna_mat4_orthographic(
+		__in GLfloat left,
+		__in GLfloat right,
+		__in GLfloat bottom,
+		__in GLfloat top,
+		__in GLfloat near,
+		__in GLfloat far,
+		__out luna_mat4 &out
+		)
+	{
+		luna_mat4_identity(out);
+		out.m[0] = 2.f / (right - left);
+		out.m[5] = 2.f / (top - bottom);
+		out.m[10] = -2.f / (far - near);
+		out.m[12] = -(right + left) / (right - left);
+		out.m[13] = -(top + bottom) / (top - bottom);
+		out.m[14] = -(far + near) / (far - near);
+	}
+
+	void 
+	luna_mat4_perspective(
+		__in GLfloat fov,
+		__in GLfloat aspect,
+		__in GLfloat near,
+		__in GLfloat far,
+		__out luna_mat4 &out
+		)
+	{
+		GLfloat focal;
+
+		focal = 1.f / std::tan(fov * 0.5f);
+		luna_mat4_identity(out);
+		out.m[0] = focal / aspect;
+		out.m[5] = focal;
+		out.m[10] = (far + near) / (near - far);
+		out.m[11] = -1.f;
+		out.m[14] = (2.f * far * near) / (near - far);
+		out.m[15] = 0.f;
+	}
+
+	void 
+	luna_mat4_transform(
+		__in const luna_mat4 &matrix,
+		__in const luna_vec4 &vector,
+		__out luna_vec4 &out
+		)
+	{
+#ifdef __SSE__
+		_mm_store_ps(&out.x, math_mat4_column(matrix, &vector.x));
+#else
+		luna_vec4 result;
+
+		result.x = (matrix.m[0] * vector.x) + (matrix.m[4] * vector.y) 
+			+ (matrix.m[8] * vector.z) + (matrix.m[12] * vector.w);
+		result.y = (matrix.m[1] * vector.x) + (matrix.m[5] * vector.y) 
+			+ (matrix.m[9] * vector.z) + (matrix.m[13] * vector.w);
+		result.z = (matrix.m[2] * vector.x) + (matrix.m[6] * vector.y) 
+			+ (matrix.m[10] * vector.z) + (matrix.m[14] * vector.w);
+		result.w = (matrix.m[3] * vector.x) + (matrix.m[7] * vector.y) 
+			+ (matrix.m[11] * vector.z) + (matrix.m[15] * vector.w);
+		out = result;
+#endif // __SSE__
+	}
+
+	void 
+	luna_mat4_transform_batch(
+		__in const luna_mat4 &matrix,
+		__in const luna_vec3_soa &in,
+		__out const luna_vec3_soa &out,
+		__in size_t count
+		)
+	{
+		size_t iter = 0;
+
+#ifdef __AVX__
+		__m256 m_256[12];
+
+		for(iter = 0; iter < 12; ++iter) {
+			m_256[iter] = _mm256_set1_ps(matrix.m[((iter / 3) * 4) + (iter % 3)]);
+		}
+
+		for(iter = 0; (iter + 8) <= count; iter += 8) {
+			__m256 x, y, z;
+
+			x = _mm256_loadu_ps(&in.x[iter]);
+			y = _mm256_loadu_ps(&in.y[iter]);
+			z = _mm256_loadu_ps(&in.z[iter]);
+			_mm256_storeu_ps(&out.x[iter], _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(m_256[0], x), _mm256_mul_ps(m_256[3], y)), 
+				_mm256_add_ps(_mm256_mul_ps(m_256[6], z), m_256[9])));
+			_mm256_storeu_ps(&out.y[iter], _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(m_256[1], x), _mm256_mul_ps(m_256[4], y)), 
+				_mm256_add_ps(_mm256_mul_ps(m_256[7], z), m_256[10])));
+			_mm256_storeu_ps(&out.z[iter], _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(m_256[2], x), _mm256_mul_ps(m_256[5], y)), 
+				_mm256_add_ps(_mm256_mul_ps(m_256[8], z), m_256[11])));
+		}
+#endif // __AVX__
+#ifdef __SSE__
+		size_t index;
+		__m128 m_128[12];
+
+		for(index = 0; index < 12; ++index) {
+			m_128[index] = _mm_set1_ps(matrix.m[((index / 3) * 4) + (index % 3)]);
+		}
+
+		for(; (iter + 4) <= count; iter += 4) {
+			__m128 x, y, z;
+
+			x = _mm_loadu_ps(&in.x[iter]);
+			y = _mm_loadu_ps(&in.y[iter]);
+			z = _mm_loadu_ps(&in.z[iter]);
+			_mm_storeu_ps(&out.x[iter], _mm_add_ps(_mm_add_ps(_mm_mul_ps(m_128[0], x), 
+				_mm_mul_ps(m_128[3], y)), _mm_add_ps(_mm_mul_ps(m_128[6], z), m_128[9])));
+			_mm_storeu_ps(&out.y[iter], _mm_add_ps(_mm_add_ps(_mm_mul_ps(m_128[1], x), 
+				_mm_mul_ps(m_128[4], y)), _mm_add_ps(_mm_mul_ps(m_128[7], z), m_128[10])));
+			_mm_storeu_ps(&out.z[iter], _mm_add_ps(_mm_add_ps(_mm_mul_ps(m_128[2], x), 
+				_mm_mul_ps(m_128[5], y)), _mm_add_ps(_mm_mul_ps(m_128[8], z), m_128[11])));
+		}
+#endif // __SSE__
+
+		if(iter < count) {
+			luna_vec3_soa tail_in, tail_out;
+
+			tail_in.x = &in.x[iter];
+			tail_in.y = &in.y[iter];
+			tail_in.z = &in.z[iter];
+			tail_out.x = &out.x[iter];
+			tail_out.y = &out.y[iter];
+			tail_out.z = &out.z[iter];
+			luna_mat4_transform_batch_reference(matrix, tail_in, tail_out, count - iter);
+		}
+	}
+
+	void 
+	luna_mat4_transform_batch_reference(
+		__in const luna_mat4 &matrix,
+		__in const luna_vec3_soa &in,
+		__out const luna_vec3_soa &out,
+		__in size_t count
+		)
+	{
+		size_t iter;
+		GLfloat x, y, z;
+
+		// points are affine, w is taken as one
+		for(iter = 0; iter < count; ++iter) {
+			x = in.x[iter];
+			y = in.y[iter];
+			z = in.z[iter];
+			out.x[iter] = (matrix.m[0] * x) + (matrix.m[4] * y) + (matrix.m[8] * z) 
+				+ matrix.m[12];
+			out.y[iter] = (matrix.m[1] * x) + (matrix.m[5] * y) + (matrix.m[9] * z) 
+				+ matrix.m[13];
+			out.z[iter] = (matrix.m[2] * x) + (matrix.m[6] * y) + (matrix.m[10] * z) 
+				+ matrix.m[14];
+		}
+	}
+
+	void 
+	luna_mat4_transpose(
+		__in const luna_mat4 &matrix,
+		__out luna_mat4 &out
+		)
+	{
+#ifdef __SSE__
+		__m128 column[4];
+
+		column[0] = _mm_load_ps(&matrix.m[0]);
+		column[1] = _mm_load_ps(&matrix.m[4]);
+		column[2] = _mm_load_ps(&matrix.m[8]);
+		column[3] = _mm_load_ps(&matrix.m[12]);
+		_MM_TRANSPOSE4_PS(column[0], column[1], column[2], column[3]);
+		_mm_store_ps(&out.m[0], column[0]);
+		_mm_store_ps(&out.m[4], column[1]);
+		_mm_store_ps(&out.m[8], column[2]);
+		_mm_store_ps(&out.m[12], column[3]);
+#else
+		size_t column, row;
+		luna_mat4 result;
+
+		for(column = 0; column < 4; ++column) {
+
+			for(row = 0; row < 4; ++row) {
+				result.m[(row * 4) + column] = matrix.m[(column * 4) + row];
+			}
+		}
+
+		out = result;
+#endif // __SSE__
+	}
+
+	void 
+	luna_quat_from_axis_angle(
+		__in const luna_vec3 &axis,
+		__in GLfloat angle,
+		__out luna_quat &out
+		)
+	{
+		GLfloat sine;
+
+		sine = std::sin(angle * 0.5f);
+		out.x = axis.x * sine;
+		out.y = axis.y * sine;
+		out.z = axis.z * sine;
+		out.w = std::cos(angle * 0.5f);
+	}
+
+	void 
+	luna_quat_identity(
+		__out luna_quat &out
+		)
+	{
+		out.x = 0.f;
+		out.y = 0.f;
+		out.z = 0.f;
+		out.w = 1.f;
+	}
+
+	void 
+	luna_quat_multiply(
+		__in const luna_quat &left,
+		__in const luna_quat &right,
+		__out luna_quat &out
+		)
+	{
+		luna_quat result;
+
+		result.x = (left.w * right.x) + (left.x * right.w) + (left.y * right.z) 
+			- (left.z * right.y);
+		result.y = (left.w * right.y) - (left.x * right.z) + (left.y * right.w) 
+			+ (left.z * right.x);
+		result.z = (left.w * right.z) + (left.x * right.y) - (left.y * right.x) 
+			+ (left.z * right.w);
+		result.w = (left.w * right.w) - (left.x * right.x) - (left.y * right.y) 
+			- (left.z * right.z);
+		out = result;
+	}
+
+	void 
+	luna_quat_slerp(
+		__in const luna_quat &left,
+		__in const luna_quat &right,
+		__in GLfloat t,
+		__out luna_quat &out
+		)
+	{
+#ifdef __SSE__
+		__m128 dot, left_128, right_128;
+		GLfloat cosine, left_weight, right_weight, sine, theta;
+
+		left_128 = _mm_load_ps(&left.x);
+		right_128 = _mm_load_ps(&right.x);
+		dot = _mm_mul_ps(left_128, right_128);
+		dot = _mm_add_ps(dot, MATH_SWIZZLE(dot, 1, 0, 3, 2));
+		dot = _mm_add_ps(dot, MATH_SWIZZLE(dot, 2, 3, 0, 1));
+		cosine = _mm_cvtss_f32(dot);
+
+		// take the short path around the hypersphere
+		if(cosine < 0.f) {
+			cosine = -cosine;
+			right_128 = _mm_sub_ps(_mm_setzero_ps(), right_128);
+		}
+
+		if(cosine > (1.f - MATH_EPSILON)) {
+			left_weight = 1.f - t;
+			right_weight = t;
+		} else {
+			theta = std::acos(cosine);
+			sine = 1.f / std::sin(theta);
+			left_weight = std::sin((1.f - t) * theta) * sine;
+			right_weight = std::sin(t * theta) * sine;
+		}
+
+		_mm_store_ps(&out.x, _mm_add_ps(_mm_mul_ps(left_128, _mm_set1_ps(left_weight)), 
+			_mm_mul_ps(right_128, _mm_set1_ps(right_weight))));
+#else
+		luna_quat_slerp_reference(left, right, t, out);
+#endif // __SSE__
+	}
+
+	void 
+	luna_quat_slerp_reference(
+		__in const luna_quat &left,
+		__in const luna_quat &right,
+		__in GLfloat t,
+		__out luna_quat &out
+		)
+	{
+		luna_quat target = right;
+		GLfloat cosine, left_weight, right_weight, sine, theta;
+
+		cosine = (left.x * right.x) + (left.y * right.y) + (left.z * right.z) 
+			+ (left.w * right.w);
+
+		if(cosine < 0.f) {
+			cosine = -cosine;
+			target.x = -target.x;
+			target.y = -target.y;
+			target.z = -target.z;
+			target.w = -target.w;
+		}
+
+		if(cosine > (1.f - MATH_EPSILON)) {
+			left_weight = 1.f - t;
+			right_weight = t;
+		} else {
+			theta = std::acos(cosine);
+			sine = 1.f / std::sin(theta);
+			left_weight = std::sin((1.f - t) * theta) * sine;
+			right_weight = std::sin(t * theta) * sine;
+		}
+
+		out.x = (left.x * left_weight) + (target.x * right_weight);
+		out.y = (left.y * left_weight) + (target.y * right_weight);
+		out.z = (left.z * left_weight) + (target.z * right_weight);
+		out.w = (left.w * left_weight) + (target.w * right_weight);
+	}
+
+	void 
+	luna_vec3_cross(
+		__in const luna_vec3 &left,
+		__in const luna_vec3 &right,
+		__out luna_vec3 &out
+		)
+	{
+		luna_vec3 result;
+
+		result.x = (left.y * right.z) - (left.z * right.y);
+		result.y = (left.z * right.x) - (left.x * right.z);
+		result.z = (left.x * right.y) - (left.y * right.x);
+		result.pad = 0.f;
+		out = result;
+	}
+
+	GLfloat 
+	luna_vec3_dot(
+		__in const luna_vec3 &left,
+		__in const luna_vec3 &right
+		)
+	{
+		return (left.x * right.x) + (left.y * right.y) + (left.z * right.z);
+	}
+
+	GLfloat 
+	luna_vec3_length(
+		__in const luna_vec3 &vector
+		)
+	{
+		return std::sqrt(luna_vec3_dot(vector, vector));
+	}
+
+	void 
+	luna_vec3_make(
+		__in GLfloat x,
+		__in GLfloat y,
+		__in GLfloat z,
+		__out luna_vec3 &out
+		)
+	{
+		out.x = x;
+		out.y = y;
+		out.z = z;
+		out.pad = 0.f;
+	}
+
+	void 
+	luna_vec3_normalize(
+		__in const luna_vec3 &vector,
+		__out luna_vec3 &out
+		)
+	{
+		GLfloat length;
+
+		length = luna_vec3_length(vector);
+		if(length > MATH_EPSILON) {
+			length = 1.f / length;
+		}
+
+		luna_vec3_make(vector.x * length, vector.y * length, vector.z * length, out);
+	}
+
+	GLfloat 
+	luna_vec4_dot(
+		__in const luna_vec4 &left,
+		__in const luna_vec4 &right
+		)
+	{
+		return (left.x * right.x) + (left.y * right.y) + (left.z * right.z) 
+			+ (left.w * right.w);
+	}
+
+	void 
+	luna_vec4_lerp(
+		__in const luna_vec4 &left,
+		__in const luna_vec4 &right,
+		__in GLfloat t,
+		__out luna_vec4 &out
+		)
+	{
+#ifdef __SSE__
+		__m128 left_128 = _mm_load_ps(&left.x);
+
+		_mm_store_ps(&out.x, _mm_add_ps(left_128, _mm_mul_ps(_mm_set1_ps(t), 
+			_mm_sub_ps(_mm_load_ps(&right.x), left_128))));
+#else
+		out.x = left.x + (t * (right.x - left.x));
+		out.y = left.y + (t * (right.y - left.y));
+		out.z = left.z + (t * (right.z - left.z));
+		out.w = left.w + (t * (right.w - left.w));
+#endif // __SSE__
+	}
+}
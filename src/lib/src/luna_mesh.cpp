@@ -0,0 +1,1809 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <tuple>
+#include "../include/luna.h"
+#include "../include/luna_mesh_type.h"
+
+#ifdef __AVX__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif // __AVX__
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define MESH_LOD_BLOCK_COUNT(_COUNT_) (((_COUNT_) + MESH_LOD_BLOCK - 1) / MESH_LOD_BLOCK)
+		#define MESH_QUADRIC_SIZE 10
+		#define MESH_SCORE_DECAY 1.5f
+		#define MESH_SCORE_LAST 0.75f
+		#define MESH_SCORE_VALENCE 2.f
+		#define MESH_SCORE_VALENCE_POWER -0.5f
+
+		typedef struct {
+			size_t begin;
+			size_t end;
+			float sort;
+		} luna_mesh_cluster;
+
+		typedef struct {
+			double cost;
+			uint32_t from;
+			uint32_t to;
+		} luna_mesh_edge;
+
+		typedef std::tuple<uint32_t, uint32_t, uint32_t> luna_mesh_key;
+
+		static size_t 
+		mesh_align(
+			__in size_t offset
+			)
+		{
+			return ((offset + (MESH_ALIGN - 1)) & ~((size_t) MESH_ALIGN - 1));
+		}
+
+		static void 
+		mesh_cross(
+			__in const std::vector<float> &position,
+			__in const uint32_t *corner,
+			__out float result[3]
+			)
+		{
+			size_t iter;
+			float first[3], second[3];
+
+			for(iter = 0; iter < 3; ++iter) {
+				first[iter] = (position.at((corner[1] * 3) + iter) - position.at((corner[0] * 3) + iter));
+				second[iter] = (position.at((corner[2] * 3) + iter) - position.at((corner[0] * 3) + iter));
+			}
+
+			result[0] = ((first[1] * second[2]) - (first[2] * second[1]));
+			result[1] = ((first[2] * second[0]) - (first[0] * second[2]));
+			result[2] = ((first[0] * second[1]) - (first[1] * second[0]));
+		}
+
+		static bool 
+		mesh_cluster_order(
+			__in const luna_mesh_cluster &left,
+			__in const luna_mesh_cluster &right
+			)
+		{
+			return (left.sort > right.sort);
+		}
+
+		static bool 
+		mesh_edge_order(
+			__in const luna_mesh_edge &left,
+			__in const luna_mesh_edge &right
+			)
+		{
+			return ((left.cost < right.cost) || ((left.cost == right.cost) 
+				&& ((left.from < right.from) || ((left.from == right.from) 
+				&& (left.to < right.to)))));
+		}
+
+		static uint16_t 
+		mesh_half(
+			__in float value
+			)
+		{
+			uint32_t bits, mantissa;
+			int32_t exponent, shift;
+			uint16_t result, sign;
+
+			std::memcpy(&bits, &value, sizeof(bits));
+			sign = ((bits >> 16) & 0x8000);
+			exponent = (((int32_t) ((bits >> 23) & 0xff)) - 112);
+			mantissa = (bits & 0x7fffff);
+
+			if((bits & 0x7fffffff) > 0x7f800000) {
+				result = (sign | 0x7e00);
+			} else if(exponent >= 0x1f) {
+				result = (sign | 0x7c00);
+			} else if(exponent <= 0) {
+
+				// small values flush through the subnormal range, rounding to nearest
+				if(exponent < -10) {
+					result = sign;
+				} else {
+					shift = (14 - exponent);
+					mantissa |= 0x800000;
+					result = (sign | ((mantissa + (1 << (shift - 1))) >> shift));
+				}
+			} else {
+
+				// a rounding carry out of the mantissa correctly bumps the exponent
+				result = (sign | (((exponent << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1)));
+			}
+
+			return result;
+		}
+
+		static uint32_t 
+		mesh_index(
+			__in const std::string &token,
+			__in size_t count,
+			__in const std::string &path,
+			__in size_t line
+			)
+		{
+			char *end = NULL;
+			long value;
+			uint32_t result = SCALAR_INVALID(uint32_t);
+
+			if(!token.empty()) {
+				value = std::strtol(token.c_str(), &end, 10);
+
+				// obj indices are one based, and negative indices count back from the end
+				if(*end || !value || ((value > 0) && ((size_t) value > count)) 
+						|| ((value < 0) && ((size_t) -value > count))) {
+					THROW_LUNA_MESH_EXCEPTION_FORMAT(LUNA_MESH_EXCEPTION_INVALID,
+						"%s: Line %u", STRING_CHECK(path), (uint32_t) line);
+				}
+
+				result = ((value > 0) ? (value - 1) : (count + value));
+			}
+
+			return result;
+		}
+
+		static void 
+		mesh_normals(
+			__in const std::vector<float> &position,
+			__in const std::vector<uint32_t> &index,
+			__out std::vector<float> &normal
+			)
+		{
+			float cross[3], length;
+			size_t corner, iter, vertex;
+
+			normal.assign(position.size(), 0.f);
+
+			// face normals are left unnormalized, so larger faces weigh more
+			for(iter = 0; iter < index.size(); iter += 3) {
+				mesh_cross(position, &index.at(iter), cross);
+
+				for(corner = 0; corner < 3; ++corner) {
+					vertex = (index.at(iter + corner) * 3);
+					normal.at(vertex) += cross[0];
+					normal.at(vertex + 1) += cross[1];
+					normal.at(vertex + 2) += cross[2];
+				}
+			}
+
+			for(iter = 0; iter < normal.size(); iter += 3) {
+				length = std::sqrt((normal.at(iter) * normal.at(iter)) 
+					+ (normal.at(iter + 1) * normal.at(iter + 1)) 
+					+ (normal.at(iter + 2) * normal.at(iter + 2)));
+
+				if(length > 0.f) {
+					normal.at(iter) /= length;
+					normal.at(iter + 1) /= length;
+					normal.at(iter + 2) /= length;
+				} else {
+					normal.at(iter + 2) = 1.f;
+				}
+			}
+		}
+
+		static bool 
+		mesh_parse(
+			__in luna_file &file,
+			__out std::vector<float> &position,
+			__out std::vector<float> &normal,
+			__out std::vector<float> &uv,
+			__out std::vector<uint32_t> &index,
+			__out bool &has_uv
+			)
+		{
+			float value;
+			luna_mesh_key key;
+			uint32_t element[3], vertex;
+			size_t begin, iter, line = 0;
+			bool result = true;
+			std::map<luna_mesh_key, uint32_t> unique;
+			std::vector<uint32_t> face;
+			std::vector<float> *input = NULL, input_normal, input_position, input_uv;
+			std::string component, text, token, type;
+			std::map<luna_mesh_key, uint32_t>::iterator unique_iter;
+			std::istringstream stream(std::string(file.data(), file.size()));
+
+			has_uv = false;
+			index.clear();
+			normal.clear();
+			position.clear();
+			uv.clear();
+
+			while(std::getline(stream, text)) {
+				++line;
+
+				std::istringstream tokens(text.substr(0, text.find('#')));
+				if(!(tokens >> type)) {
+					continue;
+				}
+
+				if((type == "v") || (type == "vn") || (type == "vt")) {
+					input = ((type == "v") ? &input_position 
+						: ((type == "vn") ? &input_normal : &input_uv));
+
+					for(iter = 0; iter < ((type == "vt") ? 2 : 3); ++iter) {
+
+						if(!(tokens >> value)) {
+							THROW_LUNA_MESH_EXCEPTION_FORMAT(LUNA_MESH_EXCEPTION_INVALID,
+								"%s: Line %u", STRING_CHECK(file.path()), (uint32_t) line);
+						}
+
+						input->push_back(value);
+					}
+				} else if(type == "f") {
+					face.clear();
+
+					while(tokens >> token) {
+						std::istringstream corner(token);
+
+						// v, v/vt, v//vn and v/vt/vn all name a vertex
+						for(iter = 0; iter < 3; ++iter) {
+							component.clear();
+							std::getline(corner, component, '/');
+							element[iter] = mesh_index(component, (!iter ? (input_position.size() / 3)
+								: ((iter == 1) ? (input_uv.size() / 2) : (input_normal.size() / 3))), 
+								file.path(), line);
+						}
+
+						if(element[0] == SCALAR_INVALID(uint32_t)) {
+							THROW_LUNA_MESH_EXCEPTION_FORMAT(LUNA_MESH_EXCEPTION_INVALID,
+								"%s: Line %u", STRING_CHECK(file.path()), (uint32_t) line);
+						}
+
+						key = std::make_tuple(element[0], element[1], element[2]);
+						unique_iter = unique.find(key);
+						if(unique_iter == unique.end()) {
+							vertex = (position.size() / 3);
+							unique.insert(std::pair<luna_mesh_key, uint32_t>(key, vertex));
+
+							for(iter = 0; iter < 3; ++iter) {
+								position.push_back(input_position.at((element[0] * 3) + iter));
+								normal.push_back((element[2] != SCALAR_INVALID(uint32_t)) 
+									? input_normal.at((element[2] * 3) + iter) : 0.f);
+							}
+
+							for(iter = 0; iter < 2; ++iter) {
+								uv.push_back((element[1] != SCALAR_INVALID(uint32_t)) 
+									? input_uv.at((element[1] * 2) + iter) : 0.f);
+							}
+						} else {
+							vertex = unique_iter->second;
+						}
+
+						has_uv |= (element[1] != SCALAR_INVALID(uint32_t));
+						result &= (element[2] != SCALAR_INVALID(uint32_t));
+						face.push_back(vertex);
+					}
+
+					if(face.size() < 3) {
+						THROW_LUNA_MESH_EXCEPTION_FORMAT(LUNA_MESH_EXCEPTION_INVALID,
+							"%s: Line %u", STRING_CHECK(file.path()), (uint32_t) line);
+					}
+
+					// polygons are split into fans around their first corner
+					for(begin = 1; begin < (face.size() - 1); ++begin) {
+						index.push_back(face.front());
+						index.push_back(face.at(begin));
+						index.push_back(face.at(begin + 1));
+					}
+				}
+			}
+
+			return result;
+		}
+
+		static void 
+		mesh_quadric(
+			__in const std::vector<float> &position,
+			__in const uint32_t *corner,
+			__inout std::vector<double> &quadric
+			)
+		{
+			float cross[3];
+			size_t iter;
+			double *entry, length, plane[4];
+
+			mesh_cross(position, corner, cross);
+			length = std::sqrt(((double) cross[0] * cross[0]) + ((double) cross[1] * cross[1]) 
+				+ ((double) cross[2] * cross[2]));
+
+			// planes are unit length, so errors read as squared distances
+			if(length > 0.0) {
+				plane[0] = (cross[0] / length);
+				plane[1] = (cross[1] / length);
+				plane[2] = (cross[2] / length);
+				plane[3] = -((plane[0] * position.at(corner[0] * 3)) 
+					+ (plane[1] * position.at((corner[0] * 3) + 1)) 
+					+ (plane[2] * position.at((corner[0] * 3) + 2)));
+
+				for(iter = 0; iter < 3; ++iter) {
+					entry = &quadric.at(corner[iter] * MESH_QUADRIC_SIZE);
+					entry[0] += (plane[0] * plane[0]);
+					entry[1] += (plane[0] * plane[1]);
+					entry[2] += (plane[0] * plane[2]);
+					entry[3] += (plane[0] * plane[3]);
+					entry[4] += (plane[1] * plane[1]);
+					entry[5] += (plane[1] * plane[2]);
+					entry[6] += (plane[1] * plane[3]);
+					entry[7] += (plane[2] * plane[2]);
+					entry[8] += (plane[2] * plane[3]);
+					entry[9] += (plane[3] * plane[3]);
+				}
+			}
+		}
+
+		static double 
+		mesh_quadric_error(
+			__in const double *quadric,
+			__in const float *position
+			)
+		{
+			double x = position[0], y = position[1], z = position[2];
+
+			return ((quadric[0] * x * x) + (2.0 * quadric[1] * x * y) + (2.0 * quadric[2] * x * z)
+				+ (2.0 * quadric[3] * x) + (quadric[4] * y * y) + (2.0 * quadric[5] * y * z) 
+				+ (2.0 * quadric[6] * y) + (quadric[7] * z * z) + (2.0 * quadric[8] * z) 
+				+ quadric[9]);
+		}
+
+		// each level is kept if its error, projected to pixels, clears the threshold; levels
+		// coarser than the current one must clear a tighter bound, so objects sitting near
+		// a switching distance do not flicker between levels
+		static size_t 
+		mesh_select(
+			__in const luna_vec3 &eye,
+			__in GLfloat scale,
+			__in GLfloat threshold,
+			__in const GLfloat *x,
+			__in const GLfloat *y,
+			__in const GLfloat *z,
+			__in const GLfloat *radius,
+			__in const GLfloat *const *error,
+			__in size_t count,
+			__inout uint32_t *level
+			)
+		{
+			uint32_t lod, next;
+			size_t iter = 0, result = 0;
+			GLfloat distance, factor, lower = (threshold * (1.f - MESH_LOD_HYSTERESIS));
+
+#ifdef __AVX__
+			for(; (iter + 8) <= count; iter += 8) {
+				__m256 accept, bound, coarser, current, delta_x, delta_y, delta_z, distance_256, 
+					factor_256, next_256;
+				uint32_t lane, mask;
+
+				delta_x = _mm256_sub_ps(_mm256_loadu_ps(&x[iter]), _mm256_set1_ps(eye.x));
+				delta_y = _mm256_sub_ps(_mm256_loadu_ps(&y[iter]), _mm256_set1_ps(eye.y));
+				delta_z = _mm256_sub_ps(_mm256_loadu_ps(&z[iter]), _mm256_set1_ps(eye.z));
+				distance_256 = _mm256_max_ps(_mm256_sub_ps(_mm256_sqrt_ps(_mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(delta_x, delta_x), _mm256_mul_ps(delta_y, 
+					delta_y)), _mm256_mul_ps(delta_z, delta_z))), _mm256_loadu_ps(&radius[iter])), 
+					_mm256_set1_ps(MESH_LOD_NEAR));
+				factor_256 = _mm256_div_ps(_mm256_set1_ps(scale), distance_256);
+				current = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *) &level[iter]));
+				next_256 = _mm256_setzero_ps();
+
+				for(lod = 1; lod < MESH_LOD_MAX; ++lod) {
+					coarser = _mm256_cmp_ps(current, _mm256_set1_ps((float) lod), _CMP_LT_OQ);
+					bound = _mm256_or_ps(_mm256_and_ps(coarser, _mm256_set1_ps(lower)), 
+						_mm256_andnot_ps(coarser, _mm256_set1_ps(threshold)));
+					accept = _mm256_cmp_ps(_mm256_mul_ps(_mm256_loadu_ps(&error[lod - 1][iter]), 
+						factor_256), bound, _CMP_LE_OQ);
+					next_256 = _mm256_add_ps(next_256, _mm256_and_ps(accept, _mm256_set1_ps(1.f)));
+				}
+
+				mask = _mm256_movemask_ps(_mm256_cmp_ps(next_256, current, _CMP_NEQ_OQ));
+				_mm256_storeu_si256((__m256i *) &level[iter], _mm256_cvtps_epi32(next_256));
+
+				for(lane = 0; lane < 8; ++lane) {
+					result += ((mask >> lane) & 1);
+				}
+			}
+#endif // __AVX__
+#ifdef __SSE2__
+			for(; (iter + 4) <= count; iter += 4) {
+				__m128 accept, bound, coarser, current, delta_x, delta_y, delta_z, distance_128, 
+					factor_128, next_128;
+				uint32_t lane, mask;
+
+				delta_x = _mm_sub_ps(_mm_loadu_ps(&x[iter]), _mm_set1_ps(eye.x));
+				delta_y = _mm_sub_ps(_mm_loadu_ps(&y[iter]), _mm_set1_ps(eye.y));
+				delta_z = _mm_sub_ps(_mm_loadu_ps(&z[iter]), _mm_set1_ps(eye.z));
+				distance_128 = _mm_max_ps(_mm_sub_ps(_mm_sqrt_ps(_mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(delta_x, delta_x), _mm_mul_ps(delta_y, delta_y)), 
+					_mm_mul_ps(delta_z, delta_z))), _mm_loadu_ps(&radius[iter])), 
+					_mm_set1_ps(MESH_LOD_NEAR));
+				factor_128 = _mm_div_ps(_mm_set1_ps(scale), distance_128);
+				current = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) &level[iter]));
+				next_128 = _mm_setzero_ps();
+
+				for(lod = 1; lod < MESH_LOD_MAX; ++lod) {
+					coarser = _mm_cmplt_ps(current, _mm_set1_ps((float) lod));
+					bound = _mm_or_ps(_mm_and_ps(coarser, _mm_set1_ps(lower)), 
+						_mm_andnot_ps(coarser, _mm_set1_ps(threshold)));
+					accept = _mm_cmple_ps(_mm_mul_ps(_mm_loadu_ps(&error[lod - 1][iter]), 
+						factor_128), bound);
+					next_128 = _mm_add_ps(next_128, _mm_and_ps(accept, _mm_set1_ps(1.f)));
+				}
+
+				mask = _mm_movemask_ps(_mm_cmpneq_ps(next_128, current));
+				_mm_storeu_si128((__m128i *) &level[iter], _mm_cvtps_epi32(next_128));
+
+				for(lane = 0; lane < 4; ++lane) {
+					result += ((mask >> lane) & 1);
+				}
+			}
+#endif // __SSE2__
+
+			for(; iter < count; ++iter) {
+				distance = std::max(std::sqrt(((x[iter] - eye.x) * (x[iter] - eye.x)) 
+					+ ((y[iter] - eye.y) * (y[iter] - eye.y)) + ((z[iter] - eye.z) 
+					* (z[iter] - eye.z))) - radius[iter], MESH_LOD_NEAR);
+				factor = (scale / distance);
+
+				for(lod = 1, next = 0; lod < MESH_LOD_MAX; ++lod) {
+					next += ((error[lod - 1][iter] * factor) <= ((level[iter] < lod) ? lower 
+						: threshold));
+				}
+
+				result += (next != level[iter]);
+				level[iter] = next;
+			}
+
+			return result;
+		}
+
+		static float 
+		mesh_score(
+			__in int32_t position,
+			__in uint32_t remaining
+			)
+		{
+			float result = -1.f;
+
+			// forsyth's linear-speed vertex cache scoring: recently used vertices score
+			// high, and vertices with few remaining triangles are pulled forward
+			if(remaining) {
+				result = 0.f;
+
+				if(position >= 0) {
+					result = ((position < 3) ? MESH_SCORE_LAST : std::pow(1.f - ((position - 3) 
+						/ (float) (MESH_CACHE_SIZE - 3)), MESH_SCORE_DECAY));
+				}
+
+				result += (MESH_SCORE_VALENCE * std::pow((float) remaining, 
+					MESH_SCORE_VALENCE_POWER));
+			}
+
+			return result;
+		}
+
+		_luna_mesh *_luna_mesh::m_instance = NULL;
+
+		_luna_mesh::_luna_mesh(void) :
+			m_initialized(false),
+			m_lod_scale(0.f),
+			m_lod_threshold(0.f),
+			m_next(0)
+		{
+			std::memset(&m_lod_eye, 0, sizeof(m_lod_eye));
+			std::atexit(luna_mesh::_delete);
+		}
+
+		_luna_mesh::~_luna_mesh(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_mesh::_delete(void)
+		{
+
+			if(luna_mesh::m_instance) {
+				delete luna_mesh::m_instance;
+				luna_mesh::m_instance = NULL;
+			}
+		}
+
+		_luna_mesh *
+		_luna_mesh::acquire(void)
+		{
+
+			if(!luna_mesh::m_instance) {
+
+				luna_mesh::m_instance = new luna_mesh;
+				if(!luna_mesh::m_instance) {
+					THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_mesh::m_instance;
+		}
+
+		double 
+		_luna_mesh::acmr(
+			__in const std::vector<uint32_t> &index,
+			__in_opt size_t cache
+			)
+		{
+			size_t iter, miss = 0;
+			std::deque<uint32_t> fifo;
+			double result = 0.0;
+
+			// average cache miss ratio, against a fifo post-transform cache
+			for(iter = 0; iter < index.size(); ++iter) {
+
+				if(std::find(fifo.begin(), fifo.end(), index.at(iter)) == fifo.end()) {
+					++miss;
+					fifo.push_back(index.at(iter));
+
+					if(fifo.size() > cache) {
+						fifo.pop_front();
+					}
+				}
+			}
+
+			if(index.size() >= 3) {
+				result = (miss / (double) (index.size() / 3));
+			}
+
+			return result;
+		}
+
+		GLuint 
+		_luna_mesh::add(
+			__in const std::string &path
+			)
+		{
+			luna_file file;
+			GLuint result = 0;
+			luna_mesh_entry entry = luna_mesh_entry();
+			const luna_mesh_header *header = NULL;
+			luna_vertex_ptr instance_vertex = NULL;
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			file.open(path);
+			validate(file);
+			header = (const luna_mesh_header *) file.data();
+			instance_vertex = luna_vertex::acquire();
+
+			// the vao captures both buffers and the attribute layout, and the ranges go
+			// from the mapping straight into the buffers, without a staging copy
+			result = instance_vertex->add_vertex(1);
+
+			try {
+				entry.vertex_buffer = instance_vertex->add_buffer(GL_ARRAY_BUFFER, 1);
+				instance_vertex->set_buffer_data(GL_ARRAY_BUFFER, file.data() + header->vertex, 
+					header->vertex_count * sizeof(luna_mesh_vertex), GL_STATIC_DRAW);
+				entry.index_buffer = instance_vertex->add_buffer(GL_ELEMENT_ARRAY_BUFFER, 1);
+				instance_vertex->set_buffer_data(GL_ELEMENT_ARRAY_BUFFER, 
+					file.data() + header->index, header->index_count * header->index_size, 
+					GL_STATIC_DRAW);
+			} catch(...) {
+
+				// nothing is registered yet, so the vao and buffers are released here
+				instance_vertex->bind_vertex();
+
+				if(entry.index_buffer) {
+					instance_vertex->remove_buffer(entry.index_buffer);
+				}
+
+				if(entry.vertex_buffer) {
+					instance_vertex->remove_buffer(entry.vertex_buffer);
+				}
+
+				instance_vertex->remove_vertex(result);
+				throw;
+			}
+
+			glEnableVertexAttribArray(MESH_ATTRIBUTE_POSITION);
+			glVertexAttribPointer(MESH_ATTRIBUTE_POSITION, 3, GL_UNSIGNED_SHORT, GL_TRUE, 
+				sizeof(luna_mesh_vertex), (GLvoid *) offsetof(luna_mesh_vertex, position));
+			glEnableVertexAttribArray(MESH_ATTRIBUTE_NORMAL);
+			glVertexAttribPointer(MESH_ATTRIBUTE_NORMAL, 3, GL_BYTE, GL_TRUE, 
+				sizeof(luna_mesh_vertex), (GLvoid *) offsetof(luna_mesh_vertex, normal));
+			glEnableVertexAttribArray(MESH_ATTRIBUTE_UV);
+			glVertexAttribPointer(MESH_ATTRIBUTE_UV, 2, GL_HALF_FLOAT, GL_FALSE, 
+				sizeof(luna_mesh_vertex), (GLvoid *) offsetof(luna_mesh_vertex, uv));
+			instance_vertex->bind_vertex();
+
+			entry.index_count = header->index_count;
+			entry.lod.assign((const luna_mesh_lod *) (file.data() + header->lod), 
+				((const luna_mesh_lod *) (file.data() + header->lod)) + header->lod_count);
+			entry.index_type = ((header->index_size == sizeof(uint16_t)) ? GL_UNSIGNED_SHORT 
+				: GL_UNSIGNED_INT);
+			entry.maximum = { header->maximum[0], header->maximum[1], header->maximum[2], 0.f };
+			entry.minimum = { header->minimum[0], header->minimum[1], header->minimum[2], 0.f };
+			entry.reference = REFERENCE_INIT;
+			entry.vertex_count = header->vertex_count;
+			m_mesh_map.insert(std::pair<GLuint, luna_mesh_entry>(result, entry));
+
+			return result;
+		}
+
+		uint32_t 
+		_luna_mesh::add_lod(
+			__in GLuint id,
+			__in const luna_vec3 &center,
+			__in GLfloat radius
+			)
+		{
+			uint32_t lod;
+			luna_mesh_lod_entry entry;
+			std::map<GLuint, luna_mesh_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+			entry.index = m_lod_id.size();
+			entry.mesh = id;
+			m_lod_id.push_back(++m_next);
+			m_lod_level.push_back(0);
+			m_lod_radius.push_back(0.f);
+			m_lod_x.push_back(0.f);
+			m_lod_y.push_back(0.f);
+			m_lod_z.push_back(0.f);
+
+			// errors are copied in, so selection never looks the mesh up, and missing
+			// levels can never be selected
+			for(lod = 1; lod < MESH_LOD_MAX; ++lod) {
+				m_lod_error[lod - 1].push_back((lod < iter->second.lod.size()) 
+					? iter->second.lod.at(lod).error : INFINITY);
+			}
+
+			m_lod_map.insert(std::pair<uint32_t, luna_mesh_lod_entry>(m_next, entry));
+			set_lod(m_next, center, radius);
+
+			return m_next;
+		}
+
+		void 
+		_luna_mesh::bind(
+			__in_opt GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			luna_vertex::acquire()->bind_vertex(!id ? id : find(id)->first);
+		}
+
+		void 
+		_luna_mesh::bounds(
+			__in GLuint id,
+			__out luna_vec3 &minimum,
+			__out luna_vec3 &maximum
+			)
+		{
+			std::map<GLuint, luna_mesh_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+			maximum = iter->second.maximum;
+			minimum = iter->second.minimum;
+		}
+
+		luna_mesh_stat 
+		_luna_mesh::build(
+			__in const std::string &path,
+			__in const std::string &input,
+			__in_opt size_t levels
+			)
+		{
+			luna_file file;
+			luna_mesh_lod lod;
+			bool has_uv = false;
+			float error, extent;
+			luna_mesh_stat result;
+			luna_mesh_header header;
+			size_t corner, iter, level, offset;
+			luna_mesh_vertex *entry = NULL;
+			std::vector<luna_mesh_vertex> vertex;
+			std::vector<uint16_t> index_short;
+			std::vector<uint32_t> index, output, remap, simplified;
+			std::vector<float> normal, position, uv;
+
+			file.map(input);
+
+			if(!mesh_parse(file, position, normal, uv, index, has_uv)) {
+				mesh_normals(position, index, normal);
+			}
+
+			file.close();
+
+			if(index.empty() || ((position.size() / 3) > UINT32_MAX)) {
+				THROW_LUNA_MESH_EXCEPTION_FORMAT(LUNA_MESH_EXCEPTION_INVALID,
+					"%s", STRING_CHECK(input));
+			}
+
+			result.acmr_input = acmr(index);
+			result.atvr_input = ((result.acmr_input * (index.size() / 3)) / (position.size() / 3));
+			result.size_input = ((position.size() + normal.size() + uv.size()) * sizeof(float))
+				+ (index.size() * sizeof(uint32_t));
+
+			levels = std::max((size_t) 1, std::min(levels, (size_t) MESH_LOD_MAX));
+			std::memset(&lod, 0, sizeof(luna_mesh_lod));
+
+			// every level is simplified from the full mesh, so its error is measured against
+			// the original surface, and all levels share one vertex buffer
+			for(level = 0; level < levels; ++level) {
+
+				if(level) {
+					error = simplify(index, position, ((size_t) ((index.size() / 3) 
+						* std::pow(MESH_LOD_RATIO, (float) level))) * 3, simplified);
+
+					// a level held back by borders and seams ends the chain
+					if((simplified.size() / 3) > ((lod.count / 3) 
+							* ((1.f + MESH_LOD_RATIO) / 2.f))) {
+						break;
+					}
+
+					lod.error = std::max(lod.error, error);
+				} else {
+					simplified = index;
+				}
+
+				optimize(simplified, position.size() / 3);
+				optimize_overdraw(simplified, position);
+
+				if(!level) {
+					result.acmr = acmr(simplified);
+				}
+
+				lod.count = simplified.size();
+				lod.offset = output.size();
+				result.lod.push_back(lod);
+				output.insert(output.end(), simplified.begin(), simplified.end());
+			}
+
+			index.swap(output);
+
+			// vertices are renumbered in first use, so fetches walk the buffer forward
+			remap.resize(position.size() / 3, SCALAR_INVALID(uint32_t));
+
+			for(iter = 0; iter < index.size(); ++iter) {
+
+				if(remap.at(index.at(iter)) == SCALAR_INVALID(uint32_t)) {
+					remap.at(index.at(iter)) = vertex.size();
+					vertex.push_back(luna_mesh_vertex());
+				}
+
+				index.at(iter) = remap.at(index.at(iter));
+			}
+
+			std::memset(&header, 0, sizeof(luna_mesh_header));
+
+			for(corner = 0; corner < 3; ++corner) {
+				header.maximum[corner] = -INFINITY;
+				header.minimum[corner] = INFINITY;
+			}
+
+			for(iter = 0; iter < remap.size(); ++iter) {
+
+				for(corner = 0; (remap.at(iter) != SCALAR_INVALID(uint32_t)) && (corner < 3); 
+						++corner) {
+					header.maximum[corner] = std::max(header.maximum[corner], 
+						position.at((iter * 3) + corner));
+					header.minimum[corner] = std::min(header.minimum[corner], 
+						position.at((iter * 3) + corner));
+				}
+			}
+
+			for(iter = 0; iter < remap.size(); ++iter) {
+
+				if(remap.at(iter) == SCALAR_INVALID(uint32_t)) {
+					continue;
+				}
+
+				entry = &vertex.at(remap.at(iter));
+				std::memset(entry, 0, sizeof(luna_mesh_vertex));
+
+				for(corner = 0; corner < 3; ++corner) {
+					extent = (header.maximum[corner] - header.minimum[corner]);
+					entry->position[corner] = ((extent > 0.f) ? (uint16_t) std::lround(
+						((position.at((iter * 3) + corner) - header.minimum[corner]) / extent) 
+						* UINT16_MAX) : 0);
+					entry->normal[corner] = (int8_t) std::lround(std::max(-1.f, std::min(1.f, 
+						normal.at((iter * 3) + corner))) * INT8_MAX);
+				}
+
+				entry->uv[0] = mesh_half(uv.at(iter * 2));
+				entry->uv[1] = mesh_half(uv.at((iter * 2) + 1));
+			}
+
+			header.flags = (has_uv ? MESH_FLAG_UV : 0);
+			header.index_count = index.size();
+			header.index_size = ((vertex.size() <= (UINT16_MAX + 1)) ? sizeof(uint16_t) 
+				: sizeof(uint32_t));
+			header.lod = mesh_align(sizeof(luna_mesh_header));
+			header.lod_count = result.lod.size();
+			header.magic = MESH_MAGIC;
+			header.vertex = mesh_align(header.lod + (result.lod.size() * sizeof(luna_mesh_lod)));
+			header.vertex_count = vertex.size();
+			header.index = mesh_align(header.vertex + (vertex.size() * sizeof(luna_mesh_vertex)));
+			header.version = MESH_VERSION;
+
+			std::ofstream stream(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			if(!stream) {
+				THROW_LUNA_MESH_EXCEPTION_FORMAT(LUNA_MESH_EXCEPTION_EXTERNAL,
+					"Failed to open %s", STRING_CHECK(path));
+			}
+
+			stream.write((const char *) &header, sizeof(luna_mesh_header));
+			stream << std::string(header.lod - sizeof(luna_mesh_header), '\0');
+			stream.write((const char *) result.lod.data(), result.lod.size() 
+				* sizeof(luna_mesh_lod));
+			offset = (header.lod + (result.lod.size() * sizeof(luna_mesh_lod)));
+			stream << std::string(header.vertex - offset, '\0');
+			stream.write((const char *) vertex.data(), vertex.size() * sizeof(luna_mesh_vertex));
+			offset = (header.vertex + (vertex.size() * sizeof(luna_mesh_vertex)));
+			stream << std::string(header.index - offset, '\0');
+
+			if(header.index_size == sizeof(uint16_t)) {
+				index_short.assign(index.begin(), index.end());
+				stream.write((const char *) index_short.data(), index_short.size() 
+					* sizeof(uint16_t));
+			} else {
+				stream.write((const char *) index.data(), index.size() * sizeof(uint32_t));
+			}
+
+			stream.close();
+			if(!stream) {
+				THROW_LUNA_MESH_EXCEPTION_FORMAT(LUNA_MESH_EXCEPTION_EXTERNAL,
+					"Failed to write %s", STRING_CHECK(path));
+			}
+
+			result.atvr = ((result.acmr * (result.lod.front().count / 3)) / vertex.size());
+			result.index_count = result.lod.front().count;
+			result.size = (header.index + (index.size() * header.index_size));
+			result.vertex_count = vertex.size();
+
+			return result;
+		}
+
+		void 
+		_luna_mesh::clear(void)
+		{
+			uint32_t lod;
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_lod_changed.clear();
+
+			for(lod = 1; lod < MESH_LOD_MAX; ++lod) {
+				m_lod_error[lod - 1].clear();
+			}
+
+			m_lod_id.clear();
+			m_lod_level.clear();
+			m_lod_map.clear();
+			m_lod_radius.clear();
+			m_lod_x.clear();
+			m_lod_y.clear();
+			m_lod_z.clear();
+
+			while(!m_mesh_map.empty()) {
+				release(m_mesh_map.begin());
+			}
+		}
+
+		bool 
+		_luna_mesh::contains(
+			__in GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (m_mesh_map.find(id) != m_mesh_map.end());
+		}
+
+		size_t 
+		_luna_mesh::decrement_reference(
+			__in GLuint id
+			)
+		{
+			size_t result = 0;
+			std::map<GLuint, luna_mesh_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+			if(iter->second.reference > REFERENCE_INIT) {
+				result = --iter->second.reference;
+			} else {
+				release(iter);
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_mesh::draw(
+			__in GLuint id,
+			__in_opt uint32_t level
+			)
+		{
+			const luna_mesh_lod *lod = NULL;
+			std::map<GLuint, luna_mesh_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			// levels past the end of the chain draw the coarsest one
+			iter = find(id);
+			lod = &iter->second.lod.at(std::min((size_t) level, iter->second.lod.size() - 1));
+			luna_vertex::acquire()->bind_vertex(iter->first);
+			glDrawElements(GL_TRIANGLES, lod->count, iter->second.index_type, 
+				(GLvoid *) (lod->offset * ((iter->second.index_type == GL_UNSIGNED_SHORT) 
+				? sizeof(uint16_t) : sizeof(uint32_t))));
+			luna_vertex::acquire()->bind_vertex();
+		}
+
+		std::map<GLuint, luna_mesh_entry>::iterator 
+		_luna_mesh::find(
+			__in GLuint id
+			)
+		{
+			std::map<GLuint, luna_mesh_entry>::iterator result;
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			result = m_mesh_map.find(id);
+			if(result == m_mesh_map.end()) {
+				THROW_LUNA_MESH_EXCEPTION_FORMAT(LUNA_MESH_EXCEPTION_NOT_FOUND,
+					"0x%x", id);
+			}
+
+			return result;
+		}
+
+		std::map<uint32_t, luna_mesh_lod_entry>::iterator 
+		_luna_mesh::find_lod(
+			__in uint32_t id
+			)
+		{
+			std::map<uint32_t, luna_mesh_lod_entry>::iterator result;
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			result = m_lod_map.find(id);
+			if(result == m_lod_map.end()) {
+				THROW_LUNA_MESH_EXCEPTION_FORMAT(LUNA_MESH_EXCEPTION_NOT_FOUND,
+					"0x%x", id);
+			}
+
+			return result;
+		}
+
+		size_t 
+		_luna_mesh::increment_reference(
+			__in GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			return ++find(id)->second.reference;
+		}
+
+		GLsizei 
+		_luna_mesh::index_count(
+			__in GLuint id,
+			__in_opt uint32_t level
+			)
+		{
+			std::map<GLuint, luna_mesh_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+
+			return iter->second.lod.at(std::min((size_t) level, iter->second.lod.size() - 1)).count;
+		}
+
+		void 
+		_luna_mesh::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			m_next = 0;
+			clear();
+		}
+
+		bool 
+		_luna_mesh::is_allocated(void)
+		{
+			return (luna_mesh::m_instance != NULL);
+		}
+
+		bool 
+		_luna_mesh::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		uint32_t 
+		_luna_mesh::level(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_lod_level.at(find_lod(id)->second.index);
+		}
+
+		uint32_t 
+		_luna_mesh::lod_count(
+			__in GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			return find(id)->second.lod.size();
+		}
+
+		void 
+		_luna_mesh::optimize(
+			__inout std::vector<uint32_t> &index,
+			__in size_t vertex_count
+			)
+		{
+			float best_score;
+			uint32_t vertex;
+			size_t adjacent, best, corner, cursor = 0, iter, triangle;
+			std::vector<bool> emitted(index.size() / 3, false);
+			std::vector<int32_t> position(vertex_count, SCALAR_INVALID(int32_t));
+			std::vector<float> score(vertex_count), triangle_score(index.size() / 3);
+			std::vector<uint32_t> adjacency(index.size()), cache, next, offset(vertex_count + 1, 0), 
+				remaining(vertex_count, 0), result;
+
+			for(iter = 0; iter < index.size(); ++iter) {
+
+				if(index.at(iter) >= vertex_count) {
+					THROW_LUNA_MESH_EXCEPTION_FORMAT(LUNA_MESH_EXCEPTION_INVALID,
+						"Index %u", (uint32_t) iter);
+				}
+
+				++offset.at(index.at(iter) + 1);
+			}
+
+			for(iter = 0; iter < vertex_count; ++iter) {
+				offset.at(iter + 1) += offset.at(iter);
+			}
+
+			// each vertex lists its unemitted triangles, packed at the front of its range
+			for(iter = 0; iter < index.size(); ++iter) {
+				vertex = index.at(iter);
+				adjacency.at(offset.at(vertex) + remaining.at(vertex)++) = (iter / 3);
+			}
+
+			for(iter = 0; iter < vertex_count; ++iter) {
+				score.at(iter) = mesh_score(position.at(iter), remaining.at(iter));
+			}
+
+			for(iter = 0; iter < triangle_score.size(); ++iter) {
+				triangle_score.at(iter) = (score.at(index.at(iter * 3)) 
+					+ score.at(index.at((iter * 3) + 1)) + score.at(index.at((iter * 3) + 2)));
+			}
+
+			result.reserve(index.size());
+			best = SCALAR_INVALID(size_t);
+
+			for(triangle = 0; triangle < emitted.size(); ++triangle) {
+
+				// once the cache runs dry, the next unemitted triangle in input order restarts it
+				if(best == SCALAR_INVALID(size_t)) {
+
+					while(emitted.at(cursor)) {
+						++cursor;
+					}
+
+					best = cursor;
+				}
+
+				emitted.at(best) = true;
+				next.clear();
+
+				for(corner = 0; corner < 3; ++corner) {
+					vertex = index.at((best * 3) + corner);
+					result.push_back(vertex);
+
+					for(iter = offset.at(vertex); iter < (offset.at(vertex) 
+							+ remaining.at(vertex)); ++iter) {
+
+						if(adjacency.at(iter) == best) {
+							adjacency.at(iter) = adjacency.at(offset.at(vertex) 
+								+ remaining.at(vertex) - 1);
+							--remaining.at(vertex);
+							break;
+						}
+					}
+
+					if(std::find(next.begin(), next.end(), vertex) == next.end()) {
+						next.push_back(vertex);
+					}
+				}
+
+				for(iter = 0; iter < cache.size(); ++iter) {
+
+					if(std::find(next.begin(), next.end(), cache.at(iter)) == next.end()) {
+						next.push_back(cache.at(iter));
+					}
+				}
+
+				// vertices pushed past the end of the cache are scored as evicted
+				for(iter = 0; iter < next.size(); ++iter) {
+					vertex = next.at(iter);
+					position.at(vertex) = ((iter < MESH_CACHE_SIZE) ? (int32_t) iter 
+						: SCALAR_INVALID(int32_t));
+					score.at(vertex) = mesh_score(position.at(vertex), remaining.at(vertex));
+				}
+
+				best = SCALAR_INVALID(size_t);
+				best_score = -1.f;
+
+				for(iter = 0; iter < next.size(); ++iter) {
+					vertex = next.at(iter);
+
+					for(adjacent = offset.at(vertex); adjacent < (offset.at(vertex) 
+							+ remaining.at(vertex)); ++adjacent) {
+						corner = (adjacency.at(adjacent) * 3);
+						triangle_score.at(adjacency.at(adjacent)) = (score.at(index.at(corner)) 
+							+ score.at(index.at(corner + 1)) + score.at(index.at(corner + 2)));
+
+						if(triangle_score.at(adjacency.at(adjacent)) > best_score) {
+							best = adjacency.at(adjacent);
+							best_score = triangle_score.at(best);
+						}
+					}
+				}
+
+				if(next.size() > MESH_CACHE_SIZE) {
+					next.resize(MESH_CACHE_SIZE);
+				}
+
+				cache.swap(next);
+			}
+
+			index.swap(result);
+		}
+
+		void 
+		_luna_mesh::optimize_overdraw(
+			__inout std::vector<uint32_t> &index,
+			__in const std::vector<float> &position
+			)
+		{
+			float area, center[3] = { 0.f }, cross[3], length, total = 0.f;
+			size_t corner, iter, miss, triangle;
+			std::deque<uint32_t> fifo;
+			luna_mesh_cluster cluster;
+			std::vector<uint32_t> result;
+			std::vector<luna_mesh_cluster> clusters;
+			std::vector<float> centroid(3), normal(3);
+
+			// clusters break where the cache misses a whole triangle, so moving them
+			// costs the vertex cache almost nothing
+			for(triangle = 0; triangle < (index.size() / 3); ++triangle) {
+
+				for(corner = 0, miss = 0; corner < 3; ++corner) {
+
+					if(std::find(fifo.begin(), fifo.end(), index.at((triangle * 3) + corner)) 
+							== fifo.end()) {
+						++miss;
+						fifo.push_back(index.at((triangle * 3) + corner));
+
+						if(fifo.size() > MESH_FIFO_SIZE) {
+							fifo.pop_front();
+						}
+					}
+				}
+
+				if(!triangle || (miss == 3)) {
+
+					if(triangle) {
+						clusters.back().end = triangle;
+					}
+
+					cluster.begin = triangle;
+					cluster.end = (index.size() / 3);
+					cluster.sort = 0.f;
+					clusters.push_back(cluster);
+				}
+			}
+
+			for(iter = 0; iter < index.size(); iter += 3) {
+				mesh_cross(position, &index.at(iter), cross);
+				area = std::sqrt((cross[0] * cross[0]) + (cross[1] * cross[1]) 
+					+ (cross[2] * cross[2]));
+				total += area;
+
+				for(corner = 0; corner < 3; ++corner) {
+					center[corner] += (area * (position.at((index.at(iter) * 3) + corner) 
+						+ position.at((index.at(iter + 1) * 3) + corner) 
+						+ position.at((index.at(iter + 2) * 3) + corner)) / 3.f);
+				}
+			}
+
+			for(corner = 0; (total > 0.f) && (corner < 3); ++corner) {
+				center[corner] /= total;
+			}
+
+			// sander et al.: clusters facing away from the mesh center tend to occlude the
+			// rest, so drawing them first lets depth testing reject more fragments
+			for(iter = 0; iter < clusters.size(); ++iter) {
+				std::fill(centroid.begin(), centroid.end(), 0.f);
+				std::fill(normal.begin(), normal.end(), 0.f);
+				total = 0.f;
+
+				for(triangle = clusters.at(iter).begin; triangle < clusters.at(iter).end; 
+						++triangle) {
+					mesh_cross(position, &index.at(triangle * 3), cross);
+					area = std::sqrt((cross[0] * cross[0]) + (cross[1] * cross[1]) 
+						+ (cross[2] * cross[2]));
+					total += area;
+
+					for(corner = 0; corner < 3; ++corner) {
+						normal.at(corner) += cross[corner];
+						centroid.at(corner) += (area * (position.at((index.at(triangle * 3) * 3) 
+							+ corner) + position.at((index.at((triangle * 3) + 1) * 3) + corner)
+							+ position.at((index.at((triangle * 3) + 2) * 3) + corner)) / 3.f);
+					}
+				}
+
+				length = std::sqrt((normal.at(0) * normal.at(0)) + (normal.at(1) * normal.at(1))
+					+ (normal.at(2) * normal.at(2)));
+
+				for(corner = 0; (total > 0.f) && (length > 0.f) && (corner < 3); ++corner) {
+					clusters.at(iter).sort += (((centroid.at(corner) / total) - center[corner]) 
+						* (normal.at(corner) / length));
+				}
+			}
+
+			std::stable_sort(clusters.begin(), clusters.end(), mesh_cluster_order);
+			result.reserve(index.size());
+
+			for(iter = 0; iter < clusters.size(); ++iter) {
+				result.insert(result.end(), index.begin() + (clusters.at(iter).begin * 3), 
+					index.begin() + (clusters.at(iter).end * 3));
+			}
+
+			index.swap(result);
+		}
+
+		size_t 
+		_luna_mesh::reference_count(
+			__in GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			return find(id)->second.reference;
+		}
+
+		void 
+		_luna_mesh::release(
+			__in std::map<GLuint, luna_mesh_entry>::iterator iter
+			)
+		{
+			std::vector<uint32_t> lod;
+			std::vector<uint32_t>::iterator lod_iter;
+			std::map<uint32_t, luna_mesh_lod_entry>::iterator entry;
+
+			// lod instances go with their mesh
+			for(entry = m_lod_map.begin(); entry != m_lod_map.end(); ++entry) {
+
+				if(entry->second.mesh == iter->first) {
+					lod.push_back(entry->first);
+				}
+			}
+
+			for(lod_iter = lod.begin(); lod_iter != lod.end(); ++lod_iter) {
+				remove_lod(*lod_iter);
+			}
+
+			// the vertex component may already be torn down during shutdown
+			if(luna_vertex::is_allocated() && luna_vertex::acquire()->is_initialized()) {
+				luna_vertex::acquire()->remove_vertex(iter->first);
+				luna_vertex::acquire()->remove_buffer(iter->second.index_buffer);
+				luna_vertex::acquire()->remove_buffer(iter->second.vertex_buffer);
+			}
+
+			m_mesh_map.erase(iter);
+		}
+
+		void 
+		_luna_mesh::remove(
+			__in GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			// meshes may have several holders, so only the last one releases it
+			decrement_reference(id);
+		}
+
+		void 
+		_luna_mesh::remove_lod(
+			__in uint32_t id
+			)
+		{
+			uint32_t lod;
+			size_t index, last;
+			std::map<uint32_t, luna_mesh_lod_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find_lod(id);
+			index = iter->second.index;
+			last = (m_lod_id.size() - 1);
+
+			// swap the final entry into the hole so the arrays stay dense
+			for(lod = 1; lod < MESH_LOD_MAX; ++lod) {
+				m_lod_error[lod - 1][index] = m_lod_error[lod - 1][last];
+				m_lod_error[lod - 1].pop_back();
+			}
+
+			m_lod_id[index] = m_lod_id[last];
+			m_lod_level[index] = m_lod_level[last];
+			m_lod_radius[index] = m_lod_radius[last];
+			m_lod_x[index] = m_lod_x[last];
+			m_lod_y[index] = m_lod_y[last];
+			m_lod_z[index] = m_lod_z[last];
+			m_lod_id.pop_back();
+			m_lod_level.pop_back();
+			m_lod_radius.pop_back();
+			m_lod_x.pop_back();
+			m_lod_y.pop_back();
+			m_lod_z.pop_back();
+
+			if(index != last) {
+				find_lod(m_lod_id[index])->second.index = index;
+			}
+
+			m_lod_map.erase(iter);
+		}
+
+		size_t 
+		_luna_mesh::select(
+			__in const luna_vec3 &eye,
+			__in GLfloat scale,
+			__in_opt GLfloat threshold
+			)
+		{
+			size_t blocks, iter, result = 0;
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			// scale is the viewport height over 2 * tan(fov / 2), so error times scale over
+			// distance is the error in pixels
+			blocks = MESH_LOD_BLOCK_COUNT(m_lod_id.size());
+			m_lod_changed.assign(blocks, 0);
+			m_lod_eye = eye;
+			m_lod_scale = scale;
+			m_lod_threshold = threshold;
+
+			if((blocks > 1) && luna_job::is_allocated() && luna_job::acquire()->is_initialized()) {
+				luna_job::acquire()->run(blocks, luna_mesh::select_range, this);
+			} else {
+				select_range(0, blocks, this);
+			}
+
+			for(iter = 0; iter < blocks; ++iter) {
+				result += m_lod_changed[iter];
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_mesh::select_range(
+			__in size_t begin,
+			__in size_t end,
+			__in void *context
+			)
+		{
+			uint32_t lod;
+			size_t block, count, offset;
+			const GLfloat *error[MESH_LOD_MAX - 1];
+			luna_mesh_ptr instance = (luna_mesh_ptr) context;
+
+			for(block = begin; block < end; ++block) {
+				offset = (block * MESH_LOD_BLOCK);
+				count = std::min((size_t) MESH_LOD_BLOCK, instance->m_lod_id.size() - offset);
+
+				for(lod = 1; lod < MESH_LOD_MAX; ++lod) {
+					error[lod - 1] = &instance->m_lod_error[lod - 1][offset];
+				}
+
+				instance->m_lod_changed[block] = mesh_select(instance->m_lod_eye, 
+					instance->m_lod_scale, instance->m_lod_threshold, &instance->m_lod_x[offset], 
+					&instance->m_lod_y[offset], &instance->m_lod_z[offset], 
+					&instance->m_lod_radius[offset], error, count, 
+					&instance->m_lod_level[offset]);
+			}
+		}
+
+		void 
+		_luna_mesh::set_lod(
+			__in uint32_t id,
+			__in const luna_vec3 &center,
+			__in GLfloat radius
+			)
+		{
+			std::map<uint32_t, luna_mesh_lod_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find_lod(id);
+			if(radius < 0.f) {
+				THROW_LUNA_MESH_EXCEPTION_FORMAT(LUNA_MESH_EXCEPTION_INVALID,
+					"0x%x", id);
+			}
+
+			m_lod_radius[iter->second.index] = radius;
+			m_lod_x[iter->second.index] = center.x;
+			m_lod_y[iter->second.index] = center.y;
+			m_lod_z[iter->second.index] = center.z;
+		}
+
+		float 
+		_luna_mesh::simplify(
+			__in const std::vector<uint32_t> &index,
+			__in const std::vector<float> &position,
+			__in size_t target,
+			__out std::vector<uint32_t> &result
+			)
+		{
+			bool flip;
+			uint64_t key;
+			luna_mesh_edge edge;
+			float after[3], before[3];
+			double error = 0.0, *quadric_from, *quadric_to;
+			size_t adjacent, candidate, corner, count, iter, removed;
+			uint32_t collapsed[3], vertex, vertex_count = (position.size() / 3);
+			std::map<uint64_t, size_t> border;
+			std::map<uint64_t, size_t>::iterator border_iter;
+			std::vector<luna_mesh_edge> edges;
+			std::vector<bool> locked(vertex_count, false), touched;
+			std::vector<uint32_t> adjacency, offset, remap;
+			std::vector<double> quadric(vertex_count * MESH_QUADRIC_SIZE, 0.0);
+
+			result = index;
+
+			for(iter = 0; iter < index.size(); iter += 3) {
+				mesh_quadric(position, &index.at(iter), quadric);
+
+				for(corner = 0; corner < 3; ++corner) {
+					key = std::min(index.at(iter + corner), index.at(iter + ((corner + 1) % 3)));
+					key = ((key << 32) | std::max(index.at(iter + corner), 
+						index.at(iter + ((corner + 1) % 3))));
+					++border[key];
+				}
+			}
+
+			// edges used by a single triangle are borders or uv seams, and stay put
+			for(border_iter = border.begin(); border_iter != border.end(); ++border_iter) {
+
+				if(border_iter->second == 1) {
+					locked.at(border_iter->first >> 32) = true;
+					locked.at(border_iter->first & UINT32_MAX) = true;
+				}
+			}
+
+			// half edge collapses in passes, cheapest first, where each pass leaves the
+			// neighborhood of a collapse alone so that its costs stay valid
+			while(result.size() > target) {
+				edges.clear();
+
+				for(iter = 0; iter < result.size(); iter += 3) {
+
+					for(corner = 0; corner < 3; ++corner) {
+						edge.from = result.at(iter + corner);
+						edge.to = result.at(iter + ((corner + 1) % 3));
+
+						if(!locked.at(edge.from)) {
+							edge.cost = (mesh_quadric_error(&quadric.at(edge.from 
+								* MESH_QUADRIC_SIZE), &position.at(edge.to * 3)) 
+								+ mesh_quadric_error(&quadric.at(edge.to * MESH_QUADRIC_SIZE), 
+								&position.at(edge.to * 3)));
+							edges.push_back(edge);
+						}
+					}
+				}
+
+				std::sort(edges.begin(), edges.end(), mesh_edge_order);
+
+				offset.assign(vertex_count + 1, 0);
+				adjacency.resize(result.size());
+
+				for(iter = 0; iter < result.size(); ++iter) {
+					++offset.at(result.at(iter) + 1);
+				}
+
+				for(iter = 0; iter < vertex_count; ++iter) {
+					offset.at(iter + 1) += offset.at(iter);
+				}
+
+				remap.assign(offset.begin(), offset.end() - 1);
+
+				for(iter = 0; iter < result.size(); ++iter) {
+					adjacency.at(remap.at(result.at(iter))++) = (iter / 3);
+				}
+
+				for(iter = 0; iter < vertex_count; ++iter) {
+					remap.at(iter) = iter;
+				}
+
+				touched.assign(vertex_count, false);
+				removed = 0;
+
+				for(candidate = 0; (candidate < edges.size()) && ((result.size() - (removed * 3)) 
+						> target); ++candidate) {
+					edge = edges.at(candidate);
+
+					if(touched.at(edge.from) || touched.at(edge.to)) {
+						continue;
+					}
+
+					// collapses that fold a surrounding triangle over are rejected
+					for(adjacent = offset.at(edge.from), flip = false; !flip 
+							&& (adjacent < offset.at(edge.from + 1)); ++adjacent) {
+						iter = (adjacency.at(adjacent) * 3);
+
+						for(corner = 0; corner < 3; ++corner) {
+							vertex = result.at(iter + corner);
+							collapsed[corner] = ((vertex == edge.from) ? edge.to : vertex);
+						}
+
+						// triangles that already hold the edge collapse away, and are skipped
+						if(((collapsed[0] != edge.to) + (collapsed[1] != edge.to) 
+								+ (collapsed[2] != edge.to)) == 2) {
+							mesh_cross(position, &result.at(iter), before);
+							mesh_cross(position, collapsed, after);
+							flip = (((before[0] * after[0]) + (before[1] * after[1]) 
+								+ (before[2] * after[2])) <= 0.f);
+						}
+					}
+
+					if(flip) {
+						continue;
+					}
+
+					quadric_from = &quadric.at(edge.from * MESH_QUADRIC_SIZE);
+					quadric_to = &quadric.at(edge.to * MESH_QUADRIC_SIZE);
+
+					for(iter = 0; iter < MESH_QUADRIC_SIZE; ++iter) {
+						quadric_to[iter] += quadric_from[iter];
+					}
+
+					error = std::max(error, edge.cost);
+					remap.at(edge.from) = edge.to;
+
+					for(adjacent = offset.at(edge.from); adjacent < offset.at(edge.from + 1); 
+							++adjacent) {
+						iter = (adjacency.at(adjacent) * 3);
+						removed += ((result.at(iter) == edge.to) || (result.at(iter + 1) == edge.to)
+							|| (result.at(iter + 2) == edge.to));
+
+						for(corner = 0; corner < 3; ++corner) {
+							touched.at(result.at(iter + corner)) = true;
+						}
+					}
+				}
+
+				if(!removed) {
+					break;
+				}
+
+				for(iter = 0, count = 0; iter < result.size(); iter += 3) {
+
+					for(corner = 0; corner < 3; ++corner) {
+						collapsed[corner] = remap.at(result.at(iter + corner));
+					}
+
+					if((collapsed[0] != collapsed[1]) && (collapsed[0] != collapsed[2]) 
+							&& (collapsed[1] != collapsed[2])) {
+						result.at(count++) = collapsed[0];
+						result.at(count++) = collapsed[1];
+						result.at(count++) = collapsed[2];
+					}
+				}
+
+				result.resize(count);
+			}
+
+			return std::sqrt(error);
+		}
+
+		size_t 
+		_luna_mesh::size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_mesh_map.size();
+		}
+
+		std::string 
+		_luna_mesh::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+			std::map<GLuint, luna_mesh_entry>::iterator iter;
+
+			result << LUNA_MESH_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_mesh_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+				result << " LOD. " << m_lod_id.size();
+
+				for(iter = m_mesh_map.begin(); iter != m_mesh_map.end(); ++iter) {
+					result << std::endl << "--- 0x" << SCALAR_AS_HEX(GLuint, iter->first)
+						<< ", VERT. " << iter->second.vertex_count 
+						<< ", IDX. " << iter->second.index_count
+						<< ", LOD. " << iter->second.lod.size()
+						<< ", REF. " << iter->second.reference;
+				}
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_mesh::uninitialize(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_MESH_EXCEPTION(LUNA_MESH_EXCEPTION_UNINITIALIZED);
+			}
+
+			clear();
+			m_initialized = false;
+		}
+
+		void 
+		_luna_mesh::validate(
+			__in luna_file &file
+			)
+		{
+			size_t iter;
+			uint32_t value;
+			const luna_mesh_lod *lod = NULL;
+			const luna_mesh_header *header = (const luna_mesh_header *) file.data();
+
+			// ranges are handed to gl as-is, so every one is checked first
+			if((file.size() < sizeof(luna_mesh_header)) || (header->magic != MESH_MAGIC)
+					|| (header->version != MESH_VERSION) || (header->index_count % 3)
+					|| (header->index_count > INT32_MAX) || (header->vertex_count > INT32_MAX)
+					|| ((header->index_size != sizeof(uint16_t)) 
+						&& (header->index_size != sizeof(uint32_t)))
+					|| (header->vertex % MESH_ALIGN) || (header->index % MESH_ALIGN)
+					|| (header->vertex > file.size()) || (header->vertex_count 
+						> ((file.size() - header->vertex) / sizeof(luna_mesh_vertex)))
+					|| (header->index > file.size()) || (header->index_count 
+						> ((file.size() - header->index) / header->index_size))
+					|| !header->lod_count || (header->lod_count > MESH_LOD_MAX)
+					|| (header->lod % MESH_ALIGN) || (header->lod > file.size()) 
+					|| (header->lod_count > ((file.size() - header->lod) 
+						/ sizeof(luna_mesh_lod)))) {
+				THROW_LUNA_MESH_EXCEPTION_FORMAT(LUNA_MESH_EXCEPTION_INVALID,
+					"%s", STRING_CHECK(file.path()));
+			}
+
+			lod = (const luna_mesh_lod *) (file.data() + header->lod);
+
+			for(iter = 0; iter < header->lod_count; ++iter) {
+
+				if((lod[iter].count % 3) || (lod[iter].offset > header->index_count) 
+						|| (lod[iter].count > (header->index_count - lod[iter].offset))
+						|| !std::isfinite(lod[iter].error) 
+						|| (iter && (lod[iter].error < lod[iter - 1].error))) {
+					THROW_LUNA_MESH_EXCEPTION_FORMAT(LUNA_MESH_EXCEPTION_INVALID,
+						"%s: Level %u", STRING_CHECK(file.path()), (uint32_t) iter);
+				}
+			}
+
+			for(iter = 0; iter < header->index_count; ++iter) {
+
+				if(header->index_size == sizeof(uint16_t)) {
+					value = ((const uint16_t *) (file.data() + header->index))[iter];
+				} else {
+					value = ((const uint32_t *) (file.data() + header->index))[iter];
+				}
+
+				if(value >= header->vertex_count) {
+					THROW_LUNA_MESH_EXCEPTION_FORMAT(LUNA_MESH_EXCEPTION_INVALID,
+						"%s: Index %u", STRING_CHECK(file.path()), (uint32_t) iter);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,904 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include "../include/luna.h"
+#include "../include/luna_navigation_type.h"
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define NAVIGATION_DIAGONAL 0.70710678f
+		#define NAVIGATION_INFINITE UINT32_MAX
+		#define NAVIGATION_WEIGHT_DIAGONAL 14
+		#define NAVIGATION_WEIGHT_STRAIGHT 10
+
+		#define NAVIGATION_KEY(_VALUE_, _CELL_) \
+			((((uint64_t) (_VALUE_)) << 32) | ((uint64_t) (_CELL_)))
+
+		#define NAVIGATION_OPPOSITE(_DIRECTION_) (((_DIRECTION_) + 4) & 7)
+
+		#define NAVIGATION_SECTOR_COUNT(_COUNT_) \
+			(((_COUNT_) + NAVIGATION_SECTOR - 1) / NAVIGATION_SECTOR)
+
+		#define NAVIGATION_WEIGHT(_DIRECTION_) \
+			(((_DIRECTION_) & 1) ? NAVIGATION_WEIGHT_DIAGONAL : NAVIGATION_WEIGHT_STRAIGHT)
+
+		static const int NAVIGATION_OFFSET_X[] = {
+			1, 1, 0, -1, -1, -1, 0, 1,
+			};
+
+		static const int NAVIGATION_OFFSET_Y[] = {
+			0, 1, 1, 1, 0, -1, -1, -1,
+			};
+
+		static const GLfloat NAVIGATION_VECTOR_X[] = {
+			1.f, NAVIGATION_DIAGONAL, 0.f, -NAVIGATION_DIAGONAL, -1.f, -NAVIGATION_DIAGONAL, 
+			0.f, NAVIGATION_DIAGONAL, 0.f, 0.f,
+			};
+
+		static const GLfloat NAVIGATION_VECTOR_Y[] = {
+			0.f, NAVIGATION_DIAGONAL, 1.f, NAVIGATION_DIAGONAL, 0.f, -NAVIGATION_DIAGONAL, 
+			-1.f, -NAVIGATION_DIAGONAL, 0.f, 0.f,
+			};
+
+		typedef std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> 
+			luna_navigation_queue;
+
+		// looks up the neighbour of a cell, diagonal steps may not cut past a blocked corner
+		static bool 
+		navigation_neighbour(
+			__in const std::vector<uint8_t> &cost,
+			__in size_t width,
+			__in size_t height,
+			__in size_t cell,
+			__in size_t direction,
+			__out size_t &result
+			)
+		{
+			int x, y;
+
+			x = (int) (cell % width) + NAVIGATION_OFFSET_X[direction];
+			y = (int) (cell / width) + NAVIGATION_OFFSET_Y[direction];
+			if((x < 0) || (y < 0) || (x >= (int) width) || (y >= (int) height)) {
+				return false;
+			}
+
+			result = (y * width) + x;
+			if(cost[result] == NAVIGATION_COST_BLOCKED) {
+				return false;
+			}
+
+			return (!(direction & 1) || ((cost[(y * width) + (cell % width)] != NAVIGATION_COST_BLOCKED) 
+				&& (cost[((cell / width) * width) + x] != NAVIGATION_COST_BLOCKED)));
+		}
+
+		_luna_navigation *_luna_navigation::m_instance = NULL;
+
+		_luna_navigation::_luna_navigation(void) :
+			m_cell(NAVIGATION_DEF_CELL),
+			m_height(NAVIGATION_DEF_HEIGHT),
+			m_initialized(false),
+			m_next(0),
+			m_pending(0),
+			m_serial(0),
+			m_width(NAVIGATION_DEF_WIDTH)
+		{
+			std::atexit(luna_navigation::_delete);
+			luna_vec3_make(0.f, 0.f, 0.f, m_origin);
+		}
+
+		_luna_navigation::~_luna_navigation(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_navigation::_delete(void)
+		{
+
+			if(luna_navigation::m_instance) {
+				delete luna_navigation::m_instance;
+				luna_navigation::m_instance = NULL;
+			}
+		}
+
+		_luna_navigation *
+		_luna_navigation::acquire(void)
+		{
+
+			if(!luna_navigation::m_instance) {
+
+				luna_navigation::m_instance = new luna_navigation;
+				if(!luna_navigation::m_instance) {
+					THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_navigation::m_instance;
+		}
+
+		uint32_t 
+		_luna_navigation::add(
+			__in const luna_vec3 &target
+			)
+		{
+			size_t x = 0, y = 0;
+			uint32_t goal;
+			luna_navigation_field field;
+			std::map<uint32_t, uint32_t>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!cell(target, x, y)) {
+				THROW_LUNA_NAVIGATION_EXCEPTION_FORMAT(LUNA_NAVIGATION_EXCEPTION_INVALID,
+					"{%f, %f}", (double) target.x, (double) target.y);
+			}
+
+			// targets in the same cell share one field
+			goal = (y * m_width) + x;
+
+			iter = m_target_map.find(goal);
+			if(iter != m_target_map.end()) {
+				++find(iter->second)->second.reference;
+				return iter->second;
+			}
+
+			field.goal = goal;
+			field.pending = false;
+			field.reference = 1;
+			field.rebuild = true;
+			field.serial = ++m_serial;
+			m_field_map.insert(std::pair<uint32_t, luna_navigation_field>(++m_next, field));
+			m_target_map.insert(std::pair<uint32_t, uint32_t>(goal, m_next));
+
+			return m_next;
+		}
+
+		bool 
+		_luna_navigation::cell(
+			__in const luna_vec3 &position,
+			__out size_t &x,
+			__out size_t &y
+			)
+		{
+			GLfloat cell_x, cell_y;
+
+			cell_x = std::floor((position.x - m_origin.x) / m_cell);
+			cell_y = std::floor((position.y - m_origin.y) / m_cell);
+			if(!(cell_x >= 0.f) || !(cell_y >= 0.f) || (cell_x >= (GLfloat) m_width) 
+					|| (cell_y >= (GLfloat) m_height)) {
+				return false;
+			}
+
+			x = (size_t) cell_x;
+			y = (size_t) cell_y;
+
+			return true;
+		}
+
+		GLfloat 
+		_luna_navigation::cell_size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_cell;
+		}
+
+		void 
+		_luna_navigation::clear(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_cost.assign(m_width * m_height, NAVIGATION_COST_DEF);
+			m_cost_snapshot.reset();
+			m_dirty.clear();
+			m_field_map.clear();
+			m_target_map.clear();
+
+			// fields still generating reference this instance, so they must land before 
+			// they are dropped
+			std::unique_lock<std::mutex> lock(m_complete_lock);
+
+			while(m_complete.size() < m_pending) {
+				m_complete_condition.wait(lock);
+			}
+
+			while(!m_complete.empty()) {
+				delete m_complete.front();
+				m_complete.pop_front();
+				--m_pending;
+			}
+		}
+
+		size_t 
+		_luna_navigation::collect(void)
+		{
+			size_t result = 0;
+			luna_navigation_request *request = NULL;
+			std::map<uint32_t, luna_navigation_field>::iterator iter;
+
+			for(;;) {
+
+				{
+					std::lock_guard<std::mutex> lock(m_complete_lock);
+
+					if(m_complete.empty()) {
+						break;
+					}
+
+					request = m_complete.front();
+					m_complete.pop_front();
+					--m_pending;
+				}
+
+				iter = m_field_map.find(request->id);
+				if((iter != m_field_map.end()) && (iter->second.serial == request->serial)) {
+					iter->second.pending = false;
+
+					// failed generations keep the last field and start over from scratch
+					if(request->result) {
+						iter->second.data = request->result;
+						++result;
+					} else {
+						iter->second.rebuild = true;
+					}
+				}
+
+				delete request;
+			}
+
+			return result;
+		}
+
+		bool 
+		_luna_navigation::contains(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (m_field_map.find(id) != m_field_map.end());
+		}
+
+		uint8_t 
+		_luna_navigation::cost(
+			__in const luna_vec3 &position
+			)
+		{
+			size_t x = 0, y = 0;
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (cell(position, x, y) ? m_cost[(y * m_width) + x] : NAVIGATION_COST_BLOCKED);
+		}
+
+		void 
+		_luna_navigation::dispatch(
+			__in uint32_t id,
+			__inout luna_navigation_field &field
+			)
+		{
+			luna_navigation_request *request = NULL;
+
+			request = new luna_navigation_request;
+			if(!request) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_ALLOCATED);
+			}
+
+			request->cost = m_cost_snapshot;
+			request->goal = field.goal;
+			request->height = m_height;
+			request->id = id;
+			request->serial = field.serial;
+			request->width = m_width;
+
+			if(!field.rebuild) {
+				request->previous = field.data;
+				request->sector.assign(field.dirty.begin(), field.dirty.end());
+			}
+
+			field.dirty.clear();
+			field.pending = true;
+			field.rebuild = false;
+			++m_pending;
+
+			// without workers the field is generated here, and lands in the same update
+			if(luna_job::is_allocated() && luna_job::acquire()->is_initialized()) {
+
+				try {
+					luna_job::acquire()->add(luna_navigation::run, request);
+				} catch(...) {
+					--m_pending;
+					field.pending = false;
+					field.rebuild = true;
+					delete request;
+					throw;
+				}
+			} else {
+				luna_navigation::run(request);
+			}
+		}
+
+		std::map<uint32_t, luna_navigation_field>::iterator 
+		_luna_navigation::find(
+			__in uint32_t id
+			)
+		{
+			std::map<uint32_t, luna_navigation_field>::iterator result;
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			result = m_field_map.find(id);
+			if(result == m_field_map.end()) {
+				THROW_LUNA_NAVIGATION_EXCEPTION_FORMAT(LUNA_NAVIGATION_EXCEPTION_NOT_FOUND,
+					"0x%x", id);
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_navigation::generate(
+			__inout luna_navigation_request &request
+			)
+		{
+			uint64_t key;
+			std::vector<uint8_t> mark;
+			luna_navigation_queue queue;
+			uint32_t best, candidate, value;
+			std::vector<uint32_t> invalid, stack;
+			size_t count, direction, iter, maximum_x, maximum_y, minimum_x, minimum_y, neighbour, 
+				sector_x, x, y;
+			const std::vector<uint8_t> &cost = *request.cost;
+
+			count = request.width * request.height;
+			request.result = std::make_shared<luna_navigation_data>();
+			std::vector<uint8_t> &flow = request.result->direction;
+			std::vector<uint32_t> &integration = request.result->integration;
+
+			if(request.previous) {
+				flow = request.previous->direction;
+				integration = request.previous->integration;
+				mark.assign(count, 0);
+				sector_x = NAVIGATION_SECTOR_COUNT(request.width);
+
+				// cells in a dirty sector, and the ring around it whose diagonal steps may now cut 
+				// a blocked corner, are reset along with every cell whose path runs through them
+				for(iter = 0; iter < request.sector.size(); ++iter) {
+					minimum_x = (request.sector[iter] % sector_x) * NAVIGATION_SECTOR;
+					minimum_y = (request.sector[iter] / sector_x) * NAVIGATION_SECTOR;
+					maximum_x = std::min(minimum_x + NAVIGATION_SECTOR, request.width - 1);
+					maximum_y = std::min(minimum_y + NAVIGATION_SECTOR, request.height - 1);
+					minimum_x = (minimum_x ? (minimum_x - 1) : 0);
+					minimum_y = (minimum_y ? (minimum_y - 1) : 0);
+
+					for(y = minimum_y; y <= maximum_y; ++y) {
+
+						for(x = minimum_x; x <= maximum_x; ++x) {
+
+							if(!mark[(y * request.width) + x]) {
+								mark[(y * request.width) + x] = 1;
+								stack.push_back((y * request.width) + x);
+							}
+						}
+					}
+				}
+
+				while(!stack.empty()) {
+					iter = stack.back();
+					stack.pop_back();
+					invalid.push_back(iter);
+
+					for(direction = 0; direction < NAVIGATION_DIRECTION_GOAL; ++direction) {
+						x = (iter % request.width) + NAVIGATION_OFFSET_X[direction];
+						y = (iter / request.width) + NAVIGATION_OFFSET_Y[direction];
+						if((x >= request.width) || (y >= request.height)) {
+							continue;
+						}
+
+						neighbour = (y * request.width) + x;
+						if(!mark[neighbour] && (flow[neighbour] == NAVIGATION_OPPOSITE(direction))) {
+							mark[neighbour] = 1;
+							stack.push_back(neighbour);
+						}
+					}
+
+					flow[iter] = NAVIGATION_DIRECTION_NONE;
+					integration[iter] = NAVIGATION_INFINITE;
+				}
+			} else {
+				flow.assign(count, NAVIGATION_DIRECTION_NONE);
+				integration.assign(count, NAVIGATION_INFINITE);
+			}
+
+			if((!request.previous || mark[request.goal]) 
+					&& (cost[request.goal] != NAVIGATION_COST_BLOCKED)) {
+				flow[request.goal] = NAVIGATION_DIRECTION_GOAL;
+				integration[request.goal] = 0;
+				queue.push(NAVIGATION_KEY(0, request.goal));
+			}
+
+			// reset cells restart from the best of their surviving neighbours
+			for(iter = 0; iter < invalid.size(); ++iter) {
+
+				if((invalid[iter] == request.goal) || (cost[invalid[iter]] == NAVIGATION_COST_BLOCKED)) {
+					continue;
+				}
+
+				best = NAVIGATION_INFINITE;
+
+				for(direction = 0; direction < NAVIGATION_DIRECTION_GOAL; ++direction) {
+
+					if(!navigation_neighbour(cost, request.width, request.height, invalid[iter], 
+							direction, neighbour) || (integration[neighbour] == NAVIGATION_INFINITE)) {
+						continue;
+					}
+
+					candidate = integration[neighbour] 
+						+ (NAVIGATION_WEIGHT(direction) * cost[invalid[iter]]);
+					if(candidate < best) {
+						best = candidate;
+						flow[invalid[iter]] = direction;
+					}
+				}
+
+				if(best != NAVIGATION_INFINITE) {
+					integration[invalid[iter]] = best;
+					queue.push(NAVIGATION_KEY(best, invalid[iter]));
+				}
+			}
+
+			// each cell pays its own cost to leave, so the flow points at the neighbour that 
+			// settled it
+			while(!queue.empty()) {
+				key = queue.top();
+				queue.pop();
+				iter = (key & UINT32_MAX);
+				value = (key >> 32);
+				if(value != integration[iter]) {
+					continue;
+				}
+
+				for(direction = 0; direction < NAVIGATION_DIRECTION_GOAL; ++direction) {
+
+					if(!navigation_neighbour(cost, request.width, request.height, iter, direction, 
+							neighbour)) {
+						continue;
+					}
+
+					candidate = value + (NAVIGATION_WEIGHT(direction) * cost[neighbour]);
+					if(candidate < integration[neighbour]) {
+						flow[neighbour] = NAVIGATION_OPPOSITE(direction);
+						integration[neighbour] = candidate;
+						queue.push(NAVIGATION_KEY(candidate, neighbour));
+					}
+				}
+			}
+		}
+
+		size_t 
+		_luna_navigation::height(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_height;
+		}
+
+		void 
+		_luna_navigation::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			m_next = 0;
+			clear();
+		}
+
+		bool 
+		_luna_navigation::is_allocated(void)
+		{
+			return (luna_navigation::m_instance != NULL);
+		}
+
+		bool 
+		_luna_navigation::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		bool 
+		_luna_navigation::is_ready(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (find(id)->second.data != NULL);
+		}
+
+		void 
+		_luna_navigation::mark(
+			__in size_t minimum_x,
+			__in size_t minimum_y,
+			__in size_t maximum_x,
+			__in size_t maximum_y
+			)
+		{
+			size_t x = 0, y = 0;
+
+			for(y = (minimum_y / NAVIGATION_SECTOR); y <= (maximum_y / NAVIGATION_SECTOR); ++y) {
+
+				for(x = (minimum_x / NAVIGATION_SECTOR); x <= (maximum_x / NAVIGATION_SECTOR); ++x) {
+					m_dirty.insert((y * NAVIGATION_SECTOR_COUNT(m_width)) + x);
+				}
+			}
+		}
+
+		size_t 
+		_luna_navigation::pending(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_pending;
+		}
+
+		size_t 
+		_luna_navigation::reference_count(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			return find(id)->second.reference;
+		}
+
+		void 
+		_luna_navigation::remove(
+			__in uint32_t id
+			)
+		{
+			std::map<uint32_t, luna_navigation_field>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+			if(!--iter->second.reference) {
+				m_target_map.erase(iter->second.goal);
+				m_field_map.erase(iter);
+			}
+		}
+
+		void 
+		_luna_navigation::run(
+			__in void *context
+			)
+		{
+			luna_navigation_ptr inst = luna_navigation::acquire();
+			luna_navigation_request *request = (luna_navigation_request *) context;
+
+			try {
+				generate(*request);
+			} catch(...) {
+				request->result.reset();
+			}
+
+			// notified under the lock, so a waiting clear cannot free the instance first
+			std::lock_guard<std::mutex> lock(inst->m_complete_lock);
+			inst->m_complete.push_back(request);
+			inst->m_complete_condition.notify_all();
+		}
+
+		bool 
+		_luna_navigation::sample(
+			__in uint32_t id,
+			__in const luna_vec3 &position,
+			__out luna_vec3 &direction
+			)
+		{
+			size_t x = 0, y = 0;
+			uint8_t result = NAVIGATION_DIRECTION_NONE;
+			std::map<uint32_t, luna_navigation_field>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+			if(iter->second.data && cell(position, x, y)) {
+				result = iter->second.data->direction[(y * m_width) + x];
+			}
+
+			luna_vec3_make(NAVIGATION_VECTOR_X[result], NAVIGATION_VECTOR_Y[result], 0.f, direction);
+
+			return (result != NAVIGATION_DIRECTION_NONE);
+		}
+
+		size_t 
+		_luna_navigation::sample(
+			__in uint32_t id,
+			__in const std::vector<luna_vec3> &position,
+			__out std::vector<luna_vec3> &direction
+			)
+		{
+			size_t index, result = 0, x, y;
+			uint8_t value;
+			const uint8_t *flow = NULL;
+			std::map<uint32_t, luna_navigation_field>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+			if(iter->second.data) {
+				flow = iter->second.data->direction.data();
+			}
+
+			direction.resize(position.size());
+
+			for(index = 0; index < position.size(); ++index) {
+				value = NAVIGATION_DIRECTION_NONE;
+
+				if(flow && cell(position[index], x, y)) {
+					value = flow[(y * m_width) + x];
+				}
+
+				luna_vec3_make(NAVIGATION_VECTOR_X[value], NAVIGATION_VECTOR_Y[value], 0.f, 
+					direction[index]);
+				result += (value != NAVIGATION_DIRECTION_NONE);
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_navigation::set_cost(
+			__in const luna_vec3 &position,
+			__in uint8_t cost
+			)
+		{
+			size_t x = 0, y = 0;
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!cost || !cell(position, x, y)) {
+				THROW_LUNA_NAVIGATION_EXCEPTION_FORMAT(LUNA_NAVIGATION_EXCEPTION_INVALID,
+					"{%f, %f}, %u", (double) position.x, (double) position.y, cost);
+			}
+
+			if(m_cost[(y * m_width) + x] != cost) {
+				m_cost[(y * m_width) + x] = cost;
+				mark(x, y, x, y);
+			}
+		}
+
+		void 
+		_luna_navigation::set_cost(
+			__in const luna_vec3 &minimum,
+			__in const luna_vec3 &maximum,
+			__in uint8_t cost
+			)
+		{
+			bool changed = false;
+			GLfloat maximum_x, maximum_y, minimum_x, minimum_y;
+			size_t high_x, high_y, low_x, low_y, x, y;
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!cost) {
+				THROW_LUNA_NAVIGATION_EXCEPTION_FORMAT(LUNA_NAVIGATION_EXCEPTION_INVALID,
+					"%u", cost);
+			}
+
+			// the area is clipped to the grid, cells it only partly covers are included
+			minimum_x = std::floor((minimum.x - m_origin.x) / m_cell);
+			minimum_y = std::floor((minimum.y - m_origin.y) / m_cell);
+			maximum_x = std::floor((maximum.x - m_origin.x) / m_cell);
+			maximum_y = std::floor((maximum.y - m_origin.y) / m_cell);
+			if(!(maximum_x >= 0.f) || !(maximum_y >= 0.f) || !(minimum_x < (GLfloat) m_width) 
+					|| !(minimum_y < (GLfloat) m_height) || (minimum_x > maximum_x) 
+					|| (minimum_y > maximum_y)) {
+				return;
+			}
+
+			low_x = (size_t) std::max(minimum_x, 0.f);
+			low_y = (size_t) std::max(minimum_y, 0.f);
+			high_x = (size_t) std::min(maximum_x, (GLfloat) (m_width - 1));
+			high_y = (size_t) std::min(maximum_y, (GLfloat) (m_height - 1));
+
+			for(y = low_y; y <= high_y; ++y) {
+
+				for(x = low_x; x <= high_x; ++x) {
+					changed = (changed || (m_cost[(y * m_width) + x] != cost));
+					m_cost[(y * m_width) + x] = cost;
+				}
+			}
+
+			if(changed) {
+				mark(low_x, low_y, high_x, high_y);
+			}
+		}
+
+		void 
+		_luna_navigation::set_grid(
+			__in size_t width,
+			__in size_t height,
+			__in_opt GLfloat cell_size,
+			__in_opt const luna_vec3 &origin
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!width || !height || ((width * height) > NAVIGATION_CELL_MAX) 
+					|| (height > (NAVIGATION_CELL_MAX / width)) || !(cell_size > 0.f) 
+					|| std::isinf(cell_size)) {
+				THROW_LUNA_NAVIGATION_EXCEPTION_FORMAT(LUNA_NAVIGATION_EXCEPTION_INVALID,
+					"%lux%lu, %f", (unsigned long) width, (unsigned long) height, (double) cell_size);
+			}
+
+			// costs and goals are laid out by the grid, so every field is dropped
+			m_cell = cell_size;
+			m_height = height;
+			m_origin = origin;
+			m_width = width;
+			clear();
+		}
+
+		size_t 
+		_luna_navigation::size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_field_map.size();
+		}
+
+		std::string 
+		_luna_navigation::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+
+			result << LUNA_NAVIGATION_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_navigation_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+				result << " CNT. " << m_field_map.size() << ", GRID. " << m_width << "x" << m_height 
+					<< ", DIRTY. " << m_dirty.size() << ", PEND. " << m_pending 
+					<< ", CELL. " << std::fixed << std::setprecision(3) << m_cell;
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_navigation::uninitialize(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			clear();
+			m_cost.clear();
+			m_initialized = false;
+		}
+
+		size_t 
+		_luna_navigation::update(void)
+		{
+			size_t result;
+			std::map<uint32_t, luna_navigation_field>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			result = collect();
+
+			// edits are published once per frame, workers read an immutable copy of the costs
+			if(!m_dirty.empty() || !m_cost_snapshot) {
+				m_cost_snapshot = std::make_shared<const std::vector<uint8_t>>(m_cost);
+
+				for(iter = m_field_map.begin(); iter != m_field_map.end(); ++iter) {
+					iter->second.dirty.insert(m_dirty.begin(), m_dirty.end());
+				}
+
+				m_dirty.clear();
+			}
+
+			// a field has at most one generation in flight, edits made meanwhile wait for the 
+			// next one, and the last finished field is sampled until then
+			for(iter = m_field_map.begin(); iter != m_field_map.end(); ++iter) {
+
+				if(!iter->second.pending && (iter->second.rebuild || !iter->second.dirty.empty())) {
+					dispatch(iter->first, iter->second);
+				}
+			}
+
+			return (result + collect());
+		}
+
+		size_t 
+		_luna_navigation::width(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_NAVIGATION_EXCEPTION(LUNA_NAVIGATION_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_width;
+		}
+	}
+}
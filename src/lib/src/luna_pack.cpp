@@ -0,0 +1,806 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include "../include/luna.h"
+#include "../include/luna_pack_type.h"
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define PACK_HASH_BITS 12
+		#define PACK_LITERAL_LAST 5
+		#define PACK_MATCH_LIMIT 12
+		#define PACK_MATCH_MIN 4
+		#define PACK_OFFSET_MAX 0xffff
+
+		typedef struct {
+			std::string name;
+			std::vector<char> payload;
+			luna_pack_toc toc;
+		} luna_pack_entry;
+
+		static size_t 
+		pack_align(
+			__in size_t offset
+			)
+		{
+			return ((offset + (PACK_ALIGN - 1)) & ~((size_t) PACK_ALIGN - 1));
+		}
+
+		static bool 
+		pack_compare(
+			__in const luna_pack_toc &entry,
+			__in uint64_t hash
+			)
+		{
+			return (entry.hash < hash);
+		}
+
+		static size_t 
+		pack_extend(
+			__in const uint8_t *data,
+			__in size_t size,
+			__inout size_t &position,
+			__in size_t value
+			)
+		{
+			uint8_t byte;
+
+			// nibbles of 15 continue into bytes, ending at the first byte below 255
+			if(value == 0xf) {
+
+				do {
+
+					if(position >= size) {
+						THROW_LUNA_PACK_EXCEPTION_FORMAT(LUNA_PACK_EXCEPTION_INVALID,
+							"Truncated length at %u", (uint32_t) position);
+					}
+
+					byte = data[position++];
+					value += byte;
+				} while(byte == UINT8_MAX);
+			}
+
+			return value;
+		}
+
+		static void 
+		pack_length(
+			__in size_t value,
+			__inout std::vector<char> &result
+			)
+		{
+
+			for(; value >= UINT8_MAX; value -= UINT8_MAX) {
+				result.push_back((char) UINT8_MAX);
+			}
+
+			result.push_back((char) value);
+		}
+
+		static std::string 
+		pack_name(
+			__in const std::string &name
+			)
+		{
+			size_t begin = 0;
+
+			// "./a" and "a" name the same entry
+			while(!name.compare(begin, 2, "./")) {
+				begin += 2;
+			}
+
+			return name.substr(begin);
+		}
+
+		static bool 
+		pack_order(
+			__in const luna_pack_entry &left,
+			__in const luna_pack_entry &right
+			)
+		{
+			return ((left.toc.hash < right.toc.hash) || ((left.toc.hash == right.toc.hash) 
+				&& (left.name < right.name)));
+		}
+
+		static uint32_t 
+		pack_read(
+			__in const char *data
+			)
+		{
+			uint32_t result;
+
+			std::memcpy(&result, data, sizeof(result));
+
+			return result;
+		}
+
+		static void 
+		pack_sequence(
+			__in const char *literal,
+			__in size_t literal_length,
+			__in size_t offset,
+			__in size_t match_length,
+			__inout std::vector<char> &result
+			)
+		{
+			uint8_t token;
+			size_t position = result.size();
+
+			token = (std::min(literal_length, (size_t) 0xf) << 4);
+			result.push_back(0);
+
+			if(literal_length >= 0xf) {
+				pack_length(literal_length - 0xf, result);
+			}
+
+			result.insert(result.end(), literal, literal + literal_length);
+
+			// the final sequence carries literals only
+			if(match_length) {
+				match_length -= PACK_MATCH_MIN;
+				token |= std::min(match_length, (size_t) 0xf);
+				result.push_back((char) (offset & UINT8_MAX));
+				result.push_back((char) (offset >> 8));
+
+				if(match_length >= 0xf) {
+					pack_length(match_length - 0xf, result);
+				}
+			}
+
+			result.at(position) = (char) token;
+		}
+
+		_luna_pack *_luna_pack::m_instance = NULL;
+
+		_luna_pack::_luna_pack(void) :
+			m_initialized(false),
+			m_next(0)
+		{
+			std::atexit(luna_pack::_delete);
+		}
+
+		_luna_pack::~_luna_pack(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_pack::_delete(void)
+		{
+
+			if(luna_pack::m_instance) {
+				delete luna_pack::m_instance;
+				luna_pack::m_instance = NULL;
+			}
+		}
+
+		_luna_pack *
+		_luna_pack::acquire(void)
+		{
+
+			if(!luna_pack::m_instance) {
+
+				luna_pack::m_instance = new luna_pack;
+				if(!luna_pack::m_instance) {
+					THROW_LUNA_PACK_EXCEPTION(LUNA_PACK_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_pack::m_instance;
+		}
+
+		size_t 
+		_luna_pack::build(
+			__in const std::string &path,
+			__in const std::vector<std::string> &input,
+			__in_opt bool compress
+			)
+		{
+			size_t iter, offset;
+			luna_file file;
+			std::string names;
+			luna_pack_header header;
+			std::set<std::string> unique;
+			std::vector<char> compressed;
+			std::vector<luna_pack_entry> entry;
+
+			entry.resize(input.size());
+
+			for(iter = 0; iter < input.size(); ++iter) {
+				entry.at(iter).name = pack_name(input.at(iter));
+
+				if(!unique.insert(entry.at(iter).name).second) {
+					THROW_LUNA_PACK_EXCEPTION_FORMAT(LUNA_PACK_EXCEPTION_DUPLICATE,
+						"%s", STRING_CHECK(entry.at(iter).name));
+				}
+
+				file.map(input.at(iter));
+
+				if((file.size() > UINT32_MAX) || (entry.at(iter).name.size() > UINT16_MAX)) {
+					THROW_LUNA_PACK_EXCEPTION_FORMAT(LUNA_PACK_EXCEPTION_INVALID,
+						"%s", STRING_CHECK(input.at(iter)));
+				}
+
+				std::memset(&entry.at(iter).toc, 0, sizeof(luna_pack_toc));
+				entry.at(iter).toc.hash = key(entry.at(iter).name);
+				entry.at(iter).toc.length = file.size();
+				entry.at(iter).toc.name_length = entry.at(iter).name.size();
+
+				if(compress && file.size()) {
+					luna_pack::compress(file.data(), file.size(), compressed);
+				}
+
+				// raw entries are read in place, so compression has to earn that back
+				if(compress && file.size() && (compressed.size() 
+						< (file.size() - (file.size() / 8)))) {
+					entry.at(iter).payload = compressed;
+					entry.at(iter).toc.flags = PACK_FLAG_COMPRESSED;
+				} else {
+					entry.at(iter).payload.assign(file.data(), file.data() + file.size());
+				}
+
+				entry.at(iter).toc.size = entry.at(iter).payload.size();
+				file.close();
+			}
+
+			std::sort(entry.begin(), entry.end(), pack_order);
+
+			offset = (sizeof(luna_pack_header) + (entry.size() * sizeof(luna_pack_toc)));
+
+			for(iter = 0; iter < entry.size(); ++iter) {
+				entry.at(iter).toc.name = (offset + names.size());
+				names += entry.at(iter).name;
+			}
+
+			offset = pack_align(offset + names.size());
+			if(offset > UINT32_MAX) {
+				THROW_LUNA_PACK_EXCEPTION_FORMAT(LUNA_PACK_EXCEPTION_INVALID,
+					"%s", STRING_CHECK(path));
+			}
+
+			for(iter = 0; iter < entry.size(); ++iter) {
+				entry.at(iter).toc.offset = offset;
+				offset = pack_align(offset + entry.at(iter).payload.size());
+			}
+
+			std::memset(&header, 0, sizeof(luna_pack_header));
+			header.count = entry.size();
+			header.magic = PACK_MAGIC;
+			header.toc = sizeof(luna_pack_header);
+			header.version = PACK_VERSION;
+
+			std::ofstream stream(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			if(!stream) {
+				THROW_LUNA_PACK_EXCEPTION_FORMAT(LUNA_PACK_EXCEPTION_EXTERNAL,
+					"Failed to open %s", STRING_CHECK(path));
+			}
+
+			stream.write((const char *) &header, sizeof(luna_pack_header));
+
+			for(iter = 0; iter < entry.size(); ++iter) {
+				stream.write((const char *) &entry.at(iter).toc, sizeof(luna_pack_toc));
+			}
+
+			offset = (sizeof(luna_pack_header) + (entry.size() * sizeof(luna_pack_toc)) 
+				+ names.size());
+			stream << names << std::string(pack_align(offset) - offset, '\0');
+
+			for(iter = 0; iter < entry.size(); ++iter) {
+				offset = entry.at(iter).payload.size();
+				stream.write(entry.at(iter).payload.data(), offset);
+				stream << std::string(pack_align(offset) - offset, '\0');
+			}
+
+			stream.close();
+			if(!stream) {
+				THROW_LUNA_PACK_EXCEPTION_FORMAT(LUNA_PACK_EXCEPTION_EXTERNAL,
+					"Failed to write %s", STRING_CHECK(path));
+			}
+
+			return entry.size();
+		}
+
+		void 
+		_luna_pack::clear(void)
+		{
+			std::map<uint32_t, luna_file *>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_PACK_EXCEPTION(LUNA_PACK_EXCEPTION_UNINITIALIZED);
+			}
+
+			std::lock_guard<std::mutex> lock(m_pack_lock);
+
+			// mappings still viewed in place are unmapped when their last view closes
+			for(iter = m_pack_map.begin(); iter != m_pack_map.end(); ++iter) {
+
+				if(m_view_map.find(iter->first) != m_view_map.end()) {
+					m_unmount_map.insert(*iter);
+				} else {
+					delete iter->second;
+				}
+			}
+
+			m_pack_map.clear();
+		}
+
+		void 
+		_luna_pack::close(
+			__in uint32_t id
+			)
+		{
+			std::map<uint32_t, size_t>::iterator iter;
+			std::map<uint32_t, luna_file *>::iterator unmount_iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_PACK_EXCEPTION(LUNA_PACK_EXCEPTION_UNINITIALIZED);
+			}
+
+			std::lock_guard<std::mutex> lock(m_pack_lock);
+
+			// views opened before a teardown have nothing left to release
+			iter = m_view_map.find(id);
+			if(iter == m_view_map.end()) {
+				return;
+			}
+
+			if(!--iter->second) {
+				m_view_map.erase(iter);
+
+				// the last view out of an unmounted pack takes its mapping with it
+				unmount_iter = m_unmount_map.find(id);
+				if(unmount_iter != m_unmount_map.end()) {
+					delete unmount_iter->second;
+					m_unmount_map.erase(unmount_iter);
+				}
+			}
+		}
+
+		void 
+		_luna_pack::compress(
+			__in const char *data,
+			__in size_t size,
+			__out std::vector<char> &result
+			)
+		{
+			uint32_t hash, sequence;
+			size_t anchor = 0, length, match, position;
+			std::vector<size_t> table(1 << PACK_HASH_BITS, SCALAR_INVALID(size_t));
+
+			result.clear();
+
+			// greedy lz4 block encoding, with the format's end of block rules: the last
+			// match starts 12 bytes before the end, and the last 5 bytes are literals
+			if(size > PACK_MATCH_LIMIT) {
+
+				for(position = 0; position < (size - PACK_MATCH_LIMIT);) {
+					sequence = pack_read(data + position);
+					hash = ((sequence * 2654435761U) >> (32 - PACK_HASH_BITS));
+					match = table.at(hash);
+					table.at(hash) = position;
+
+					if((match != SCALAR_INVALID(size_t)) && ((position - match) <= PACK_OFFSET_MAX) 
+							&& (pack_read(data + match) == sequence)) {
+
+						length = PACK_MATCH_MIN;
+
+						while(((position + length) < (size - PACK_LITERAL_LAST)) 
+								&& (data[match + length] == data[position + length])) {
+							++length;
+						}
+
+						pack_sequence(data + anchor, position - anchor, position - match, length, 
+							result);
+						position += length;
+						anchor = position;
+					} else {
+						++position;
+					}
+				}
+			}
+
+			pack_sequence(data + anchor, size - anchor, 0, 0, result);
+		}
+
+		bool 
+		_luna_pack::contains(
+			__in const std::string &name
+			)
+		{
+			luna_pack_view view;
+
+			if(!m_initialized) {
+				THROW_LUNA_PACK_EXCEPTION(LUNA_PACK_EXCEPTION_UNINITIALIZED);
+			}
+
+			return lookup(name, view);
+		}
+
+		void 
+		_luna_pack::decompress(
+			__in const char *data,
+			__in size_t size,
+			__out char *result,
+			__in size_t length
+			)
+		{
+			uint8_t token;
+			size_t input = 0, literal, match, offset, output = 0;
+			const uint8_t *source = (const uint8_t *) data;
+
+			// every length and offset is checked, so corrupt entries cannot write out of bounds
+			while(input < size) {
+				token = source[input++];
+
+				literal = pack_extend(source, size, input, token >> 4);
+				if((literal > (size - input)) || (literal > (length - output))) {
+					THROW_LUNA_PACK_EXCEPTION_FORMAT(LUNA_PACK_EXCEPTION_INVALID,
+						"Literal overrun at %u", (uint32_t) input);
+				}
+
+				if(literal) {
+					std::memcpy(result + output, source + input, literal);
+					input += literal;
+					output += literal;
+				}
+
+				if(input < size) {
+
+					if((size - input) < sizeof(uint16_t)) {
+						THROW_LUNA_PACK_EXCEPTION_FORMAT(LUNA_PACK_EXCEPTION_INVALID,
+							"Truncated offset at %u", (uint32_t) input);
+					}
+
+					offset = (source[input] | (source[input + 1] << 8));
+					input += sizeof(uint16_t);
+
+					if(!offset || (offset > output)) {
+						THROW_LUNA_PACK_EXCEPTION_FORMAT(LUNA_PACK_EXCEPTION_INVALID,
+							"Invalid offset at %u", (uint32_t) input);
+					}
+
+					match = (pack_extend(source, size, input, token & 0xf) + PACK_MATCH_MIN);
+					if(match > (length - output)) {
+						THROW_LUNA_PACK_EXCEPTION_FORMAT(LUNA_PACK_EXCEPTION_INVALID,
+							"Match overrun at %u", (uint32_t) input);
+					}
+
+					// matches may overlap their own output, so they copy forward bytewise
+					for(; match; --match, ++output) {
+						result[output] = result[output - offset];
+					}
+				}
+			}
+
+			if(output != length) {
+				THROW_LUNA_PACK_EXCEPTION_FORMAT(LUNA_PACK_EXCEPTION_INVALID,
+					"Decoded %u of %u bytes", (uint32_t) output, (uint32_t) length);
+			}
+		}
+
+		void 
+		_luna_pack::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_PACK_EXCEPTION(LUNA_PACK_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			clear();
+		}
+
+		bool 
+		_luna_pack::is_allocated(void)
+		{
+			return (luna_pack::m_instance != NULL);
+		}
+
+		bool 
+		_luna_pack::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		uint64_t 
+		_luna_pack::key(
+			__in const std::string &name
+			)
+		{
+			size_t iter;
+			uint64_t result = HASH_FNV_BASIS;
+
+			for(iter = 0; iter < name.size(); ++iter) {
+				result = HASH_FNV(result, name[iter]);
+			}
+
+			return result;
+		}
+
+		bool 
+		_luna_pack::lookup(
+			__in const std::string &name,
+			__out luna_pack_view &view
+			)
+		{
+			uint64_t hash;
+			bool result = false;
+			std::string entry_name;
+			std::map<uint32_t, luna_file *>::reverse_iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_PACK_EXCEPTION(LUNA_PACK_EXCEPTION_UNINITIALIZED);
+			}
+
+			entry_name = pack_name(name);
+			hash = key(entry_name);
+
+			std::lock_guard<std::mutex> lock(m_pack_lock);
+
+			// later mounts shadow earlier ones
+			for(iter = m_pack_map.rbegin(); !result && (iter != m_pack_map.rend()); ++iter) {
+
+				result = search(*iter->second, entry_name, hash, view);
+				if(result) {
+					view.id = iter->first;
+				}
+			}
+
+			return result;
+		}
+
+		uint32_t 
+		_luna_pack::mount(
+			__in const std::string &path
+			)
+		{
+			luna_file *file = NULL;
+
+			if(!m_initialized) {
+				THROW_LUNA_PACK_EXCEPTION(LUNA_PACK_EXCEPTION_UNINITIALIZED);
+			}
+
+			file = new luna_file;
+			if(!file) {
+				THROW_LUNA_PACK_EXCEPTION(LUNA_PACK_EXCEPTION_ALLOCATED);
+			}
+
+			try {
+				file->map(path);
+				validate(*file);
+			} catch(...) {
+				delete file;
+				throw;
+			}
+
+			std::lock_guard<std::mutex> lock(m_pack_lock);
+			m_pack_map.insert(std::pair<uint32_t, luna_file *>(++m_next, file));
+
+			return m_next;
+		}
+
+		bool 
+		_luna_pack::open(
+			__in const std::string &name,
+			__out luna_pack_view &view
+			)
+		{
+			uint64_t hash;
+			bool result = false;
+			std::string entry_name;
+			std::map<uint32_t, luna_file *>::reverse_iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_PACK_EXCEPTION(LUNA_PACK_EXCEPTION_UNINITIALIZED);
+			}
+
+			entry_name = pack_name(name);
+			hash = key(entry_name);
+
+			std::lock_guard<std::mutex> lock(m_pack_lock);
+
+			// the view holds its mapping until closed, so it stays valid across an unmount
+			for(iter = m_pack_map.rbegin(); !result && (iter != m_pack_map.rend()); ++iter) {
+
+				result = search(*iter->second, entry_name, hash, view);
+				if(result) {
+					view.id = iter->first;
+					++m_view_map[view.id];
+				}
+			}
+
+			return result;
+		}
+
+		bool 
+		_luna_pack::search(
+			__in luna_file &file,
+			__in const std::string &name,
+			__in uint64_t hash,
+			__out luna_pack_view &view
+			)
+		{
+			bool result = false;
+			const luna_pack_toc *begin, *end, *iter;
+			const luna_pack_header *header = (const luna_pack_header *) file.data();
+
+			begin = (const luna_pack_toc *) (file.data() + header->toc);
+			end = (begin + header->count);
+
+			// hash collisions sit next to each other, so names are compared across the run
+			for(iter = std::lower_bound(begin, end, hash, pack_compare); !result && (iter != end) 
+					&& (iter->hash == hash); ++iter) {
+
+				result = ((iter->name_length == name.size()) && !std::memcmp(file.data() 
+					+ iter->name, name.c_str(), name.size()));
+				if(result) {
+					view.data = (file.data() + iter->offset);
+					view.flags = iter->flags;
+					view.length = iter->length;
+					view.size = iter->size;
+				}
+			}
+
+			return result;
+		}
+
+		size_t 
+		_luna_pack::size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PACK_EXCEPTION(LUNA_PACK_EXCEPTION_UNINITIALIZED);
+			}
+
+			std::lock_guard<std::mutex> lock(m_pack_lock);
+
+			return m_pack_map.size();
+		}
+
+		std::string 
+		_luna_pack::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+			std::map<uint32_t, luna_file *>::iterator iter;
+
+			result << LUNA_PACK_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_pack_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+				std::lock_guard<std::mutex> lock(m_pack_lock);
+
+				for(iter = m_pack_map.begin(); iter != m_pack_map.end(); ++iter) {
+					result << std::endl << "--- 0x" << SCALAR_AS_HEX(uint32_t, iter->first)
+						<< ", " << iter->second->path() << ", CNT. " 
+						<< ((const luna_pack_header *) iter->second->data())->count
+						<< ", SIZE. " << iter->second->size();
+				}
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_pack::uninitialize(void)
+		{
+			std::map<uint32_t, luna_file *>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_PACK_EXCEPTION(LUNA_PACK_EXCEPTION_UNINITIALIZED);
+			}
+
+			clear();
+
+			{
+				std::lock_guard<std::mutex> lock(m_pack_lock);
+
+				// views left open past teardown cannot keep their mappings
+				for(iter = m_unmount_map.begin(); iter != m_unmount_map.end(); ++iter) {
+					delete iter->second;
+				}
+
+				m_unmount_map.clear();
+				m_view_map.clear();
+			}
+
+			m_initialized = false;
+		}
+
+		void 
+		_luna_pack::unmount(
+			__in uint32_t id
+			)
+		{
+			std::map<uint32_t, luna_file *>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_PACK_EXCEPTION(LUNA_PACK_EXCEPTION_UNINITIALIZED);
+			}
+
+			std::lock_guard<std::mutex> lock(m_pack_lock);
+
+			iter = m_pack_map.find(id);
+			if(iter == m_pack_map.end()) {
+				THROW_LUNA_PACK_EXCEPTION_FORMAT(LUNA_PACK_EXCEPTION_NOT_FOUND,
+					"0x%x", id);
+			}
+
+			// views returned by lookup go with the mapping, views held open keep it until 
+			// the last one closes
+			if(m_view_map.find(id) != m_view_map.end()) {
+				m_unmount_map.insert(*iter);
+			} else {
+				delete iter->second;
+			}
+
+			m_pack_map.erase(iter);
+		}
+
+		void 
+		_luna_pack::validate(
+			__in luna_file &file
+			)
+		{
+			size_t iter;
+			const luna_pack_toc *toc = NULL;
+			const luna_pack_header *header = (const luna_pack_header *) file.data();
+
+			// entries are trusted once mounted, so every range is checked here
+			if((file.size() < sizeof(luna_pack_header)) || (header->magic != PACK_MAGIC)
+					|| (header->version != PACK_VERSION) 
+					|| (header->toc < sizeof(luna_pack_header))
+					|| (header->toc % sizeof(uint64_t)) || (header->toc > file.size())
+					|| (header->count > ((file.size() - header->toc) / sizeof(luna_pack_toc)))) {
+				THROW_LUNA_PACK_EXCEPTION_FORMAT(LUNA_PACK_EXCEPTION_INVALID,
+					"%s", STRING_CHECK(file.path()));
+			}
+
+			toc = (const luna_pack_toc *) (file.data() + header->toc);
+
+			for(iter = 0; iter < header->count; ++iter) {
+
+				if((toc[iter].offset > file.size()) 
+						|| (toc[iter].size > (file.size() - toc[iter].offset))
+						|| (toc[iter].name > file.size()) 
+						|| (toc[iter].name_length > (file.size() - toc[iter].name))
+						|| (iter && (toc[iter].hash < toc[iter - 1].hash))
+						|| (!(toc[iter].flags & PACK_FLAG_COMPRESSED) 
+							&& (toc[iter].size != toc[iter].length))) {
+					THROW_LUNA_PACK_EXCEPTION_FORMAT(LUNA_PACK_EXCEPTION_INVALID,
+						"%s: Entry %u", STRING_CHECK(file.path()), (uint32_t) iter);
+				}
+			}
+		}
+	}
+}
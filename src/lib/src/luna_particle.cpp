@@ -0,0 +1,1387 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include "../include/luna.h"
+#include "../include/luna_particle_type.h"
+
+#ifdef __AVX__
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif // __AVX__
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define PARTICLE_CORNER_COUNT 4
+		#define PARTICLE_FEEDBACK_ACCELERATION "particle_acceleration"
+		#define PARTICLE_FEEDBACK_CAPACITY "particle_capacity"
+		#define PARTICLE_FEEDBACK_DAMPING "particle_damping"
+		#define PARTICLE_FEEDBACK_DELTA "particle_delta"
+		#define PARTICLE_FEEDBACK_DIRECTION "particle_direction"
+		#define PARTICLE_FEEDBACK_LIFETIME "particle_lifetime"
+		#define PARTICLE_FEEDBACK_ORIGIN "particle_origin"
+		#define PARTICLE_FEEDBACK_SEED "particle_seed"
+		#define PARTICLE_FEEDBACK_SPAWN_BEGIN "particle_spawn_begin"
+		#define PARTICLE_FEEDBACK_SPAWN_COUNT "particle_spawn_count"
+		#define PARTICLE_FEEDBACK_SPEED "particle_speed"
+		#define PARTICLE_FEEDBACK_SPREAD "particle_spread"
+		#define PARTICLE_LIFETIME_MIN 0.001f
+		#define PARTICLE_SEED 0x9e3779b9
+		#define PARTICLE_STATE_WIDTH 2
+		#define PARTICLE_STREAM_WIDTH 4
+		#define PARTICLE_UNIT_BUFFER 1
+		#define PARTICLE_UNIT_TEXTURE 0
+
+		#define PARTICLE_ELAPSED(_BEGIN_) \
+			std::chrono::duration<double, std::milli>( \
+				std::chrono::high_resolution_clock::now() - (_BEGIN_)).count()
+
+		enum {
+			PARTICLE_ARRAY_INVERSE_LIFETIME = 0,
+			PARTICLE_ARRAY_LIFE,
+			PARTICLE_ARRAY_VELOCITY_X,
+			PARTICLE_ARRAY_VELOCITY_Y,
+			PARTICLE_ARRAY_VELOCITY_Z,
+			PARTICLE_ARRAY_X,
+			PARTICLE_ARRAY_Y,
+			PARTICLE_ARRAY_Z,
+		};
+
+		#define PARTICLE_ARRAY_COUNT (PARTICLE_ARRAY_Z + 1)
+
+		// one vertex per slot, dead slots inside the spawn window are respawned and every slot
+		// is integrated, the result is captured into the other buffer with rasterization off
+		static const std::string PARTICLE_SHADER_FEEDBACK = 
+			"#version 150\n"
+			"uniform vec3 " PARTICLE_FEEDBACK_ACCELERATION ";\n"
+			"uniform int " PARTICLE_FEEDBACK_CAPACITY ";\n"
+			"uniform float " PARTICLE_FEEDBACK_DAMPING ";\n"
+			"uniform float " PARTICLE_FEEDBACK_DELTA ";\n"
+			"uniform vec3 " PARTICLE_FEEDBACK_DIRECTION ";\n"
+			"uniform vec2 " PARTICLE_FEEDBACK_LIFETIME ";\n"
+			"uniform vec3 " PARTICLE_FEEDBACK_ORIGIN ";\n"
+			"uniform uint " PARTICLE_FEEDBACK_SEED ";\n"
+			"uniform int " PARTICLE_FEEDBACK_SPAWN_BEGIN ";\n"
+			"uniform int " PARTICLE_FEEDBACK_SPAWN_COUNT ";\n"
+			"uniform vec2 " PARTICLE_FEEDBACK_SPEED ";\n"
+			"uniform float " PARTICLE_FEEDBACK_SPREAD ";\n"
+			"in vec4 " PARTICLE_ATTRIBUTE_POSITION ";\n"
+			"in vec4 " PARTICLE_ATTRIBUTE_VELOCITY ";\n"
+			"out vec4 " PARTICLE_VARYING_POSITION ";\n"
+			"out vec4 " PARTICLE_VARYING_VELOCITY ";\n"
+			"float random(inout uint state) {\n"
+			"\tstate ^= (state << 13);\n"
+			"\tstate ^= (state >> 17);\n"
+			"\tstate ^= (state << 5);\n"
+			"\treturn float(state >> 8) / 16777216.0;\n"
+			"}\n"
+			"void main(void) {\n"
+			"\tuint state;\n"
+			"\tvec3 position = " PARTICLE_ATTRIBUTE_POSITION ".xyz;\n"
+			"\tvec3 velocity = " PARTICLE_ATTRIBUTE_VELOCITY ".xyz;\n"
+			"\tfloat lifetime = " PARTICLE_ATTRIBUTE_VELOCITY ".w;\n"
+			"\tfloat life = " PARTICLE_ATTRIBUTE_POSITION ".w * lifetime;\n"
+			"\tint slot = ((gl_VertexID - " PARTICLE_FEEDBACK_SPAWN_BEGIN ") + " 
+				PARTICLE_FEEDBACK_CAPACITY ") % " PARTICLE_FEEDBACK_CAPACITY ";\n"
+			"\tif((life <= 0.0) && (slot < " PARTICLE_FEEDBACK_SPAWN_COUNT ")) {\n"
+			"\t\tstate = (uint(gl_VertexID) * 0x9e3779b9u) ^ " PARTICLE_FEEDBACK_SEED ";\n"
+			"\t\tstate |= 1u;\n"
+			"\t\tlifetime = max(mix(" PARTICLE_FEEDBACK_LIFETIME ".x, " 
+				PARTICLE_FEEDBACK_LIFETIME ".y, random(state)), 0.001);\n"
+			"\t\tlife = lifetime;\n"
+			"\t\tvelocity.x = " PARTICLE_FEEDBACK_DIRECTION ".x + (" PARTICLE_FEEDBACK_SPREAD 
+				" * ((random(state) * 2.0) - 1.0));\n"
+			"\t\tvelocity.y = " PARTICLE_FEEDBACK_DIRECTION ".y + (" PARTICLE_FEEDBACK_SPREAD 
+				" * ((random(state) * 2.0) - 1.0));\n"
+			"\t\tvelocity.z = " PARTICLE_FEEDBACK_DIRECTION ".z + (" PARTICLE_FEEDBACK_SPREAD 
+				" * ((random(state) * 2.0) - 1.0));\n"
+			"\t\tvelocity *= mix(" PARTICLE_FEEDBACK_SPEED ".x, " PARTICLE_FEEDBACK_SPEED 
+				".y, random(state));\n"
+			"\t\tposition = " PARTICLE_FEEDBACK_ORIGIN ";\n"
+			"\t}\n"
+			"\tvelocity = (velocity + (" PARTICLE_FEEDBACK_ACCELERATION " * " 
+				PARTICLE_FEEDBACK_DELTA ")) * " PARTICLE_FEEDBACK_DAMPING ";\n"
+			"\tposition += velocity * " PARTICLE_FEEDBACK_DELTA ";\n"
+			"\tlife -= " PARTICLE_FEEDBACK_DELTA ";\n"
+			"\t" PARTICLE_VARYING_POSITION " = vec4(position, (lifetime > 0.0) ? "
+				"(max(life, 0.0) / lifetime) : 0.0);\n"
+			"\t" PARTICLE_VARYING_VELOCITY " = vec4(velocity, lifetime);\n"
+			"}\n";
+
+		// untextured emitters fall back to a soft round falloff
+		static const std::string PARTICLE_SHADER_FRAGMENT = 
+			"#version 150\n"
+			"uniform sampler2D " PARTICLE_UNIFORM_TEXTURE ";\n"
+			"uniform int " PARTICLE_UNIFORM_TEXTURED ";\n"
+			"in vec2 frag_uv;\n"
+			"in vec4 frag_color;\n"
+			"out vec4 color;\n"
+			"void main(void) {\n"
+			"\tvec2 offset = (frag_uv * 2.0) - 1.0;\n"
+			"\tcolor = frag_color * ((" PARTICLE_UNIFORM_TEXTURED " != 0) ? texture(" 
+				PARTICLE_UNIFORM_TEXTURE ", frag_uv) : vec4(1.0, 1.0, 1.0, "
+				"clamp(1.0 - dot(offset, offset), 0.0, 1.0)));\n"
+			"}\n";
+
+		// each instance fetches its position and fade, and expands a view aligned quad, dead
+		// gpu slots have no fade left and are moved outside the clip volume
+		static const std::string PARTICLE_SHADER_VERTEX = 
+			"#version 150\n"
+			"uniform samplerBuffer " PARTICLE_UNIFORM_BUFFER ";\n"
+			"uniform vec4 " PARTICLE_UNIFORM_COLOR_BEGIN ";\n"
+			"uniform vec4 " PARTICLE_UNIFORM_COLOR_END ";\n"
+			"uniform int " PARTICLE_UNIFORM_OFFSET ";\n"
+			"uniform mat4 " PARTICLE_UNIFORM_PROJECTION ";\n"
+			"uniform vec2 " PARTICLE_UNIFORM_SIZE ";\n"
+			"uniform int " PARTICLE_UNIFORM_STRIDE ";\n"
+			"uniform mat4 " PARTICLE_UNIFORM_VIEW ";\n"
+			"out vec2 frag_uv;\n"
+			"out vec4 frag_color;\n"
+			"void main(void) {\n"
+			"\tvec4 particle = texelFetch(" PARTICLE_UNIFORM_BUFFER ", (" 
+				PARTICLE_UNIFORM_OFFSET " + gl_InstanceID) * " PARTICLE_UNIFORM_STRIDE ");\n"
+			"\tvec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));\n"
+			"\tvec4 position = " PARTICLE_UNIFORM_VIEW " * vec4(particle.xyz, 1.0);\n"
+			"\tposition.xy += (corner - 0.5) * mix(" PARTICLE_UNIFORM_SIZE ".y, " 
+				PARTICLE_UNIFORM_SIZE ".x, particle.w);\n"
+			"\tfrag_uv = corner;\n"
+			"\tfrag_color = mix(" PARTICLE_UNIFORM_COLOR_END ", " 
+				PARTICLE_UNIFORM_COLOR_BEGIN ", particle.w);\n"
+			"\tgl_Position = (particle.w > 0.0) ? (" PARTICLE_UNIFORM_PROJECTION 
+				" * position) : vec4(2.0, 2.0, 2.0, 1.0);\n"
+			"}\n";
+
+		static void 
+		particle_array(
+			__in luna_particle_entry &entry,
+			__in size_t offset,
+			__out GLfloat **array
+			)
+		{
+			array[PARTICLE_ARRAY_INVERSE_LIFETIME] = &entry.inverse_lifetime[offset];
+			array[PARTICLE_ARRAY_LIFE] = &entry.life[offset];
+			array[PARTICLE_ARRAY_VELOCITY_X] = &entry.velocity_x[offset];
+			array[PARTICLE_ARRAY_VELOCITY_Y] = &entry.velocity_y[offset];
+			array[PARTICLE_ARRAY_VELOCITY_Z] = &entry.velocity_z[offset];
+			array[PARTICLE_ARRAY_X] = &entry.x[offset];
+			array[PARTICLE_ARRAY_Y] = &entry.y[offset];
+			array[PARTICLE_ARRAY_Z] = &entry.z[offset];
+		}
+
+		static void 
+		particle_color(
+			__in uint32_t color,
+			__out GLfloat *out
+			)
+		{
+			size_t iter;
+
+			for(iter = 0; iter < 4; ++iter) {
+				out[iter] = (((color >> (iter * 8)) & 0xff) / 255.f);
+			}
+		}
+
+		// copies a particle down to its compacted slot, the source is never behind the
+		// destination so this is safe in place
+		static inline void 
+		particle_keep(
+			__in GLfloat *const *array,
+			__in size_t destination,
+			__in size_t source,
+			__in GLfloat fade,
+			__out GLfloat *stream
+			)
+		{
+			size_t iter;
+
+			for(iter = 0; iter < PARTICLE_ARRAY_COUNT; ++iter) {
+				array[iter][destination] = array[iter][source];
+			}
+
+			stream += (destination * PARTICLE_STREAM_WIDTH);
+			stream[0] = array[PARTICLE_ARRAY_X][source];
+			stream[1] = array[PARTICLE_ARRAY_Y][source];
+			stream[2] = array[PARTICLE_ARRAY_Z][source];
+			stream[3] = fade;
+		}
+
+		// integrates a run of particles in place and compacts the survivors to its front,
+		// returning how many survived
+		static size_t 
+		particle_integrate(
+			__inout luna_particle_entry &entry,
+			__in size_t offset,
+			__in size_t count,
+			__in GLfloat delta
+			)
+		{
+			size_t iter = 0, result = 0;
+			GLfloat *array[PARTICLE_ARRAY_COUNT], *stream;
+			GLfloat acceleration_x, acceleration_y, acceleration_z, damping;
+			GLfloat *inverse_lifetime, *life, *velocity_x, *velocity_y, *velocity_z, *x, *y, *z;
+
+			particle_array(entry, offset, array);
+			inverse_lifetime = array[PARTICLE_ARRAY_INVERSE_LIFETIME];
+			life = array[PARTICLE_ARRAY_LIFE];
+			velocity_x = array[PARTICLE_ARRAY_VELOCITY_X];
+			velocity_y = array[PARTICLE_ARRAY_VELOCITY_Y];
+			velocity_z = array[PARTICLE_ARRAY_VELOCITY_Z];
+			x = array[PARTICLE_ARRAY_X];
+			y = array[PARTICLE_ARRAY_Y];
+			z = array[PARTICLE_ARRAY_Z];
+			stream = &entry.stream[offset * PARTICLE_STREAM_WIDTH];
+			acceleration_x = (entry.emitter.acceleration.x * delta);
+			acceleration_y = (entry.emitter.acceleration.y * delta);
+			acceleration_z = (entry.emitter.acceleration.z * delta);
+			damping = std::max(0.f, 1.f - (entry.emitter.drag * delta));
+
+#ifdef __AVX__
+			for(; (iter + 8) <= count; iter += 8) {
+				GLfloat fade[8];
+				uint32_t lane, mask;
+				__m256 life_256, velocity_x_256, velocity_y_256, velocity_z_256;
+
+				velocity_x_256 = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&velocity_x[iter]), 
+					_mm256_set1_ps(acceleration_x)), _mm256_set1_ps(damping));
+				velocity_y_256 = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&velocity_y[iter]), 
+					_mm256_set1_ps(acceleration_y)), _mm256_set1_ps(damping));
+				velocity_z_256 = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&velocity_z[iter]), 
+					_mm256_set1_ps(acceleration_z)), _mm256_set1_ps(damping));
+				_mm256_storeu_ps(&velocity_x[iter], velocity_x_256);
+				_mm256_storeu_ps(&velocity_y[iter], velocity_y_256);
+				_mm256_storeu_ps(&velocity_z[iter], velocity_z_256);
+				_mm256_storeu_ps(&x[iter], _mm256_add_ps(_mm256_loadu_ps(&x[iter]), 
+					_mm256_mul_ps(velocity_x_256, _mm256_set1_ps(delta))));
+				_mm256_storeu_ps(&y[iter], _mm256_add_ps(_mm256_loadu_ps(&y[iter]), 
+					_mm256_mul_ps(velocity_y_256, _mm256_set1_ps(delta))));
+				_mm256_storeu_ps(&z[iter], _mm256_add_ps(_mm256_loadu_ps(&z[iter]), 
+					_mm256_mul_ps(velocity_z_256, _mm256_set1_ps(delta))));
+				life_256 = _mm256_sub_ps(_mm256_loadu_ps(&life[iter]), _mm256_set1_ps(delta));
+				_mm256_storeu_ps(&life[iter], life_256);
+				_mm256_storeu_ps(fade, _mm256_mul_ps(life_256, 
+					_mm256_loadu_ps(&inverse_lifetime[iter])));
+
+				// branchless compaction, every lane is written but only live ones advance
+				mask = _mm256_movemask_ps(_mm256_cmp_ps(life_256, _mm256_setzero_ps(), 
+					_CMP_GT_OQ));
+				for(lane = 0; lane < 8; ++lane) {
+					particle_keep(array, result, iter + lane, fade[lane], stream);
+					result += ((mask >> lane) & 1);
+				}
+			}
+#endif // __AVX__
+#ifdef __SSE__
+			for(; (iter + 4) <= count; iter += 4) {
+				GLfloat fade[4];
+				uint32_t lane, mask;
+				__m128 life_128, velocity_x_128, velocity_y_128, velocity_z_128;
+
+				velocity_x_128 = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velocity_x[iter]), 
+					_mm_set1_ps(acceleration_x)), _mm_set1_ps(damping));
+				velocity_y_128 = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velocity_y[iter]), 
+					_mm_set1_ps(acceleration_y)), _mm_set1_ps(damping));
+				velocity_z_128 = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velocity_z[iter]), 
+					_mm_set1_ps(acceleration_z)), _mm_set1_ps(damping));
+				_mm_storeu_ps(&velocity_x[iter], velocity_x_128);
+				_mm_storeu_ps(&velocity_y[iter], velocity_y_128);
+				_mm_storeu_ps(&velocity_z[iter], velocity_z_128);
+				_mm_storeu_ps(&x[iter], _mm_add_ps(_mm_loadu_ps(&x[iter]), 
+					_mm_mul_ps(velocity_x_128, _mm_set1_ps(delta))));
+				_mm_storeu_ps(&y[iter], _mm_add_ps(_mm_loadu_ps(&y[iter]), 
+					_mm_mul_ps(velocity_y_128, _mm_set1_ps(delta))));
+				_mm_storeu_ps(&z[iter], _mm_add_ps(_mm_loadu_ps(&z[iter]), 
+					_mm_mul_ps(velocity_z_128, _mm_set1_ps(delta))));
+				life_128 = _mm_sub_ps(_mm_loadu_ps(&life[iter]), _mm_set1_ps(delta));
+				_mm_storeu_ps(&life[iter], life_128);
+				_mm_storeu_ps(fade, _mm_mul_ps(life_128, _mm_loadu_ps(&inverse_lifetime[iter])));
+
+				mask = _mm_movemask_ps(_mm_cmpgt_ps(life_128, _mm_setzero_ps()));
+				for(lane = 0; lane < 4; ++lane) {
+					particle_keep(array, result, iter + lane, fade[lane], stream);
+					result += ((mask >> lane) & 1);
+				}
+			}
+#endif // __SSE__
+
+			for(; iter < count; ++iter) {
+				velocity_x[iter] = ((velocity_x[iter] + acceleration_x) * damping);
+				velocity_y[iter] = ((velocity_y[iter] + acceleration_y) * damping);
+				velocity_z[iter] = ((velocity_z[iter] + acceleration_z) * damping);
+				x[iter] += (velocity_x[iter] * delta);
+				y[iter] += (velocity_y[iter] * delta);
+				z[iter] += (velocity_z[iter] * delta);
+				life[iter] -= delta;
+				particle_keep(array, result, iter, life[iter] * inverse_lifetime[iter], stream);
+				result += (life[iter] > 0.f);
+			}
+
+			return result;
+		}
+
+		static void 
+		particle_move(
+			__inout luna_particle_entry &entry,
+			__in size_t destination,
+			__in size_t source,
+			__in size_t count
+			)
+		{
+			size_t iter;
+			GLfloat *array[PARTICLE_ARRAY_COUNT], *from[PARTICLE_ARRAY_COUNT];
+
+			particle_array(entry, destination, array);
+			particle_array(entry, source, from);
+
+			for(iter = 0; iter < PARTICLE_ARRAY_COUNT; ++iter) {
+				std::memmove(array[iter], from[iter], count * sizeof(GLfloat));
+			}
+
+			std::memmove(&entry.stream[destination * PARTICLE_STREAM_WIDTH], 
+				&entry.stream[source * PARTICLE_STREAM_WIDTH], 
+				count * PARTICLE_STREAM_WIDTH * sizeof(GLfloat));
+		}
+
+		// xorshift, cheap enough to call per spawned particle
+		static GLfloat 
+		particle_random(
+			__inout uint32_t &state,
+			__in GLfloat minimum,
+			__in GLfloat maximum
+			)
+		{
+			state ^= (state << 13);
+			state ^= (state >> 17);
+			state ^= (state << 5);
+
+			return (minimum + ((maximum - minimum) * ((state >> 8) / 16777216.f)));
+		}
+
+		static void 
+		particle_reserve(
+			__inout luna_particle_entry &entry,
+			__in size_t capacity
+			)
+		{
+			entry.capacity = capacity;
+			entry.count = 0;
+			entry.emit = 0.f;
+			entry.inverse_lifetime.resize(capacity);
+			entry.life.resize(capacity);
+			entry.stream.resize(capacity * PARTICLE_STREAM_WIDTH);
+			entry.velocity_x.resize(capacity);
+			entry.velocity_y.resize(capacity);
+			entry.velocity_z.resize(capacity);
+			entry.x.resize(capacity);
+			entry.y.resize(capacity);
+			entry.z.resize(capacity);
+		}
+
+		_luna_particle *_luna_particle::m_instance = NULL;
+
+		_luna_particle::_luna_particle(void) :
+			m_buffer(0),
+			m_buffer_length(0),
+			m_buffer_max(0),
+			m_buffer_texture(0),
+			m_draw_count(0),
+			m_feedback_program(0),
+			m_feedback_serial(0),
+			m_feedback_shader(0),
+			m_initialized(false),
+			m_next(0),
+			m_program(0),
+			m_vertex(0)
+		{
+			std::atexit(luna_particle::_delete);
+		}
+
+		_luna_particle::~_luna_particle(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_particle::_delete(void)
+		{
+
+			if(luna_particle::m_instance) {
+				delete luna_particle::m_instance;
+				luna_particle::m_instance = NULL;
+			}
+		}
+
+		_luna_particle *
+		_luna_particle::acquire(void)
+		{
+
+			if(!luna_particle::m_instance) {
+
+				luna_particle::m_instance = new luna_particle;
+				if(!luna_particle::m_instance) {
+					THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_particle::m_instance;
+		}
+
+		uint32_t 
+		_luna_particle::add(
+			__in const luna_particle_emitter &emitter,
+			__in size_t capacity,
+			__in_opt bool gpu
+			)
+		{
+			size_t iter;
+			luna_particle_entry entry;
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!capacity) {
+				THROW_LUNA_PARTICLE_EXCEPTION_FORMAT(LUNA_PARTICLE_EXCEPTION_INVALID,
+					"%lu", (unsigned long) capacity);
+			}
+
+			for(iter = 0; iter < PARTICLE_BUFFER_COUNT; ++iter) {
+				entry.buffer[iter] = 0;
+				entry.vertex[iter] = 0;
+			}
+
+			entry.buffer_index = 0;
+			entry.emitter = emitter;
+			entry.random = ((++m_next * PARTICLE_SEED) | 1);
+			entry.spawn = 0;
+			particle_reserve(entry, gpu ? 0 : capacity);
+			entry.capacity = capacity;
+
+			if(gpu) {
+				add_feedback(entry);
+			}
+
+			m_entry_map.insert(std::pair<uint32_t, luna_particle_entry>(m_next, entry));
+
+			return m_next;
+		}
+
+		void 
+		_luna_particle::add_feedback(
+			__inout luna_particle_entry &entry
+			)
+		{
+			size_t iter;
+			std::vector<luna_particle_state> state;
+			luna_vertex_ptr instance_vertex = NULL;
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			load_feedback();
+			instance_vertex = luna_vertex::acquire();
+
+			// every slot starts zeroed, so dead and with no lifetime left to fade
+			state.resize(entry.capacity);
+
+			for(iter = 0; iter < PARTICLE_BUFFER_COUNT; ++iter) {
+				entry.buffer[iter] = instance_vertex->add_buffer(GL_ARRAY_BUFFER, 1);
+				instance_vertex->set_buffer_data(GL_ARRAY_BUFFER, &state[0], 
+					state.size() * sizeof(luna_particle_state), GL_DYNAMIC_COPY);
+			}
+
+			bind_feedback(entry);
+		}
+
+		luna_particle_stat 
+		_luna_particle::benchmark(
+			__in size_t count,
+			__in_opt size_t frames
+			)
+		{
+			size_t frame, mode;
+			double elapsed[2];
+			luna_particle_pass pass;
+			luna_particle_entry entry;
+			luna_particle_stat result;
+			std::vector<luna_particle_entry *> entries;
+			std::chrono::high_resolution_clock::time_point begin;
+
+			// a fountain whose deaths are refilled each frame, so every frame compacts
+			luna_vec3_make(0.f, -9.8f, 0.f, entry.emitter.acceleration);
+			entry.emitter.color_begin = SPRITE_COLOR_WHITE;
+			entry.emitter.color_end = SPRITE_COLOR_WHITE;
+			luna_vec3_make(0.f, 1.f, 0.f, entry.emitter.direction);
+			entry.emitter.drag = 0.1f;
+			entry.emitter.lifetime_max = 2.f;
+			entry.emitter.lifetime_min = 0.25f;
+			luna_vec3_make(0.f, 0.f, 0.f, entry.emitter.position);
+			entry.emitter.program = 0;
+			entry.emitter.rate = 0.f;
+			entry.emitter.size_begin = 1.f;
+			entry.emitter.size_end = 1.f;
+			entry.emitter.speed_max = 10.f;
+			entry.emitter.speed_min = 5.f;
+			entry.emitter.spread = 0.25f;
+			entry.emitter.texture = 0;
+			entries.push_back(&entry);
+
+			for(mode = 0; mode < 2; ++mode) {
+				entry.random = (((uint32_t) count * PARTICLE_SEED) | 1);
+				particle_reserve(entry, count);
+				spawn(entry, count);
+				elapsed[mode] = 0.0;
+
+				for(frame = 0; frame < frames; ++frame) {
+					begin = std::chrono::high_resolution_clock::now();
+					step(entries, 1.f / PARTICLE_DEF_FRAMES, !mode, pass);
+					elapsed[mode] += PARTICLE_ELAPSED(begin);
+					spawn(entry, count);
+				}
+			}
+
+			result.count = count;
+			result.frames = frames;
+			result.update = ((elapsed[0] > 0.0) ? ((count * frames) / elapsed[0]) : 0.0);
+			result.update_serial = ((elapsed[1] > 0.0) ? ((count * frames) / elapsed[1]) : 0.0);
+			result.workers = ((luna_job::is_allocated() && luna_job::acquire()->is_initialized()) 
+				? luna_job::acquire()->worker_count() : 0);
+
+			return result;
+		}
+
+		void 
+		_luna_particle::bind_feedback(
+			__inout luna_particle_entry &entry
+			)
+		{
+			size_t iter;
+			luna_vertex_ptr instance_vertex = NULL;
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			instance_vertex = luna_vertex::acquire();
+
+			// one vao per buffer, so each frame reads whichever was written last, vaos built 
+			// against older locations are replaced
+			for(iter = 0; iter < PARTICLE_BUFFER_COUNT; ++iter) {
+
+				if(entry.vertex[iter]) {
+					instance_vertex->remove_vertex(entry.vertex[iter]);
+				}
+
+				entry.vertex[iter] = instance_vertex->add_vertex(1);
+				instance_vertex->bind_buffer(GL_ARRAY_BUFFER, entry.buffer[iter]);
+
+				if(m_feedback.position >= 0) {
+					glEnableVertexAttribArray(m_feedback.position);
+					glVertexAttribPointer(m_feedback.position, 4, GL_FLOAT, GL_FALSE, 
+						sizeof(luna_particle_state), 
+						(GLvoid *) offsetof(luna_particle_state, position));
+				}
+
+				if(m_feedback.velocity >= 0) {
+					glEnableVertexAttribArray(m_feedback.velocity);
+					glVertexAttribPointer(m_feedback.velocity, 4, GL_FLOAT, GL_FALSE, 
+						sizeof(luna_particle_state), 
+						(GLvoid *) offsetof(luna_particle_state, velocity));
+				}
+			}
+
+			instance_vertex->bind_vertex();
+			instance_vertex->bind_buffer(GL_ARRAY_BUFFER);
+		}
+
+		void 
+		_luna_particle::clear(void)
+		{
+			std::map<uint32_t, luna_particle_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			for(iter = m_entry_map.begin(); iter != m_entry_map.end(); ++iter) {
+				remove_feedback(iter->second);
+			}
+
+			release();
+			m_draw_count = 0;
+			m_entry_active.clear();
+			m_entry_map.clear();
+			m_pass.block.clear();
+		}
+
+		bool 
+		_luna_particle::contains(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (m_entry_map.find(id) != m_entry_map.end());
+		}
+
+		size_t 
+		_luna_particle::draw_count(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_draw_count;
+		}
+
+		size_t 
+		_luna_particle::emit(
+			__in uint32_t id,
+			__in size_t count
+			)
+		{
+			std::map<uint32_t, luna_particle_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+
+			// gpu bursts widen the next spawn window instead
+			if(iter->second.buffer[0]) {
+				count = std::min(count, iter->second.capacity);
+				iter->second.emit += count;
+			} else {
+				count = spawn(iter->second, count);
+			}
+
+			return count;
+		}
+
+		luna_particle_emitter 
+		_luna_particle::emitter(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return find(id)->second.emitter;
+		}
+
+		std::map<uint32_t, luna_particle_entry>::iterator 
+		_luna_particle::find(
+			__in uint32_t id
+			)
+		{
+			std::map<uint32_t, luna_particle_entry>::iterator result;
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			result = m_entry_map.find(id);
+			if(result == m_entry_map.end()) {
+				THROW_LUNA_PARTICLE_EXCEPTION_FORMAT(LUNA_PARTICLE_EXCEPTION_NOT_FOUND,
+					"0x%x", id);
+			}
+
+			return result;
+		}
+
+		std::map<GLuint, luna_particle_program>::iterator 
+		_luna_particle::find_program(
+			__in GLuint id
+			)
+		{
+			size_t serial;
+			luna_particle_program entry;
+			std::map<GLuint, luna_particle_program>::iterator result;
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			serial = luna_shader_program::acquire()->serial(id);
+
+			// a relinked program may have moved its locations, so they are queried again
+			result = m_program_map.find(id);
+			if((result != m_program_map.end()) && (result->second.serial != serial)) {
+				m_program_map.erase(result);
+				result = m_program_map.end();
+			}
+
+			if(result == m_program_map.end()) {
+				entry.buffer = glGetUniformLocation(id, PARTICLE_UNIFORM_BUFFER);
+				entry.color_begin = glGetUniformLocation(id, PARTICLE_UNIFORM_COLOR_BEGIN);
+				entry.color_end = glGetUniformLocation(id, PARTICLE_UNIFORM_COLOR_END);
+				entry.offset = glGetUniformLocation(id, PARTICLE_UNIFORM_OFFSET);
+				entry.projection = glGetUniformLocation(id, PARTICLE_UNIFORM_PROJECTION);
+				entry.serial = serial;
+				entry.size = glGetUniformLocation(id, PARTICLE_UNIFORM_SIZE);
+				entry.stride = glGetUniformLocation(id, PARTICLE_UNIFORM_STRIDE);
+				entry.texture = glGetUniformLocation(id, PARTICLE_UNIFORM_TEXTURE);
+				entry.textured = glGetUniformLocation(id, PARTICLE_UNIFORM_TEXTURED);
+				entry.view = glGetUniformLocation(id, PARTICLE_UNIFORM_VIEW);
+				result = m_program_map.insert(std::pair<GLuint, luna_particle_program>(
+					id, entry)).first;
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_particle::flush(
+			__in const luna_mat4 &view,
+			__in const luna_mat4 &projection
+			)
+		{
+			bool gpu = false;
+			GLuint buffer, program;
+			GLfloat color_begin[4], color_end[4];
+			size_t count, first, instances, offset, stride;
+			luna_particle_entry *entry = NULL;
+			std::map<uint32_t, luna_particle_entry>::iterator iter;
+			std::map<GLuint, luna_particle_program>::iterator program_iter;
+			luna_shader_program_ptr instance_shader_program = NULL;
+			luna_texture_ptr instance_texture = NULL;
+			luna_vertex_ptr instance_vertex = NULL;
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_draw_count = 0;
+			count = particle_count();
+
+			for(iter = m_entry_map.begin(); iter != m_entry_map.end(); ++iter) {
+				gpu |= (iter->second.buffer[0] != 0);
+			}
+
+			if(count || gpu) {
+				instance_shader_program = luna_shader_program::acquire();
+				instance_texture = luna_texture::acquire();
+				instance_vertex = luna_vertex::acquire();
+
+				// quads are generated from the vertex id, so the vao carries no attributes
+				if(!m_buffer) {
+					m_buffer = instance_vertex->add_buffer(GL_TEXTURE_BUFFER, 1);
+					m_vertex = instance_vertex->add_vertex(1);
+					instance_vertex->bind_vertex();
+					glGenTextures(1, &m_buffer_texture);
+					glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &m_buffer_max);
+				}
+
+				if(!m_program) {
+					luna_shader_ptr instance_shader = luna_shader::acquire();
+
+					m_program_shader.push_back(instance_shader->add(PARTICLE_SHADER_VERTEX, 
+						false, GL_VERTEX_SHADER));
+					m_program_shader.push_back(instance_shader->add(PARTICLE_SHADER_FRAGMENT, 
+						false, GL_FRAGMENT_SHADER));
+					m_program = instance_shader_program->add(m_program_shader);
+				}
+
+				// orphan the previous contents so the upload does not stall on the gpu, every
+				// cpu emitter streams into its own range of the one buffer
+				count = std::min(count, (size_t) m_buffer_max);
+				if(count) {
+					instance_vertex->bind_buffer(GL_TEXTURE_BUFFER, m_buffer);
+					m_buffer_length = std::max(m_buffer_length, 
+						count * PARTICLE_STREAM_WIDTH * sizeof(GLfloat));
+					instance_vertex->set_buffer_data(GL_TEXTURE_BUFFER, NULL, m_buffer_length, 
+						GL_STREAM_DRAW);
+
+					for(iter = m_entry_map.begin(), offset = 0; (iter != m_entry_map.end()) 
+							&& (offset < count); ++iter) {
+						entry = &iter->second;
+
+						if(entry->count) {
+							instance_vertex->set_buffer_sub_data(GL_TEXTURE_BUFFER, 
+								offset * PARTICLE_STREAM_WIDTH * sizeof(GLfloat), 
+								&entry->stream[0], std::min(entry->count, count - offset) 
+									* PARTICLE_STREAM_WIDTH * sizeof(GLfloat));
+							offset += entry->count;
+						}
+					}
+
+					instance_vertex->bind_buffer(GL_TEXTURE_BUFFER);
+				}
+
+				glActiveTexture(GL_TEXTURE0 + PARTICLE_UNIT_BUFFER);
+				glBindTexture(GL_TEXTURE_BUFFER, m_buffer_texture);
+				instance_vertex->bind_vertex(m_vertex);
+
+				for(iter = m_entry_map.begin(), offset = 0; iter != m_entry_map.end(); ++iter) {
+					entry = &iter->second;
+
+					// gpu emitters draw every slot straight from their last feedback buffer
+					if(entry->buffer[0]) {
+						buffer = entry->buffer[entry->buffer_index];
+						first = 0;
+						instances = std::min(entry->capacity, 
+							(size_t) m_buffer_max / PARTICLE_STATE_WIDTH);
+						stride = PARTICLE_STATE_WIDTH;
+					} else if(entry->count && (offset < count)) {
+						buffer = m_buffer;
+						first = offset;
+						instances = std::min(entry->count, count - offset);
+						stride = 1;
+						offset += entry->count;
+					} else {
+						continue;
+					}
+
+					glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+					program = (entry->emitter.program ? entry->emitter.program : m_program);
+					program_iter = find_program(program);
+					particle_color(entry->emitter.color_begin, color_begin);
+					particle_color(entry->emitter.color_end, color_end);
+					instance_shader_program->use(program);
+					glUniform1i(program_iter->second.buffer, PARTICLE_UNIT_BUFFER);
+					glUniform4fv(program_iter->second.color_begin, 1, color_begin);
+					glUniform4fv(program_iter->second.color_end, 1, color_end);
+					glUniform1i(program_iter->second.offset, first);
+					glUniformMatrix4fv(program_iter->second.projection, 1, GL_FALSE, projection.m);
+					glUniform2f(program_iter->second.size, entry->emitter.size_begin, 
+						entry->emitter.size_end);
+					glUniform1i(program_iter->second.stride, stride);
+					glUniform1i(program_iter->second.texture, PARTICLE_UNIT_TEXTURE);
+					glUniform1i(program_iter->second.textured, entry->emitter.texture ? 1 : 0);
+					glUniformMatrix4fv(program_iter->second.view, 1, GL_FALSE, view.m);
+					instance_texture->bind(entry->emitter.texture, PARTICLE_UNIT_TEXTURE);
+					glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, PARTICLE_CORNER_COUNT, instances);
+					++m_draw_count;
+				}
+
+				glActiveTexture(GL_TEXTURE0 + PARTICLE_UNIT_BUFFER);
+				glBindTexture(GL_TEXTURE_BUFFER, 0);
+				instance_texture->bind();
+				instance_vertex->bind_vertex();
+				instance_shader_program->use();
+			}
+		}
+
+		void 
+		_luna_particle::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			m_next = 0;
+			clear();
+		}
+
+		void 
+		_luna_particle::integrate_range(
+			__in size_t begin,
+			__in size_t end,
+			__in void *context
+			)
+		{
+			luna_particle_block *block = NULL;
+			luna_particle_pass *pass = (luna_particle_pass *) context;
+
+			for(; begin < end; ++begin) {
+				block = &pass->block[begin];
+				block->alive = particle_integrate(*block->entry, block->offset, block->count, 
+					pass->delta);
+			}
+		}
+
+		bool 
+		_luna_particle::is_allocated(void)
+		{
+			return (luna_particle::m_instance != NULL);
+		}
+
+		bool 
+		_luna_particle::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		void 
+		_luna_particle::load_feedback(void)
+		{
+			size_t serial;
+			std::vector<GLuint> shader;
+			std::vector<std::string> varying;
+			std::map<uint32_t, luna_particle_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			// the varyings are handed to the program component, which declares them before linking
+			if(!m_feedback_program) {
+				m_feedback_shader = luna_shader::acquire()->add(PARTICLE_SHADER_FEEDBACK, false, 
+					GL_VERTEX_SHADER);
+				shader.push_back(m_feedback_shader);
+				varying.push_back(PARTICLE_VARYING_POSITION);
+				varying.push_back(PARTICLE_VARYING_VELOCITY);
+				m_feedback_program = luna_shader_program::acquire()->add(shader, varying);
+			}
+
+			// a relink may move every location, so they are queried again and the vaos of 
+			// existing gpu emitters rebuilt against them
+			serial = luna_shader_program::acquire()->serial(m_feedback_program);
+			if(serial != m_feedback_serial) {
+				m_feedback.acceleration = glGetUniformLocation(m_feedback_program, 
+					PARTICLE_FEEDBACK_ACCELERATION);
+				m_feedback.capacity = glGetUniformLocation(m_feedback_program, 
+					PARTICLE_FEEDBACK_CAPACITY);
+				m_feedback.damping = glGetUniformLocation(m_feedback_program, 
+					PARTICLE_FEEDBACK_DAMPING);
+				m_feedback.delta = glGetUniformLocation(m_feedback_program, 
+					PARTICLE_FEEDBACK_DELTA);
+				m_feedback.direction = glGetUniformLocation(m_feedback_program, 
+					PARTICLE_FEEDBACK_DIRECTION);
+				m_feedback.lifetime = glGetUniformLocation(m_feedback_program, 
+					PARTICLE_FEEDBACK_LIFETIME);
+				m_feedback.origin = glGetUniformLocation(m_feedback_program, 
+					PARTICLE_FEEDBACK_ORIGIN);
+				m_feedback.position = glGetAttribLocation(m_feedback_program, 
+					PARTICLE_ATTRIBUTE_POSITION);
+				m_feedback.seed = glGetUniformLocation(m_feedback_program, 
+					PARTICLE_FEEDBACK_SEED);
+				m_feedback.spawn_begin = glGetUniformLocation(m_feedback_program, 
+					PARTICLE_FEEDBACK_SPAWN_BEGIN);
+				m_feedback.spawn_count = glGetUniformLocation(m_feedback_program, 
+					PARTICLE_FEEDBACK_SPAWN_COUNT);
+				m_feedback.speed = glGetUniformLocation(m_feedback_program, 
+					PARTICLE_FEEDBACK_SPEED);
+				m_feedback.spread = glGetUniformLocation(m_feedback_program, 
+					PARTICLE_FEEDBACK_SPREAD);
+				m_feedback.velocity = glGetAttribLocation(m_feedback_program, 
+					PARTICLE_ATTRIBUTE_VELOCITY);
+				m_feedback_serial = serial;
+
+				for(iter = m_entry_map.begin(); iter != m_entry_map.end(); ++iter) {
+
+					if(iter->second.buffer[0]) {
+						bind_feedback(iter->second);
+					}
+				}
+			}
+		}
+
+		size_t 
+		_luna_particle::particle_count(void)
+		{
+			size_t result = 0;
+			std::map<uint32_t, luna_particle_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			for(iter = m_entry_map.begin(); iter != m_entry_map.end(); ++iter) {
+				result += iter->second.count;
+			}
+
+			return result;
+		}
+
+		size_t 
+		_luna_particle::particle_count(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return find(id)->second.count;
+		}
+
+		void 
+		_luna_particle::release(void)
+		{
+			std::vector<GLuint>::iterator shader_iter;
+
+			// the gl components may already be torn down during shutdown
+			if(m_buffer && luna_vertex::is_allocated() 
+					&& luna_vertex::acquire()->is_initialized()) {
+				luna_vertex::acquire()->remove_vertex(m_vertex);
+				luna_vertex::acquire()->remove_buffer(m_buffer);
+				glDeleteTextures(1, &m_buffer_texture);
+			}
+
+			// shaders and programs may be shared, so only this component's references are dropped
+			if(m_program && luna_shader_program::is_allocated() 
+					&& luna_shader_program::acquire()->is_initialized()) {
+				luna_shader_program::acquire()->decrement_reference(m_program);
+			}
+
+			if(m_feedback_program && luna_shader_program::is_allocated() 
+					&& luna_shader_program::acquire()->is_initialized()) {
+				luna_shader_program::acquire()->decrement_reference(m_feedback_program);
+			}
+
+			if(luna_shader::is_allocated() && luna_shader::acquire()->is_initialized()) {
+
+				for(shader_iter = m_program_shader.begin(); shader_iter != m_program_shader.end(); 
+						++shader_iter) {
+					luna_shader::acquire()->decrement_reference(*shader_iter);
+				}
+
+				if(m_feedback_shader) {
+					luna_shader::acquire()->decrement_reference(m_feedback_shader);
+				}
+			}
+
+			m_buffer = 0;
+			m_buffer_length = 0;
+			m_buffer_max = 0;
+			m_buffer_texture = 0;
+			m_feedback_program = 0;
+			m_feedback_serial = 0;
+			m_feedback_shader = 0;
+			m_program = 0;
+			m_program_map.clear();
+			m_program_shader.clear();
+			m_vertex = 0;
+		}
+
+		void 
+		_luna_particle::remove(
+			__in uint32_t id
+			)
+		{
+			std::map<uint32_t, luna_particle_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+			remove_feedback(iter->second);
+			m_entry_map.erase(iter);
+		}
+
+		void 
+		_luna_particle::remove_feedback(
+			__inout luna_particle_entry &entry
+			)
+		{
+			size_t iter;
+
+			// the gl components may already be torn down during shutdown
+			if(luna_vertex::is_allocated() && luna_vertex::acquire()->is_initialized()) {
+
+				for(iter = 0; iter < PARTICLE_BUFFER_COUNT; ++iter) {
+
+					if(entry.vertex[iter]) {
+						luna_vertex::acquire()->remove_vertex(entry.vertex[iter]);
+					}
+
+					if(entry.buffer[iter]) {
+						luna_vertex::acquire()->remove_buffer(entry.buffer[iter]);
+					}
+				}
+			}
+
+			for(iter = 0; iter < PARTICLE_BUFFER_COUNT; ++iter) {
+				entry.buffer[iter] = 0;
+				entry.vertex[iter] = 0;
+			}
+		}
+
+		void 
+		_luna_particle::set(
+			__in uint32_t id,
+			__in const luna_particle_emitter &emitter
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			find(id)->second.emitter = emitter;
+		}
+
+		void 
+		_luna_particle::simulate(
+			__inout luna_particle_entry &entry,
+			__in size_t count,
+			__in GLfloat delta
+			)
+		{
+			luna_particle_emitter *emitter = &entry.emitter;
+			luna_vertex_ptr instance_vertex = NULL;
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			load_feedback();
+			instance_vertex = luna_vertex::acquire();
+			count = std::min(count, entry.capacity);
+			particle_random(entry.random, 0.f, 1.f);
+			luna_shader_program::acquire()->use(m_feedback_program);
+			glUniform3f(m_feedback.acceleration, emitter->acceleration.x, 
+				emitter->acceleration.y, emitter->acceleration.z);
+			glUniform1i(m_feedback.capacity, entry.capacity);
+			glUniform1f(m_feedback.damping, std::max(0.f, 1.f - (emitter->drag * delta)));
+			glUniform1f(m_feedback.delta, delta);
+			glUniform3f(m_feedback.direction, emitter->direction.x, emitter->direction.y, 
+				emitter->direction.z);
+			glUniform2f(m_feedback.lifetime, emitter->lifetime_min, emitter->lifetime_max);
+			glUniform3f(m_feedback.origin, emitter->position.x, emitter->position.y, 
+				emitter->position.z);
+			glUniform1ui(m_feedback.seed, entry.random);
+			glUniform1i(m_feedback.spawn_begin, entry.spawn);
+			glUniform1i(m_feedback.spawn_count, count);
+			glUniform2f(m_feedback.speed, emitter->speed_min, emitter->speed_max);
+			glUniform1f(m_feedback.spread, emitter->spread);
+
+			// spawns walk the slots as a ring, so with enough capacity for the emitter's rate
+			// the window only ever lands on slots that have already died
+			entry.spawn = ((entry.spawn + count) % entry.capacity);
+
+			// the current buffer feeds the vao while the other captures, so state never leaves
+			// the gpu
+			instance_vertex->bind_vertex(entry.vertex[entry.buffer_index]);
+			glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 
+				entry.buffer[entry.buffer_index ^ 1]);
+			glEnable(GL_RASTERIZER_DISCARD);
+			glBeginTransformFeedback(GL_POINTS);
+			glDrawArrays(GL_POINTS, 0, entry.capacity);
+			glEndTransformFeedback();
+			glDisable(GL_RASTERIZER_DISCARD);
+			glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+			instance_vertex->bind_vertex();
+			entry.buffer_index ^= 1;
+		}
+
+		size_t 
+		_luna_particle::size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_entry_map.size();
+		}
+
+		size_t 
+		_luna_particle::spawn(
+			__inout luna_particle_entry &entry,
+			__in size_t count
+			)
+		{
+			size_t iter, result;
+			GLfloat speed, *stream;
+			const luna_particle_emitter &emitter = entry.emitter;
+
+			result = std::min(count, entry.capacity - entry.count);
+
+			for(iter = entry.count; iter < (entry.count + result); ++iter) {
+				entry.life[iter] = std::max(particle_random(entry.random, emitter.lifetime_min, 
+					emitter.lifetime_max), PARTICLE_LIFETIME_MIN);
+				entry.inverse_lifetime[iter] = (1.f / entry.life[iter]);
+				speed = particle_random(entry.random, emitter.speed_min, emitter.speed_max);
+				entry.velocity_x[iter] = ((emitter.direction.x + (emitter.spread 
+					* particle_random(entry.random, -1.f, 1.f))) * speed);
+				entry.velocity_y[iter] = ((emitter.direction.y + (emitter.spread 
+					* particle_random(entry.random, -1.f, 1.f))) * speed);
+				entry.velocity_z[iter] = ((emitter.direction.z + (emitter.spread 
+					* particle_random(entry.random, -1.f, 1.f))) * speed);
+				entry.x[iter] = emitter.position.x;
+				entry.y[iter] = emitter.position.y;
+				entry.z[iter] = emitter.position.z;
+
+				// a flush before the next step draws new particles straight from the stream
+				stream = &entry.stream[iter * PARTICLE_STREAM_WIDTH];
+				stream[0] = emitter.position.x;
+				stream[1] = emitter.position.y;
+				stream[2] = emitter.position.z;
+				stream[3] = 1.f;
+			}
+
+			entry.count += result;
+
+			return result;
+		}
+
+		void 
+		_luna_particle::step(
+			__in const std::vector<luna_particle_entry *> &entries,
+			__in GLfloat delta,
+			__in bool parallel,
+			__inout luna_particle_pass &pass
+			)
+		{
+			size_t iter, offset;
+			luna_particle_block block;
+			luna_particle_entry *entry = NULL;
+
+			pass.block.clear();
+			pass.delta = delta;
+
+			// large emitters are split into blocks, so one emitter can span several workers
+			for(iter = 0; iter < entries.size(); ++iter) {
+				entry = entries.at(iter);
+
+				for(offset = 0; offset < entry->count; offset += PARTICLE_BLOCK) {
+					block.alive = 0;
+					block.count = std::min((size_t) PARTICLE_BLOCK, entry->count - offset);
+					block.entry = entry;
+					block.offset = offset;
+					pass.block.push_back(block);
+				}
+
+				entry->count = 0;
+			}
+
+			if(parallel && (pass.block.size() > 1) && luna_job::is_allocated() 
+					&& luna_job::acquire()->is_initialized()) {
+				luna_job::acquire()->run(pass.block.size(), luna_particle::integrate_range, &pass);
+			} else {
+				integrate_range(0, pass.block.size(), &pass);
+			}
+
+			// each block compacted to its own front, so slide them down behind each other
+			for(iter = 0; iter < pass.block.size(); ++iter) {
+				entry = pass.block.at(iter).entry;
+
+				if(pass.block.at(iter).offset != entry->count) {
+					particle_move(*entry, entry->count, pass.block.at(iter).offset, 
+						pass.block.at(iter).alive);
+				}
+
+				entry->count += pass.block.at(iter).alive;
+			}
+		}
+
+		std::string 
+		_luna_particle::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+			std::map<uint32_t, luna_particle_entry>::iterator iter;
+
+			result << LUNA_PARTICLE_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_particle_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+				result << " EMIT. " << m_entry_map.size() << ", DRAW. " << m_draw_count;
+
+				for(iter = m_entry_map.begin(); iter != m_entry_map.end(); ++iter) {
+					result << std::endl << "--- 0x" << SCALAR_AS_HEX(uint32_t, iter->first)
+						<< ", PART. " << iter->second.count 
+						<< ", CAP. " << iter->second.capacity
+						<< ", GPU. " << (iter->second.buffer[0] ? 1 : 0);
+				}
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_particle::uninitialize(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			clear();
+			m_initialized = false;
+		}
+
+		size_t 
+		_luna_particle::update(
+			__in GLfloat delta
+			)
+		{
+			bool gpu = false;
+			size_t count, result = 0;
+			luna_particle_entry *entry = NULL;
+			std::map<uint32_t, luna_particle_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_PARTICLE_EXCEPTION(LUNA_PARTICLE_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_entry_active.clear();
+
+			for(iter = m_entry_map.begin(); iter != m_entry_map.end(); ++iter) {
+				entry = &iter->second;
+				entry->emit += (entry->emitter.rate * delta);
+				count = (size_t) std::max(entry->emit, 0.f);
+				entry->emit -= count;
+
+				if(entry->buffer[0]) {
+					simulate(*entry, count, delta);
+					gpu = true;
+					continue;
+				}
+
+				spawn(*entry, count);
+
+				if(entry->count) {
+					m_entry_active.push_back(entry);
+				}
+			}
+
+			if(gpu) {
+				luna_shader_program::acquire()->use();
+			}
+
+			step(m_entry_active, delta, true, m_pass);
+
+			for(iter = m_entry_map.begin(); iter != m_entry_map.end(); ++iter) {
+				result += iter->second.count;
+			}
+
+			return result;
+		}
+	}
+}
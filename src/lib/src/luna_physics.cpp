@@ -0,0 +1,1627 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "../include/luna.h"
+#include "../include/luna_physics_type.h"
+
+#ifdef __AVX__
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif // __AVX__
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define PHYSICS_BAUMGARTE 0.2f
+		#define PHYSICS_BOUNCE 1.f
+		#define PHYSICS_NONE UINT32_MAX
+		#define PHYSICS_PAIR_BLOCK 256
+		#define PHYSICS_SLOP 0.005f
+		#define PHYSICS_STEP_MAX 8
+		#define PHYSICS_TOLERANCE_ABSOLUTE 0.0005f
+		#define PHYSICS_TOLERANCE_RELATIVE 0.95f
+
+		#define PHYSICS_BLOCK_COUNT(_COUNT_) (((_COUNT_) + PHYSICS_BLOCK - 1) / PHYSICS_BLOCK)
+
+		#define PHYSICS_FEATURE(_FLIP_, _REFERENCE_, _INCIDENT_, _VERTEX_) \
+			((((uint32_t) (_FLIP_)) << 24) | (((uint32_t) (_REFERENCE_)) << 16) \
+			| (((uint32_t) (_INCIDENT_)) << 8) | ((uint32_t) (_VERTEX_)))
+
+		#define PHYSICS_KEY(_FIRST_, _SECOND_) \
+			((((uint64_t) (_FIRST_)) << 32) | ((uint64_t) (_SECOND_)))
+
+		#define PHYSICS_PAIR_BLOCK_COUNT(_COUNT_) \
+			(((_COUNT_) + PHYSICS_PAIR_BLOCK - 1) / PHYSICS_PAIR_BLOCK)
+
+		// keeps the side of a segment behind a line, splitting it where it crosses
+		static size_t 
+		physics_clip(
+			__in const GLfloat *x,
+			__in const GLfloat *y,
+			__in const uint32_t *vertex,
+			__in GLfloat normal_x,
+			__in GLfloat normal_y,
+			__in GLfloat offset,
+			__out GLfloat *result_x,
+			__out GLfloat *result_y,
+			__out uint32_t *result_vertex
+			)
+		{
+			size_t result = 0;
+			GLfloat distance[2], scale;
+
+			distance[0] = (normal_x * x[0]) + (normal_y * y[0]) - offset;
+			distance[1] = (normal_x * x[1]) + (normal_y * y[1]) - offset;
+
+			if(distance[0] <= 0.f) {
+				result_x[result] = x[0];
+				result_y[result] = y[0];
+				result_vertex[result++] = vertex[0];
+			}
+
+			if(distance[1] <= 0.f) {
+				result_x[result] = x[1];
+				result_y[result] = y[1];
+				result_vertex[result++] = vertex[1];
+			}
+
+			if((distance[0] * distance[1]) < 0.f) {
+				scale = distance[0] / (distance[0] - distance[1]);
+				result_x[result] = x[0] + (scale * (x[1] - x[0]));
+				result_y[result] = y[0] + (scale * (y[1] - y[0]));
+				result_vertex[result++] = vertex[(distance[0] > 0.f) ? 0 : 1];
+			}
+
+			return result;
+		}
+
+		static void 
+		physics_circle(
+			__in GLfloat first_x,
+			__in GLfloat first_y,
+			__in GLfloat first_radius,
+			__in GLfloat second_x,
+			__in GLfloat second_y,
+			__in GLfloat second_radius,
+			__inout luna_physics_contact &contact
+			)
+		{
+			GLfloat distance, distance_x, distance_y, penetration, reach;
+
+			distance_x = second_x - first_x;
+			distance_y = second_y - first_y;
+			distance = (distance_x * distance_x) + (distance_y * distance_y);
+			reach = first_radius + second_radius;
+			if(distance > (reach * reach)) {
+				return;
+			}
+
+			distance = std::sqrt(distance);
+			if(distance > 0.f) {
+				contact.normal_x = distance_x / distance;
+				contact.normal_y = distance_y / distance;
+			} else {
+				contact.normal_x = 1.f;
+				contact.normal_y = 0.f;
+			}
+
+			penetration = reach - distance;
+			contact.point[0].feature = 0;
+			contact.point[0].penetration = penetration;
+			contact.point[0].x = first_x + (contact.normal_x * (first_radius - (penetration * 0.5f)));
+			contact.point[0].y = first_y + (contact.normal_y * (first_radius - (penetration * 0.5f)));
+			contact.count = 1;
+		}
+
+		template <class T> static void 
+		physics_erase(
+			__inout std::vector<T> &entry,
+			__in size_t index
+			)
+		{
+			entry[index] = entry.back();
+			entry.pop_back();
+		}
+
+		static GLfloat 
+		physics_separation(
+			__in const luna_physics_polygon &first,
+			__in const luna_physics_polygon &second,
+			__out size_t &edge
+			)
+		{
+			size_t iter, vertex;
+			GLfloat distance, result = -HUGE_VALF, separation;
+
+			edge = 0;
+
+			for(iter = 0; iter < first.count; ++iter) {
+				separation = HUGE_VALF;
+
+				for(vertex = 0; vertex < second.count; ++vertex) {
+					distance = (first.normal_x[iter] * (second.x[vertex] - first.x[iter])) 
+						+ (first.normal_y[iter] * (second.y[vertex] - first.y[iter]));
+					separation = std::min(separation, distance);
+				}
+
+				if(separation > result) {
+					result = separation;
+					edge = iter;
+				}
+			}
+
+			return result;
+		}
+
+		static void 
+		physics_polygon(
+			__in const luna_physics_polygon &first,
+			__in const luna_physics_polygon &second,
+			__inout luna_physics_contact &contact
+			)
+		{
+			bool flip;
+			uint32_t clip_vertex[2], incident_vertex[2], vertex[2];
+			size_t edge, edge_first, edge_second, incident = 0, iter, next;
+			const luna_physics_polygon *incident_polygon, *reference_polygon;
+			GLfloat clip_x[2], clip_y[2], front, incident_x[2], incident_y[2], minimum = HUGE_VALF, 
+				normal_x, normal_y, separation, separation_first, separation_second, x[2], y[2];
+
+			separation_first = physics_separation(first, second, edge_first);
+			if(separation_first > 0.f) {
+				return;
+			}
+
+			separation_second = physics_separation(second, first, edge_second);
+			if(separation_second > 0.f) {
+				return;
+			}
+
+			// the first polygon is preferred, so the reference face does not flicker between 
+			// nearly equal axes
+			flip = (separation_second > ((PHYSICS_TOLERANCE_RELATIVE * separation_first) 
+				+ PHYSICS_TOLERANCE_ABSOLUTE));
+			edge = (flip ? edge_second : edge_first);
+			reference_polygon = (flip ? &second : &first);
+			incident_polygon = (flip ? &first : &second);
+			normal_x = reference_polygon->normal_x[edge];
+			normal_y = reference_polygon->normal_y[edge];
+
+			for(iter = 0; iter < incident_polygon->count; ++iter) {
+				separation = (normal_x * incident_polygon->normal_x[iter]) 
+					+ (normal_y * incident_polygon->normal_y[iter]);
+				if(separation < minimum) {
+					minimum = separation;
+					incident = iter;
+				}
+			}
+
+			next = ((incident + 1) % incident_polygon->count);
+			incident_x[0] = incident_polygon->x[incident];
+			incident_y[0] = incident_polygon->y[incident];
+			incident_x[1] = incident_polygon->x[next];
+			incident_y[1] = incident_polygon->y[next];
+			incident_vertex[0] = incident;
+			incident_vertex[1] = next;
+			next = ((edge + 1) % reference_polygon->count);
+
+			// the incident edge is clipped to the sides of the reference edge, whose tangent 
+			// is the normal turned a quarter counter-clockwise
+			if(physics_clip(incident_x, incident_y, incident_vertex, normal_y, -normal_x, 
+					(normal_y * reference_polygon->x[edge]) - (normal_x * reference_polygon->y[edge]), 
+					clip_x, clip_y, clip_vertex) < 2) {
+				return;
+			}
+
+			if(physics_clip(clip_x, clip_y, clip_vertex, -normal_y, normal_x, 
+					(-normal_y * reference_polygon->x[next]) + (normal_x * reference_polygon->y[next]), 
+					x, y, vertex) < 2) {
+				return;
+			}
+
+			front = (normal_x * reference_polygon->x[edge]) + (normal_y * reference_polygon->y[edge]);
+
+			for(iter = 0; iter < 2; ++iter) {
+				separation = (normal_x * x[iter]) + (normal_y * y[iter]) - front;
+				if(separation > 0.f) {
+					continue;
+				}
+
+				// points sit halfway between the incident vertex and the reference face
+				luna_physics_point &point = contact.point[contact.count++];
+				point.feature = PHYSICS_FEATURE(flip, edge, incident, vertex[iter]);
+				point.penetration = -separation;
+				point.x = x[iter] - (normal_x * separation * 0.5f);
+				point.y = y[iter] - (normal_y * separation * 0.5f);
+			}
+
+			contact.normal_x = (flip ? -normal_x : normal_x);
+			contact.normal_y = (flip ? -normal_y : normal_y);
+		}
+
+		static void 
+		physics_polygon_circle(
+			__in const luna_physics_polygon &polygon,
+			__in GLfloat x,
+			__in GLfloat y,
+			__in GLfloat radius,
+			__in bool flip,
+			__inout luna_physics_contact &contact
+			)
+		{
+			uint32_t region = 0;
+			size_t edge = 0, iter, next;
+			GLfloat distance, distance_x, distance_y, normal_x, normal_y, separation = -HUGE_VALF;
+
+			for(iter = 0; iter < polygon.count; ++iter) {
+				distance = (polygon.normal_x[iter] * (x - polygon.x[iter])) 
+					+ (polygon.normal_y[iter] * (y - polygon.y[iter]));
+				if(distance > radius) {
+					return;
+				} else if(distance > separation) {
+					separation = distance;
+					edge = iter;
+				}
+			}
+
+			next = ((edge + 1) % polygon.count);
+			normal_x = polygon.normal_x[edge];
+			normal_y = polygon.normal_y[edge];
+
+			// centers outside the face are pushed away from its nearest corner instead
+			if(separation > 0.f) {
+
+				if((((x - polygon.x[edge]) * (polygon.x[next] - polygon.x[edge])) 
+						+ ((y - polygon.y[edge]) * (polygon.y[next] - polygon.y[edge]))) <= 0.f) {
+					region = 1;
+				} else if((((x - polygon.x[next]) * (polygon.x[edge] - polygon.x[next])) 
+						+ ((y - polygon.y[next]) * (polygon.y[edge] - polygon.y[next]))) <= 0.f) {
+					region = 2;
+				}
+
+				if(region) {
+					distance_x = x - polygon.x[(region == 1) ? edge : next];
+					distance_y = y - polygon.y[(region == 1) ? edge : next];
+					distance = (distance_x * distance_x) + (distance_y * distance_y);
+					if(distance > (radius * radius)) {
+						return;
+					}
+
+					separation = std::sqrt(distance);
+					if(separation > 0.f) {
+						normal_x = distance_x / separation;
+						normal_y = distance_y / separation;
+					}
+				}
+			}
+
+			luna_physics_point &point = contact.point[0];
+			point.feature = PHYSICS_FEATURE(flip, edge, 0, region);
+			point.penetration = radius - separation;
+			point.x = x - (normal_x * (radius + separation) * 0.5f);
+			point.y = y - (normal_y * (radius + separation) * 0.5f);
+			contact.count = 1;
+			contact.normal_x = (flip ? -normal_x : normal_x);
+			contact.normal_y = (flip ? -normal_y : normal_y);
+		}
+
+		static bool 
+		physics_order(
+			__in const luna_physics_contact &first,
+			__in const luna_physics_contact &second
+			)
+		{
+			return (first.key < second.key);
+		}
+
+		static uint32_t 
+		physics_root(
+			__inout std::vector<uint32_t> &parent,
+			__in uint32_t index
+			)
+		{
+
+			while(parent[index] != index) {
+				parent[index] = parent[parent[index]];
+				index = parent[index];
+			}
+
+			return index;
+		}
+
+		static void 
+		physics_run(
+			__in size_t blocks,
+			__in luna_job_range_cb callback,
+			__in void *context
+			)
+		{
+
+			if((blocks > 1) && luna_job::is_allocated() && luna_job::acquire()->is_initialized()) {
+				luna_job::acquire()->run(blocks, callback, context);
+			} else {
+				callback(0, blocks, context);
+			}
+		}
+
+		_luna_physics *_luna_physics::m_instance = NULL;
+
+		_luna_physics::_luna_physics(void) :
+			m_accumulator(0.f),
+			m_axis(0),
+			m_delta(0.f),
+			m_fixed_step(PHYSICS_DEF_STEP),
+			m_initialized(false),
+			m_island_count(0),
+			m_iterations(PHYSICS_DEF_ITERATIONS),
+			m_next(0)
+		{
+			std::atexit(luna_physics::_delete);
+			luna_vec3_make(0.f, -9.81f, 0.f, m_gravity);
+		}
+
+		_luna_physics::~_luna_physics(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_physics::_delete(void)
+		{
+
+			if(luna_physics::m_instance) {
+				delete luna_physics::m_instance;
+				luna_physics::m_instance = NULL;
+			}
+		}
+
+		_luna_physics *
+		_luna_physics::acquire(void)
+		{
+
+			if(!luna_physics::m_instance) {
+
+				luna_physics::m_instance = new luna_physics;
+				if(!luna_physics::m_instance) {
+					THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_physics::m_instance;
+		}
+
+		uint32_t 
+		_luna_physics::add(
+			__in const luna_physics_body &body
+			)
+		{
+			size_t iter, next;
+			luna_physics_polygon polygon;
+			GLfloat area = 0.f, cross, inertia = 0.f, length;
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!(body.mass >= 0.f) || std::isinf(body.mass) || !(body.friction >= 0.f) 
+					|| !(body.restitution >= 0.f) || (body.shape.type > PHYSICS_SHAPE_MAX)) {
+				THROW_LUNA_PHYSICS_EXCEPTION_FORMAT(LUNA_PHYSICS_EXCEPTION_INVALID,
+					"%f", (double) body.mass);
+			}
+
+			polygon.count = 0;
+
+			if(body.shape.type == PHYSICS_SHAPE_CIRCLE) {
+
+				if(!(body.shape.radius > 0.f)) {
+					THROW_LUNA_PHYSICS_EXCEPTION_FORMAT(LUNA_PHYSICS_EXCEPTION_INVALID,
+						"%f", (double) body.shape.radius);
+				}
+
+				inertia = 0.5f * body.shape.radius * body.shape.radius;
+			} else {
+
+				if((body.shape.count < 3) || (body.shape.count > PHYSICS_VERTEX_MAX)) {
+					THROW_LUNA_PHYSICS_EXCEPTION_FORMAT(LUNA_PHYSICS_EXCEPTION_INVALID,
+						"%lu", (unsigned long) body.shape.count);
+				}
+
+				polygon.count = body.shape.count;
+
+				for(iter = 0; iter < polygon.count; ++iter) {
+					next = ((iter + 1) % polygon.count);
+					const luna_vec3 &first = body.shape.vertex[iter], &second = body.shape.vertex[next], 
+						&third = body.shape.vertex[(next + 1) % polygon.count];
+
+					// every corner must turn left, which rejects concave and clockwise outlines
+					if(((second.x - first.x) * (third.y - second.y)) 
+							- ((second.y - first.y) * (third.x - second.x)) <= 0.f) {
+						THROW_LUNA_PHYSICS_EXCEPTION_FORMAT(LUNA_PHYSICS_EXCEPTION_INVALID,
+							"%lu", (unsigned long) next);
+					}
+
+					length = std::sqrt(((second.x - first.x) * (second.x - first.x)) 
+						+ ((second.y - first.y) * (second.y - first.y)));
+					polygon.normal_x[iter] = (second.y - first.y) / length;
+					polygon.normal_y[iter] = (first.x - second.x) / length;
+					polygon.x[iter] = first.x;
+					polygon.y[iter] = first.y;
+
+					// inertia of the triangle fan about the center of mass, per unit mass
+					cross = (first.x * second.y) - (first.y * second.x);
+					area += cross;
+					inertia += cross * ((first.x * first.x) + (first.x * second.x) 
+						+ (second.x * second.x) + (first.y * first.y) + (first.y * second.y) 
+						+ (second.y * second.y));
+				}
+
+				inertia /= (6.f * area);
+			}
+
+			m_table.angle.push_back(body.angle);
+			m_table.angular_velocity.push_back(body.angular_velocity);
+			m_table.force_x.push_back(0.f);
+			m_table.force_y.push_back(0.f);
+			m_table.friction.push_back(body.friction);
+			m_table.inertia_inverse.push_back((body.mass > 0.f) ? (1.f / (body.mass * inertia)) : 0.f);
+			m_table.local.push_back(polygon);
+			m_table.mass_inverse.push_back((body.mass > 0.f) ? (1.f / body.mass) : 0.f);
+			m_table.maximum_x.push_back(0.f);
+			m_table.maximum_y.push_back(0.f);
+			m_table.minimum_x.push_back(0.f);
+			m_table.minimum_y.push_back(0.f);
+			m_table.radius.push_back(body.shape.radius);
+			m_table.restitution.push_back(body.restitution);
+			m_table.torque.push_back(0.f);
+			m_table.type.push_back(body.shape.type);
+			m_table.velocity_x.push_back(body.velocity.x);
+			m_table.velocity_y.push_back(body.velocity.y);
+			m_table.world.push_back(polygon);
+			m_table.x.push_back(body.position.x);
+			m_table.y.push_back(body.position.y);
+			m_id.push_back(++m_next);
+			m_index_map.insert(std::pair<uint32_t, size_t>(m_next, m_id.size() - 1));
+
+			return m_next;
+		}
+
+		GLfloat 
+		_luna_physics::angle(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_table.angle[find(id)->second];
+		}
+
+		GLfloat 
+		_luna_physics::angular_velocity(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_table.angular_velocity[find(id)->second];
+		}
+
+		void 
+		_luna_physics::apply_force(
+			__in uint32_t id,
+			__in const luna_vec3 &force,
+			__in_opt GLfloat torque
+			)
+		{
+			size_t index;
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			index = find(id)->second;
+			m_table.force_x[index] += force.x;
+			m_table.force_y[index] += force.y;
+			m_table.torque[index] += torque;
+		}
+
+		void 
+		_luna_physics::apply_impulse(
+			__in uint32_t id,
+			__in const luna_vec3 &impulse,
+			__in_opt GLfloat angular_impulse
+			)
+		{
+			size_t index;
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			index = find(id)->second;
+			m_table.velocity_x[index] += (impulse.x * m_table.mass_inverse[index]);
+			m_table.velocity_y[index] += (impulse.y * m_table.mass_inverse[index]);
+			m_table.angular_velocity[index] += (angular_impulse * m_table.inertia_inverse[index]);
+		}
+
+		void 
+		_luna_physics::bound_range(
+			__in size_t begin,
+			__in size_t end,
+			__in void *context
+			)
+		{
+			GLfloat cosine, sine;
+			size_t block, index, iter, last;
+			luna_physics_ptr instance = (luna_physics_ptr) context;
+			luna_physics_table &table = instance->m_table;
+
+			for(block = begin; block < end; ++block) {
+				last = std::min((block + 1) * PHYSICS_BLOCK, table.x.size());
+
+				for(index = block * PHYSICS_BLOCK; index < last; ++index) {
+
+					if(table.type[index] == PHYSICS_SHAPE_CIRCLE) {
+						table.minimum_x[index] = table.x[index] - table.radius[index];
+						table.minimum_y[index] = table.y[index] - table.radius[index];
+						table.maximum_x[index] = table.x[index] + table.radius[index];
+						table.maximum_y[index] = table.y[index] + table.radius[index];
+						continue;
+					}
+
+					const luna_physics_polygon &local = table.local[index];
+					luna_physics_polygon &world = table.world[index];
+					cosine = std::cos(table.angle[index]);
+					sine = std::sin(table.angle[index]);
+					table.minimum_x[index] = HUGE_VALF;
+					table.minimum_y[index] = HUGE_VALF;
+					table.maximum_x[index] = -HUGE_VALF;
+					table.maximum_y[index] = -HUGE_VALF;
+
+					for(iter = 0; iter < local.count; ++iter) {
+						world.normal_x[iter] = (cosine * local.normal_x[iter]) 
+							- (sine * local.normal_y[iter]);
+						world.normal_y[iter] = (sine * local.normal_x[iter]) 
+							+ (cosine * local.normal_y[iter]);
+						world.x[iter] = table.x[index] + (cosine * local.x[iter]) 
+							- (sine * local.y[iter]);
+						world.y[iter] = table.y[index] + (sine * local.x[iter]) 
+							+ (cosine * local.y[iter]);
+						table.minimum_x[index] = std::min(table.minimum_x[index], world.x[iter]);
+						table.minimum_y[index] = std::min(table.minimum_y[index], world.y[iter]);
+						table.maximum_x[index] = std::max(table.maximum_x[index], world.x[iter]);
+						table.maximum_y[index] = std::max(table.maximum_y[index], world.y[iter]);
+					}
+				}
+			}
+		}
+
+		void 
+		_luna_physics::broadphase(void)
+		{
+			luna_physics_contact contact;
+			uint32_t first, index, second;
+			GLfloat center, mean[2] = { 0.f, 0.f }, spread[2] = { 0.f, 0.f };
+			size_t axis, count, iter, next;
+			const GLfloat *maximum, *minimum, *other_maximum, *other_minimum;
+
+			count = m_id.size();
+			m_contact.clear();
+
+			// sweep along the axis the bodies spread over most, so a tall stack does not turn 
+			// into every pair overlapping on the sweep axis
+			for(iter = 0; iter < count; ++iter) {
+				center = (m_table.minimum_x[iter] + m_table.maximum_x[iter]) * 0.5f;
+				mean[0] += center;
+				spread[0] += (center * center);
+				center = (m_table.minimum_y[iter] + m_table.maximum_y[iter]) * 0.5f;
+				mean[1] += center;
+				spread[1] += (center * center);
+			}
+
+			axis = ((count && ((spread[1] - ((mean[1] * mean[1]) / count)) 
+				> (spread[0] - ((mean[0] * mean[0]) / count)))) ? 1 : 0);
+			if((axis != m_axis) || (m_sweep.size() != count)) {
+				m_axis = axis;
+				m_sweep.resize(count);
+
+				for(iter = 0; iter < count; ++iter) {
+					m_sweep[iter] = iter;
+				}
+			}
+
+			minimum = (axis ? m_table.minimum_y.data() : m_table.minimum_x.data());
+			maximum = (axis ? m_table.maximum_y.data() : m_table.maximum_x.data());
+			other_minimum = (axis ? m_table.minimum_x.data() : m_table.minimum_y.data());
+			other_maximum = (axis ? m_table.maximum_x.data() : m_table.maximum_y.data());
+
+			// bodies move little between steps, so the previous order is nearly sorted and an 
+			// insertion sort runs in close to linear time
+			for(iter = 1; iter < count; ++iter) {
+				index = m_sweep[iter];
+
+				for(next = iter; next > 0; --next) {
+					first = m_sweep[next - 1];
+					if((minimum[first] < minimum[index]) 
+							|| ((minimum[first] == minimum[index]) && (first < index))) {
+						break;
+					}
+
+					m_sweep[next] = first;
+				}
+
+				m_sweep[next] = index;
+			}
+
+			for(iter = 0; iter < count; ++iter) {
+				first = m_sweep[iter];
+
+				for(next = iter + 1; (next < count) && (minimum[m_sweep[next]] <= maximum[first]); 
+						++next) {
+					second = m_sweep[next];
+
+					if(((m_table.mass_inverse[first] == 0.f) && (m_table.mass_inverse[second] == 0.f)) 
+							|| (other_minimum[first] > other_maximum[second]) 
+							|| (other_minimum[second] > other_maximum[first])) {
+						continue;
+					}
+
+					index = ((m_id[first] < m_id[second]) ? first : second);
+					contact.body[0] = index;
+					contact.body[1] = ((index == first) ? second : first);
+					contact.count = 0;
+					contact.friction = std::sqrt(m_table.friction[first] * m_table.friction[second]);
+					contact.key = PHYSICS_KEY(m_id[contact.body[0]], m_id[contact.body[1]]);
+					contact.restitution = std::max(m_table.restitution[first], 
+						m_table.restitution[second]);
+					m_contact.push_back(contact);
+				}
+			}
+		}
+
+		void 
+		_luna_physics::clear(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_accumulator = 0.f;
+			m_contact.clear();
+			m_contact_previous.clear();
+			m_id.clear();
+			m_index_map.clear();
+			m_island.clear();
+			m_island_count = 0;
+			m_label.clear();
+			m_local.clear();
+			m_parent.clear();
+			m_sweep.clear();
+			m_table.angle.clear();
+			m_table.angular_velocity.clear();
+			m_table.force_x.clear();
+			m_table.force_y.clear();
+			m_table.friction.clear();
+			m_table.inertia_inverse.clear();
+			m_table.local.clear();
+			m_table.mass_inverse.clear();
+			m_table.maximum_x.clear();
+			m_table.maximum_y.clear();
+			m_table.minimum_x.clear();
+			m_table.minimum_y.clear();
+			m_table.radius.clear();
+			m_table.restitution.clear();
+			m_table.torque.clear();
+			m_table.type.clear();
+			m_table.velocity_x.clear();
+			m_table.velocity_y.clear();
+			m_table.world.clear();
+			m_table.x.clear();
+			m_table.y.clear();
+		}
+
+		void 
+		_luna_physics::collide(
+			__in const luna_physics_table &table,
+			__inout luna_physics_contact &contact
+			)
+		{
+			uint32_t first, second;
+
+			first = contact.body[0];
+			second = contact.body[1];
+
+			if(table.type[first] == PHYSICS_SHAPE_CIRCLE) {
+
+				if(table.type[second] == PHYSICS_SHAPE_CIRCLE) {
+					physics_circle(table.x[first], table.y[first], table.radius[first], 
+						table.x[second], table.y[second], table.radius[second], contact);
+				} else {
+					physics_polygon_circle(table.world[second], table.x[first], table.y[first], 
+						table.radius[first], true, contact);
+				}
+			} else if(table.type[second] == PHYSICS_SHAPE_CIRCLE) {
+				physics_polygon_circle(table.world[first], table.x[second], table.y[second], 
+					table.radius[second], false, contact);
+			} else {
+				physics_polygon(table.world[first], table.world[second], contact);
+			}
+		}
+
+		bool 
+		_luna_physics::contains(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (m_index_map.find(id) != m_index_map.end());
+		}
+
+		std::map<uint32_t, size_t>::iterator 
+		_luna_physics::find(
+			__in uint32_t id
+			)
+		{
+			std::map<uint32_t, size_t>::iterator result;
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			result = m_index_map.find(id);
+			if(result == m_index_map.end()) {
+				THROW_LUNA_PHYSICS_EXCEPTION_FORMAT(LUNA_PHYSICS_EXCEPTION_NOT_FOUND,
+					"0x%x", id);
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_physics::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			m_next = 0;
+			clear();
+		}
+
+		void 
+		_luna_physics::integrate_position_range(
+			__in size_t begin,
+			__in size_t end,
+			__in void *context
+			)
+		{
+			GLfloat delta;
+			size_t iter, last;
+			luna_physics_ptr instance = (luna_physics_ptr) context;
+			luna_physics_table &table = instance->m_table;
+
+			delta = instance->m_delta;
+			iter = begin * PHYSICS_BLOCK;
+			last = std::min(end * PHYSICS_BLOCK, table.x.size());
+
+#ifdef __AVX__
+			for(; (iter + 8) <= last; iter += 8) {
+				__m256 step = _mm256_set1_ps(delta);
+
+				_mm256_storeu_ps(&table.x[iter], _mm256_add_ps(_mm256_loadu_ps(&table.x[iter]), 
+					_mm256_mul_ps(_mm256_loadu_ps(&table.velocity_x[iter]), step)));
+				_mm256_storeu_ps(&table.y[iter], _mm256_add_ps(_mm256_loadu_ps(&table.y[iter]), 
+					_mm256_mul_ps(_mm256_loadu_ps(&table.velocity_y[iter]), step)));
+				_mm256_storeu_ps(&table.angle[iter], _mm256_add_ps(_mm256_loadu_ps(
+					&table.angle[iter]), _mm256_mul_ps(_mm256_loadu_ps(
+					&table.angular_velocity[iter]), step)));
+			}
+#endif // __AVX__
+#ifdef __SSE__
+			for(; (iter + 4) <= last; iter += 4) {
+				__m128 step = _mm_set1_ps(delta);
+
+				_mm_storeu_ps(&table.x[iter], _mm_add_ps(_mm_loadu_ps(&table.x[iter]), 
+					_mm_mul_ps(_mm_loadu_ps(&table.velocity_x[iter]), step)));
+				_mm_storeu_ps(&table.y[iter], _mm_add_ps(_mm_loadu_ps(&table.y[iter]), 
+					_mm_mul_ps(_mm_loadu_ps(&table.velocity_y[iter]), step)));
+				_mm_storeu_ps(&table.angle[iter], _mm_add_ps(_mm_loadu_ps(&table.angle[iter]), 
+					_mm_mul_ps(_mm_loadu_ps(&table.angular_velocity[iter]), step)));
+			}
+#endif // __SSE__
+
+			for(; iter < last; ++iter) {
+				table.x[iter] += (table.velocity_x[iter] * delta);
+				table.y[iter] += (table.velocity_y[iter] * delta);
+				table.angle[iter] += (table.angular_velocity[iter] * delta);
+			}
+		}
+
+		void 
+		_luna_physics::integrate_velocity_range(
+			__in size_t begin,
+			__in size_t end,
+			__in void *context
+			)
+		{
+			GLfloat delta, gravity_x, gravity_y;
+			size_t iter, last;
+			luna_physics_ptr instance = (luna_physics_ptr) context;
+			luna_physics_table &table = instance->m_table;
+
+			delta = instance->m_delta;
+			gravity_x = instance->m_gravity.x;
+			gravity_y = instance->m_gravity.y;
+			iter = begin * PHYSICS_BLOCK;
+			last = std::min(end * PHYSICS_BLOCK, table.x.size());
+
+			// gravity only moves bodies with mass, forces are consumed by the step
+#ifdef __AVX__
+			for(; (iter + 8) <= last; iter += 8) {
+				__m256 dynamic, inverse, step = _mm256_set1_ps(delta);
+
+				inverse = _mm256_loadu_ps(&table.mass_inverse[iter]);
+				dynamic = _mm256_cmp_ps(inverse, _mm256_setzero_ps(), _CMP_GT_OQ);
+				_mm256_storeu_ps(&table.velocity_x[iter], _mm256_add_ps(_mm256_loadu_ps(
+					&table.velocity_x[iter]), _mm256_mul_ps(_mm256_add_ps(_mm256_and_ps(dynamic, 
+					_mm256_set1_ps(gravity_x)), _mm256_mul_ps(_mm256_loadu_ps(&table.force_x[iter]), 
+					inverse)), step)));
+				_mm256_storeu_ps(&table.velocity_y[iter], _mm256_add_ps(_mm256_loadu_ps(
+					&table.velocity_y[iter]), _mm256_mul_ps(_mm256_add_ps(_mm256_and_ps(dynamic, 
+					_mm256_set1_ps(gravity_y)), _mm256_mul_ps(_mm256_loadu_ps(&table.force_y[iter]), 
+					inverse)), step)));
+				_mm256_storeu_ps(&table.angular_velocity[iter], _mm256_add_ps(_mm256_loadu_ps(
+					&table.angular_velocity[iter]), _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(
+					&table.torque[iter]), _mm256_loadu_ps(&table.inertia_inverse[iter])), step)));
+				_mm256_storeu_ps(&table.force_x[iter], _mm256_setzero_ps());
+				_mm256_storeu_ps(&table.force_y[iter], _mm256_setzero_ps());
+				_mm256_storeu_ps(&table.torque[iter], _mm256_setzero_ps());
+			}
+#endif // __AVX__
+#ifdef __SSE__
+			for(; (iter + 4) <= last; iter += 4) {
+				__m128 dynamic, inverse, step = _mm_set1_ps(delta);
+
+				inverse = _mm_loadu_ps(&table.mass_inverse[iter]);
+				dynamic = _mm_cmpgt_ps(inverse, _mm_setzero_ps());
+				_mm_storeu_ps(&table.velocity_x[iter], _mm_add_ps(_mm_loadu_ps(
+					&table.velocity_x[iter]), _mm_mul_ps(_mm_add_ps(_mm_and_ps(dynamic, 
+					_mm_set1_ps(gravity_x)), _mm_mul_ps(_mm_loadu_ps(&table.force_x[iter]), 
+					inverse)), step)));
+				_mm_storeu_ps(&table.velocity_y[iter], _mm_add_ps(_mm_loadu_ps(
+					&table.velocity_y[iter]), _mm_mul_ps(_mm_add_ps(_mm_and_ps(dynamic, 
+					_mm_set1_ps(gravity_y)), _mm_mul_ps(_mm_loadu_ps(&table.force_y[iter]), 
+					inverse)), step)));
+				_mm_storeu_ps(&table.angular_velocity[iter], _mm_add_ps(_mm_loadu_ps(
+					&table.angular_velocity[iter]), _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(
+					&table.torque[iter]), _mm_loadu_ps(&table.inertia_inverse[iter])), step)));
+				_mm_storeu_ps(&table.force_x[iter], _mm_setzero_ps());
+				_mm_storeu_ps(&table.force_y[iter], _mm_setzero_ps());
+				_mm_storeu_ps(&table.torque[iter], _mm_setzero_ps());
+			}
+#endif // __SSE__
+
+			for(; iter < last; ++iter) {
+				table.velocity_x[iter] += ((((table.mass_inverse[iter] > 0.f) ? gravity_x : 0.f) 
+					+ (table.force_x[iter] * table.mass_inverse[iter])) * delta);
+				table.velocity_y[iter] += ((((table.mass_inverse[iter] > 0.f) ? gravity_y : 0.f) 
+					+ (table.force_y[iter] * table.mass_inverse[iter])) * delta);
+				table.angular_velocity[iter] += ((table.torque[iter] * table.inertia_inverse[iter]) 
+					* delta);
+				table.force_x[iter] = 0.f;
+				table.force_y[iter] = 0.f;
+				table.torque[iter] = 0.f;
+			}
+		}
+
+		bool 
+		_luna_physics::is_allocated(void)
+		{
+			return (luna_physics::m_instance != NULL);
+		}
+
+		bool 
+		_luna_physics::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		void 
+		_luna_physics::island(void)
+		{
+			size_t count, iter, side;
+			uint32_t body, first, root, second;
+
+			count = m_id.size();
+			m_label.assign(count, PHYSICS_NONE);
+			m_local.assign(count, PHYSICS_NONE);
+			m_parent.resize(count);
+			m_island_count = 0;
+
+			for(iter = 0; iter < count; ++iter) {
+				m_parent[iter] = iter;
+			}
+
+			// static bodies never join islands, so a shared floor does not serialize the scene
+			for(iter = 0; iter < m_contact.size(); ++iter) {
+				first = m_contact[iter].body[0];
+				second = m_contact[iter].body[1];
+
+				if((m_table.mass_inverse[first] > 0.f) && (m_table.mass_inverse[second] > 0.f)) {
+					first = physics_root(m_parent, first);
+					second = physics_root(m_parent, second);
+					m_parent[std::max(first, second)] = std::min(first, second);
+				}
+			}
+
+			// islands are numbered in contact order, which is sorted, so the split is the same 
+			// whatever the worker count
+			for(iter = 0; iter < m_contact.size(); ++iter) {
+				luna_physics_contact &contact = m_contact[iter];
+
+				body = ((m_table.mass_inverse[contact.body[0]] > 0.f) ? contact.body[0] 
+					: contact.body[1]);
+				root = physics_root(m_parent, body);
+
+				if(m_label[root] == PHYSICS_NONE) {
+					m_label[root] = m_island_count++;
+
+					if(m_island.size() < m_island_count) {
+						m_island.resize(m_island_count);
+					}
+
+					m_island[m_label[root]].body.clear();
+					m_island[m_label[root]].contact.clear();
+				}
+
+				luna_physics_island &entry = m_island[m_label[root]];
+
+				for(side = 0; side < 2; ++side) {
+					body = contact.body[side];
+
+					if(m_table.mass_inverse[body] > 0.f) {
+
+						if(m_local[body] == PHYSICS_NONE) {
+							m_local[body] = entry.body.size();
+							entry.body.push_back(body);
+						}
+
+						contact.local[side] = m_local[body];
+					} else {
+						contact.local[side] = entry.body.size();
+						entry.body.push_back(body);
+					}
+				}
+
+				entry.contact.push_back(iter);
+			}
+		}
+
+		size_t 
+		_luna_physics::island_count(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_island_count;
+		}
+
+		void 
+		_luna_physics::match(void)
+		{
+			size_t count = 0, iter, point, previous = 0, previous_point;
+
+			// pairs that are not touching are dropped, the rest are sorted by key so warm 
+			// starting and island numbering see the same order every step
+			for(iter = 0; iter < m_contact.size(); ++iter) {
+
+				if(m_contact[iter].count) {
+					m_contact[count++] = m_contact[iter];
+				}
+			}
+
+			m_contact.resize(count);
+			std::sort(m_contact.begin(), m_contact.end(), physics_order);
+
+			for(iter = 0; iter < m_contact.size(); ++iter) {
+				luna_physics_contact &contact = m_contact[iter];
+
+				while((previous < m_contact_previous.size()) 
+						&& (m_contact_previous[previous].key < contact.key)) {
+					++previous;
+				}
+
+				for(point = 0; point < contact.count; ++point) {
+					contact.point[point].impulse_normal = 0.f;
+					contact.point[point].impulse_tangent = 0.f;
+
+					if((previous == m_contact_previous.size()) 
+							|| (m_contact_previous[previous].key != contact.key)) {
+						continue;
+					}
+
+					const luna_physics_contact &entry = m_contact_previous[previous];
+
+					for(previous_point = 0; previous_point < entry.count; ++previous_point) {
+
+						if(entry.point[previous_point].feature == contact.point[point].feature) {
+							contact.point[point].impulse_normal = 
+								entry.point[previous_point].impulse_normal;
+							contact.point[point].impulse_tangent = 
+								entry.point[previous_point].impulse_tangent;
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		void 
+		_luna_physics::narrow_range(
+			__in size_t begin,
+			__in size_t end,
+			__in void *context
+			)
+		{
+			size_t iter, last;
+			luna_physics_ptr instance = (luna_physics_ptr) context;
+
+			last = std::min(end * PHYSICS_PAIR_BLOCK, instance->m_contact.size());
+
+			for(iter = begin * PHYSICS_PAIR_BLOCK; iter < last; ++iter) {
+				collide(instance->m_table, instance->m_contact[iter]);
+			}
+		}
+
+		luna_vec3 
+		_luna_physics::position(
+			__in uint32_t id
+			)
+		{
+			size_t index;
+			luna_vec3 result;
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			index = find(id)->second;
+			luna_vec3_make(m_table.x[index], m_table.y[index], 0.f, result);
+
+			return result;
+		}
+
+		size_t 
+		_luna_physics::query_contacts(
+			__out std::vector<std::pair<uint32_t, uint32_t>> &result
+			)
+		{
+			std::vector<luna_physics_contact>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			result.clear();
+
+			for(iter = m_contact.begin(); iter != m_contact.end(); ++iter) {
+				result.push_back(std::pair<uint32_t, uint32_t>(iter->key >> 32, 
+					iter->key & UINT32_MAX));
+			}
+
+			return result.size();
+		}
+
+		void 
+		_luna_physics::remove(
+			__in uint32_t id
+			)
+		{
+			size_t count = 0, index, iter, last;
+			std::map<uint32_t, size_t>::iterator entry;
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			entry = find(id);
+			index = entry->second;
+			last = m_id.size() - 1;
+			physics_erase(m_id, index);
+			physics_erase(m_table.angle, index);
+			physics_erase(m_table.angular_velocity, index);
+			physics_erase(m_table.force_x, index);
+			physics_erase(m_table.force_y, index);
+			physics_erase(m_table.friction, index);
+			physics_erase(m_table.inertia_inverse, index);
+			physics_erase(m_table.local, index);
+			physics_erase(m_table.mass_inverse, index);
+			physics_erase(m_table.maximum_x, index);
+			physics_erase(m_table.maximum_y, index);
+			physics_erase(m_table.minimum_x, index);
+			physics_erase(m_table.minimum_y, index);
+			physics_erase(m_table.radius, index);
+			physics_erase(m_table.restitution, index);
+			physics_erase(m_table.torque, index);
+			physics_erase(m_table.type, index);
+			physics_erase(m_table.velocity_x, index);
+			physics_erase(m_table.velocity_y, index);
+			physics_erase(m_table.world, index);
+			physics_erase(m_table.x, index);
+			physics_erase(m_table.y, index);
+			m_index_map.erase(entry);
+
+			if(index != last) {
+				find(m_id[index])->second = index;
+			}
+
+			// contacts of the removed body are dropped, the rest are rebuilt by the next step
+			for(iter = 0; iter < m_contact.size(); ++iter) {
+
+				if(((m_contact[iter].key >> 32) != id) && ((m_contact[iter].key & UINT32_MAX) != id)) {
+					m_contact[count++] = m_contact[iter];
+				}
+			}
+
+			m_contact.resize(count);
+		}
+
+		void 
+		_luna_physics::set_angle(
+			__in uint32_t id,
+			__in GLfloat angle
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_table.angle[find(id)->second] = angle;
+		}
+
+		void 
+		_luna_physics::set_angular_velocity(
+			__in uint32_t id,
+			__in GLfloat angular_velocity
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_table.angular_velocity[find(id)->second] = angular_velocity;
+		}
+
+		void 
+		_luna_physics::set_fixed_step(
+			__in GLfloat step
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!(step >= 0.f) || std::isinf(step)) {
+				THROW_LUNA_PHYSICS_EXCEPTION_FORMAT(LUNA_PHYSICS_EXCEPTION_INVALID,
+					"%f", (double) step);
+			}
+
+			m_accumulator = 0.f;
+			m_fixed_step = step;
+		}
+
+		void 
+		_luna_physics::set_gravity(
+			__in const luna_vec3 &gravity
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_gravity = gravity;
+		}
+
+		void 
+		_luna_physics::set_iterations(
+			__in size_t iterations
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!iterations) {
+				THROW_LUNA_PHYSICS_EXCEPTION_FORMAT(LUNA_PHYSICS_EXCEPTION_INVALID,
+					"%lu", (unsigned long) iterations);
+			}
+
+			m_iterations = iterations;
+		}
+
+		void 
+		_luna_physics::set_position(
+			__in uint32_t id,
+			__in const luna_vec3 &position
+			)
+		{
+			size_t index;
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			index = find(id)->second;
+			m_table.x[index] = position.x;
+			m_table.y[index] = position.y;
+		}
+
+		void 
+		_luna_physics::set_velocity(
+			__in uint32_t id,
+			__in const luna_vec3 &velocity
+			)
+		{
+			size_t index;
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			index = find(id)->second;
+			m_table.velocity_x[index] = velocity.x;
+			m_table.velocity_y[index] = velocity.y;
+		}
+
+		void 
+		_luna_physics::simulate(
+			__in GLfloat delta
+			)
+		{
+			size_t blocks;
+
+			blocks = PHYSICS_BLOCK_COUNT(m_id.size());
+			m_delta = delta;
+			physics_run(blocks, luna_physics::bound_range, this);
+			m_contact_previous.swap(m_contact);
+			broadphase();
+			physics_run(PHYSICS_PAIR_BLOCK_COUNT(m_contact.size()), luna_physics::narrow_range, this);
+			match();
+			island();
+			physics_run(blocks, luna_physics::integrate_velocity_range, this);
+
+			// islands share no moving bodies, so each is solved whole on one worker
+			physics_run(m_island_count, luna_physics::solve_range, this);
+			physics_run(blocks, luna_physics::integrate_position_range, this);
+		}
+
+		size_t 
+		_luna_physics::size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_id.size();
+		}
+
+		void 
+		_luna_physics::solve(
+			__inout luna_physics_island &island
+			)
+		{
+			uint32_t first, second;
+			size_t body, contact, iteration, point;
+			GLfloat bias, cross_first, cross_second, impulse, impulse_x, impulse_y, 
+				inertia_first, inertia_second, mass, mass_first, mass_second, normal_x, normal_y, 
+				previous, relative_x, relative_y, speed;
+			std::vector<GLfloat> &angular_velocity = island.angular_velocity, 
+				&velocity_x = island.velocity_x, &velocity_y = island.velocity_y;
+
+			angular_velocity.resize(island.body.size());
+			velocity_x.resize(island.body.size());
+			velocity_y.resize(island.body.size());
+
+			for(body = 0; body < island.body.size(); ++body) {
+				angular_velocity[body] = m_table.angular_velocity[island.body[body]];
+				velocity_x[body] = m_table.velocity_x[island.body[body]];
+				velocity_y[body] = m_table.velocity_y[island.body[body]];
+			}
+
+			// effective masses and biases are fixed for the step, and last step's impulses 
+			// are applied up front so resting stacks start close to their solution
+			for(contact = 0; contact < island.contact.size(); ++contact) {
+				luna_physics_contact &entry = m_contact[island.contact[contact]];
+
+				first = entry.local[0];
+				second = entry.local[1];
+				mass_first = m_table.mass_inverse[entry.body[0]];
+				mass_second = m_table.mass_inverse[entry.body[1]];
+				inertia_first = m_table.inertia_inverse[entry.body[0]];
+				inertia_second = m_table.inertia_inverse[entry.body[1]];
+				normal_x = entry.normal_x;
+				normal_y = entry.normal_y;
+
+				for(point = 0; point < entry.count; ++point) {
+					luna_physics_point &contact_point = entry.point[point];
+
+					contact_point.anchor_x[0] = contact_point.x - m_table.x[entry.body[0]];
+					contact_point.anchor_y[0] = contact_point.y - m_table.y[entry.body[0]];
+					contact_point.anchor_x[1] = contact_point.x - m_table.x[entry.body[1]];
+					contact_point.anchor_y[1] = contact_point.y - m_table.y[entry.body[1]];
+					cross_first = (contact_point.anchor_x[0] * normal_y) 
+						- (contact_point.anchor_y[0] * normal_x);
+					cross_second = (contact_point.anchor_x[1] * normal_y) 
+						- (contact_point.anchor_y[1] * normal_x);
+					mass = mass_first + mass_second + (inertia_first * cross_first * cross_first) 
+						+ (inertia_second * cross_second * cross_second);
+					contact_point.mass_normal = ((mass > 0.f) ? (1.f / mass) : 0.f);
+					cross_first = (contact_point.anchor_x[0] * -normal_x) 
+						- (contact_point.anchor_y[0] * normal_y);
+					cross_second = (contact_point.anchor_x[1] * -normal_x) 
+						- (contact_point.anchor_y[1] * normal_y);
+					mass = mass_first + mass_second + (inertia_first * cross_first * cross_first) 
+						+ (inertia_second * cross_second * cross_second);
+					contact_point.mass_tangent = ((mass > 0.f) ? (1.f / mass) : 0.f);
+					relative_x = velocity_x[second] 
+						- (angular_velocity[second] * contact_point.anchor_y[1]) 
+						- velocity_x[first] + (angular_velocity[first] * contact_point.anchor_y[0]);
+					relative_y = velocity_y[second] 
+						+ (angular_velocity[second] * contact_point.anchor_x[1]) 
+						- velocity_y[first] - (angular_velocity[first] * contact_point.anchor_x[0]);
+					speed = (relative_x * normal_x) + (relative_y * normal_y);
+					bias = (PHYSICS_BAUMGARTE / m_delta) 
+						* std::max(contact_point.penetration - PHYSICS_SLOP, 0.f);
+					if(speed < -PHYSICS_BOUNCE) {
+						bias = std::max(bias, -entry.restitution * speed);
+					}
+
+					contact_point.bias = bias;
+					impulse_x = (contact_point.impulse_normal * normal_x) 
+						+ (contact_point.impulse_tangent * normal_y);
+					impulse_y = (contact_point.impulse_normal * normal_y) 
+						- (contact_point.impulse_tangent * normal_x);
+					velocity_x[first] -= (mass_first * impulse_x);
+					velocity_y[first] -= (mass_first * impulse_y);
+					angular_velocity[first] -= (inertia_first * ((contact_point.anchor_x[0] * impulse_y) 
+						- (contact_point.anchor_y[0] * impulse_x)));
+					velocity_x[second] += (mass_second * impulse_x);
+					velocity_y[second] += (mass_second * impulse_y);
+					angular_velocity[second] += (inertia_second 
+						* ((contact_point.anchor_x[1] * impulse_y) 
+						- (contact_point.anchor_y[1] * impulse_x)));
+				}
+			}
+
+			for(iteration = 0; iteration < m_iterations; ++iteration) {
+
+				for(contact = 0; contact < island.contact.size(); ++contact) {
+					luna_physics_contact &entry = m_contact[island.contact[contact]];
+
+					first = entry.local[0];
+					second = entry.local[1];
+					mass_first = m_table.mass_inverse[entry.body[0]];
+					mass_second = m_table.mass_inverse[entry.body[1]];
+					inertia_first = m_table.inertia_inverse[entry.body[0]];
+					inertia_second = m_table.inertia_inverse[entry.body[1]];
+					normal_x = entry.normal_x;
+					normal_y = entry.normal_y;
+
+					for(point = 0; point < entry.count; ++point) {
+						luna_physics_point &contact_point = entry.point[point];
+
+						// friction first, clamped by the normal impulse gathered so far
+						relative_x = velocity_x[second] 
+							- (angular_velocity[second] * contact_point.anchor_y[1]) 
+							- velocity_x[first] + (angular_velocity[first] * contact_point.anchor_y[0]);
+						relative_y = velocity_y[second] 
+							+ (angular_velocity[second] * contact_point.anchor_x[1]) 
+							- velocity_y[first] - (angular_velocity[first] * contact_point.anchor_x[0]);
+						speed = (relative_x * normal_y) - (relative_y * normal_x);
+						previous = contact_point.impulse_tangent;
+						bias = entry.friction * contact_point.impulse_normal;
+						contact_point.impulse_tangent = std::max(-bias, std::min(previous 
+							- (contact_point.mass_tangent * speed), bias));
+						impulse = contact_point.impulse_tangent - previous;
+						impulse_x = impulse * normal_y;
+						impulse_y = -impulse * normal_x;
+						velocity_x[first] -= (mass_first * impulse_x);
+						velocity_y[first] -= (mass_first * impulse_y);
+						angular_velocity[first] -= (inertia_first 
+							* ((contact_point.anchor_x[0] * impulse_y) 
+							- (contact_point.anchor_y[0] * impulse_x)));
+						velocity_x[second] += (mass_second * impulse_x);
+						velocity_y[second] += (mass_second * impulse_y);
+						angular_velocity[second] += (inertia_second 
+							* ((contact_point.anchor_x[1] * impulse_y) 
+							- (contact_point.anchor_y[1] * impulse_x)));
+
+						// the accumulated normal impulse may shrink but never pulls
+						relative_x = velocity_x[second] 
+							- (angular_velocity[second] * contact_point.anchor_y[1]) 
+							- velocity_x[first] + (angular_velocity[first] * contact_point.anchor_y[0]);
+						relative_y = velocity_y[second] 
+							+ (angular_velocity[second] * contact_point.anchor_x[1]) 
+							- velocity_y[first] - (angular_velocity[first] * contact_point.anchor_x[0]);
+						speed = (relative_x * normal_x) + (relative_y * normal_y);
+						previous = contact_point.impulse_normal;
+						contact_point.impulse_normal = std::max(previous 
+							+ (contact_point.mass_normal * (contact_point.bias - speed)), 0.f);
+						impulse = contact_point.impulse_normal - previous;
+						impulse_x = impulse * normal_x;
+						impulse_y = impulse * normal_y;
+						velocity_x[first] -= (mass_first * impulse_x);
+						velocity_y[first] -= (mass_first * impulse_y);
+						angular_velocity[first] -= (inertia_first 
+							* ((contact_point.anchor_x[0] * impulse_y) 
+							- (contact_point.anchor_y[0] * impulse_x)));
+						velocity_x[second] += (mass_second * impulse_x);
+						velocity_y[second] += (mass_second * impulse_y);
+						angular_velocity[second] += (inertia_second 
+							* ((contact_point.anchor_x[1] * impulse_y) 
+							- (contact_point.anchor_y[1] * impulse_x)));
+					}
+				}
+			}
+
+			for(body = 0; body < island.body.size(); ++body) {
+
+				if(m_table.mass_inverse[island.body[body]] > 0.f) {
+					m_table.angular_velocity[island.body[body]] = angular_velocity[body];
+					m_table.velocity_x[island.body[body]] = velocity_x[body];
+					m_table.velocity_y[island.body[body]] = velocity_y[body];
+				}
+			}
+		}
+
+		void 
+		_luna_physics::solve_range(
+			__in size_t begin,
+			__in size_t end,
+			__in void *context
+			)
+		{
+			size_t iter;
+			luna_physics_ptr instance = (luna_physics_ptr) context;
+
+			for(iter = begin; iter < end; ++iter) {
+				instance->solve(instance->m_island[iter]);
+			}
+		}
+
+		size_t 
+		_luna_physics::step(
+			__in GLfloat delta
+			)
+		{
+			size_t result = 0;
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(!(delta >= 0.f) || std::isinf(delta)) {
+				THROW_LUNA_PHYSICS_EXCEPTION_FORMAT(LUNA_PHYSICS_EXCEPTION_INVALID,
+					"%f", (double) delta);
+			}
+
+			if(m_fixed_step > 0.f) {
+				m_accumulator += delta;
+
+				// fixed steps only depend on the step count, a long frame runs a bounded number 
+				// of them and drops the rest rather than falling further behind
+				while((m_accumulator >= m_fixed_step) && (result < PHYSICS_STEP_MAX)) {
+					simulate(m_fixed_step);
+					m_accumulator -= m_fixed_step;
+					++result;
+				}
+
+				if(m_accumulator >= m_fixed_step) {
+					m_accumulator = std::fmod(m_accumulator, m_fixed_step);
+				}
+			} else if(delta > 0.f) {
+				simulate(delta);
+				result = 1;
+			}
+
+			return result;
+		}
+
+		std::string 
+		_luna_physics::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+
+			result << LUNA_PHYSICS_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_physics_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+				result << " CNT. " << m_id.size() << ", CONTACT. " << m_contact.size() 
+					<< ", ISLAND. " << m_island_count << ", ITER. " << m_iterations 
+					<< ", STEP. " << std::fixed << std::setprecision(3) << m_fixed_step;
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_physics::uninitialize(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			clear();
+			m_initialized = false;
+		}
+
+		luna_vec3 
+		_luna_physics::velocity(
+			__in uint32_t id
+			)
+		{
+			size_t index;
+			luna_vec3 result;
+
+			if(!m_initialized) {
+				THROW_LUNA_PHYSICS_EXCEPTION(LUNA_PHYSICS_EXCEPTION_UNINITIALIZED);
+			}
+
+			index = find(id)->second;
+			luna_vec3_make(m_table.velocity_x[index], m_table.velocity_y[index], 0.f, result);
+
+			return result;
+		}
+	}
+}
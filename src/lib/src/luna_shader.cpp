@@ -17,7 +17,10 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
 #include "../include/luna.h"
 #include "../include/luna_shader_type.h"
 
@@ -25,10 +28,99 @@ namespace LUNA {
 
 	namespace COMP {
 
+		static std::string 
+		shader_directive(
+			__in const char *line,
+			__in const char *next,
+			__out std::string &text,
+			__out size_t &end
+			)
+		{
+			size_t begin = 0;
+			std::string result;
+
+			end = std::string::npos;
+			text.clear();
+
+			while(((line + begin) < next) && ((line[begin] == ' ') || (line[begin] == '\t'))) {
+				++begin;
+			}
+
+			// only directive lines are copied out of the source
+			if(((line + begin) < next) && (line[begin] == '#')) {
+				text.assign(line, ((next[-1] == '\n') ? (next - 1) : next));
+
+				begin = text.find_first_not_of(" \t", begin + 1);
+				if(begin != std::string::npos) {
+					end = text.find_first_of(" \t\"<", begin);
+					result = text.substr(begin, end - begin);
+				}
+			}
+
+			return result;
+		}
+
+		static std::string 
+		shader_join(
+			__in const luna_shader_source &source
+			)
+		{
+			size_t iter;
+			std::string result;
+
+			for(iter = 0; iter < source.span.size(); ++iter) {
+				result.append(source.span.at(iter), source.length.at(iter));
+			}
+
+			return result;
+		}
+
+		static const char *
+		shader_line(
+			__in const char *line,
+			__in const char *end
+			)
+		{
+			const char *result = (const char *) std::memchr(line, '\n', end - line);
+
+			return (result ? (result + 1) : end);
+		}
+
+		static void 
+		shader_span(
+			__in const char *data,
+			__in size_t length,
+			__inout luna_shader_source &source
+			)
+		{
+
+			if(length) {
+				source.length.push_back((GLint) length);
+				source.span.push_back((const GLchar *) data);
+			}
+		}
+
+		static void 
+		shader_text(
+			__in const std::string &text,
+			__inout luna_shader_source &source
+			)
+		{
+
+			// generated text lives in a deque, so earlier spans stay valid as it grows
+			if(!text.empty()) {
+				source.text.push_back(text);
+				shader_span(source.text.back().c_str(), source.text.back().size(), source);
+			}
+		}
+
 		_luna_shader *_luna_shader::m_instance = NULL;
 
 		_luna_shader::_luna_shader(void) :
-			m_initialized(false)
+			m_initialized(false),
+			m_pending(0),
+			m_serial(0),
+			m_watch(SCALAR_INVALID(int))
 		{
 			std::atexit(luna_shader::_delete);
 		}
@@ -70,66 +162,83 @@ namespace LUNA {
 		_luna_shader::add(
 			__in const std::string &input,
 			__in bool is_file,
-			__in GLenum type
+			__in GLenum type,
+			__in_opt const luna_shader_define &define
 			)
 		{
-			int length;
+			std::string text;
 			GLuint result = 0;
-			std::string err, source;
-			GLint err_length, status;
+			luna_shader_entry entry;
+			uint64_t content, variant;
+			luna_shader_source source;
+			luna_shader_variant variant_entry;
+			std::map<uint64_t, GLuint>::iterator source_iter;
+			std::map<uint64_t, luna_shader_variant>::iterator iter;
 
 			if(!m_initialized) {
 				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
 			}
 
-			result = glCreateShader(type);
-			if(!result) {
-				THROW_LUNA_SHADER_EXCEPTION_FORMAT(LUNA_SHADER_EXCEPTION_EXTERNAL,
-					"%s", "glCreateShader failed");
-			}
-
-			if(is_file) {
-
-				std::ifstream file(input.c_str(), std::ios::in);
-				if(!file) {
-					THROW_LUNA_SHADER_EXCEPTION_FORMAT(LUNA_SHADER_EXCEPTION_FILE_NOT_FOUND,
-						"%s", STRING_CHECK(input));
-				}
+			// repeated permutations share the compiled shader, hits are checked against the 
+			// inputs, so a key collision compiles its own shader instead
+			variant = key(input, is_file, type, define);
 
-				file.seekg(0, std::ios::end);
-				length = file.tellg();
-				file.seekg(0, std::ios::beg);
-				source.resize(length);
-				file.read((char *) &source[0], length);
-				file.close();
+			iter = m_variant_map.find(variant);
+			if((iter != m_variant_map.end()) && (iter->second.input == input) 
+					&& (iter->second.is_file == is_file) && (iter->second.type == type) 
+					&& (iter->second.define == define)) {
+				result = iter->second.id;
+				increment_reference(result);
 			} else {
-				source = input;
-			}
-
-			const char *source_addr = source.c_str();
-			glShaderSource(result, 1, (const GLchar **) &source_addr, NULL);
-			glCompileShader(result);
+				preprocess(input, is_file, define, source);
+				text = shader_join(source);
+
+				// distinct permutations that expand to identical source share one shader, 
+				// file shaders only share within the same file, since each reloads from its own
+				content = key(source, input, is_file, type);
+
+				source_iter = m_source_map.find(content);
+				if((source_iter != m_source_map.end()) 
+						&& (find(source_iter->second)->second.is_file == is_file) 
+						&& (!is_file || (find(source_iter->second)->second.input == input)) 
+						&& (find(source_iter->second)->second.text == text)) {
+					result = source_iter->second;
+					increment_reference(result);
+				} else {
+					result = compile(source, type);
+					entry.define = define;
+					entry.file = source.name;
+					entry.input = input;
+					entry.is_file = is_file;
+					entry.reference = REFERENCE_INIT;
+					entry.serial = ++m_serial;
+					entry.source = content;
+					entry.text = text;
+					entry.type = type;
+					m_shader_map.insert(std::pair<GLuint, luna_shader_entry>(result, entry));
+					m_source_map.insert(std::pair<uint64_t, GLuint>(content, result));
+
+					if(is_file) {
+						watch(result);
+					}
+				}
 
-			glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-			if(status == GL_FALSE) {
-				glGetShaderiv(result, GL_INFO_LOG_LENGTH, &err_length);
-				err.resize(err_length + 1);
-				glGetShaderInfoLog(result, err_length, NULL, (char *) &err[0]);
-				glDeleteShader(result);
-				THROW_LUNA_SHADER_EXCEPTION_FORMAT(LUNA_SHADER_EXCEPTION_EXTERNAL,
-					"glGetShaderiv failed: %s", err.c_str());
+				variant_entry.define = define;
+				variant_entry.id = result;
+				variant_entry.input = input;
+				variant_entry.is_file = is_file;
+				variant_entry.type = type;
+				m_variant_map.insert(std::pair<uint64_t, luna_shader_variant>(variant, 
+					variant_entry));
 			}
 
-			m_shader_map.insert(std::pair<GLuint, std::pair<GLenum, size_t>>(result, 
-				std::pair<GLenum, size_t>(type, REFERENCE_INIT)));
-
 			return result;
 		}
 
 		void 
 		_luna_shader::clear(void)
 		{
-			std::map<GLuint, std::pair<GLenum, size_t>>::iterator iter;
+			std::map<GLuint, luna_shader_entry>::iterator iter;
 
 			if(!m_initialized) {
 				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
@@ -139,7 +248,85 @@ namespace LUNA {
 				glDeleteShader(iter->first);
 			}
 
+			m_directory_map.clear();
+			m_file_map.clear();
 			m_shader_map.clear();
+			m_source_map.clear();
+			m_variant_map.clear();
+
+			// in-flight reloads reference this instance, so they must land before they 
+			// are dropped
+			{
+				std::unique_lock<std::mutex> lock(m_reloaded_lock);
+
+				while(m_reloaded.size() < m_pending) {
+					m_reloaded_condition.wait(lock);
+				}
+
+				while(!m_reloaded.empty()) {
+					delete m_reloaded.front();
+					m_reloaded.pop_front();
+					--m_pending;
+				}
+			}
+
+			if(m_watch != SCALAR_INVALID(int)) {
+				close(m_watch);
+				m_watch = SCALAR_INVALID(int);
+			}
+
+			m_reload_error.clear();
+			m_watch_map.clear();
+		}
+
+		GLuint 
+		_luna_shader::compile(
+			__in const luna_shader_source &source,
+			__in GLenum type,
+			__in_opt GLuint id
+			)
+		{
+			size_t iter;
+			std::string err;
+			GLuint result = id;
+			GLint err_length, status;
+
+			// existing shaders are recompiled in place, so their handle stays valid
+			if(!result) {
+				result = glCreateShader(type);
+			}
+
+			if(!result) {
+				THROW_LUNA_SHADER_EXCEPTION_FORMAT(LUNA_SHADER_EXCEPTION_EXTERNAL,
+					"%s", "glCreateShader failed");
+			}
+
+			// spans point into the mapped files, so the driver copies the source exactly once
+			glShaderSource(result, source.span.size(), source.span.data(), source.length.data());
+			glCompileShader(result);
+
+			glGetShaderiv(result, GL_COMPILE_STATUS, &status);
+			if(status == GL_FALSE) {
+				glGetShaderiv(result, GL_INFO_LOG_LENGTH, &err_length);
+				err.resize(err_length + 1);
+				glGetShaderInfoLog(result, err_length, NULL, (char *) &err[0]);
+				err.resize(std::strlen(err.c_str()));
+
+				if(!id) {
+					glDeleteShader(result);
+				}
+
+				// log entries are prefixed by source string number
+				for(iter = 0; iter < source.name.size(); ++iter) {
+					err += "\n--- " + std::to_string(iter) + ": " 
+						+ (source.name.at(iter).empty() ? EMPTY : source.name.at(iter));
+				}
+
+				THROW_LUNA_SHADER_EXCEPTION_FORMAT(LUNA_SHADER_EXCEPTION_EXTERNAL,
+					"glGetShaderiv failed: %s", err.c_str());
+			}
+
+			return result;
 		}
 
 		bool 
@@ -161,29 +348,112 @@ namespace LUNA {
 			)
 		{
 			size_t result = 0;
-			std::map<GLuint, std::pair<GLenum, size_t>>::iterator iter;
+			std::map<GLuint, luna_shader_entry>::iterator iter;
 
 			if(!m_initialized) {
 				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
 			}
 
 			iter = find(id);
-			if(iter->second.second > REFERENCE_INIT) {
-				result = --iter->second.second;
+			if(iter->second.reference > REFERENCE_INIT) {
+				result = --iter->second.reference;
 			} else {
-				glDeleteShader(iter->first);
-				m_shader_map.erase(iter);
+				release(iter);
 			}
 
 			return result;
 		}
 
-		std::map<GLuint, std::pair<GLenum, size_t>>::iterator 
+		void 
+		_luna_shader::expand(
+			__in const char *data,
+			__in size_t size,
+			__in size_t index,
+			__in const luna_shader_define &define,
+			__in size_t offset,
+			__inout std::set<std::string> &included,
+			__inout luna_shader_source &result
+			)
+		{
+			luna_file *file = NULL;
+			size_t begin, child, end, number = 0;
+			luna_shader_define::const_iterator define_iter;
+			const char *line = data, *next, *span = data, *tail = (data + size);
+			std::string directive, directory, name, text;
+
+			directory = result.name.at(index).substr(0, 
+				result.name.at(index).find_last_of('/') + 1);
+
+			// untouched lines accumulate into one span, directives split it
+			for(; line < tail; line = next) {
+				next = shader_line(line, tail);
+				++number;
+				directive = shader_directive(line, next, text, end);
+
+				if(directive == "include") {
+					begin = text.find_first_of("\"<", end);
+					end = ((begin != std::string::npos) ? text.find_first_of("\">", begin + 1) 
+						: std::string::npos);
+
+					if(end == std::string::npos) {
+						THROW_LUNA_SHADER_EXCEPTION_FORMAT(LUNA_SHADER_EXCEPTION_INVALID,
+							"%s:%u: %s", STRING_CHECK(result.name.at(index)), (uint32_t) number, 
+							text.c_str());
+					}
+
+					shader_span(span, line - span, result);
+					name = directory + text.substr(begin + 1, end - begin - 1);
+
+					// each file is included once, which also breaks include cycles
+					if(included.insert(name).second) {
+						file = &read(name, result);
+						result.name.push_back(name);
+						child = (result.name.size() - 1);
+						shader_text("#line " + std::to_string(1 - offset) + " " 
+							+ std::to_string(child) + "\n", result);
+						expand(file->data(), file->size(), child, define, offset, included, 
+							result);
+					}
+
+					shader_text("#line " + std::to_string(number + 1 - offset) + " " 
+						+ std::to_string(index) + "\n", result);
+					span = next;
+				} else if(directive == "version") {
+
+					if(!index) {
+						shader_span(span, next - span, result);
+						text = ((next[-1] == '\n') ? std::string() : std::string("\n"));
+
+						for(define_iter = define.begin(); define_iter != define.end(); 
+								++define_iter) {
+							text += "#define " + define_iter->first + " " + define_iter->second 
+								+ "\n";
+						}
+
+						shader_text(text + "#line " + std::to_string(number + 1 - offset) + " " 
+							+ std::to_string(index) + "\n", result);
+					} else {
+						shader_span(span, line - span, result);
+						shader_text("\n", result);
+					}
+
+					span = next;
+				}
+			}
+
+			shader_span(span, tail - span, result);
+
+			if(size && (tail[-1] != '\n')) {
+				shader_text("\n", result);
+			}
+		}
+
+		std::map<GLuint, luna_shader_entry>::iterator 
 		_luna_shader::find(
 			__in GLuint id
 			)
 		{
-			std::map<GLuint, std::pair<GLenum, size_t>>::iterator result;
+			std::map<GLuint, luna_shader_entry>::iterator result;
 
 			if(!m_initialized) {
 				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
@@ -208,7 +478,7 @@ namespace LUNA {
 				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
 			}
 
-			return ++find(id)->second.second;
+			return ++find(id)->second.reference;
 		}
 
 		void 
@@ -235,6 +505,236 @@ namespace LUNA {
 			return m_initialized;
 		}
 
+		uint64_t 
+		_luna_shader::key(
+			__in const std::string &input,
+			__in bool is_file,
+			__in GLenum type,
+			__in const luna_shader_define &define
+			)
+		{
+			size_t iter;
+			uint64_t result = HASH_FNV_BASIS;
+			luna_shader_define::const_iterator define_iter;
+
+			for(iter = 0; iter < sizeof(type); ++iter) {
+				result = HASH_FNV(result, type >> (iter * 8));
+			}
+
+			result = HASH_FNV(result, is_file);
+
+			for(iter = 0; iter < input.size(); ++iter) {
+				result = HASH_FNV(result, input[iter]);
+			}
+
+			// defines are already sorted by name, so equal sets hash equally
+			for(define_iter = define.begin(); define_iter != define.end(); ++define_iter) {
+				result = HASH_FNV(result, '\0');
+
+				for(iter = 0; iter < define_iter->first.size(); ++iter) {
+					result = HASH_FNV(result, define_iter->first[iter]);
+				}
+
+				result = HASH_FNV(result, '=');
+
+				for(iter = 0; iter < define_iter->second.size(); ++iter) {
+					result = HASH_FNV(result, define_iter->second[iter]);
+				}
+			}
+
+			return result;
+		}
+
+		uint64_t 
+		_luna_shader::key(
+			__in const luna_shader_source &source,
+			__in const std::string &input,
+			__in bool is_file,
+			__in GLenum type
+			)
+		{
+			size_t iter, span;
+			uint64_t result = HASH_FNV_BASIS;
+
+			// matches the key of the concatenated source, without building it
+			for(iter = 0; iter < sizeof(type); ++iter) {
+				result = HASH_FNV(result, type >> (iter * 8));
+			}
+
+			result = HASH_FNV(result, is_file);
+
+			if(is_file) {
+
+				for(iter = 0; iter < input.size(); ++iter) {
+					result = HASH_FNV(result, input[iter]);
+				}
+			}
+
+			for(span = 0; span < source.span.size(); ++span) {
+
+				for(iter = 0; iter < (size_t) source.length.at(span); ++iter) {
+					result = HASH_FNV(result, source.span.at(span)[iter]);
+				}
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_shader::poll(void)
+		{
+			ssize_t length;
+			size_t offset;
+			std::set<GLuint> changed;
+			luna_shader_request *request = NULL;
+			const struct inotify_event *event = NULL;
+			std::set<GLuint>::iterator changed_iter;
+			std::map<GLuint, luna_shader_entry>::iterator iter;
+			std::map<std::string, std::set<GLuint>>::iterator file_iter;
+			std::map<int, std::pair<std::string, size_t>>::iterator watch_iter;
+			alignas(struct inotify_event) char buffer[SHADER_WATCH_BUFFER];
+
+			// editors save in bursts, so a frame's events collapse into one reload per shader
+			while((length = ::read(m_watch, buffer, SHADER_WATCH_BUFFER)) > 0) {
+
+				for(offset = 0; offset < (size_t) length; 
+						offset += (sizeof(struct inotify_event) + event->len)) {
+					event = (const struct inotify_event *) &buffer[offset];
+
+					// events may still be queued for a directory that was just unwatched
+					watch_iter = m_watch_map.find(event->wd);
+					if(event->len && (watch_iter != m_watch_map.end())) {
+
+						file_iter = m_file_map.find(watch_iter->second.first + event->name);
+						if(file_iter != m_file_map.end()) {
+							changed.insert(file_iter->second.begin(), file_iter->second.end());
+						}
+					}
+				}
+			}
+
+			for(changed_iter = changed.begin(); changed_iter != changed.end(); ++changed_iter) {
+				iter = find(*changed_iter);
+
+				request = new luna_shader_request;
+				if(!request) {
+					THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_ALLOCATED);
+				}
+
+				request->define = iter->second.define;
+				request->id = iter->first;
+				request->input = iter->second.input;
+				request->serial = iter->second.serial;
+				++m_pending;
+
+				try {
+					luna_job::acquire()->add(luna_shader::reload, request);
+				} catch(...) {
+					--m_pending;
+					delete request;
+					throw;
+				}
+			}
+		}
+
+		std::string 
+		_luna_shader::preprocess(
+			__in const std::string &input,
+			__in bool is_file,
+			__in_opt const luna_shader_define &define
+			)
+		{
+			size_t iter;
+			std::string result;
+			luna_shader_source source;
+
+			if(!m_initialized) {
+				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			preprocess(input, is_file, define, source);
+
+			for(iter = 0; iter < source.span.size(); ++iter) {
+				result.append(source.span.at(iter), source.length.at(iter));
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_shader::preprocess(
+			__in const std::string &input,
+			__in bool is_file,
+			__in const luna_shader_define &define,
+			__out luna_shader_source &result
+			)
+		{
+			size_t end, offset = 1, size;
+			bool version = false;
+			luna_file *file = NULL;
+			std::string text;
+			std::set<std::string> included;
+			const char *data, *line, *next;
+			luna_shader_define::const_iterator define_iter;
+
+			// string inputs are referenced in place, so they must outlive the source
+			if(is_file) {
+				file = &read(input, result);
+				data = file->data();
+				size = file->size();
+				included.insert(input);
+			} else {
+				data = input.c_str();
+				size = input.size();
+			}
+
+			// glsl 3.30 changed #line to name the following line, earlier versions
+			// name the directive line itself
+			for(line = data; !version && (line < (data + size)); line = next) {
+				next = shader_line(line, data + size);
+
+				version = (shader_directive(line, next, text, end) == "version");
+				if(version) {
+					offset = ((std::strtoul(text.c_str() + end, NULL, 10) >= 330) ? 0 : 1);
+				}
+			}
+
+			result.name.clear();
+			result.name.push_back(is_file ? input : std::string());
+
+			// defines follow the version directive, or lead the source if there is none
+			if(!version) {
+				text.clear();
+
+				for(define_iter = define.begin(); define_iter != define.end(); ++define_iter) {
+					text += "#define " + define_iter->first + " " + define_iter->second + "\n";
+				}
+
+				shader_text(text + "#line " + std::to_string(1 - offset) + " 0\n", result);
+			}
+
+			expand(data, size, 0, define, offset, included, result);
+		}
+
+		luna_file &
+		_luna_shader::read(
+			__in const std::string &path,
+			__inout luna_shader_source &source
+			)
+		{
+			source.file.emplace_back();
+
+			try {
+				source.file.back().open(path);
+			} catch(...) {
+				source.file.pop_back();
+				THROW_LUNA_SHADER_EXCEPTION_FORMAT(LUNA_SHADER_EXCEPTION_FILE_NOT_FOUND,
+					"%s", STRING_CHECK(path));
+			}
+
+			return source.file.back();
+		}
+
 		size_t 
 		_luna_shader::reference_count(
 			__in GLuint id
@@ -245,7 +745,69 @@ namespace LUNA {
 				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
 			}
 
-			return find(id)->second.second;
+			return find(id)->second.reference;
+		}
+
+		void 
+		_luna_shader::release(
+			__in std::map<GLuint, luna_shader_entry>::iterator iter
+			)
+		{
+			std::map<uint64_t, GLuint>::iterator source_iter;
+			std::map<uint64_t, luna_shader_variant>::iterator variant_iter;
+
+			// every permutation resolving to this shader goes with it
+			for(variant_iter = m_variant_map.begin(); variant_iter != m_variant_map.end();) {
+
+				if(variant_iter->second.id == iter->first) {
+					variant_iter = m_variant_map.erase(variant_iter);
+				} else {
+					++variant_iter;
+				}
+			}
+
+			// a colliding shader is not in the map, and must not take the other one out
+			source_iter = m_source_map.find(iter->second.source);
+			if((source_iter != m_source_map.end()) && (source_iter->second == iter->first)) {
+				m_source_map.erase(source_iter);
+			}
+
+			unwatch(iter->first);
+			glDeleteShader(iter->first);
+			m_shader_map.erase(iter);
+		}
+
+		void 
+		_luna_shader::reload(
+			__in void *context
+			)
+		{
+			luna_shader_ptr inst = luna_shader::acquire();
+			luna_shader_request *request = (luna_shader_request *) context;
+
+			try {
+				preprocess(request->input, true, request->define, request->source);
+			} catch(std::exception &exc) {
+				request->error = exc.what();
+			} catch(...) {
+				request->error = EXCEPTION_UNKNOWN;
+			}
+
+			// notified under the lock, so a waiting clear cannot free the instance first
+			std::lock_guard<std::mutex> lock(inst->m_reloaded_lock);
+			inst->m_reloaded.push_back(request);
+			inst->m_reloaded_condition.notify_all();
+		}
+
+		std::string 
+		_luna_shader::reload_error(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_reload_error;
 		}
 
 		void 
@@ -253,15 +815,13 @@ namespace LUNA {
 			__in GLuint id
 			)
 		{
-			std::map<GLuint, std::pair<GLenum, size_t>>::iterator iter;
 
 			if(!m_initialized) {
 				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
 			}
 
-			iter = find(id);
-			glDeleteShader(iter->first);
-			m_shader_map.erase(iter);
+			// shaders may be shared by content, so only the last holder deletes it
+			decrement_reference(id);
 		}
 
 		size_t 
@@ -275,13 +835,83 @@ namespace LUNA {
 			return m_shader_map.size();
 		}
 
+		bool 
+		_luna_shader::swap(
+			__in luna_shader_request &request
+			)
+		{
+			GLuint scratch;
+			uint64_t content;
+			bool result = false;
+			luna_shader_program_ptr inst = NULL;
+			std::map<uint64_t, GLuint>::iterator source_iter;
+			std::map<GLuint, luna_shader_entry>::iterator iter;
+
+			iter = find(request.id);
+
+			// saves that leave the expanded source unchanged do not recompile
+			content = key(request.source, iter->second.input, iter->second.is_file, 
+				iter->second.type);
+			if(content != iter->second.source) {
+
+				try {
+
+					// the new source is compiled into a scratch shader first, so a failed 
+					// compile leaves the live shader and its source untouched
+					scratch = compile(request.source, iter->second.type);
+					glDeleteShader(scratch);
+
+					// the shader stops sharing its old source, it holds the new source from 
+					// here on
+					source_iter = m_source_map.find(iter->second.source);
+					if((source_iter != m_source_map.end()) 
+							&& (source_iter->second == iter->first)) {
+						m_source_map.erase(source_iter);
+					}
+
+					iter->second.source = 0;
+					iter->second.text.clear();
+
+					// recompiled in place, so programs and callers keep the same handle
+					compile(request.source, iter->second.type, iter->first);
+					iter->second.source = content;
+					iter->second.text = shader_join(request.source);
+					m_source_map.insert(std::pair<uint64_t, GLuint>(content, iter->first));
+
+					// linked programs keep their executable until a relink succeeds
+					if(luna_shader_program::is_allocated()) {
+
+						inst = luna_shader_program::acquire();
+						if(inst && inst->is_initialized()) {
+							inst->relink(iter->first);
+						}
+					}
+
+					result = true;
+				} catch(std::exception &exc) {
+					m_reload_error = exc.what();
+				}
+			}
+
+			// includes may have been added or removed
+			unwatch(iter->first);
+			iter->second.file = request.source.name;
+			watch(iter->first);
+
+			if(result) {
+				m_reload_error.clear();
+			}
+
+			return result;
+		}
+
 		std::string 
 		_luna_shader::to_string(
 			__in_opt bool verbose
 			)
 		{
 			std::stringstream result;
-			std::map<GLuint, std::pair<GLenum, size_t>>::iterator iter;
+			std::map<GLuint, luna_shader_entry>::iterator iter;
 
 			result << LUNA_SHADER_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
 
@@ -295,8 +925,13 @@ namespace LUNA {
 
 				for(iter = m_shader_map.begin(); iter != m_shader_map.end(); ++iter) {
 					result << std::endl << "--- 0x" << SCALAR_AS_HEX(GLuint, iter->first)
-						<< ", 0x" << SCALAR_AS_HEX(GLenum, iter->second.first)
-						<< ", REF. " << iter->second.second;
+						<< ", 0x" << SCALAR_AS_HEX(GLenum, iter->second.type)
+						<< ", REF. " << iter->second.reference
+						<< ", DEF. " << iter->second.define.size();
+
+					if(iter->second.is_file) {
+						result << ", " << iter->second.input;
+					}
 				}
 			}
 
@@ -313,7 +948,7 @@ namespace LUNA {
 				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
 			}
 
-			return find(id)->second.first;
+			return find(id)->second.type;
 		}
 
 		void 
@@ -328,10 +963,166 @@ namespace LUNA {
 			m_initialized = false;
 		}
 
+		void 
+		_luna_shader::unwatch(
+			__in GLuint id
+			)
+		{
+			std::vector<std::string>::iterator iter;
+			std::map<std::string, int>::iterator directory_iter;
+			std::map<std::string, std::set<GLuint>>::iterator file_iter;
+			std::map<int, std::pair<std::string, size_t>>::iterator watch_iter;
+			std::map<GLuint, luna_shader_entry>::iterator shader_iter = find(id);
+
+			for(iter = shader_iter->second.file.begin(); iter != shader_iter->second.file.end(); 
+					++iter) {
+
+				file_iter = m_file_map.find(*iter);
+				if(file_iter == m_file_map.end()) {
+					continue;
+				}
+
+				file_iter->second.erase(id);
+				if(!file_iter->second.empty()) {
+					continue;
+				}
+
+				m_file_map.erase(file_iter);
+
+				// directory watches are counted by file, the last file out removes the watch
+				directory_iter = m_directory_map.find(iter->substr(0, 
+					iter->find_last_of('/') + 1));
+				if(directory_iter == m_directory_map.end()) {
+					continue;
+				}
+
+				watch_iter = m_watch_map.find(directory_iter->second);
+				if((watch_iter != m_watch_map.end()) && !--watch_iter->second.second) {
+					inotify_rm_watch(m_watch, watch_iter->first);
+
+					// paths naming the same directory share one descriptor
+					for(directory_iter = m_directory_map.begin(); 
+							directory_iter != m_directory_map.end();) {
+
+						if(directory_iter->second == watch_iter->first) {
+							directory_iter = m_directory_map.erase(directory_iter);
+						} else {
+							++directory_iter;
+						}
+					}
+
+					m_watch_map.erase(watch_iter);
+				}
+			}
+		}
+
+		size_t 
+		_luna_shader::update(void)
+		{
+			size_t result = 0;
+			luna_shader_request *request = NULL;
+			std::map<GLuint, luna_shader_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(m_watch != SCALAR_INVALID(int)) {
+				poll();
+			}
+
+			// sources are read on a worker, compiles and relinks happen here between frames
+			for(;;) {
+
+				{
+					std::lock_guard<std::mutex> lock(m_reloaded_lock);
+
+					if(m_reloaded.empty()) {
+						break;
+					}
+
+					request = m_reloaded.front();
+					m_reloaded.pop_front();
+					--m_pending;
+				}
+
+				// shaders removed while reading are dropped
+				iter = m_shader_map.find(request->id);
+				if((iter != m_shader_map.end()) && (iter->second.serial == request->serial)) {
+
+					if(request->error.empty()) {
+
+						if(swap(*request)) {
+							++result;
+						}
+					} else {
+						m_reload_error = request->error;
+					}
+				}
+
+				delete request;
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_shader::watch(
+			__in GLuint id
+			)
+		{
+			int descriptor;
+			std::string directory;
+			std::vector<std::string>::iterator iter;
+			std::map<std::string, std::set<GLuint>>::iterator file_iter;
+			std::map<int, std::pair<std::string, size_t>>::iterator watch_iter;
+			std::map<GLuint, luna_shader_entry>::iterator shader_iter = find(id);
+
+			// hot reload is best effort, shaders still work without a watcher
+			if(m_watch == SCALAR_INVALID(int)) {
+				m_watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			}
+
+			if(m_watch != SCALAR_INVALID(int)) {
+
+				// directories are watched, since editors often save by replacing the file
+				for(iter = shader_iter->second.file.begin(); 
+						iter != shader_iter->second.file.end(); ++iter) {
+
+					// files already watched only gain another shader
+					file_iter = m_file_map.find(*iter);
+					if(file_iter != m_file_map.end()) {
+						file_iter->second.insert(id);
+						continue;
+					}
+
+					directory = iter->substr(0, iter->find_last_of('/') + 1);
+
+					// watching a watched directory again returns its existing descriptor
+					descriptor = inotify_add_watch(m_watch, directory.empty() ? "." 
+						: directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+					if(descriptor != SCALAR_INVALID(int)) {
+
+						watch_iter = m_watch_map.find(descriptor);
+						if(watch_iter == m_watch_map.end()) {
+							m_watch_map.insert(std::pair<int, std::pair<std::string, size_t>>(
+								descriptor, std::pair<std::string, size_t>(directory, 1)));
+						} else {
+							++watch_iter->second.second;
+						}
+
+						m_directory_map[directory] = descriptor;
+						m_file_map[*iter].insert(id);
+					}
+				}
+			}
+		}
+
 		_luna_shader_program *_luna_shader_program::m_instance = NULL;
 
 		_luna_shader_program::_luna_shader_program(void) :
-			m_initialized(false)
+			m_initialized(false),
+			m_serial(0)
 		{
 			std::atexit(luna_shader_program::_delete);
 		}
@@ -371,51 +1162,64 @@ namespace LUNA {
 
 		GLuint 
 		_luna_shader_program::add(
-			__in const std::vector<GLuint> &shaders
+			__in const std::vector<GLuint> &shaders,
+			__in_opt const std::vector<std::string> &varyings
 			)
 		{
-			std::string err;
 			GLuint result = 0;
-			GLint err_length, status;
-			std::vector<GLuint>::const_iterator iter;
+			uint64_t shader_key;
+			std::vector<GLuint> shader_set;
+			std::vector<GLuint>::iterator iter;
+			std::map<uint64_t, GLuint>::iterator key_iter;
 
 			if(!m_initialized) {
 				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
 			}
 
-			result = glCreateProgram();
-			if(!result) {
-				THROW_LUNA_SHADER_EXCEPTION_FORMAT(LUNA_SHADER_EXCEPTION_EXTERNAL,
-					"%s", "glCreateProgram failed");
-			}
+			// programs are shared by shader set, independent of the order given, but
+			// feedback varyings are ordered and change the link, so they are keyed too
+			shader_set = shaders;
+			std::sort(shader_set.begin(), shader_set.end());
+			shader_set.erase(std::unique(shader_set.begin(), shader_set.end()), shader_set.end());
+			shader_key = key(shader_set, varyings);
+
+			// hits are checked against the stored set, so a key collision links its own program
+			key_iter = m_key_map.find(shader_key);
+			if((key_iter != m_key_map.end()) 
+					&& (find(key_iter->second)->second.first == shader_set) 
+					&& (m_varying_map.at(key_iter->second) == varyings)) {
+				result = key_iter->second;
+				increment_reference(result);
+			} else {
 
-			for(iter = shaders.begin(); iter != shaders.end(); ++iter) {
-				glAttachShader(result, *iter);
-			}
+				result = glCreateProgram();
+				if(!result) {
+					THROW_LUNA_SHADER_EXCEPTION_FORMAT(LUNA_SHADER_EXCEPTION_EXTERNAL,
+						"%s", "glCreateProgram failed");
+				}
 
-			glLinkProgram(result);
+				try {
+					link(result, shader_set, varyings);
+				} catch(...) {
+					glDeleteProgram(result);
+					throw;
+				}
 
-			for(iter = shaders.begin(); iter != shaders.end(); ++iter) {
-				glDetachShader(result, *iter);
-			}
+				bind_uniform_blocks(result);
 
-			glGetProgramiv(result, GL_LINK_STATUS, &status);
-			if(status == GL_FALSE) {
-				glGetProgramiv(result, GL_INFO_LOG_LENGTH, &err_length);
-				err.resize(err_length + 1);
-				glGetProgramInfoLog(result, err_length, NULL, (char *) &err[0]);
-				glDeleteProgram(result);
-				THROW_LUNA_SHADER_EXCEPTION_FORMAT(LUNA_SHADER_EXCEPTION_EXTERNAL,
-					"glGetProgramiv failed: %s", err.c_str());
-			}
+				for(iter = shader_set.begin(); iter != shader_set.end(); ++iter) {
+					increment_shader_reference(*iter);
+				}
 
-			for(iter = shaders.begin(); iter != shaders.end(); ++iter) {
-				increment_shader_reference(*iter);
+				m_key_map.insert(std::pair<uint64_t, GLuint>(shader_key, result));
+				m_serial_map.insert(std::pair<GLuint, size_t>(result, ++m_serial));
+				m_varying_map.insert(std::pair<GLuint, std::vector<std::string>>(result, 
+					varyings));
+				m_shader_program_map.insert(std::pair<GLuint, std::pair<std::vector<GLuint>, 
+					size_t>>(result, std::pair<std::vector<GLuint>, size_t>(shader_set, 
+					REFERENCE_INIT)));
 			}
 
-			m_shader_program_map.insert(std::pair<GLuint, std::pair<std::vector<GLuint>, size_t>>(
-				result, std::pair<std::vector<GLuint>, size_t>(shaders, REFERENCE_INIT)));
-
 			return result;
 		}
 
@@ -441,6 +1245,40 @@ namespace LUNA {
 			return result;
 		}
 
+		void 
+		_luna_shader_program::bind_uniform_blocks(
+			__in GLuint id
+			)
+		{
+			std::string name;
+			GLuint block;
+			GLsizei name_length;
+			GLint count = 0, length = 0;
+			luna_uniform_ptr inst = NULL;
+
+			if(!m_initialized) {
+				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			// blocks share a binding point by name, so one buffer range serves every program
+			if(luna_uniform::is_allocated()) {
+
+				inst = luna_uniform::acquire();
+				if(inst && inst->is_initialized()) {
+					glGetProgramiv(id, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+					glGetProgramiv(id, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &length);
+
+					for(block = 0; block < (GLuint) count; ++block) {
+						name.resize(length + 1);
+						glGetActiveUniformBlockName(id, block, length + 1, &name_length, 
+							(GLchar *) &name[0]);
+						name.resize(name_length);
+						glUniformBlockBinding(id, block, inst->add(name));
+					}
+				}
+			}
+		}
+
 		void 
 		_luna_shader_program::clear(void)
 		{
@@ -463,7 +1301,10 @@ namespace LUNA {
 				glDeleteProgram(iter->first);
 			}
 
+			m_key_map.clear();
+			m_serial_map.clear();
 			m_shader_program_map.clear();
+			m_varying_map.clear();
 		}
 
 		bool 
@@ -485,7 +1326,6 @@ namespace LUNA {
 			)
 		{
 			size_t result = 0;
-			std::vector<GLuint>::iterator shader_iter;
 			std::map<GLuint, std::pair<std::vector<GLuint>, size_t>>::iterator iter;
 
 			if(!m_initialized) {
@@ -496,15 +1336,7 @@ namespace LUNA {
 			if(iter->second.second > REFERENCE_INIT) {
 				result = --iter->second.second;
 			} else {
-
-				for(shader_iter = iter->second.first.begin(); 
-						shader_iter != iter->second.first.end();
-						++shader_iter) {
-					decrement_shader_reference(*shader_iter);
-				}
-
-				glDeleteProgram(iter->first);
-				m_shader_program_map.erase(iter);
+				release(iter);
 			}
 
 			return result;
@@ -615,6 +1447,80 @@ namespace LUNA {
 			return m_initialized;
 		}
 
+		uint64_t 
+		_luna_shader_program::key(
+			__in const std::vector<GLuint> &shaders,
+			__in const std::vector<std::string> &varyings
+			)
+		{
+			size_t byte;
+			uint64_t result = HASH_FNV_BASIS;
+			std::vector<GLuint>::const_iterator iter;
+			std::vector<std::string>::const_iterator varying_iter;
+
+			for(iter = shaders.begin(); iter != shaders.end(); ++iter) {
+
+				for(byte = 0; byte < sizeof(GLuint); ++byte) {
+					result = HASH_FNV(result, *iter >> (byte * 8));
+				}
+			}
+
+			// names are hashed with their terminators, so the boundaries are unambiguous
+			for(varying_iter = varyings.begin(); varying_iter != varyings.end(); 
+					++varying_iter) {
+
+				for(byte = 0; byte <= varying_iter->size(); ++byte) {
+					result = HASH_FNV(result, varying_iter->c_str()[byte]);
+				}
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_shader_program::link(
+			__in GLuint id,
+			__in const std::vector<GLuint> &shaders,
+			__in const std::vector<std::string> &varyings
+			)
+		{
+			std::string err;
+			GLint err_length, status;
+			std::vector<const GLchar *> name;
+			std::vector<GLuint>::const_iterator iter;
+			std::vector<std::string>::const_iterator varying_iter;
+
+			for(iter = shaders.begin(); iter != shaders.end(); ++iter) {
+				glAttachShader(id, *iter);
+			}
+
+			// feedback varyings only take effect at the next link, so declare them first
+			if(!varyings.empty()) {
+
+				for(varying_iter = varyings.begin(); varying_iter != varyings.end(); 
+						++varying_iter) {
+					name.push_back(varying_iter->c_str());
+				}
+
+				glTransformFeedbackVaryings(id, name.size(), &name[0], GL_INTERLEAVED_ATTRIBS);
+			}
+
+			glLinkProgram(id);
+
+			for(iter = shaders.begin(); iter != shaders.end(); ++iter) {
+				glDetachShader(id, *iter);
+			}
+
+			glGetProgramiv(id, GL_LINK_STATUS, &status);
+			if(status == GL_FALSE) {
+				glGetProgramiv(id, GL_INFO_LOG_LENGTH, &err_length);
+				err.resize(err_length + 1);
+				glGetProgramInfoLog(id, err_length, NULL, (char *) &err[0]);
+				THROW_LUNA_SHADER_EXCEPTION_FORMAT(LUNA_SHADER_EXCEPTION_EXTERNAL,
+					"glGetProgramiv failed: %s", err.c_str());
+			}
+		}
+
 		size_t 
 		_luna_shader_program::reference_count(
 			__in GLuint id
@@ -628,19 +1534,69 @@ namespace LUNA {
 			return find(id)->second.second;
 		}
 
-		void 
-		_luna_shader_program::remove(
-			__in GLuint id
+		size_t 
+		_luna_shader_program::relink(
+			__in GLuint shader
 			)
 		{
-			std::vector<GLuint>::iterator shader_iter;
+			GLuint test;
+			std::vector<GLuint> program;
+			std::vector<GLuint>::iterator program_iter;
 			std::map<GLuint, std::pair<std::vector<GLuint>, size_t>>::iterator iter;
 
 			if(!m_initialized) {
 				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
 			}
 
-			iter = find(id);
+			for(iter = m_shader_program_map.begin(); iter != m_shader_program_map.end(); 
+					++iter) {
+
+				if(std::binary_search(iter->second.first.begin(), iter->second.first.end(), 
+						shader)) {
+					program.push_back(iter->first);
+				}
+			}
+
+			// a failed link discards the executable, so every dependent program is
+			// first linked into a scratch object and only relinked once all succeed
+			for(program_iter = program.begin(); program_iter != program.end(); ++program_iter) {
+
+				test = glCreateProgram();
+				if(!test) {
+					THROW_LUNA_SHADER_EXCEPTION_FORMAT(LUNA_SHADER_EXCEPTION_EXTERNAL,
+						"%s", "glCreateProgram failed");
+				}
+
+				try {
+					link(test, find(*program_iter)->second.first, 
+						m_varying_map.at(*program_iter));
+				} catch(...) {
+					glDeleteProgram(test);
+					throw;
+				}
+
+				glDeleteProgram(test);
+			}
+
+			for(program_iter = program.begin(); program_iter != program.end(); ++program_iter) {
+				link(*program_iter, find(*program_iter)->second.first, 
+					m_varying_map.at(*program_iter));
+				bind_uniform_blocks(*program_iter);
+
+				// a relink may move every location, so cached locations are checked against this
+				m_serial_map[*program_iter] = ++m_serial;
+			}
+
+			return program.size();
+		}
+
+		void 
+		_luna_shader_program::release(
+			__in std::map<GLuint, std::pair<std::vector<GLuint>, size_t>>::iterator iter
+			)
+		{
+			std::vector<GLuint>::iterator shader_iter;
+			std::map<uint64_t, GLuint>::iterator key_iter;
 
 			for(shader_iter = iter->second.first.begin(); 
 					shader_iter != iter->second.first.end();
@@ -648,10 +1604,45 @@ namespace LUNA {
 				decrement_shader_reference(*shader_iter);
 			}
 
+			// a colliding program is not in the map, and must not take the other one out
+			key_iter = m_key_map.find(key(iter->second.first, m_varying_map.at(iter->first)));
+			if((key_iter != m_key_map.end()) && (key_iter->second == iter->first)) {
+				m_key_map.erase(key_iter);
+			}
+
+			m_serial_map.erase(iter->first);
+			m_varying_map.erase(iter->first);
 			glDeleteProgram(iter->first);
 			m_shader_program_map.erase(iter);
 		}
 
+		void 
+		_luna_shader_program::remove(
+			__in GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			// programs may be shared by content, so only the last holder deletes it
+			decrement_reference(id);
+		}
+
+		size_t 
+		_luna_shader_program::serial(
+			__in GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_SHADER_EXCEPTION(LUNA_SHADER_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_serial_map.at(find(id)->first);
+		}
+
 		size_t 
 		_luna_shader_program::size(void)
 		{
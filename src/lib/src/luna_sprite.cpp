@@ -0,0 +1,611 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "../include/luna.h"
+#include "../include/luna_sprite_type.h"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif // __SSE__
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define SPRITE_CORNER_COUNT 4
+		#define SPRITE_INDEX_COUNT 6
+		// the key only orders quads, names that differ above 24 bits may share a key but are
+		// still batched apart, since batches compare the full names
+		#define SPRITE_KEY(_LAYER_, _PROGRAM_, _TEXTURE_) \
+			(((uint64_t) (_LAYER_) << 48) | (((uint64_t) (_PROGRAM_) & 0xffffff) << 24) \
+			| ((uint64_t) (_TEXTURE_) & 0xffffff))
+
+		enum {
+			SPRITE_UV_U0 = 0,
+			SPRITE_UV_U1,
+			SPRITE_UV_V0,
+			SPRITE_UV_V1,
+		};
+
+		static const std::string SPRITE_SHADER_FRAGMENT = 
+			"#version 150\n"
+			"uniform sampler2D " SPRITE_UNIFORM_TEXTURE ";\n"
+			"in vec2 frag_uv;\n"
+			"in vec4 frag_color;\n"
+			"out vec4 color;\n"
+			"void main(void) {\n"
+			"\tcolor = texture(" SPRITE_UNIFORM_TEXTURE ", frag_uv) * frag_color;\n"
+			"}\n";
+
+		static const std::string SPRITE_SHADER_VERTEX = 
+			"#version 150\n"
+			"uniform mat4 " SPRITE_UNIFORM_PROJECTION ";\n"
+			"in vec2 " SPRITE_ATTRIBUTE_POSITION ";\n"
+			"in vec2 " SPRITE_ATTRIBUTE_UV ";\n"
+			"in vec4 " SPRITE_ATTRIBUTE_COLOR ";\n"
+			"out vec2 frag_uv;\n"
+			"out vec4 frag_color;\n"
+			"void main(void) {\n"
+			"\tfrag_uv = " SPRITE_ATTRIBUTE_UV ";\n"
+			"\tfrag_color = " SPRITE_ATTRIBUTE_COLOR ";\n"
+			"\tgl_Position = " SPRITE_UNIFORM_PROJECTION 
+				" * vec4(" SPRITE_ATTRIBUTE_POSITION ", 0.0, 1.0);\n"
+			"}\n";
+
+		_luna_sprite *_luna_sprite::m_instance = NULL;
+
+		_luna_sprite::_luna_sprite(void) :
+			m_buffer(0),
+			m_buffer_index(0),
+			m_buffer_index_count(0),
+			m_buffer_length(0),
+			m_draw_count(0),
+			m_initialized(false),
+			m_program(0)
+		{
+			std::atexit(luna_sprite::_delete);
+		}
+
+		_luna_sprite::~_luna_sprite(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_sprite::_delete(void)
+		{
+
+			if(luna_sprite::m_instance) {
+				delete luna_sprite::m_instance;
+				luna_sprite::m_instance = NULL;
+			}
+		}
+
+		_luna_sprite *
+		_luna_sprite::acquire(void)
+		{
+
+			if(!luna_sprite::m_instance) {
+
+				luna_sprite::m_instance = new luna_sprite;
+				if(!luna_sprite::m_instance) {
+					THROW_LUNA_SPRITE_EXCEPTION(LUNA_SPRITE_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_sprite::m_instance;
+		}
+
+		void 
+		_luna_sprite::add(
+			__in const luna_sprite_quad &quad
+			)
+		{
+			uint64_t key;
+
+			if(!m_initialized) {
+				THROW_LUNA_SPRITE_EXCEPTION(LUNA_SPRITE_EXCEPTION_UNINITIALIZED);
+			}
+
+			key = SPRITE_KEY(quad.layer, quad.program, quad.texture);
+			m_key.push_back(key);
+			m_color.push_back(quad.color);
+			m_cosine.push_back(std::cos(quad.rotation));
+			m_half_height.push_back(quad.height * 0.5f);
+			m_half_width.push_back(quad.width * 0.5f);
+			m_sine.push_back(std::sin(quad.rotation));
+			m_uv[SPRITE_UV_U0].push_back(quad.u0);
+			m_uv[SPRITE_UV_U1].push_back(quad.u1);
+			m_uv[SPRITE_UV_V0].push_back(quad.v0);
+			m_uv[SPRITE_UV_V1].push_back(quad.v1);
+			m_quad_program.push_back(quad.program);
+			m_quad_texture.push_back(quad.texture);
+			m_x.push_back(quad.x);
+			m_y.push_back(quad.y);
+		}
+
+		void 
+		_luna_sprite::add(
+			__in const luna_atlas_rect &rect,
+			__in GLfloat x,
+			__in GLfloat y,
+			__in_opt GLfloat rotation,
+			__in_opt uint32_t color,
+			__in_opt uint16_t layer,
+			__in_opt GLuint program
+			)
+		{
+			luna_sprite_quad quad;
+
+			quad.color = color;
+			quad.height = rect.height;
+			quad.layer = layer;
+			quad.program = program;
+			quad.rotation = rotation;
+			quad.texture = rect.texture;
+			quad.u0 = rect.u0;
+			quad.u1 = rect.u1;
+			quad.v0 = rect.v0;
+			quad.v1 = rect.v1;
+			quad.width = rect.width;
+			quad.x = x;
+			quad.y = y;
+			add(quad);
+		}
+
+		void 
+		_luna_sprite::build(void)
+		{
+			size_t count, corner, iter = 0;
+
+			count = m_x.size();
+
+			for(corner = 0; corner < SPRITE_CORNER_COUNT; ++corner) {
+				m_corner_x[corner].resize(count);
+				m_corner_y[corner].resize(count);
+			}
+
+#ifdef __SSE__
+			// four sprites per pass, corners written as soa
+			for(; (iter + 4) <= count; iter += 4) {
+				__m128 a, b, d, e, x, y;
+
+				x = _mm_loadu_ps(&m_x[iter]);
+				y = _mm_loadu_ps(&m_y[iter]);
+				a = _mm_mul_ps(_mm_loadu_ps(&m_half_width[iter]), _mm_loadu_ps(&m_cosine[iter]));
+				b = _mm_mul_ps(_mm_loadu_ps(&m_half_height[iter]), _mm_loadu_ps(&m_sine[iter]));
+				d = _mm_mul_ps(_mm_loadu_ps(&m_half_width[iter]), _mm_loadu_ps(&m_sine[iter]));
+				e = _mm_mul_ps(_mm_loadu_ps(&m_half_height[iter]), _mm_loadu_ps(&m_cosine[iter]));
+				_mm_storeu_ps(&m_corner_x[0][iter], _mm_add_ps(_mm_sub_ps(x, a), b));
+				_mm_storeu_ps(&m_corner_y[0][iter], _mm_sub_ps(_mm_sub_ps(y, d), e));
+				_mm_storeu_ps(&m_corner_x[1][iter], _mm_add_ps(_mm_add_ps(x, a), b));
+				_mm_storeu_ps(&m_corner_y[1][iter], _mm_sub_ps(_mm_add_ps(y, d), e));
+				_mm_storeu_ps(&m_corner_x[2][iter], _mm_sub_ps(_mm_add_ps(x, a), b));
+				_mm_storeu_ps(&m_corner_y[2][iter], _mm_add_ps(_mm_add_ps(y, d), e));
+				_mm_storeu_ps(&m_corner_x[3][iter], _mm_sub_ps(_mm_sub_ps(x, a), b));
+				_mm_storeu_ps(&m_corner_y[3][iter], _mm_add_ps(_mm_sub_ps(y, d), e));
+			}
+#endif // __SSE__
+
+			for(; iter < count; ++iter) {
+				GLfloat a, b, d, e;
+
+				a = m_half_width[iter] * m_cosine[iter];
+				b = m_half_height[iter] * m_sine[iter];
+				d = m_half_width[iter] * m_sine[iter];
+				e = m_half_height[iter] * m_cosine[iter];
+				m_corner_x[0][iter] = (m_x[iter] - a) + b;
+				m_corner_y[0][iter] = (m_y[iter] - d) - e;
+				m_corner_x[1][iter] = (m_x[iter] + a) + b;
+				m_corner_y[1][iter] = (m_y[iter] + d) - e;
+				m_corner_x[2][iter] = (m_x[iter] + a) - b;
+				m_corner_y[2][iter] = (m_y[iter] + d) + e;
+				m_corner_x[3][iter] = (m_x[iter] - a) - b;
+				m_corner_y[3][iter] = (m_y[iter] - d) + e;
+			}
+		}
+
+		void 
+		_luna_sprite::clear(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_SPRITE_EXCEPTION(LUNA_SPRITE_EXCEPTION_UNINITIALIZED);
+			}
+
+			release();
+			reset();
+			m_draw_count = 0;
+		}
+
+		size_t 
+		_luna_sprite::draw_count(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_SPRITE_EXCEPTION(LUNA_SPRITE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_draw_count;
+		}
+
+		std::map<GLuint, luna_sprite_program>::iterator 
+		_luna_sprite::find_program(
+			__in GLuint id
+			)
+		{
+			size_t serial;
+			GLint location;
+			luna_sprite_program entry;
+			luna_vertex_ptr instance_vertex = NULL;
+			std::map<GLuint, luna_sprite_program>::iterator result;
+
+			if(!m_initialized) {
+				THROW_LUNA_SPRITE_EXCEPTION(LUNA_SPRITE_EXCEPTION_UNINITIALIZED);
+			}
+
+			instance_vertex = luna_vertex::acquire();
+			serial = luna_shader_program::acquire()->serial(id);
+
+			// a relinked program may have moved its locations, so its vao is built again
+			result = m_program_map.find(id);
+			if((result != m_program_map.end()) && (result->second.serial != serial)) {
+				instance_vertex->remove_vertex(result->second.vao);
+				m_program_map.erase(result);
+				result = m_program_map.end();
+			}
+
+			if(result == m_program_map.end()) {
+
+				// the vao captures both buffers, so it is built once per program
+				entry.vao = instance_vertex->add_vertex(1);
+				instance_vertex->bind_buffer(GL_ARRAY_BUFFER, m_buffer);
+				instance_vertex->bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer_index);
+
+				location = glGetAttribLocation(id, SPRITE_ATTRIBUTE_POSITION);
+				if(location >= 0) {
+					glEnableVertexAttribArray(location);
+					glVertexAttribPointer(location, 2, GL_FLOAT, GL_FALSE, 
+						sizeof(luna_sprite_vertex), 
+						(GLvoid *) offsetof(luna_sprite_vertex, x));
+				}
+
+				location = glGetAttribLocation(id, SPRITE_ATTRIBUTE_UV);
+				if(location >= 0) {
+					glEnableVertexAttribArray(location);
+					glVertexAttribPointer(location, 2, GL_FLOAT, GL_FALSE, 
+						sizeof(luna_sprite_vertex), 
+						(GLvoid *) offsetof(luna_sprite_vertex, u));
+				}
+
+				location = glGetAttribLocation(id, SPRITE_ATTRIBUTE_COLOR);
+				if(location >= 0) {
+					glEnableVertexAttribArray(location);
+					glVertexAttribPointer(location, 4, GL_UNSIGNED_BYTE, GL_TRUE, 
+						sizeof(luna_sprite_vertex), 
+						(GLvoid *) offsetof(luna_sprite_vertex, color));
+				}
+
+				instance_vertex->bind_vertex();
+				entry.projection = glGetUniformLocation(id, SPRITE_UNIFORM_PROJECTION);
+				entry.serial = serial;
+				entry.texture = glGetUniformLocation(id, SPRITE_UNIFORM_TEXTURE);
+				result = m_program_map.insert(std::pair<GLuint, luna_sprite_program>(
+					id, entry)).first;
+			}
+
+			return result;
+		}
+
+		void 
+		_luna_sprite::flush(
+			__in GLsizei width,
+			__in GLsizei height
+			)
+		{
+			GLuint program, texture;
+			size_t begin, count, corner, iter, index;
+			luna_sprite_vertex *vertex = NULL;
+			std::map<GLuint, luna_sprite_program>::iterator program_iter;
+			luna_shader_program_ptr instance_shader_program = NULL;
+			luna_texture_ptr instance_texture = NULL;
+			luna_vertex_ptr instance_vertex = NULL;
+			GLfloat projection[] = {
+				2.f / width, 0.f, 0.f, 0.f,
+				0.f, -2.f / height, 0.f, 0.f,
+				0.f, 0.f, -1.f, 0.f,
+				-1.f, 1.f, 0.f, 1.f,
+				};
+
+			if(!m_initialized) {
+				THROW_LUNA_SPRITE_EXCEPTION(LUNA_SPRITE_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_draw_count = 0;
+			count = m_x.size();
+
+			if(count) {
+				instance_shader_program = luna_shader_program::acquire();
+				instance_texture = luna_texture::acquire();
+				instance_vertex = luna_vertex::acquire();
+
+				if(!m_buffer) {
+					m_buffer = instance_vertex->add_buffer(GL_ARRAY_BUFFER, 1);
+					m_buffer_index = instance_vertex->add_buffer(GL_ELEMENT_ARRAY_BUFFER, 1);
+				}
+
+				if(!m_program) {
+					luna_shader_ptr instance_shader = luna_shader::acquire();
+
+					m_program_shader.push_back(instance_shader->add(SPRITE_SHADER_VERTEX, 
+						false, GL_VERTEX_SHADER));
+					m_program_shader.push_back(instance_shader->add(SPRITE_SHADER_FRAGMENT, 
+						false, GL_FRAGMENT_SHADER));
+					m_program = instance_shader_program->add(m_program_shader);
+				}
+
+				// order by layer first, then by state so each run is one draw
+				m_order.resize(count);
+				for(iter = 0; iter < count; ++iter) {
+					m_order[iter] = iter;
+				}
+
+				if(!std::is_sorted(m_key.begin(), m_key.end())) {
+					std::stable_sort(m_order.begin(), m_order.end(), 
+						[this](size_t left, size_t right) { 
+							return m_key[left] < m_key[right]; 
+						});
+				}
+
+				build();
+				m_vertex.resize(count * SPRITE_CORNER_COUNT);
+				vertex = &m_vertex[0];
+
+				for(iter = 0; iter < count; ++iter) {
+					index = m_order[iter];
+
+					for(corner = 0; corner < SPRITE_CORNER_COUNT; ++corner, ++vertex) {
+						vertex->x = m_corner_x[corner][index];
+						vertex->y = m_corner_y[corner][index];
+						// texture and atlas rows are stored bottom-up, so the bottom corners 
+						// take v0
+						vertex->u = m_uv[((corner == 0) || (corner == 3)) ? SPRITE_UV_U0 
+							: SPRITE_UV_U1][index];
+						vertex->v = m_uv[(corner < 2) ? SPRITE_UV_V0 : SPRITE_UV_V1][index];
+						vertex->color = m_color[index];
+					}
+				}
+
+				// orphan the previous contents so the upload does not stall on the gpu
+				instance_vertex->bind_buffer(GL_ARRAY_BUFFER, m_buffer);
+				m_buffer_length = std::max(m_buffer_length, 
+					m_vertex.size() * sizeof(luna_sprite_vertex));
+				instance_vertex->set_buffer_data(GL_ARRAY_BUFFER, NULL, m_buffer_length, 
+					GL_STREAM_DRAW);
+				instance_vertex->set_buffer_sub_data(GL_ARRAY_BUFFER, 0, &m_vertex[0], 
+					m_vertex.size() * sizeof(luna_sprite_vertex));
+				reserve_index(count);
+
+				for(begin = 0; begin < count;) {
+					program = m_quad_program[m_order[begin]];
+					texture = m_quad_texture[m_order[begin]];
+
+					for(iter = begin + 1; (iter < count) 
+							&& (m_quad_program[m_order[iter]] == program)
+							&& (m_quad_texture[m_order[iter]] == texture); 
+							++iter);
+
+					if(!program) {
+						program = m_program;
+					}
+
+					program_iter = find_program(program);
+					instance_shader_program->use(program);
+					glUniformMatrix4fv(program_iter->second.projection, 1, GL_FALSE, projection);
+					glUniform1i(program_iter->second.texture, 0);
+					instance_texture->bind(texture, 0);
+					instance_vertex->bind_vertex(program_iter->second.vao);
+					glDrawElements(GL_TRIANGLES, (iter - begin) * SPRITE_INDEX_COUNT, 
+						GL_UNSIGNED_INT, 
+						(GLvoid *) (begin * SPRITE_INDEX_COUNT * sizeof(GLuint)));
+					++m_draw_count;
+					begin = iter;
+				}
+
+				instance_vertex->bind_vertex();
+				instance_shader_program->use();
+			}
+
+			reset();
+		}
+
+		void 
+		_luna_sprite::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_SPRITE_EXCEPTION(LUNA_SPRITE_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			clear();
+		}
+
+		bool 
+		_luna_sprite::is_allocated(void)
+		{
+			return (luna_sprite::m_instance != NULL);
+		}
+
+		bool 
+		_luna_sprite::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		void 
+		_luna_sprite::release(void)
+		{
+			std::vector<GLuint>::iterator shader_iter;
+			std::map<GLuint, luna_sprite_program>::iterator iter;
+
+			// the gl components may already be torn down during shutdown
+			if(luna_vertex::is_allocated() && luna_vertex::acquire()->is_initialized()) {
+
+				for(iter = m_program_map.begin(); iter != m_program_map.end(); ++iter) {
+					luna_vertex::acquire()->remove_vertex(iter->second.vao);
+				}
+
+				if(m_buffer) {
+					luna_vertex::acquire()->remove_buffer(m_buffer);
+					luna_vertex::acquire()->remove_buffer(m_buffer_index);
+				}
+			}
+
+			// shaders and programs may be shared, so only this component's references are dropped
+			if(m_program && luna_shader_program::is_allocated() 
+					&& luna_shader_program::acquire()->is_initialized()) {
+				luna_shader_program::acquire()->decrement_reference(m_program);
+			}
+
+			if(luna_shader::is_allocated() && luna_shader::acquire()->is_initialized()) {
+
+				for(shader_iter = m_program_shader.begin(); shader_iter != m_program_shader.end(); 
+						++shader_iter) {
+					luna_shader::acquire()->decrement_reference(*shader_iter);
+				}
+			}
+
+			m_buffer = 0;
+			m_buffer_index = 0;
+			m_buffer_index_count = 0;
+			m_buffer_length = 0;
+			m_program = 0;
+			m_program_map.clear();
+			m_program_shader.clear();
+		}
+
+		void 
+		_luna_sprite::reserve_index(
+			__in size_t count
+			)
+		{
+			size_t iter;
+			std::vector<GLuint> index;
+
+			if(!m_initialized) {
+				THROW_LUNA_SPRITE_EXCEPTION(LUNA_SPRITE_EXCEPTION_UNINITIALIZED);
+			}
+
+			if(count > m_buffer_index_count) {
+				count = std::max(count, m_buffer_index_count * 2);
+				index.resize(count * SPRITE_INDEX_COUNT);
+
+				for(iter = 0; iter < count; ++iter) {
+					index[(iter * SPRITE_INDEX_COUNT)] = (iter * SPRITE_CORNER_COUNT);
+					index[(iter * SPRITE_INDEX_COUNT) + 1] = (iter * SPRITE_CORNER_COUNT) + 1;
+					index[(iter * SPRITE_INDEX_COUNT) + 2] = (iter * SPRITE_CORNER_COUNT) + 2;
+					index[(iter * SPRITE_INDEX_COUNT) + 3] = (iter * SPRITE_CORNER_COUNT) + 2;
+					index[(iter * SPRITE_INDEX_COUNT) + 4] = (iter * SPRITE_CORNER_COUNT) + 3;
+					index[(iter * SPRITE_INDEX_COUNT) + 5] = (iter * SPRITE_CORNER_COUNT);
+				}
+
+				// the element binding is vao state, so bind through an unbound vao
+				luna_vertex::acquire()->bind_vertex();
+				luna_vertex::acquire()->bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer_index);
+				luna_vertex::acquire()->set_buffer_data(GL_ELEMENT_ARRAY_BUFFER, &index[0], 
+					index.size() * sizeof(GLuint), GL_STATIC_DRAW);
+				m_buffer_index_count = count;
+			}
+		}
+
+		void 
+		_luna_sprite::reset(void)
+		{
+			size_t iter;
+
+			for(iter = 0; iter < SPRITE_CORNER_COUNT; ++iter) {
+				m_uv[iter].clear();
+			}
+
+			m_color.clear();
+			m_cosine.clear();
+			m_half_height.clear();
+			m_half_width.clear();
+			m_key.clear();
+			m_quad_program.clear();
+			m_quad_texture.clear();
+			m_sine.clear();
+			m_x.clear();
+			m_y.clear();
+		}
+
+		size_t 
+		_luna_sprite::size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_SPRITE_EXCEPTION(LUNA_SPRITE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_x.size();
+		}
+
+		std::string 
+		_luna_sprite::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+
+			result << LUNA_SPRITE_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_sprite_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+				result << " SPRITE. " << m_x.size() << ", DRAW. " << m_draw_count
+					<< ", CAP. " << m_buffer_index_count;
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_sprite::uninitialize(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_SPRITE_EXCEPTION(LUNA_SPRITE_EXCEPTION_UNINITIALIZED);
+			}
+
+			clear();
+			m_initialized = false;
+		}
+	}
+}
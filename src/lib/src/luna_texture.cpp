@@ -0,0 +1,620 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include "../include/luna.h"
+#include "../include/luna_texture_type.h"
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define TEXTURE_CHANNELS 4
+
+		_luna_texture *_luna_texture::m_instance = NULL;
+
+		_luna_texture::_luna_texture(void) :
+			m_initialized(false),
+			m_pbo_index(0),
+			m_pending(0),
+			m_serial(0)
+		{
+			std::memset(m_pbo, 0, sizeof(m_pbo));
+			std::atexit(luna_texture::_delete);
+		}
+
+		_luna_texture::~_luna_texture(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_texture::_delete(void)
+		{
+
+			if(luna_texture::m_instance) {
+				delete luna_texture::m_instance;
+				luna_texture::m_instance = NULL;
+			}
+		}
+
+		_luna_texture *
+		_luna_texture::acquire(void)
+		{
+
+			if(!luna_texture::m_instance) {
+
+				luna_texture::m_instance = new luna_texture;
+				if(!luna_texture::m_instance) {
+					THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_texture::m_instance;
+		}
+
+		GLuint 
+		_luna_texture::add(
+			__in const std::string &path
+			)
+		{
+			GLuint result = 0;
+			luna_texture_entry entry;
+			luna_texture_request *request = NULL;
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			request = new luna_texture_request;
+			if(!request) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_ALLOCATED);
+			}
+
+			// the handle is valid immediately, storage arrives once decoded and uploaded
+			glGenTextures(1, &result);
+			entry.failed = false;
+			entry.height = 0;
+			entry.loaded = false;
+			entry.reference = REFERENCE_INIT;
+			entry.serial = ++m_serial;
+			entry.width = 0;
+			m_texture_map.insert(std::pair<GLuint, luna_texture_entry>(result, entry));
+
+			request->height = 0;
+			request->id = result;
+			request->path = path;
+			request->serial = entry.serial;
+			request->width = 0;
+			++m_pending;
+
+			try {
+				luna_job::acquire()->add(luna_texture::decode, request);
+			} catch(...) {
+				--m_pending;
+				delete request;
+				throw;
+			}
+
+			return result;
+		}
+
+		GLuint 
+		_luna_texture::add(
+			__in GLsizei width,
+			__in GLsizei height,
+			__in_opt const void *data
+			)
+		{
+			GLuint result = 0;
+			luna_texture_entry entry;
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			glGenTextures(1, &result);
+			glBindTexture(GL_TEXTURE_2D, result);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, 
+				GL_UNSIGNED_BYTE, data);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			entry.failed = false;
+			entry.height = height;
+			entry.loaded = true;
+			entry.reference = REFERENCE_INIT;
+			entry.serial = ++m_serial;
+			entry.width = width;
+			m_texture_map.insert(std::pair<GLuint, luna_texture_entry>(result, entry));
+
+			return result;
+		}
+
+		void 
+		_luna_texture::bind(
+			__in_opt GLuint id,
+			__in_opt GLuint unit
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			glActiveTexture(GL_TEXTURE0 + unit);
+			glBindTexture(GL_TEXTURE_2D, !id ? id : find(id)->first);
+		}
+
+		void 
+		_luna_texture::clear(void)
+		{
+			std::map<GLuint, luna_texture_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			for(iter = m_texture_map.begin(); iter != m_texture_map.end(); ++iter) {
+				glDeleteTextures(1, &iter->first);
+			}
+
+			m_texture_map.clear();
+
+			{
+				std::lock_guard<std::mutex> lock(m_decoded_lock);
+
+				while(!m_decoded.empty()) {
+					delete m_decoded.front();
+					m_decoded.pop_front();
+					--m_pending;
+				}
+			}
+
+			if(m_pbo[0]) {
+				glDeleteBuffers(TEXTURE_PBO_COUNT, m_pbo);
+				std::memset(m_pbo, 0, sizeof(m_pbo));
+			}
+
+			m_pbo_index = 0;
+		}
+
+		bool 
+		_luna_texture::contains(
+			__in GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (m_texture_map.find(id) != m_texture_map.end());
+		}
+
+		void 
+		_luna_texture::decode(
+			__in void *context
+			)
+		{
+			int row;
+			luna_file file;
+			SDL_Surface *converted = NULL, *surface = NULL;
+			luna_texture_request *request = (luna_texture_request *) context;
+
+			// every request is queued back, teardown waits for it even when decoding throws
+			try {
+				file.open(request->path);
+
+				// images decode straight from the mapping, rather than through buffered reads
+				surface = SDL_LoadBMP_RW(SDL_RWFromConstMem(file.data(), file.size()), 1);
+				if(surface) {
+					converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+					SDL_FreeSurface(surface);
+				}
+
+				if(!converted) {
+					request->error = SDL_GetError();
+				} else if((converted->w <= 0) || (converted->h <= 0)) {
+
+					// empty images have no storage to upload, so they fail here
+					request->error = "Empty image";
+				} else {
+					request->height = converted->h;
+					request->width = converted->w;
+					request->pixels.resize(converted->w * converted->h * TEXTURE_CHANNELS);
+
+					// rows are flipped, so texture coordinates originate at the bottom-left
+					SDL_LockSurface(converted);
+
+					for(row = 0; row < converted->h; ++row) {
+						std::memcpy(&request->pixels[(converted->h - row - 1) * converted->w 
+							* TEXTURE_CHANNELS], (uint8_t *) converted->pixels 
+							+ (row * converted->pitch), converted->w * TEXTURE_CHANNELS);
+					}
+
+					SDL_UnlockSurface(converted);
+				}
+			} catch(std::exception &exc) {
+				request->error = exc.what();
+			} catch(...) {
+				request->error = EXCEPTION_UNKNOWN;
+			}
+
+			if(converted) {
+				SDL_FreeSurface(converted);
+			}
+
+			if(!request->error.empty()) {
+				request->pixels.clear();
+			}
+
+			// notified under the lock, so a waiting teardown cannot free the instance first
+			std::lock_guard<std::mutex> lock(luna_texture::m_instance->m_decoded_lock);
+			luna_texture::m_instance->m_decoded.push_back(request);
+			luna_texture::m_instance->m_decoded_condition.notify_all();
+		}
+
+		size_t 
+		_luna_texture::decrement_reference(
+			__in GLuint id
+			)
+		{
+			size_t result = 0;
+			std::map<GLuint, luna_texture_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+			if(iter->second.reference > REFERENCE_INIT) {
+				result = --iter->second.reference;
+			} else {
+				glDeleteTextures(1, &iter->first);
+				m_texture_map.erase(iter);
+			}
+
+			return result;
+		}
+
+		std::string 
+		_luna_texture::error(
+			__in GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return find(id)->second.error;
+		}
+
+		std::map<GLuint, luna_texture_entry>::iterator 
+		_luna_texture::find(
+			__in GLuint id
+			)
+		{
+			std::map<GLuint, luna_texture_entry>::iterator result;
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			result = m_texture_map.find(id);
+			if(result == m_texture_map.end()) {
+				THROW_LUNA_TEXTURE_EXCEPTION_FORMAT(LUNA_TEXTURE_EXCEPTION_NOT_FOUND,
+					"0x%x", id);
+			}
+
+			return result;
+		}
+
+		GLsizei 
+		_luna_texture::height(
+			__in GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return find(id)->second.height;
+		}
+
+		size_t 
+		_luna_texture::increment_reference(
+			__in GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return ++find(id)->second.reference;
+		}
+
+		void 
+		_luna_texture::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			clear();
+		}
+
+		bool 
+		_luna_texture::is_allocated(void)
+		{
+			return (luna_texture::m_instance != NULL);
+		}
+
+		bool 
+		_luna_texture::is_failed(
+			__in GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return find(id)->second.failed;
+		}
+
+		bool 
+		_luna_texture::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		bool 
+		_luna_texture::is_loaded(
+			__in GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return find(id)->second.loaded;
+		}
+
+		size_t 
+		_luna_texture::pending(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_pending;
+		}
+
+		size_t 
+		_luna_texture::reference_count(
+			__in GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return find(id)->second.reference;
+		}
+
+		void 
+		_luna_texture::remove(
+			__in GLuint id
+			)
+		{
+			std::map<GLuint, luna_texture_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = find(id);
+			glDeleteTextures(1, &iter->first);
+			m_texture_map.erase(iter);
+		}
+
+		size_t 
+		_luna_texture::size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_texture_map.size();
+		}
+
+		std::string 
+		_luna_texture::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+			std::map<GLuint, luna_texture_entry>::iterator iter;
+
+			result << LUNA_TEXTURE_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_texture_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+
+				for(iter = m_texture_map.begin(); iter != m_texture_map.end(); ++iter) {
+					result << std::endl << "--- 0x" << SCALAR_AS_HEX(GLuint, iter->first)
+						<< ", " << iter->second.width << "x" << iter->second.height
+						<< " (" << (iter->second.loaded ? "LOADED" 
+							: (iter->second.failed ? "FAILED" : "PENDING")) << ")"
+						<< ", REF. " << iter->second.reference;
+				}
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_texture::uninitialize(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			// in-flight decodes reference this instance, so they must land before teardown
+			{
+				std::unique_lock<std::mutex> lock(m_decoded_lock);
+
+				while(m_decoded.size() < m_pending) {
+					m_decoded_condition.wait(lock);
+				}
+			}
+
+			clear();
+			m_initialized = false;
+		}
+
+		void 
+		_luna_texture::update(
+			__in_opt size_t limit
+			)
+		{
+			luna_texture_request *request = NULL;
+			std::map<GLuint, luna_texture_entry>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			while(limit) {
+
+				{
+					std::lock_guard<std::mutex> lock(m_decoded_lock);
+
+					if(m_decoded.empty()) {
+						break;
+					}
+
+					request = m_decoded.front();
+					m_decoded.pop_front();
+					--m_pending;
+				}
+
+				// textures removed while decoding are dropped
+				iter = m_texture_map.find(request->id);
+				if((iter != m_texture_map.end()) && (iter->second.serial == request->serial)) {
+
+					if(request->error.empty()) {
+						upload(*request);
+						iter->second.height = request->height;
+						iter->second.loaded = true;
+						iter->second.width = request->width;
+						--limit;
+					} else {
+
+						// a bad image must not stop the frame loop, so the failure is kept on 
+						// the texture for the caller to query
+						iter->second.error = request->error;
+						iter->second.failed = true;
+						SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, 
+							"Texture decode failed: %s: %s", STRING_CHECK(request->path), 
+							request->error.c_str());
+					}
+				}
+
+				delete request;
+			}
+		}
+
+		void 
+		_luna_texture::upload(
+			__in luna_texture_request &request
+			)
+		{
+			GLvoid *buffer = NULL;
+			const GLvoid *pixels = NULL;
+			size_t length = request.pixels.size();
+
+			if(!m_pbo[0]) {
+				glGenBuffers(TEXTURE_PBO_COUNT, m_pbo);
+			}
+
+			// pixels are staged through a rotating unpack buffer, so the copy into
+			// texture storage does not stall on the previous upload
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo[m_pbo_index]);
+			m_pbo_index = ((m_pbo_index + 1) % TEXTURE_PBO_COUNT);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, length, NULL, GL_STREAM_DRAW);
+
+			buffer = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, length, GL_MAP_WRITE_BIT 
+				| GL_MAP_INVALIDATE_BUFFER_BIT);
+			if(buffer) {
+				std::memcpy(buffer, &request.pixels[0], length);
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			} else {
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				pixels = &request.pixels[0];
+			}
+
+			glBindTexture(GL_TEXTURE_2D, request.id);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, request.width, request.height, 0, GL_RGBA, 
+				GL_UNSIGNED_BYTE, pixels);
+			glGenerateMipmap(GL_TEXTURE_2D);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+
+		GLsizei 
+		_luna_texture::width(
+			__in GLuint id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TEXTURE_EXCEPTION(LUNA_TEXTURE_EXCEPTION_UNINITIALIZED);
+			}
+
+			return find(id)->second.width;
+		}
+	}
+}
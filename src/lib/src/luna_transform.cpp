@@ -0,0 +1,632 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include "../include/luna.h"
+#include "../include/luna_transform_type.h"
+
+namespace LUNA {
+
+	namespace COMP {
+
+		#define TRANSFORM_ROOT SCALAR_INVALID(size_t)
+
+		_luna_transform *_luna_transform::m_instance = NULL;
+
+		_luna_transform::_luna_transform(void) :
+			m_initialized(false),
+			m_level_begin(0),
+			m_next(0),
+			m_serial(0),
+			m_sorted(true),
+			m_update_count(0)
+		{
+			std::atexit(luna_transform::_delete);
+		}
+
+		_luna_transform::~_luna_transform(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_transform::_delete(void)
+		{
+
+			if(luna_transform::m_instance) {
+				delete luna_transform::m_instance;
+				luna_transform::m_instance = NULL;
+			}
+		}
+
+		_luna_transform *
+		_luna_transform::acquire(void)
+		{
+
+			if(!luna_transform::m_instance) {
+
+				luna_transform::m_instance = new luna_transform;
+				if(!luna_transform::m_instance) {
+					THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_transform::m_instance;
+		}
+
+		uint32_t 
+		_luna_transform::add(
+			__in_opt uint32_t parent
+			)
+		{
+			luna_mat4 world;
+			luna_quat rotation;
+			luna_vec3 position, scale;
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			luna_mat4_identity(world);
+			luna_quat_identity(rotation);
+			luna_vec3_make(0.f, 0.f, 0.f, position);
+			luna_vec3_make(1.f, 1.f, 1.f, scale);
+			m_parent.push_back(parent ? find(parent)->second : TRANSFORM_ROOT);
+			m_changed.push_back(0);
+			m_depth.push_back(0);
+			m_dirty.push_back(true);
+			m_id.push_back(++m_next);
+			m_position.push_back(position);
+			m_rotation.push_back(rotation);
+			m_scale.push_back(scale);
+			m_world.push_back(world);
+			m_index_map.insert(std::pair<uint32_t, size_t>(m_next, m_id.size() - 1));
+			m_sorted = false;
+
+			return m_next;
+		}
+
+		void 
+		_luna_transform::clear(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			m_changed.clear();
+			m_depth.clear();
+			m_dirty.clear();
+			m_id.clear();
+			m_index_map.clear();
+			m_level.clear();
+			m_parent.clear();
+			m_position.clear();
+			m_rotation.clear();
+			m_scale.clear();
+			m_world.clear();
+			m_sorted = true;
+		}
+
+		bool 
+		_luna_transform::contains(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (m_index_map.find(id) != m_index_map.end());
+		}
+
+		std::map<uint32_t, size_t>::iterator 
+		_luna_transform::find(
+			__in uint32_t id
+			)
+		{
+			std::map<uint32_t, size_t>::iterator result;
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			result = m_index_map.find(id);
+			if(result == m_index_map.end()) {
+				THROW_LUNA_TRANSFORM_EXCEPTION_FORMAT(LUNA_TRANSFORM_EXCEPTION_NOT_FOUND,
+					"0x%x", id);
+			}
+
+			return result;
+		}
+
+		size_t 
+		_luna_transform::index(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			sort();
+
+			return find(id)->second;
+		}
+
+		void 
+		_luna_transform::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			m_next = 0;
+			m_serial = 0;
+			clear();
+		}
+
+		bool 
+		_luna_transform::is_allocated(void)
+		{
+			return (luna_transform::m_instance != NULL);
+		}
+
+		bool 
+		_luna_transform::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		uint32_t 
+		_luna_transform::parent(
+			__in uint32_t id
+			)
+		{
+			size_t index;
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			index = m_parent[find(id)->second];
+
+			return ((index == TRANSFORM_ROOT) ? 0 : m_id[index]);
+		}
+
+		luna_vec3 
+		_luna_transform::position(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_position[find(id)->second];
+		}
+
+		void 
+		_luna_transform::remove(
+			__in uint32_t id
+			)
+		{
+			size_t iter, target;
+			std::vector<size_t> order;
+			std::vector<uint8_t> removed;
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			// parents precede children once sorted, so the subtree is found in one pass
+			sort();
+			target = find(id)->second;
+			removed.resize(m_id.size(), false);
+
+			for(iter = 0; iter < m_id.size(); ++iter) {
+				removed[iter] = ((iter == target) || ((m_parent[iter] != TRANSFORM_ROOT) 
+					&& removed[m_parent[iter]]));
+
+				if(!removed[iter]) {
+					order.push_back(iter);
+				}
+			}
+
+			reorder(order);
+		}
+
+		void 
+		_luna_transform::reorder(
+			__in const std::vector<size_t> &order
+			)
+		{
+			size_t iter, parent;
+			std::vector<size_t> inverse;
+			std::vector<uint8_t> dirty;
+			std::vector<luna_mat4> world;
+			std::vector<luna_quat> rotation;
+			std::vector<luna_vec3> position, scale;
+			std::vector<uint32_t> changed, depth, id;
+			std::vector<size_t> parent_index;
+
+			inverse.resize(m_id.size(), TRANSFORM_ROOT);
+			changed.reserve(order.size());
+			depth.reserve(order.size());
+			dirty.reserve(order.size());
+			id.reserve(order.size());
+			parent_index.reserve(order.size());
+			position.reserve(order.size());
+			rotation.reserve(order.size());
+			scale.reserve(order.size());
+			world.reserve(order.size());
+
+			for(iter = 0; iter < order.size(); ++iter) {
+				inverse[order[iter]] = iter;
+			}
+
+			m_index_map.clear();
+			m_level.clear();
+
+			for(iter = 0; iter < order.size(); ++iter) {
+				parent = m_parent[order[iter]];
+				changed.push_back(m_changed[order[iter]]);
+				depth.push_back(m_depth[order[iter]]);
+				dirty.push_back(m_dirty[order[iter]]);
+				id.push_back(m_id[order[iter]]);
+				parent_index.push_back((parent == TRANSFORM_ROOT) ? parent : inverse[parent]);
+				position.push_back(m_position[order[iter]]);
+				rotation.push_back(m_rotation[order[iter]]);
+				scale.push_back(m_scale[order[iter]]);
+				world.push_back(m_world[order[iter]]);
+				m_index_map.insert(std::pair<uint32_t, size_t>(id.back(), iter));
+
+				while(m_level.size() <= depth.back()) {
+					m_level.push_back(iter);
+				}
+			}
+
+			m_level.push_back(order.size());
+			m_changed.swap(changed);
+			m_depth.swap(depth);
+			m_dirty.swap(dirty);
+			m_id.swap(id);
+			m_parent.swap(parent_index);
+			m_position.swap(position);
+			m_rotation.swap(rotation);
+			m_scale.swap(scale);
+			m_world.swap(world);
+		}
+
+		luna_quat 
+		_luna_transform::rotation(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_rotation[find(id)->second];
+		}
+
+		luna_vec3 
+		_luna_transform::scale(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_scale[find(id)->second];
+		}
+
+		void 
+		_luna_transform::set_parent(
+			__in uint32_t id,
+			__in_opt uint32_t parent
+			)
+		{
+			size_t index, iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			index = find(id)->second;
+
+			if(parent) {
+
+				// reject parents that would close a cycle
+				for(iter = find(parent)->second; iter != TRANSFORM_ROOT; iter = m_parent[iter]) {
+
+					if(iter == index) {
+						THROW_LUNA_TRANSFORM_EXCEPTION_FORMAT(LUNA_TRANSFORM_EXCEPTION_INVALID,
+							"0x%x (parent 0x%x)", id, parent);
+					}
+				}
+
+				m_parent[index] = find(parent)->second;
+			} else {
+				m_parent[index] = TRANSFORM_ROOT;
+			}
+
+			m_dirty[index] = true;
+			m_sorted = false;
+		}
+
+		void 
+		_luna_transform::set_position(
+			__in uint32_t id,
+			__in const luna_vec3 &position
+			)
+		{
+			size_t index;
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			index = find(id)->second;
+			m_position[index] = position;
+			m_dirty[index] = true;
+		}
+
+		void 
+		_luna_transform::set_rotation(
+			__in uint32_t id,
+			__in const luna_quat &rotation
+			)
+		{
+			size_t index;
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			index = find(id)->second;
+			m_rotation[index] = rotation;
+			m_dirty[index] = true;
+		}
+
+		void 
+		_luna_transform::set_scale(
+			__in uint32_t id,
+			__in const luna_vec3 &scale
+			)
+		{
+			size_t index;
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			index = find(id)->second;
+			m_scale[index] = scale;
+			m_dirty[index] = true;
+		}
+
+		size_t 
+		_luna_transform::size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_id.size();
+		}
+
+		void 
+		_luna_transform::sort(void)
+		{
+			uint32_t depth_max = 0;
+			size_t iter, parent;
+			std::vector<size_t> offset, order, stack;
+
+			if(!m_sorted) {
+				m_depth.assign(m_depth.size(), SCALAR_INVALID(uint32_t));
+
+				// resolve depths from the top of each unresolved chain downward
+				for(iter = 0; iter < m_id.size(); ++iter) {
+
+					for(parent = iter; (parent != TRANSFORM_ROOT) 
+							&& (m_depth[parent] == SCALAR_INVALID(uint32_t)); 
+							parent = m_parent[parent]) {
+						stack.push_back(parent);
+					}
+
+					while(!stack.empty()) {
+						parent = m_parent[stack.back()];
+						m_depth[stack.back()] = ((parent == TRANSFORM_ROOT) ? 0 
+							: (m_depth[parent] + 1));
+						depth_max = std::max(depth_max, m_depth[stack.back()]);
+						stack.pop_back();
+					}
+				}
+
+				// stable counting sort by depth
+				offset.resize(depth_max + 2, 0);
+				order.resize(m_id.size());
+
+				for(iter = 0; iter < m_id.size(); ++iter) {
+					++offset[m_depth[iter] + 1];
+				}
+
+				for(iter = 1; iter < offset.size(); ++iter) {
+					offset[iter] += offset[iter - 1];
+				}
+
+				for(iter = 0; iter < m_id.size(); ++iter) {
+					order[offset[m_depth[iter]]++] = iter;
+				}
+
+				reorder(order);
+				m_sorted = true;
+			}
+		}
+
+		std::string 
+		_luna_transform::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+
+			result << LUNA_TRANSFORM_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_transform_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+				result << " CNT. " << m_id.size() << ", LVL. " 
+					<< (m_level.empty() ? 0 : (m_level.size() - 1))
+					<< ", UPD. " << m_update_count;
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_transform::uninitialize(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			clear();
+			m_initialized = false;
+		}
+
+		size_t 
+		_luna_transform::update(void)
+		{
+			size_t count, level;
+			luna_job_ptr instance_job = NULL;
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			sort();
+			++m_serial;
+			m_update_count = 0;
+
+			if(luna_job::is_allocated() && luna_job::acquire()->is_initialized()) {
+				instance_job = luna_job::acquire();
+			}
+
+			// nodes within a level only read their parent, so each level runs in parallel
+			for(level = 0; (level + 1) < m_level.size(); ++level) {
+				m_level_begin = m_level[level];
+				count = m_level[level + 1] - m_level_begin;
+
+				if(instance_job && (count >= TRANSFORM_PARALLEL_MIN)) {
+					instance_job->run(count, luna_transform::update_range, this, 
+						TRANSFORM_GRAIN);
+				} else {
+					update_range(0, count, this);
+				}
+			}
+
+			return m_update_count;
+		}
+
+		void 
+		_luna_transform::update_range(
+			__in size_t begin,
+			__in size_t end,
+			__in void *context
+			)
+		{
+			luna_mat4 local;
+			size_t count = 0, iter, parent;
+			luna_transform_ptr instance = (luna_transform_ptr) context;
+
+			for(iter = (instance->m_level_begin + begin); 
+					iter < (instance->m_level_begin + end); 
+					++iter) {
+				parent = instance->m_parent[iter];
+
+				// a node is stale if it changed, or its parent was recomputed this pass
+				if(instance->m_dirty[iter] || ((parent != TRANSFORM_ROOT) 
+						&& (instance->m_changed[parent] == instance->m_serial))) {
+
+					if(parent != TRANSFORM_ROOT) {
+						luna_mat4_from_trs(instance->m_position[iter], 
+							instance->m_rotation[iter], instance->m_scale[iter], local);
+						luna_mat4_multiply(instance->m_world[parent], local, 
+							instance->m_world[iter]);
+					} else {
+						luna_mat4_from_trs(instance->m_position[iter], 
+							instance->m_rotation[iter], instance->m_scale[iter], 
+							instance->m_world[iter]);
+					}
+
+					instance->m_changed[iter] = instance->m_serial;
+					instance->m_dirty[iter] = false;
+					++count;
+				}
+			}
+
+			instance->m_update_count += count;
+		}
+
+		const luna_mat4 &
+		_luna_transform::world(
+			__in uint32_t id
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_world[find(id)->second];
+		}
+
+		const luna_mat4 *
+		_luna_transform::world_data(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_TRANSFORM_EXCEPTION(LUNA_TRANSFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			sort();
+
+			return (m_world.empty() ? NULL : &m_world[0]);
+		}
+	}
+}
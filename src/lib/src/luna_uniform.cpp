@@ -0,0 +1,448 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include "../include/luna.h"
+#include "../include/luna_uniform_type.h"
+
+namespace LUNA {
+
+	namespace COMP {
+
+		_luna_uniform *_luna_uniform::m_instance = NULL;
+
+		_luna_uniform::_luna_uniform(void) :
+			m_alignment(0),
+			m_buffer(0),
+			m_frame(0),
+			m_initialized(false),
+			m_maximum(0),
+			m_offset(0),
+			m_peak(0),
+			m_uploaded(0)
+		{
+			std::atexit(luna_uniform::_delete);
+			std::memset(m_fence, 0, sizeof(m_fence));
+		}
+
+		_luna_uniform::~_luna_uniform(void)
+		{
+
+			if(m_initialized) {
+				uninitialize();
+			}
+		}
+
+		void 
+		_luna_uniform::_delete(void)
+		{
+
+			if(luna_uniform::m_instance) {
+				delete luna_uniform::m_instance;
+				luna_uniform::m_instance = NULL;
+			}
+		}
+
+		_luna_uniform *
+		_luna_uniform::acquire(void)
+		{
+
+			if(!luna_uniform::m_instance) {
+
+				luna_uniform::m_instance = new luna_uniform;
+				if(!luna_uniform::m_instance) {
+					THROW_LUNA_UNIFORM_EXCEPTION(LUNA_UNIFORM_EXCEPTION_ALLOCATED);
+				}
+			}
+
+			return luna_uniform::m_instance;
+		}
+
+		GLuint 
+		_luna_uniform::add(
+			__in const std::string &name
+			)
+		{
+			GLuint result;
+			std::map<std::string, GLuint>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_UNIFORM_EXCEPTION(LUNA_UNIFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = m_binding_map.find(name);
+			if(iter != m_binding_map.end()) {
+				result = iter->second;
+			} else {
+
+				if(m_binding_map.size() >= UNIFORM_BINDING_MAX) {
+					THROW_LUNA_UNIFORM_EXCEPTION_FORMAT(LUNA_UNIFORM_EXCEPTION_FULL,
+						"%s", STRING_CHECK(name));
+				}
+
+				result = m_binding_map.size();
+				m_binding_map.insert(std::pair<std::string, GLuint>(name, result));
+			}
+
+			return result;
+		}
+
+		luna_uniform_range 
+		_luna_uniform::allocate(
+			__in GLsizeiptr size
+			)
+		{
+			GLintptr offset;
+			luna_uniform_range result;
+
+			if(!m_initialized) {
+				THROW_LUNA_UNIFORM_EXCEPTION(LUNA_UNIFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			prepare();
+
+			if((size <= 0) || (size > m_maximum)) {
+				THROW_LUNA_UNIFORM_EXCEPTION_FORMAT(LUNA_UNIFORM_EXCEPTION_INVALID,
+					"%u", (uint32_t) size);
+			}
+
+			offset = (((m_offset + m_alignment - 1) / m_alignment) * m_alignment);
+			if((offset + size) > UNIFORM_FRAME_SIZE) {
+				THROW_LUNA_UNIFORM_EXCEPTION_FORMAT(LUNA_UNIFORM_EXCEPTION_FULL,
+					"%u", (uint32_t) size);
+			}
+
+			result.data = &m_staging[offset];
+			result.offset = ((m_frame * UNIFORM_FRAME_SIZE) + offset);
+			result.size = size;
+			m_offset = (offset + size);
+			m_peak = std::max(m_peak, (size_t) m_offset);
+
+			return result;
+		}
+
+		void 
+		_luna_uniform::bind(
+			__in GLuint binding,
+			__in const luna_uniform_range &range
+			)
+		{
+			GLintptr offset;
+
+			if(!m_initialized) {
+				THROW_LUNA_UNIFORM_EXCEPTION(LUNA_UNIFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			// ranges only live until the next frame boundary and must be sent by upload
+			// before they are bound
+			offset = (range.offset - (m_frame * UNIFORM_FRAME_SIZE));
+			if(!m_buffer || (binding >= UNIFORM_BINDING_MAX) || (offset < 0) 
+					|| ((offset + range.size) > m_uploaded)) {
+				THROW_LUNA_UNIFORM_EXCEPTION_FORMAT(LUNA_UNIFORM_EXCEPTION_INVALID,
+					"0x%x", binding);
+			}
+
+			glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_buffer, range.offset, range.size);
+		}
+
+		GLuint 
+		_luna_uniform::binding(
+			__in const std::string &name
+			)
+		{
+			std::map<std::string, GLuint>::iterator iter;
+
+			if(!m_initialized) {
+				THROW_LUNA_UNIFORM_EXCEPTION(LUNA_UNIFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			iter = m_binding_map.find(name);
+			if(iter == m_binding_map.end()) {
+				THROW_LUNA_UNIFORM_EXCEPTION_FORMAT(LUNA_UNIFORM_EXCEPTION_NOT_FOUND,
+					"%s", STRING_CHECK(name));
+			}
+
+			return iter->second;
+		}
+
+		void 
+		_luna_uniform::clear(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_UNIFORM_EXCEPTION(LUNA_UNIFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			release();
+			m_binding_map.clear();
+			m_frame = 0;
+			m_offset = 0;
+			m_peak = 0;
+			m_uploaded = 0;
+		}
+
+		bool 
+		_luna_uniform::contains(
+			__in const std::string &name
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_UNIFORM_EXCEPTION(LUNA_UNIFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			return (m_binding_map.find(name) != m_binding_map.end());
+		}
+
+		void 
+		_luna_uniform::initialize(void)
+		{
+
+			if(m_initialized) {
+				THROW_LUNA_UNIFORM_EXCEPTION(LUNA_UNIFORM_EXCEPTION_INITIALIZED);
+			}
+
+			m_initialized = true;
+			clear();
+		}
+
+		bool 
+		_luna_uniform::is_allocated(void)
+		{
+			return (luna_uniform::m_instance != NULL);
+		}
+
+		bool 
+		_luna_uniform::is_initialized(void)
+		{
+			return m_initialized;
+		}
+
+		void 
+		_luna_uniform::prepare(void)
+		{
+
+			// the ring is created on first use, once a context exists
+			if(!m_buffer) {
+				glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_alignment);
+				glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &m_maximum);
+				m_alignment = std::max(m_alignment, 1);
+				m_maximum = std::min(m_maximum, UNIFORM_FRAME_SIZE);
+
+				glGenBuffers(1, &m_buffer);
+				if(!m_buffer) {
+					THROW_LUNA_UNIFORM_EXCEPTION_FORMAT(LUNA_UNIFORM_EXCEPTION_EXTERNAL,
+						"%s", "glGenBuffers failed");
+				}
+
+				glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+				glBufferData(GL_UNIFORM_BUFFER, UNIFORM_FRAME_COUNT * UNIFORM_FRAME_SIZE, NULL, 
+					GL_STREAM_DRAW);
+				glBindBuffer(GL_UNIFORM_BUFFER, 0);
+				m_staging.resize(UNIFORM_FRAME_SIZE);
+			}
+		}
+
+		luna_uniform_range 
+		_luna_uniform::push(
+			__in GLuint binding,
+			__in const GLvoid *data,
+			__in GLsizeiptr size
+			)
+		{
+			luna_uniform_range result;
+
+			if(!m_initialized) {
+				THROW_LUNA_UNIFORM_EXCEPTION(LUNA_UNIFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			// ranges allocated before this one are sent along with it, so they must be
+			// written first
+			result = allocate(size);
+			std::memcpy(result.data, data, size);
+			upload();
+			bind(binding, result);
+
+			return result;
+		}
+
+		void 
+		_luna_uniform::release(void)
+		{
+			size_t iter;
+
+			for(iter = 0; iter < UNIFORM_FRAME_COUNT; ++iter) {
+
+				if(m_fence[iter]) {
+					glDeleteSync(m_fence[iter]);
+					m_fence[iter] = NULL;
+				}
+			}
+
+			if(m_buffer) {
+				glDeleteBuffers(1, &m_buffer);
+				m_buffer = 0;
+			}
+
+			m_staging.clear();
+		}
+
+		size_t 
+		_luna_uniform::size(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_UNIFORM_EXCEPTION(LUNA_UNIFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_binding_map.size();
+		}
+
+		std::string 
+		_luna_uniform::to_string(
+			__in_opt bool verbose
+			)
+		{
+			std::stringstream result;
+			std::map<std::string, GLuint>::iterator iter;
+
+			result << LUNA_UNIFORM_HEADER << " (" << (m_initialized ? "INIT" : "UNINIT");
+
+			if(verbose) {
+				result << ", PTR. 0x" << SCALAR_AS_HEX(luna_uniform_ptr, this);
+			}
+
+			result << ")";
+
+			if(m_initialized) {
+				result << " FRAME. " << m_frame << ", USED. " << m_offset << "/" 
+					<< UNIFORM_FRAME_SIZE << ", SENT. " << m_uploaded << ", PEAK. " 
+					<< m_peak << ", ALIGN. " << m_alignment;
+
+				for(iter = m_binding_map.begin(); iter != m_binding_map.end(); ++iter) {
+					result << std::endl << "--- " << iter->first << ", BIND. " 
+						<< iter->second;
+				}
+			}
+
+			return result.str();
+		}
+
+		void 
+		_luna_uniform::uninitialize(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_UNIFORM_EXCEPTION(LUNA_UNIFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			clear();
+			m_initialized = false;
+		}
+
+		void 
+		_luna_uniform::update(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_UNIFORM_EXCEPTION(LUNA_UNIFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			// fence the region drawn from this frame, then wait until the gpu has
+			// retired the oldest region before it is written again
+			if(m_buffer) {
+
+				if(m_fence[m_frame]) {
+					glDeleteSync(m_fence[m_frame]);
+				}
+
+				m_fence[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				m_frame = ((m_frame + 1) % UNIFORM_FRAME_COUNT);
+
+				// the region is only reused once its fence has signaled
+				if(m_fence[m_frame]) {
+
+					while(glClientWaitSync(m_fence[m_frame], GL_SYNC_FLUSH_COMMANDS_BIT, 
+							UNIFORM_FENCE_TIMEOUT) == GL_TIMEOUT_EXPIRED) {
+						SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, 
+							"Uniform fence timeout: %u", (uint32_t) m_frame);
+					}
+
+					glDeleteSync(m_fence[m_frame]);
+					m_fence[m_frame] = NULL;
+				}
+			}
+
+			m_offset = 0;
+			m_uploaded = 0;
+		}
+
+		void 
+		_luna_uniform::upload(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_UNIFORM_EXCEPTION(LUNA_UNIFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			// every range allocated since the last upload is sent in one write, so they 
+			// must all be written first
+			write(m_uploaded, m_offset - m_uploaded);
+			m_uploaded = m_offset;
+		}
+
+		size_t 
+		_luna_uniform::used(void)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_UNIFORM_EXCEPTION(LUNA_UNIFORM_EXCEPTION_UNINITIALIZED);
+			}
+
+			return m_offset;
+		}
+
+		void 
+		_luna_uniform::write(
+			__in GLintptr offset,
+			__in GLsizeiptr size
+			)
+		{
+			GLvoid *buffer = NULL;
+
+			if(m_buffer && (size > 0)) {
+				glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+
+				// the frame region is fenced, so the write never overlaps gpu reads
+				buffer = glMapBufferRange(GL_UNIFORM_BUFFER, (m_frame * UNIFORM_FRAME_SIZE) 
+					+ offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT 
+					| GL_MAP_UNSYNCHRONIZED_BIT);
+				if(buffer) {
+					std::memcpy(buffer, &m_staging[offset], size);
+					glUnmapBuffer(GL_UNIFORM_BUFFER);
+				} else {
+					glBufferSubData(GL_UNIFORM_BUFFER, (m_frame * UNIFORM_FRAME_SIZE) 
+						+ offset, size, &m_staging[offset]);
+				}
+
+				glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			}
+		}
+	}
+}
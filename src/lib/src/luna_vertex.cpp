@@ -402,6 +402,22 @@ namespace LUNA {
 			glBufferData(target, length, data, usage);
 		}
 
+		void 
+		_luna_vertex::set_buffer_sub_data(
+			__in GLenum target,
+			__in size_t offset,
+			__in const void *data,
+			__in size_t length
+			)
+		{
+
+			if(!m_initialized) {
+				THROW_LUNA_VERTEX_EXCEPTION(LUNA_VERTEX_EXCEPTION_UNINITIALIZED);
+			}
+
+			glBufferSubData(target, offset, length, data);
+		}
+
 		size_t 
 		_luna_vertex::size(void)
 		{
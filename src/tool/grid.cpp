@@ -0,0 +1,71 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iomanip>
+#include "../lib/include/luna.h"
+
+#define GRID_OPTION_QUERIES "-q"
+
+int 
+main(
+	__in int argc,
+	__in char *argv[]
+	)
+{
+	luna_grid_stat stat;
+	int iter = 1, result = 0;
+	size_t queries = GRID_DEF_QUERIES;
+
+	if((argc > (iter + 1)) && (std::string(argv[iter]) == GRID_OPTION_QUERIES)) {
+		queries = std::strtoul(argv[iter + 1], NULL, 10);
+		iter += 2;
+	}
+
+	if(argc < (iter + 1)) {
+		std::cerr << "Usage: " << argv[0] << " [" << GRID_OPTION_QUERIES << " QUERIES] COUNT..." 
+			<< std::endl;
+		result = SCALAR_INVALID(int);
+		goto exit;
+	}
+
+	try {
+		luna_job::acquire()->initialize();
+
+		for(; iter < argc; ++iter) {
+			stat = luna_grid::benchmark(std::strtoul(argv[iter], NULL, 10), queries);
+			std::cout << stat.count << " entities, " << stat.pair_count << " pairs, " 
+				<< stat.workers << " workers" << std::endl << std::fixed << std::setprecision(3) 
+				<< "Build: " << stat.build << " ms" << std::endl 
+				<< "Pairs: " << stat.pairs << " ms" << std::endl 
+				<< "Radius: " << stat.query_radius << " queries/ms" << std::endl 
+				<< "AABB: " << stat.query_aabb << " queries/ms" << std::endl;
+		}
+
+		luna_job::acquire()->uninitialize();
+	} catch(luna_exception &exc) {
+		std::cerr << exc.to_string(true) << std::endl;
+		result = SCALAR_INVALID(int);
+	} catch(std::exception &exc) {
+		std::cerr << exc.what() << std::endl;
+		result = SCALAR_INVALID(int);
+	}
+
+exit:
+	return result;
+}
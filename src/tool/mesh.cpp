@@ -0,0 +1,70 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iomanip>
+#include "../lib/include/luna.h"
+
+#define MESH_OPTION_LEVELS "-l"
+
+int 
+main(
+	__in int argc,
+	__in char *argv[]
+	)
+{
+	luna_mesh_stat stat;
+	int iter = 1, result = 0;
+	size_t level, levels = MESH_LOD_MAX;
+
+	if((argc > (iter + 1)) && (std::string(argv[iter]) == MESH_OPTION_LEVELS)) {
+		levels = std::strtoul(argv[iter + 1], NULL, 10);
+		iter += 2;
+	}
+
+	if(argc != (iter + 2)) {
+		std::cerr << "Usage: " << argv[0] << " [" << MESH_OPTION_LEVELS << " LEVELS] OUTPUT INPUT" 
+			<< std::endl;
+		result = SCALAR_INVALID(int);
+		goto exit;
+	}
+
+	try {
+		stat = luna_mesh::build(argv[iter], argv[iter + 1], levels);
+		std::cout << argv[iter] << ": " << stat.vertex_count << " vertices, " 
+			<< (stat.index_count / 3) << " triangles" << std::endl << std::fixed 
+			<< std::setprecision(3) << "ACMR: " << stat.acmr_input << " -> " << stat.acmr 
+			<< " (FIFO " << MESH_FIFO_SIZE << ")" << std::endl << "ATVR: " << stat.atvr_input 
+			<< " -> " << stat.atvr << std::endl << "Size: " << stat.size_input << " -> " 
+			<< stat.size << " bytes" << std::endl;
+
+		for(level = 0; level < stat.lod.size(); ++level) {
+			std::cout << "LOD " << level << ": " << (stat.lod.at(level).count / 3) 
+				<< " triangles, error " << stat.lod.at(level).error << std::endl;
+		}
+	} catch(luna_exception &exc) {
+		std::cerr << exc.to_string(true) << std::endl;
+		result = SCALAR_INVALID(int);
+	} catch(std::exception &exc) {
+		std::cerr << exc.what() << std::endl;
+		result = SCALAR_INVALID(int);
+	}
+
+exit:
+	return result;
+}
@@ -0,0 +1,65 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "../lib/include/luna.h"
+
+#define PACK_OPTION_UNCOMPRESSED "-u"
+
+int 
+main(
+	__in int argc,
+	__in char *argv[]
+	)
+{
+	int iter = 1, result = 0;
+	bool compress = true;
+	std::string output;
+	std::vector<std::string> input;
+
+	if((argc > iter) && (std::string(argv[iter]) == PACK_OPTION_UNCOMPRESSED)) {
+		compress = false;
+		++iter;
+	}
+
+	if(argc <= (iter + 1)) {
+		std::cerr << "Usage: " << argv[0] << " [" << PACK_OPTION_UNCOMPRESSED 
+			<< "] OUTPUT INPUT..." << std::endl;
+		result = SCALAR_INVALID(int);
+		goto exit;
+	}
+
+	output = argv[iter++];
+
+	for(; iter < argc; ++iter) {
+		input.push_back(argv[iter]);
+	}
+
+	try {
+		std::cout << output << ": " << luna_pack::build(output, input, compress) 
+			<< " entries" << std::endl;
+	} catch(luna_exception &exc) {
+		std::cerr << exc.to_string(true) << std::endl;
+		result = SCALAR_INVALID(int);
+	} catch(std::exception &exc) {
+		std::cerr << exc.what() << std::endl;
+		result = SCALAR_INVALID(int);
+	}
+
+exit:
+	return result;
+}
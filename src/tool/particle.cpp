@@ -0,0 +1,65 @@
+/**
+ * libluna
+ * Copyright (C) 2015 David Jolly
+ * ----------------------
+ *
+ * libluna is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libluna is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iomanip>
+#include "../lib/include/luna.h"
+
+#define PARTICLE_OPTION_FRAMES "-f"
+
+int 
+main(
+	__in int argc,
+	__in char *argv[]
+	)
+{
+	size_t frames = PARTICLE_DEF_FRAMES;
+	luna_particle_stat stat;
+	int iter = 1, result = 0;
+
+	if((argc > (iter + 1)) && (std::string(argv[iter]) == PARTICLE_OPTION_FRAMES)) {
+		frames = std::strtoul(argv[iter + 1], NULL, 10);
+		iter += 2;
+	}
+
+	if(argc != (iter + 1)) {
+		std::cerr << "Usage: " << argv[0] << " [" << PARTICLE_OPTION_FRAMES << " FRAMES] COUNT" 
+			<< std::endl;
+		result = SCALAR_INVALID(int);
+		goto exit;
+	}
+
+	try {
+		luna_job::acquire()->initialize();
+		stat = luna_particle::benchmark(std::strtoul(argv[iter], NULL, 10), frames);
+		luna_job::acquire()->uninitialize();
+		std::cout << stat.count << " particles, " << stat.frames << " frames, " 
+			<< stat.workers << " workers" << std::endl << std::fixed << std::setprecision(3) 
+			<< "Update: " << stat.update << " particles/ms" << std::endl 
+			<< "Update (serial): " << stat.update_serial << " particles/ms" << std::endl;
+	} catch(luna_exception &exc) {
+		std::cerr << exc.to_string(true) << std::endl;
+		result = SCALAR_INVALID(int);
+	} catch(std::exception &exc) {
+		std::cerr << exc.what() << std::endl;
+		result = SCALAR_INVALID(int);
+	}
+
+exit:
+	return result;
+}